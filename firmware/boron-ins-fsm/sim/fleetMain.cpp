@@ -0,0 +1,348 @@
+/* fleetMain.cpp - Replays recorded state machine inputs into many StateMachine instances
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Usage: braveFleet --inputs FILE [--inputs FILE ...] [--sweep FIELD=START:END:STEP ...]
+ *                   [--copies N] [--threads N]
+ *
+ * Input recordings are written by braveSim --record-inputs, one line per tick. Every
+ * recording is replayed into one instance per config, and each instance runs on its own
+ * without the radar, door sensor or publish models, so thousands of them fit on a thread
+ * pool. Sweeps over config fields multiply: two sweeps of 5 values replay each recording
+ * with 25 configs. Console calls are not recorded, so every instance keeps its config for
+ * the whole replay.
+ */
+
+#include "stateMachineCore.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ***************************** Macro definitions *****************************
+
+#define FLEET_MAX_SWEEPS    4
+
+// ***************************** Global typedefs *****************************
+
+// One line of a recording: ms door_status door_open door_unknown door_closed ins_magnitude
+typedef struct RecordedTick {
+    uint32_t ms;
+    StateMachineInputs inputs;
+} RecordedTick;
+
+typedef struct Recording {
+    const char* path;
+    std::vector<RecordedTick> ticks;
+} Recording;
+
+typedef struct ConfigField {
+    const char* name;
+    unsigned long StateMachineConfig::*field;
+} ConfigField;
+
+typedef struct Sweep {
+    const ConfigField* field;
+    unsigned long start;
+    unsigned long end;
+    unsigned long step;
+} Sweep;
+
+// What one instance did over one recording
+typedef struct ReplayResult {
+    uint32_t durationAlerts;
+    uint32_t stillnessAlerts;
+    uint32_t sessionsEnded;
+    uint32_t transitionCounts[STATE_MACHINE_TRANSITION_COUNT];
+} ReplayResult;
+
+// The I/O context of one instance
+typedef struct Replay {
+    const RecordedTick* tick;
+    ReplayResult* result;
+} Replay;
+
+// ***************************** Local variables *****************************
+
+static const ConfigField configFields[] = {
+    {"stillness_ins_threshold",           &StateMachineConfig::stillness_ins_threshold},
+    {"occupancy_detection_ins_threshold", &StateMachineConfig::occupancy_detection_ins_threshold},
+    {"state0_occupancy_detection_time",   &StateMachineConfig::state0_occupancy_detection_time},
+    {"state1_initial_time",               &StateMachineConfig::state1_initial_time},
+    {"duration_alert_time",               &StateMachineConfig::duration_alert_time},
+    {"stillness_alert_time",              &StateMachineConfig::stillness_alert_time},
+};
+
+// ***************************** Replay I/O *****************************
+
+static uint32_t replayNow(void* context) {
+    return ((Replay*)context)->tick->ms;
+}
+
+static void readReplayInputs(void* context, StateMachineInputs* inputs) {
+    *inputs = ((Replay*)context)->tick->inputs;
+}
+
+static void countSessionMessage(void* context, const char* eventName, const char* message, SessionMessageKind kind) {
+    ReplayResult* result = ((Replay*)context)->result;
+    if (kind == SESSION_MESSAGE_END) {
+        result->sessionsEnded++;
+    }
+    else if (strcmp(eventName, "Duration Alert") == 0) {
+        result->durationAlerts++;
+    }
+    else {
+        result->stillnessAlerts++;
+    }
+}
+
+// ***************************** Local functions *****************************
+
+static void printUsage() {
+    fprintf(stderr,
+            "Usage: braveFleet --inputs FILE [options]\n"
+            "  --inputs FILE          state machine inputs recorded by braveSim --record-inputs,\n"
+            "                         can be given more than once\n"
+            "  --sweep F=START:END:STEP\n"
+            "                         replay with config field F from START to END, up to %d sweeps\n"
+            "  --copies N             replay every recording and config N times, all copies must agree (default: 1)\n"
+            "  --threads N            worker threads (default: one per core)\n"
+            "Config fields:",
+            FLEET_MAX_SWEEPS);
+    for (const ConfigField& field : configFields) {
+        fprintf(stderr, " %s", field.name);
+    }
+    fprintf(stderr, "\n");
+}
+
+static bool loadRecording(Recording& recording) {
+    FILE* file = fopen(recording.path, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "fleet: cannot open %s\n", recording.path);
+        return false;
+    }
+
+    char line[128];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        lineNumber++;
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+
+        unsigned long ms;
+        unsigned int doorStatus;
+        int doorOpen, doorUnknown, doorClosed;
+        float magnitude;
+        if (sscanf(line, "%lu %x %d %d %d %f", &ms, &doorStatus, &doorOpen, &doorUnknown, &doorClosed, &magnitude) != 6) {
+            fprintf(stderr, "fleet: %s:%d: expected ms door_status door_open door_unknown door_closed ins_magnitude\n",
+                    recording.path, lineNumber);
+            fclose(file);
+            return false;
+        }
+
+        RecordedTick tick = {};
+        tick.ms = (uint32_t)ms;
+        tick.inputs.doorStatus = (uint8_t)doorStatus;
+        tick.inputs.isDoorOpen = doorOpen != 0;
+        tick.inputs.isDoorStatusUnknown = doorUnknown != 0;
+        tick.inputs.isDoorClosedEvent = doorClosed != 0;
+        tick.inputs.insMagnitude = magnitude;
+        recording.ticks.push_back(tick);
+    }
+    fclose(file);
+    return true;
+}
+
+static const ConfigField* findConfigField(const char* name, size_t length) {
+    for (const ConfigField& field : configFields) {
+        if (strlen(field.name) == length && strncmp(field.name, name, length) == 0) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+// F=START:END:STEP
+static bool parseSweep(const char* value, Sweep* sweep) {
+    const char* equals = strchr(value, '=');
+    if (equals == nullptr) {
+        return false;
+    }
+    sweep->field = findConfigField(value, equals - value);
+
+    char* end;
+    sweep->start = strtoul(equals + 1, &end, 10);
+    if (*end != ':') {
+        return false;
+    }
+    sweep->end = strtoul(end + 1, &end, 10);
+    if (*end != ':') {
+        return false;
+    }
+    sweep->step = strtoul(end + 1, &end, 10);
+    return sweep->field != nullptr && *end == '\0' && sweep->step > 0 && sweep->end >= sweep->start;
+}
+
+// Every combination of the swept values, the first sweep changing slowest
+static std::vector<StateMachineConfig> expandSweeps(const Sweep* sweeps, int numSweeps) {
+    std::vector<StateMachineConfig> configs = {defaultStateMachineConfig};
+    for (int i = 0; i < numSweeps; i++) {
+        std::vector<StateMachineConfig> expanded;
+        for (const StateMachineConfig& config : configs) {
+            for (unsigned long value = sweeps[i].start; value <= sweeps[i].end; value += sweeps[i].step) {
+                StateMachineConfig swept = config;
+                swept.*sweeps[i].field->field = value;
+                expanded.push_back(swept);
+            }
+        }
+        configs = expanded;
+    }
+    return configs;
+}
+
+static ReplayResult replay(const Recording& recording, const StateMachineConfig& config) {
+    ReplayResult result = {};
+    Replay context = {nullptr, &result};
+    StateMachineIO io = {replayNow, readReplayInputs, nullptr, nullptr, nullptr, nullptr, countSessionMessage, &context};
+    StateMachine machine(io, config);
+
+    for (const RecordedTick& tick : recording.ticks) {
+        context.tick = &tick;
+        machine.tick();
+    }
+
+    StateTransitionCount counts[STATE_MACHINE_TRANSITION_COUNT];
+    machine.getTransitionCounts(counts, STATE_MACHINE_TRANSITION_COUNT);
+    for (int row = 0; row < STATE_MACHINE_TRANSITION_COUNT; row++) {
+        result.transitionCounts[row] = counts[row].count;
+    }
+    return result;
+}
+
+// ***************************** Main *****************************
+
+int main(int argc, char* argv[]) {
+    std::vector<Recording> recordings;
+    Sweep sweeps[FLEET_MAX_SWEEPS];
+    int numSweeps = 0;
+    unsigned long copies = 1;
+    unsigned long numThreads = std::thread::hardware_concurrency();
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            printUsage();
+            return 2;
+        }
+
+        if (strcmp(arg, "--inputs") == 0) {
+            recordings.push_back({value, {}});
+        }
+        else if (strcmp(arg, "--sweep") == 0) {
+            if (numSweeps == FLEET_MAX_SWEEPS || !parseSweep(value, &sweeps[numSweeps])) {
+                printUsage();
+                return 2;
+            }
+            numSweeps++;
+        }
+        else if (strcmp(arg, "--copies") == 0) {
+            copies = strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(arg, "--threads") == 0) {
+            numThreads = strtoul(value, nullptr, 10);
+        }
+        else {
+            printUsage();
+            return 2;
+        }
+        i++;
+    }
+
+    if (recordings.empty() || copies == 0) {
+        printUsage();
+        return 2;
+    }
+    if (numThreads == 0) {
+        numThreads = 1;
+    }
+
+    size_t totalTicks = 0;
+    for (Recording& recording : recordings) {
+        if (!loadRecording(recording)) {
+            return 1;
+        }
+        totalTicks += recording.ticks.size();
+    }
+
+    std::vector<StateMachineConfig> configs = expandSweeps(sweeps, numSweeps);
+
+    // One job per instance: config, then recording, then copy
+    size_t numJobs = configs.size() * recordings.size() * copies;
+    std::vector<ReplayResult> results(numJobs);
+    std::atomic<size_t> nextJob(0);
+
+    auto wallStart = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (unsigned long t = 0; t < numThreads; t++) {
+        workers.emplace_back([&]() {
+            for (size_t job = nextJob++; job < numJobs; job = nextJob++) {
+                size_t config = job / (recordings.size() * copies);
+                size_t recording = job / copies % recordings.size();
+                results[job] = replay(recordings[recording], configs[config]);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+
+    // Copies share nothing, so any disagreement means instances are leaking state
+    size_t mismatches = 0;
+    for (size_t job = 0; job < numJobs; job++) {
+        if (memcmp(&results[job], &results[job - job % copies], sizeof(ReplayResult)) != 0) {
+            mismatches++;
+        }
+    }
+
+    fprintf(stderr, "Replayed %zu instances (%zu configs x %zu recordings x %lu copies) on %lu threads in %.2f s, %.1f M ticks/s\n",
+            numJobs, configs.size(), recordings.size(), copies, numThreads, wall.count(),
+            (wall.count() > 0) ? totalTicks * configs.size() * copies / wall.count() / 1e6 : 0.0);
+
+    // Tab separated, one row per config with totals over the recordings
+    printf("config\tdurationAlerts\tstillnessAlerts\tsessionsEnded\n");
+    for (size_t config = 0; config < configs.size(); config++) {
+        std::string name;
+        for (int i = 0; i < numSweeps; i++) {
+            name += (i > 0 ? " " : "") + std::string(sweeps[i].field->name) + "=" + std::to_string(configs[config].*sweeps[i].field->field);
+        }
+        if (name.empty()) {
+            name = "default";
+        }
+
+        ReplayResult total = {};
+        for (size_t recording = 0; recording < recordings.size(); recording++) {
+            const ReplayResult& result = results[(config * recordings.size() + recording) * copies];
+            total.durationAlerts += result.durationAlerts;
+            total.stillnessAlerts += result.stillnessAlerts;
+            total.sessionsEnded += result.sessionsEnded;
+        }
+        printf("%s\t%lu\t%lu\t%lu\n", name.c_str(), (unsigned long)total.durationAlerts, (unsigned long)total.stillnessAlerts,
+               (unsigned long)total.sessionsEnded);
+    }
+
+    if (mismatches > 0) {
+        fprintf(stderr, "fleet: %zu instances disagreed with their first copy\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,346 @@
+/* Particle.h - Device OS shim for running the firmware on the host simulator
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Declares just the parts of the Device OS API the firmware uses, backed by the
+ * simulator: millis() is a virtual clock, Serial1 is fed from a radar trace, BLE scans
+ * return events from a door trace and Particle.publish() is written to the publish log.
+ * Unlike the unit test mocks in /test/mocks these are working implementations, so the
+ * firmware sources compile here unchanged. See particleShim.cpp.
+ */
+
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+#include "spark_wiring_string.h"
+#include "spark_wiring_vector.h"
+
+using namespace std::chrono_literals;
+
+// ***************************** Macro definitions *****************************
+
+#define PRODUCT_VERSION(x)
+#define SYSTEM_THREAD(x)
+
+#define SERIAL_8N1 0x00
+
+#define BLE_MAX_ADV_DATA_LEN 31
+
+#define FEATURE_RESET_INFO 1
+
+#define HIGH 1
+#define LOW  0
+
+// ***************************** Global typedefs *****************************
+
+typedef uint32_t system_tick_t;
+typedef uint16_t pin_t;
+typedef void* os_queue_t;
+
+enum PinMode { INPUT, OUTPUT };
+
+// Pins the firmware refers to, numbered as on the Boron
+enum : pin_t { D6 = 6, A0 = 19, A1 = 18, A2 = 17 };
+
+enum PublishFlag { PUBLIC = 0x00, PRIVATE = 0x01, NO_ACK = 0x02, WITH_ACK = 0x08 };
+
+typedef enum LogLevel {
+    LOG_LEVEL_ALL = 1,
+    LOG_LEVEL_TRACE = 1,
+    LOG_LEVEL_INFO = 30,
+    LOG_LEVEL_WARN = 40,
+    LOG_LEVEL_ERROR = 50,
+    LOG_LEVEL_PANIC = 60,
+    LOG_LEVEL_NONE = 70
+} LogLevel;
+
+enum ResetReason {
+    RESET_REASON_NONE = 0,
+    RESET_REASON_UNKNOWN = 10,
+    RESET_REASON_PIN_RESET = 20,
+    RESET_REASON_POWER_MANAGEMENT = 30,
+    RESET_REASON_POWER_DOWN = 40,
+    RESET_REASON_POWER_BROWNOUT = 50,
+    RESET_REASON_WATCHDOG = 60,
+    RESET_REASON_UPDATE = 70,
+    RESET_REASON_UPDATE_ERROR = 80,
+    RESET_REASON_UPDATE_TIMEOUT = 90,
+    RESET_REASON_FACTORY_RESET = 100,
+    RESET_REASON_SAFE_MODE = 110,
+    RESET_REASON_DFU_MODE = 120,
+    RESET_REASON_PANIC = 130,
+    RESET_REASON_USER = 140
+};
+
+// Device OS UART buffer configuration, see acquireSerial1Buffer() in ins3331.cpp
+typedef struct hal_usart_buffer_config_t {
+    uint16_t size;
+    void* rx_buffer;
+    uint16_t rx_buffer_size;
+    void* tx_buffer;
+    uint16_t tx_buffer_size;
+} hal_usart_buffer_config_t;
+
+hal_usart_buffer_config_t acquireSerial1Buffer();
+
+// ***************************** Timing and GPIO *****************************
+
+uint32_t millis();
+uint32_t micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(pin_t pin, PinMode mode);
+void digitalWrite(pin_t pin, uint8_t value);
+
+// ***************************** Threads *****************************
+
+// Simulated threads do not run their thread function; the simulator calls the matching
+// single-pass service function on the thread's schedule instead (see simulator.cpp)
+class Thread {
+public:
+    Thread(const char* name, void (*function)(void*));
+};
+
+void os_thread_yield();
+
+// ***************************** Logging *****************************
+
+class SerialLogHandler {
+public:
+    explicit SerialLogHandler(LogLevel level);
+};
+
+class Logger {
+public:
+    void info(const char* fmt, ...) const;
+    void warn(const char* fmt, ...) const;
+    void error(const char* fmt, ...) const;
+    bool isLevelEnabled(LogLevel level) const;
+};
+
+extern Logger Log;
+
+// ***************************** Cloud *****************************
+
+namespace particle {
+
+// Publishes resolve immediately in the simulator, so a Future is always done
+template <typename T>
+class Future {
+public:
+    Future() : done(false), succeeded(false), value() {}
+    Future(bool succeeded, T value) : done(true), succeeded(succeeded), value(value) {}
+
+    bool isDone() const { return done; }
+    bool isSucceeded() const { return done && succeeded; }
+    bool isFailed() const { return done && !succeeded; }
+    T result() const { return value; }
+
+    // On the device this blocks until the publish resolves
+    operator T() const { return value; }
+
+private:
+    bool done;
+    bool succeeded;
+    T value;
+};
+
+}  // namespace particle
+
+class CloudClass {
+public:
+    bool connected() const;
+    void keepAlive(int seconds) const {}
+    void publishVitals(int seconds) const {}
+    particle::Future<bool> publish(const char* eventName, const char* data, int flags = PUBLIC) const;
+    bool function(const char* name, int (*function)(String)) const;
+};
+
+extern CloudClass Particle;
+
+// Wall clock, synced from the start of the run
+class TimeClass {
+public:
+    uint32_t now() const;
+    bool isValid() const { return true; }
+};
+
+extern TimeClass Time;
+
+// The sim build sets ALERT_JOURNAL_DIR to this, see alertJournal.h
+const char* simJournalDir(void);
+
+class CellularClass {
+public:
+    bool ready() const { return true; }
+};
+
+extern CellularClass Cellular;
+
+// ***************************** System *****************************
+
+class SystemClass {
+public:
+    int resetReason() const { return RESET_REASON_NONE; }
+    void enableFeature(int feature) const {}
+    void enableReset() const {}
+    void disableReset() const {}
+    void reset() const;
+};
+
+extern SystemClass System;
+
+class RGBClass {
+public:
+    void mirrorTo(pin_t red, pin_t green, pin_t blue, bool invert = false, bool bootloader = false) const {}
+};
+
+extern RGBClass RGB;
+
+// Emulated EEPROM, erased (0xFF) at power up like a factory-new device
+class EEPROMClass {
+public:
+    static const size_t EEPROM_SIZE = 4096;
+
+    template <typename T>
+    T& get(int address, T& value) {
+        memcpy(&value, bytes() + address, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    const T& put(int address, const T& value) {
+        memcpy(bytes() + address, &value, sizeof(T));
+        return value;
+    }
+
+    size_t length() const { return EEPROM_SIZE; }
+
+private:
+    uint8_t* bytes();
+};
+
+extern EEPROMClass EEPROM;
+
+// ***************************** Serial *****************************
+
+class USARTSerial {
+public:
+    void begin(unsigned long baud, uint32_t config) {}
+    int available();
+    int read();
+    size_t readBytes(char* buffer, size_t length);
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buffer, size_t size);
+};
+
+extern USARTSerial Serial1;
+
+// USB serial, connected when braveSim --trace gives it a file to write to
+class USBSerial {
+public:
+    bool isConnected();
+    int availableForWrite();
+    size_t write(const uint8_t* buffer, size_t size);
+};
+
+extern USBSerial Serial;
+
+// Device OS runs the block with the stream locked. The simulator runs one thread at a time.
+#define WITH_LOCK(object) for (bool simLocked = true; simLocked; simLocked = false)
+
+// ***************************** BLE *****************************
+
+enum class BleAdvertisingDataType : uint8_t { MANUFACTURER_SPECIFIC_DATA = 0xFF };
+enum class BleAntennaType { DEFAULT, INTERNAL, EXTERNAL };
+
+class BleAdvertisingData {
+public:
+    BleAdvertisingData() : length(0) {}
+
+    size_t set(const uint8_t* data, size_t size);
+    size_t get(BleAdvertisingDataType type, uint8_t* buffer, size_t size) const;
+
+private:
+    uint8_t data[BLE_MAX_ADV_DATA_LEN];
+    size_t length;
+};
+
+class BleScanResult {
+public:
+    const BleAdvertisingData& advertisingData() const { return advertisingData_; }
+    BleScanResult& advertisingData(const uint8_t* data, size_t size) {
+        advertisingData_.set(data, size);
+        return *this;
+    }
+
+private:
+    BleAdvertisingData advertisingData_;
+};
+
+// The simulated radio only hears the paired door sensor, so filters are not applied
+class BleScanFilter {
+public:
+    template <typename T>
+    BleScanFilter& deviceName(T name) {
+        return *this;
+    }
+
+    template <typename T>
+    BleScanFilter& address(T address) {
+        return *this;
+    }
+};
+
+class BleClass {
+public:
+    int selectAntenna(BleAntennaType antenna) const { return 0; }
+    int setScanTimeout(uint16_t timeout) const { return 0; }
+    spark::Vector<BleScanResult> scanWithFilter(const BleScanFilter& filter) const;
+};
+
+extern BleClass BLE;
+
+// ***************************** JSON *****************************
+
+// Writes compact JSON ({"a":1,"b":true}) into a caller supplied buffer, as Device OS does
+class JSONBufferWriter {
+public:
+    JSONBufferWriter(char* buffer, size_t size);
+
+    JSONBufferWriter& beginObject();
+    JSONBufferWriter& endObject();
+    JSONBufferWriter& beginArray();
+    JSONBufferWriter& endArray();
+    JSONBufferWriter& name(const char* name);
+
+    JSONBufferWriter& value(bool value);
+    JSONBufferWriter& value(int value);
+    JSONBufferWriter& value(unsigned value);
+    JSONBufferWriter& value(long value);
+    JSONBufferWriter& value(unsigned long value);
+    JSONBufferWriter& value(double value);
+    JSONBufferWriter& value(const char* value);
+
+    char* buffer() const { return buf; }
+    size_t dataSize() const { return written; }
+    size_t bufferSize() const { return size; }
+
+private:
+    void separate();
+    void append(const char* fmt, ...);
+
+    char* buf;
+    size_t size;
+    size_t written;
+    bool needsComma;
+};
@@ -0,0 +1,278 @@
+/* particleShim.cpp - Device OS shim for running the firmware on the host simulator
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "Particle.h"
+#include "../simulator.h"
+#include "clock.h"
+
+Logger Log;
+CloudClass Particle;
+TimeClass Time;
+CellularClass Cellular;
+SystemClass System;
+RGBClass RGB;
+EEPROMClass EEPROM;
+USARTSerial Serial1;
+USBSerial Serial;
+BleClass BLE;
+
+// ***************************** Timing and GPIO *****************************
+
+uint32_t millis() {
+    return VirtualClock::millis();
+}
+
+uint32_t micros() {
+    return (uint32_t)(VirtualClock::elapsedMillis() * 1000);
+}
+
+void delay(unsigned long ms) {
+    simDelay((uint32_t)ms);
+}
+
+void delayMicroseconds(unsigned int us) {}
+
+void pinMode(pin_t pin, PinMode mode) {}
+
+void digitalWrite(pin_t pin, uint8_t value) {}
+
+// ***************************** Threads *****************************
+
+Thread::Thread(const char* name, void (*function)(void*)) {
+    simStartThread(name);
+}
+
+void os_thread_yield() {}
+
+// ***************************** Logging *****************************
+
+SerialLogHandler::SerialLogHandler(LogLevel level) {
+    simSetLogLevel(level);
+}
+
+void Logger::info(const char* fmt, ...) const {
+    va_list args;
+    va_start(args, fmt);
+    simLog(LOG_LEVEL_INFO, fmt, args);
+    va_end(args);
+}
+
+void Logger::warn(const char* fmt, ...) const {
+    va_list args;
+    va_start(args, fmt);
+    simLog(LOG_LEVEL_WARN, fmt, args);
+    va_end(args);
+}
+
+void Logger::error(const char* fmt, ...) const {
+    va_list args;
+    va_start(args, fmt);
+    simLog(LOG_LEVEL_ERROR, fmt, args);
+    va_end(args);
+}
+
+bool Logger::isLevelEnabled(LogLevel level) const {
+    return simIsLogEnabled(level);
+}
+
+// ***************************** Cloud and System *****************************
+
+bool CloudClass::connected() const {
+    return simCloudConnected();
+}
+
+particle::Future<bool> CloudClass::publish(const char* eventName, const char* data, int flags) const {
+    if (!simCloudConnected()) {
+        return particle::Future<bool>(false, false);
+    }
+    simPublish(eventName, data);
+    return particle::Future<bool>(true, true);
+}
+
+bool CloudClass::function(const char* name, int (*function)(String)) const {
+    simRegisterFunction(name, function);
+    return true;
+}
+
+uint32_t TimeClass::now() const {
+    return simWallTime();
+}
+
+void SystemClass::reset() const {
+    simSystemReset();
+}
+
+uint8_t* EEPROMClass::bytes() {
+    static uint8_t storage[EEPROM_SIZE];
+    static bool erased = false;
+    if (!erased) {
+        memset(storage, 0xFF, sizeof(storage));
+        erased = true;
+    }
+    return storage;
+}
+
+// ***************************** Serial *****************************
+
+int USARTSerial::available() {
+    return simSerialAvailable();
+}
+
+int USARTSerial::read() {
+    uint8_t c;
+    return (simSerialRead(&c, 1) == 1) ? c : -1;
+}
+
+size_t USARTSerial::readBytes(char* buffer, size_t length) {
+    return simSerialRead((uint8_t*)buffer, length);
+}
+
+size_t USARTSerial::write(uint8_t c) {
+    simSerialWrite(&c, 1);
+    return 1;
+}
+
+size_t USARTSerial::write(const uint8_t* buffer, size_t size) {
+    simSerialWrite(buffer, size);
+    return size;
+}
+
+bool USBSerial::isConnected() {
+    return simUsbConnected();
+}
+
+int USBSerial::availableForWrite() {
+    return SIM_USB_TX_BUFFER;
+}
+
+size_t USBSerial::write(const uint8_t* buffer, size_t size) {
+    simUsbWrite(buffer, size);
+    return size;
+}
+
+// ***************************** BLE *****************************
+
+size_t BleAdvertisingData::set(const uint8_t* data, size_t size) {
+    length = (size < sizeof(this->data)) ? size : sizeof(this->data);
+    memcpy(this->data, data, length);
+    return length;
+}
+
+size_t BleAdvertisingData::get(BleAdvertisingDataType type, uint8_t* buffer, size_t size) const {
+    size_t toCopy = (size < length) ? size : length;
+    memcpy(buffer, data, toCopy);
+    return toCopy;
+}
+
+spark::Vector<BleScanResult> BleClass::scanWithFilter(const BleScanFilter& filter) const {
+    spark::Vector<BleScanResult> results;
+    simScanDoor(results);
+    return results;
+}
+
+// ***************************** JSON *****************************
+
+JSONBufferWriter::JSONBufferWriter(char* buffer, size_t size) : buf(buffer), size(size), written(0), needsComma(false) {}
+
+JSONBufferWriter& JSONBufferWriter::beginObject() {
+    separate();
+    append("{");
+    needsComma = false;
+    return *this;
+}
+
+JSONBufferWriter& JSONBufferWriter::endObject() {
+    append("}");
+    needsComma = true;
+    return *this;
+}
+
+JSONBufferWriter& JSONBufferWriter::beginArray() {
+    separate();
+    append("[");
+    needsComma = false;
+    return *this;
+}
+
+JSONBufferWriter& JSONBufferWriter::endArray() {
+    append("]");
+    needsComma = true;
+    return *this;
+}
+
+JSONBufferWriter& JSONBufferWriter::name(const char* name) {
+    separate();
+    append("\"%s\":", name);
+    needsComma = false;
+    return *this;
+}
+
+JSONBufferWriter& JSONBufferWriter::value(bool value) {
+    separate();
+    append(value ? "true" : "false");
+    needsComma = true;
+    return *this;
+}
+
+JSONBufferWriter& JSONBufferWriter::value(int value) {
+    separate();
+    append("%d", value);
+    needsComma = true;
+    return *this;
+}
+
+JSONBufferWriter& JSONBufferWriter::value(unsigned value) {
+    separate();
+    append("%u", value);
+    needsComma = true;
+    return *this;
+}
+
+JSONBufferWriter& JSONBufferWriter::value(long value) {
+    separate();
+    append("%ld", value);
+    needsComma = true;
+    return *this;
+}
+
+JSONBufferWriter& JSONBufferWriter::value(unsigned long value) {
+    separate();
+    append("%lu", value);
+    needsComma = true;
+    return *this;
+}
+
+JSONBufferWriter& JSONBufferWriter::value(double value) {
+    separate();
+    append("%g", value);
+    needsComma = true;
+    return *this;
+}
+
+JSONBufferWriter& JSONBufferWriter::value(const char* value) {
+    separate();
+    append("\"%s\"", value);
+    needsComma = true;
+    return *this;
+}
+
+void JSONBufferWriter::separate() {
+    if (needsComma) {
+        append(",");
+        needsComma = false;
+    }
+}
+
+// Like Device OS, output past the end of the buffer is dropped but still counted in dataSize()
+void JSONBufferWriter::append(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    size_t space = (written < size) ? size - written : 0;
+    int n = vsnprintf(buf + written, space, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        written += (size_t)n;
+    }
+}
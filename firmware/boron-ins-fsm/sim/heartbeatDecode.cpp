@@ -0,0 +1,155 @@
+/* heartbeatDecode.cpp - Decodes the compact heartbeat published with Heartbeat_Format 1
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "heartbeatDecode.h"
+
+#include <string.h>
+
+// ***************************** Local functions *****************************
+
+static int z85Value(char digit) {
+    const char* found = (digit != '\0') ? strchr(heartbeatZ85Digits, digit) : nullptr;
+    return (found != nullptr) ? (int)(found - heartbeatZ85Digits) : -1;
+}
+
+static uint16_t getU16(const uint8_t*& in) {
+    uint16_t value = (uint16_t)(in[0] | (in[1] << 8));
+    in += 2;
+    return value;
+}
+
+static uint32_t getU32(const uint8_t*& in) {
+    uint32_t value = (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+    in += 4;
+    return value;
+}
+
+static float getFloat(const uint8_t*& in) {
+    uint32_t bits = getU32(in);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void getQueue(const uint8_t*& in, HeartbeatQueue& queue) {
+    queue.overflows = getU32(in);
+    queue.highWaterMark = getU16(in);
+    queue.meanOccupancy = getU16(in);
+}
+
+static void getNoiseFloor(const uint8_t*& in, NoiseFloorSuggestion& noiseFloor) {
+    noiseFloor.sampleCount = getU32(in);
+    noiseFloor.p50 = getFloat(in);
+    noiseFloor.p99 = getFloat(in);
+    noiseFloor.stillnessThreshold = getU16(in);
+    noiseFloor.occupancyThreshold = getU16(in);
+}
+
+// ***************************** Public functions *****************************
+
+size_t decodeZ85(const char* text, size_t length, uint8_t* out, size_t size) {
+    if (length % 5 != 0 || length / 5 * 4 > size) {
+        return 0;
+    }
+
+    size_t decoded = 0;
+    for (size_t i = 0; i < length; i += 5) {
+        uint64_t value = 0;
+        for (size_t digit = 0; digit < 5; digit++) {
+            int digitValue = z85Value(text[i + digit]);
+            if (digitValue < 0) {
+                return 0;
+            }
+            value = value * 85 + (uint64_t)digitValue;
+        }
+        if (value > 0xFFFFFFFF) {
+            return 0;
+        }
+        out[decoded++] = (uint8_t)(value >> 24);
+        out[decoded++] = (uint8_t)(value >> 16);
+        out[decoded++] = (uint8_t)(value >> 8);
+        out[decoded++] = (uint8_t)value;
+    }
+    return decoded;
+}
+
+// Schema 2 and 3 histograms from offset, which must end in the last group of 4 bytes
+static bool getHistograms(const uint8_t* in, size_t offset, size_t length, HeartbeatRecord& record) {
+    for (int occupancy = 0; occupancy < INS_OCCUPANCY_COUNT; occupancy++) {
+        InsHistogramSnapshot& histogram = record.insHistogram[occupancy];
+        if (offset + 2 > length) {
+            return false;
+        }
+        histogram.first = in[offset++];
+        histogram.span = in[offset++];
+        if (histogram.first + histogram.span > INS_HISTOGRAM_BUCKETS || offset + histogram.span > length) {
+            return false;
+        }
+        memcpy(histogram.counts, in + offset, histogram.span);
+        offset += histogram.span;
+    }
+    return length - offset < 4;
+}
+
+bool decodeCompactHeartbeat(const char* data, HeartbeatRecord& record) {
+    size_t length = strlen(data);
+    if (data[0] != HEARTBEAT_COMPACT_PREFIX || length < 1 + HEARTBEAT_COMPACT_SCHEMA1_BYTES / 4 * 5) {
+        return false;
+    }
+
+    uint8_t bytes[HEARTBEAT_COMPACT_MAX_BYTES];
+    size_t byteCount = decodeZ85(data + 1, length - 1, bytes, sizeof(bytes));
+    if (byteCount < HEARTBEAT_COMPACT_SCHEMA1_BYTES) {
+        return false;
+    }
+
+    memset(record.insHistogram, 0, sizeof(record.insHistogram));
+    memset(&record.noiseFloor, 0, sizeof(record.noiseFloor));
+    if (bytes[0] == 1) {
+        if (byteCount != HEARTBEAT_COMPACT_SCHEMA1_BYTES) {
+            return false;
+        }
+    }
+    else if (bytes[0] == 2) {
+        if (!getHistograms(bytes, HEARTBEAT_COMPACT_SCHEMA1_BYTES, byteCount, record)) {
+            return false;
+        }
+    }
+    else if (bytes[0] == HEARTBEAT_SCHEMA_ID && byteCount >= HEARTBEAT_COMPACT_FIXED_BYTES &&
+             getHistograms(bytes, HEARTBEAT_COMPACT_FIXED_BYTES, byteCount, record)) {
+        const uint8_t* noiseFloor = bytes + HEARTBEAT_COMPACT_SCHEMA1_BYTES;
+        getNoiseFloor(noiseFloor, record.noiseFloor);
+    }
+    else {
+        return false;
+    }
+
+    const uint8_t* in = bytes + 1;
+    uint8_t flags = *in++;
+    record.doorHeard = (flags & HEARTBEAT_FLAG_DOOR_HEARD) != 0;
+    record.doorLowBattery = (flags & HEARTBEAT_FLAG_DOOR_LOW_BATTERY) != 0;
+    record.doorTampered = (flags & HEARTBEAT_FLAG_DOOR_TAMPERED) != 0;
+    record.isINSZero = (flags & HEARTBEAT_FLAG_INS_ZERO) != 0;
+    record.doorMissedFrequently = (flags & HEARTBEAT_FLAG_DOOR_MISSED_FREQUENTLY) != 0;
+    record.resetReason = getU16(in);
+    record.doorLastMessage = getU32(in);
+    record.insReaderLoad = getU16(in);
+    record.consecutiveOpenDoorHeartbeatCount = getU16(in);
+    record.doorMissedCount = getU16(in);
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        record.latency[stage].count = getU32(in);
+        record.latency[stage].p50 = getU32(in);
+        record.latency[stage].p99 = getU32(in);
+        record.latency[stage].max = getU32(in);
+    }
+    getQueue(in, record.insQueue);
+    getQueue(in, record.bleQueue);
+    record.insMagnitude = getFloat(in);
+    record.insFramesParsed = getU32(in);
+    record.insChecksumErrors = getU32(in);
+    record.insFramingErrors = getU32(in);
+    record.insBytesDiscarded = getU32(in);
+    return true;
+}
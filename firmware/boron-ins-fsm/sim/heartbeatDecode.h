@@ -0,0 +1,29 @@
+/* heartbeatDecode.h - Decodes the compact heartbeat published with Heartbeat_Format 1
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Host only. The layouts come from heartbeatEncoding.h, so a new schema ID needs a case
+ * here before its heartbeats can be read.
+ */
+
+#ifndef HEARTBEAT_DECODE_H
+#define HEARTBEAT_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "heartbeatEncoding.h"
+
+// ***************************** Function declarations *****************************
+
+// Reverses Z85 text whose length is a multiple of 5. Returns the decoded length, or 0 if
+// the text has a character outside the alphabet, a group over 2^32 - 1 or does not fit.
+size_t decodeZ85(const char* text, size_t length, uint8_t* out, size_t size);
+
+// Decodes the published data of a compact heartbeat of schema 1, 2 or 3. The fields an
+// older schema does not have, the histograms before 2 and the noise floor before 3, are
+// left empty. Returns false if it is not one, is cut short or has
+// a schema ID this decoder does not know.
+bool decodeCompactHeartbeat(const char* data, HeartbeatRecord& record);
+
+#endif
@@ -0,0 +1,75 @@
+/* heartbeatDecodeMain.cpp - Expands compact heartbeats in a publish log into JSON
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Usage: braveHeartbeatDecode [--all] [FILE]
+ *
+ * FILE is a publish log, one "ms<TAB>event<TAB>data" line per event as braveSim --out
+ * writes it, or lines of event data alone. Each compact heartbeat is replaced by the JSON
+ * heartbeat the firmware would have published, and every other line is passed through.
+ * --all adds the fields only the compact format carries. Reads stdin without FILE.
+ */
+
+#include "heartbeatDecode.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    bool withCompactFields = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--all") == 0) {
+            withCompactFields = true;
+        }
+        else if (path == nullptr && argv[i][0] != '-') {
+            path = argv[i];
+        }
+        else {
+            fprintf(stderr, "Usage: braveHeartbeatDecode [--all] [FILE]\n");
+            return 2;
+        }
+    }
+
+    FILE* file = (path != nullptr) ? fopen(path, "r") : stdin;
+    if (file == nullptr) {
+        fprintf(stderr, "heartbeatDecode: cannot open %s\n", path);
+        return 1;
+    }
+
+    int badHeartbeats = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        std::string text(line);
+        bool hasNewline = !text.empty() && text.back() == '\n';
+        if (hasNewline) {
+            text.pop_back();
+        }
+
+        size_t dataStart = text.rfind('\t');
+        dataStart = (dataStart == std::string::npos) ? 0 : dataStart + 1;
+        if (text.compare(0, 1, "#") == 0 || text.compare(dataStart, 1, std::string(1, HEARTBEAT_COMPACT_PREFIX)) != 0) {
+            fputs(line, stdout);
+            continue;
+        }
+
+        HeartbeatRecord record;
+        if (!decodeCompactHeartbeat(text.c_str() + dataStart, record)) {
+            fprintf(stdout, "%s\t(bad compact heartbeat)\n", text.c_str());
+            badHeartbeats++;
+            continue;
+        }
+
+        // The histograms from --all take more than a Particle event
+        char json[16384];
+        JsonWriter writer(json, sizeof(json));
+        writeHeartbeatJson(record, writer, withCompactFields);
+        fprintf(stdout, "%s%s%s", text.substr(0, dataStart).c_str(), writer.c_str(), hasNewline ? "\n" : "");
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+
+    return (badHeartbeats > 0) ? 1 : 0;
+}
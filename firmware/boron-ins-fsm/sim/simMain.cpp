@@ -0,0 +1,144 @@
+/* simMain.cpp - Command line driver for the host firmware simulator
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Usage: braveSim --radar FILE --door FILE [--console FILE] [--out FILE]
+ *                 [--duration MS] [--uptime MS] [--door-heartbeat MS] [--seed N]
+ *                 [--journal DIR] [--outage START_MS:END_MS] [--stall EVERY_MS:LENGTH_MS]
+ *                 [--record-inputs FILE] [--trace FILE] [--verbose]
+ */
+
+#include "simulator.h"
+
+#include <chrono>
+
+// From BraveSensorProductionFirmware.ino
+void setup();
+void loop();
+
+static void printUsage() {
+    fprintf(stderr,
+            "Usage: braveSim --radar FILE --door FILE [options]\n"
+            "  --radar FILE           radar trace, lines of: start_ms period_ms i q noise\n"
+            "  --door FILE            door trace, lines of: ms status control\n"
+            "  --console FILE         console function calls, lines of: ms function argument\n"
+            "  --out FILE             write the publish log here instead of stdout\n"
+            "  --duration MS          simulated run time (default: %d ms past the last trace entry)\n"
+            "  --uptime MS            device uptime at the start of the run, e.g. 4294667296 to roll\n"
+            "                         millis() over 5 minutes in (default: 0)\n"
+            "  --door-heartbeat MS    door sensor heartbeat interval, 0 to disable (default: %d)\n"
+            "  --seed N               radar noise seed (default: 1)\n"
+            "  --journal DIR          keep the alert journal in DIR, e.g. to replay it in a later run\n"
+            "                         (default: a temporary directory removed at the end)\n"
+            "  --outage START:END     the cloud is unreachable from START ms until END ms\n"
+            "  --stall EVERY:LENGTH   block loop() for LENGTH ms once every EVERY ms\n"
+            "  --record-inputs FILE   write the state machine inputs of every tick, for braveFleet\n"
+            "  --trace FILE           write the binary trace records, for braveTraceDecode\n"
+            "  --verbose              echo firmware logs to stderr\n",
+            SIM_DEFAULT_TAIL, SIM_DOOR_HEARTBEAT_INTERVAL);
+}
+
+int main(int argc, char* argv[]) {
+    SimOptions options = {};
+    options.doorHeartbeatIntervalMs = SIM_DOOR_HEARTBEAT_INTERVAL;
+    options.seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "--verbose") == 0) {
+            options.verbose = true;
+            continue;
+        }
+        if (value == nullptr) {
+            printUsage();
+            return 2;
+        }
+
+        if (strcmp(arg, "--radar") == 0) {
+            options.radarTracePath = value;
+        }
+        else if (strcmp(arg, "--door") == 0) {
+            options.doorTracePath = value;
+        }
+        else if (strcmp(arg, "--console") == 0) {
+            options.consoleTracePath = value;
+        }
+        else if (strcmp(arg, "--out") == 0) {
+            options.publishLogPath = value;
+        }
+        else if (strcmp(arg, "--duration") == 0) {
+            options.durationMs = strtoull(value, nullptr, 10);
+        }
+        else if (strcmp(arg, "--uptime") == 0) {
+            options.uptimeMs = strtoull(value, nullptr, 10);
+        }
+        else if (strcmp(arg, "--door-heartbeat") == 0) {
+            options.doorHeartbeatIntervalMs = (uint32_t)strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(arg, "--seed") == 0) {
+            options.seed = (uint32_t)strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(arg, "--record-inputs") == 0) {
+            options.inputRecordPath = value;
+        }
+        else if (strcmp(arg, "--trace") == 0) {
+            options.tracePath = value;
+        }
+        else if (strcmp(arg, "--journal") == 0) {
+            options.journalDir = value;
+        }
+        else if (strcmp(arg, "--outage") == 0) {
+            char* end;
+            options.outageStartMs = strtoull(value, &end, 10);
+            if (*end != ':') {
+                printUsage();
+                return 2;
+            }
+            options.outageEndMs = strtoull(end + 1, nullptr, 10);
+        }
+        else if (strcmp(arg, "--stall") == 0) {
+            char* end;
+            options.stallEveryMs = (uint32_t)strtoul(value, &end, 10);
+            if (*end != ':') {
+                printUsage();
+                return 2;
+            }
+            options.stallLengthMs = (uint32_t)strtoul(end + 1, nullptr, 10);
+        }
+        else {
+            printUsage();
+            return 2;
+        }
+        i++;
+    }
+
+    if (options.radarTracePath == nullptr || options.doorTracePath == nullptr) {
+        printUsage();
+        return 2;
+    }
+    if (!simLoad(options)) {
+        return 1;
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+
+    setup();
+    uint64_t end = simEndTime();
+    while (simMillis() < end) {
+        uint64_t before = simMillis();
+        loop();
+        simRecordInputs();
+        simServiceStall();
+
+        // loop() always delays today, but never let a change to that stall the clock
+        if (simMillis() == before) {
+            simDelay(1);
+        }
+    }
+
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+    simPrintSummary(wall.count());
+    return 0;
+}
@@ -0,0 +1,630 @@
+/* simulator.cpp - Host simulator for the Boron firmware
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "simulator.h"
+#include "alertJournal.h"
+#include "clock.h"
+#include "imDoorSensor.h"
+#include "ins3331.h"
+#include "publishQueue.h"
+#include "stateMachine.h"
+#include "traceLog.h"
+
+#include <deque>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+// ***************************** Traces *****************************
+
+// Radar trace line: start_ms period_ms i q noise
+// From start_ms until the next segment starts, the radar sends one frame every period_ms
+// with I = i and Q = q, each plus uniform noise in [-noise, noise]. Period 0 is silence.
+typedef struct RadarSegment {
+    uint64_t startMs;
+    uint32_t periodMs;
+    int32_t inPhase;
+    int32_t quadrature;
+    int32_t noise;
+} RadarSegment;
+
+// Door trace line: ms status control
+// The door sensor advertises the given event data (status) and control bytes at ms
+typedef struct DoorEvent {
+    uint64_t ms;
+    uint8_t status;
+    uint8_t controlByte;
+} DoorEvent;
+
+// Console trace line: ms function argument
+typedef struct ConsoleCall {
+    uint64_t ms;
+    std::string function;
+    std::string argument;
+} ConsoleCall;
+
+// A firmware thread, run one pass at a time on its own schedule
+typedef struct SimThread {
+    const char* name;
+    void (*service)(void);
+    uint32_t intervalMs;
+    uint64_t nextRunMs;
+} SimThread;
+
+static SimOptions options;
+static SimStats stats;
+
+static std::vector<RadarSegment> radarSegments;
+static std::vector<DoorEvent> doorEvents;
+static std::vector<ConsoleCall> consoleCalls;
+static std::vector<SimThread> threads;
+static std::map<std::string, int (*)(String)> consoleFunctions;
+static std::map<std::string, uint32_t> publishCounts;
+
+// Milliseconds since the start of the run. The firmware's clock reads uptimeMs + now.
+static uint64_t now = 0;
+static bool pumping = false;
+static FILE* publishLog = stdout;
+static FILE* inputRecord = nullptr;
+static FILE* traceOutput = nullptr;
+static uint32_t inputsRecorded = 0;
+static LogLevel logLevel = LOG_LEVEL_WARN;
+static std::mt19937 noise;
+
+// Radar model
+static bool radarRunning = false;
+static size_t radarSegment = 0;
+static uint64_t radarNextFrameMs = UINT64_MAX;
+static std::deque<uint8_t> serialRxBuffer;
+static size_t serialRxBufferSize = 64;
+
+// Door sensor model
+static size_t nextDoorEvent = 0;
+static uint8_t doorStatus = CLOSED;
+static uint8_t doorControlByte = 0x00;
+static uint64_t doorNextHeartbeatMs = UINT64_MAX;
+
+static size_t nextConsoleCall = 0;
+
+// Injected loop() stalls
+static uint64_t nextStallMs = UINT64_MAX;
+
+// Alert journal directory, removed at the end of the run if the simulator made it
+static std::string journalDir;
+static bool removeJournalDir = false;
+
+static void setNow(uint64_t ms) {
+    now = ms;
+    VirtualClock::set(options.uptimeMs + now);
+}
+
+// ***************************** Loading *****************************
+
+// Read a trace file, dropping # comments and blank lines. Returns false if it can't be opened.
+static bool readTraceLines(const char* path, std::vector<std::string>& lines) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        fprintf(stderr, "sim: cannot open %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        char* start = line;
+        while (*start == ' ' || *start == '\t') {
+            start++;
+        }
+        if (*start == '#' || *start == '\n' || *start == '\r' || *start == '\0') {
+            continue;
+        }
+        start[strcspn(start, "#\r\n")] = '\0';
+        lines.push_back(start);
+    }
+    fclose(file);
+    return true;
+}
+
+static bool loadRadarTrace(const char* path) {
+    std::vector<std::string> lines;
+    if (!readTraceLines(path, lines)) {
+        return false;
+    }
+
+    for (const std::string& line : lines) {
+        unsigned long long startMs;
+        unsigned long periodMs;
+        long inPhase, quadrature, noiseAmplitude;
+        if (sscanf(line.c_str(), "%llu %lu %ld %ld %ld", &startMs, &periodMs, &inPhase, &quadrature, &noiseAmplitude) != 5 ||
+            (!radarSegments.empty() && startMs < radarSegments.back().startMs)) {
+            fprintf(stderr, "sim: %s: bad radar segment '%s'\n", path, line.c_str());
+            return false;
+        }
+        radarSegments.push_back({startMs, (uint32_t)periodMs, (int32_t)inPhase, (int32_t)quadrature, (int32_t)noiseAmplitude});
+    }
+    return true;
+}
+
+static bool loadDoorTrace(const char* path) {
+    std::vector<std::string> lines;
+    if (!readTraceLines(path, lines)) {
+        return false;
+    }
+
+    for (const std::string& line : lines) {
+        unsigned long long ms;
+        int status, controlByte;
+        bool valid = sscanf(line.c_str(), "%llu %i %i", &ms, &status, &controlByte) == 3 && status >= 0 && status <= 0xFF &&
+                     controlByte >= 0 && controlByte <= 0xFF;
+        if (!valid || (!doorEvents.empty() && ms < doorEvents.back().ms)) {
+            fprintf(stderr, "sim: %s: bad door event '%s'\n", path, line.c_str());
+            return false;
+        }
+        doorEvents.push_back({ms, (uint8_t)status, (uint8_t)controlByte});
+    }
+    return true;
+}
+
+static bool loadConsoleTrace(const char* path) {
+    std::vector<std::string> lines;
+    if (!readTraceLines(path, lines)) {
+        return false;
+    }
+
+    for (const std::string& line : lines) {
+        unsigned long long ms;
+        char function[64];
+        int consumed = 0;
+        if (sscanf(line.c_str(), "%llu %63s %n", &ms, function, &consumed) < 2 ||
+            (!consoleCalls.empty() && ms < consoleCalls.back().ms)) {
+            fprintf(stderr, "sim: %s: bad console call '%s'\n", path, line.c_str());
+            return false;
+        }
+        std::string argument = line.substr(consumed);
+        argument.erase(argument.find_last_not_of(" \t") + 1);
+        consoleCalls.push_back({ms, function, argument});
+    }
+    return true;
+}
+
+// Schedule the first frame of the first segment at or after index that is not silent
+static void scheduleRadarFrom(size_t index) {
+    radarNextFrameMs = UINT64_MAX;
+    for (radarSegment = index; radarSegment < radarSegments.size(); radarSegment++) {
+        if (radarSegments[radarSegment].periodMs > 0) {
+            radarNextFrameMs = radarSegments[radarSegment].startMs;
+            return;
+        }
+    }
+}
+
+bool simLoad(const SimOptions& simOptions) {
+    options = simOptions;
+    memset(&stats, 0, sizeof(stats));
+    noise.seed(options.seed);
+
+    if (!loadRadarTrace(options.radarTracePath) || !loadDoorTrace(options.doorTracePath)) {
+        return false;
+    }
+    if (options.consoleTracePath != nullptr && !loadConsoleTrace(options.consoleTracePath)) {
+        return false;
+    }
+
+    if (options.publishLogPath != nullptr) {
+        publishLog = fopen(options.publishLogPath, "w");
+        if (publishLog == nullptr) {
+            fprintf(stderr, "sim: cannot write %s\n", options.publishLogPath);
+            return false;
+        }
+    }
+
+    if (options.inputRecordPath != nullptr) {
+        inputRecord = fopen(options.inputRecordPath, "w");
+        if (inputRecord == nullptr) {
+            fprintf(stderr, "sim: cannot write %s\n", options.inputRecordPath);
+            return false;
+        }
+        fprintf(inputRecord, "# ms door_status door_open door_unknown door_closed ins_magnitude\n");
+    }
+
+    if (options.tracePath != nullptr) {
+        traceOutput = fopen(options.tracePath, "wb");
+        if (traceOutput == nullptr) {
+            fprintf(stderr, "sim: cannot write %s\n", options.tracePath);
+            return false;
+        }
+    }
+
+    if (options.journalDir != nullptr) {
+        journalDir = options.journalDir;
+    }
+    else {
+        char pattern[] = "/tmp/braveSimJournalXXXXXX";
+        if (mkdtemp(pattern) == nullptr) {
+            fprintf(stderr, "sim: cannot create a journal directory\n");
+            return false;
+        }
+        journalDir = pattern;
+        removeJournalDir = true;
+    }
+
+    // Size the UART receive buffer the way Device OS would, from the firmware's hook
+    hal_usart_buffer_config_t config = acquireSerial1Buffer();
+    serialRxBufferSize = config.rx_buffer_size;
+    delete[](uint8_t*) config.rx_buffer;
+    delete[](uint8_t*) config.tx_buffer;
+
+    setNow(0);
+    scheduleRadarFrom(0);
+    if (options.doorHeartbeatIntervalMs > 0) {
+        doorNextHeartbeatMs = options.doorHeartbeatIntervalMs;
+    }
+    if (options.stallEveryMs > 0) {
+        nextStallMs = options.stallEveryMs;
+    }
+    return true;
+}
+
+uint64_t simEndTime() {
+    if (options.durationMs > 0) {
+        return options.durationMs;
+    }
+
+    uint64_t last = 0;
+    if (!radarSegments.empty()) {
+        last = radarSegments.back().startMs;
+    }
+    if (!doorEvents.empty() && doorEvents.back().ms > last) {
+        last = doorEvents.back().ms;
+    }
+    if (!consoleCalls.empty() && consoleCalls.back().ms > last) {
+        last = consoleCalls.back().ms;
+    }
+    return last + SIM_DEFAULT_TAIL;
+}
+
+// ***************************** Virtual clock *****************************
+
+uint64_t simMillis() {
+    return now;
+}
+
+static void sendRadarFrame() {
+    const RadarSegment& segment = radarSegments[radarSegment];
+
+    if (!radarRunning) {
+        stats.radarFramesDropped++;
+    }
+    else {
+        std::uniform_int_distribution<int32_t> jitter(-segment.noise, segment.noise);
+        int32_t inPhase = segment.inPhase + (segment.noise > 0 ? jitter(noise) : 0);
+        int32_t quadrature = segment.quadrature + (segment.noise > 0 ? jitter(noise) : 0);
+        inPhase = (inPhase > INT16_MAX) ? INT16_MAX : (inPhase < INT16_MIN) ? INT16_MIN : inPhase;
+        quadrature = (quadrature > INT16_MAX) ? INT16_MAX : (quadrature < INT16_MIN) ? INT16_MIN : quadrature;
+
+        uint8_t frame[INS_FRAME_LENGTH] = {0};
+        frame[0] = INS_FRAME_START;
+        frame[INS_FRAME_I_HIGH_INDEX] = (uint8_t)((uint16_t)inPhase >> 8);
+        frame[INS_FRAME_I_HIGH_INDEX + 1] = (uint8_t)inPhase;
+        frame[INS_FRAME_Q_HIGH_INDEX] = (uint8_t)((uint16_t)quadrature >> 8);
+        frame[INS_FRAME_Q_HIGH_INDEX + 1] = (uint8_t)quadrature;
+        for (int i = 1; i < INS_FRAME_CHECKSUM_INDEX; i++) {
+            frame[INS_FRAME_CHECKSUM_INDEX] += frame[i];
+        }
+        frame[INS_FRAME_LENGTH - 1] = INS_FRAME_END;
+
+        for (size_t i = 0; i < sizeof(frame); i++) {
+            if (serialRxBuffer.size() < serialRxBufferSize) {
+                serialRxBuffer.push_back(frame[i]);
+            }
+            else {
+                stats.uartOverflowBytes++;
+            }
+        }
+        stats.radarFramesSent++;
+    }
+
+    radarNextFrameMs += segment.periodMs;
+    if (radarSegment + 1 < radarSegments.size() && radarNextFrameMs >= radarSegments[radarSegment + 1].startMs) {
+        scheduleRadarFrom(radarSegment + 1);
+    }
+}
+
+static void runConsoleCall(const ConsoleCall& call) {
+    stats.consoleCalls++;
+    auto function = consoleFunctions.find(call.function);
+    if (function == consoleFunctions.end()) {
+        fprintf(publishLog, "# %llu %s(%s) is not a registered console function\n", (unsigned long long)now, call.function.c_str(),
+                call.argument.c_str());
+        return;
+    }
+
+    int result = function->second(String(call.argument.c_str()));
+    fprintf(publishLog, "# %llu %s(%s) returned %d\n", (unsigned long long)now, call.function.c_str(), call.argument.c_str(), result);
+}
+
+static uint64_t nextEventTime() {
+    uint64_t next = radarNextFrameMs;
+    if (nextConsoleCall < consoleCalls.size() && consoleCalls[nextConsoleCall].ms < next) {
+        next = consoleCalls[nextConsoleCall].ms;
+    }
+    for (const SimThread& thread : threads) {
+        if (thread.nextRunMs < next) {
+            next = thread.nextRunMs;
+        }
+    }
+    return next;
+}
+
+// Advance the clock, running everything that falls due on the way in time order. A delay()
+// from inside a thread pass or console call just moves the clock; the outer delay() picks up
+// anything it skipped over.
+void simDelay(uint32_t ms) {
+    uint64_t target = now + ms;
+    if (pumping) {
+        setNow(target);
+        return;
+    }
+
+    pumping = true;
+    while (true) {
+        uint64_t next = nextEventTime();
+        if (next > target) {
+            break;
+        }
+        if (next > now) {
+            setNow(next);
+        }
+
+        while (radarNextFrameMs <= now) {
+            sendRadarFrame();
+        }
+        while (nextConsoleCall < consoleCalls.size() && consoleCalls[nextConsoleCall].ms <= now) {
+            runConsoleCall(consoleCalls[nextConsoleCall++]);
+        }
+        for (SimThread& thread : threads) {
+            if (thread.nextRunMs <= now) {
+                thread.service();
+                thread.nextRunMs += thread.intervalMs;
+            }
+        }
+    }
+    if (target > now) {
+        setNow(target);
+    }
+    pumping = false;
+}
+
+// Called between loop() passes. The application thread blocks, e.g. on a cellular reconnect
+// or an EEPROM write, while the other threads and the radar carry on.
+void simServiceStall() {
+    if (now < nextStallMs) {
+        return;
+    }
+    stats.stalls++;
+    simDelay(options.stallLengthMs);
+    nextStallMs += options.stallEveryMs;
+}
+
+// Called between loop() passes. Writes the inputs of the state machine tick the pass ran, if
+// it ran one, so braveFleet can replay them into other instances.
+void simRecordInputs() {
+    const StateMachineTick& tick = stateMachine.lastTick();
+    if (inputRecord == nullptr || tick.count == inputsRecorded) {
+        return;
+    }
+
+    inputsRecorded = tick.count;
+    fprintf(inputRecord, "%lu 0x%02X %d %d %d %.9g\n", (unsigned long)tick.time, tick.inputs.doorStatus, tick.inputs.isDoorOpen,
+            tick.inputs.isDoorStatusUnknown, tick.inputs.isDoorClosedEvent, tick.inputs.insMagnitude);
+}
+
+// ***************************** Shim hooks *****************************
+
+void simStartThread(const char* name) {
+    static const SimThread known[] = {
+        {"readINSThread", serviceINSReader, INS_READER_WAIT_INTERVAL, 0},
+        {"filterINSThread", serviceINSFilter, INS_FILTER_WAIT_INTERVAL, 0},
+        {"scanBLEThread", serviceBLEScanner, SIM_BLE_SCAN_INTERVAL, 0},
+    };
+
+    for (const SimThread& thread : known) {
+        if (strcmp(thread.name, name) == 0) {
+            threads.push_back(thread);
+            threads.back().nextRunMs = now;
+            return;
+        }
+    }
+
+    fprintf(stderr, "sim: no service function for thread '%s'\n", name);
+    exit(1);
+}
+
+int simSerialAvailable() {
+    return (int)serialRxBuffer.size();
+}
+
+size_t simSerialRead(uint8_t* buffer, size_t length) {
+    size_t n = (length < serialRxBuffer.size()) ? length : serialRxBuffer.size();
+    for (size_t i = 0; i < n; i++) {
+        buffer[i] = serialRxBuffer.front();
+        serialRxBuffer.pop_front();
+    }
+    return n;
+}
+
+// Commands to the radar: [WAKEUP_BYTE][START][0x80][0x01][function code]...
+// USB serial is connected only when there is a trace file to write it to
+bool simUsbConnected() {
+    return traceOutput != nullptr;
+}
+
+void simUsbWrite(const uint8_t* buffer, size_t length) {
+    if (traceOutput != nullptr) {
+        fwrite(buffer, 1, length, traceOutput);
+    }
+}
+
+void simSerialWrite(const uint8_t* buffer, size_t length) {
+    if (length < 5 || buffer[0] != WAKEUP_BYTE || buffer[1] != START_DELIMITER) {
+        return;
+    }
+    if (buffer[4] == APPLICATION_START) {
+        radarRunning = true;
+    }
+    else if (buffer[4] == APPLICATION_STOP) {
+        radarRunning = false;
+        serialRxBuffer.clear();
+    }
+}
+
+static void addDoorScanResult(spark::Vector<BleScanResult>& results, uint8_t status, uint8_t controlByte) {
+    // See serviceBLEScanner() for the advertising data layout
+    uint8_t advertisingData[7] = {0x01, globalDoorID.byte3, globalDoorID.byte2, globalDoorID.byte1, 0x01, status, controlByte};
+    BleScanResult result;
+    result.advertisingData(advertisingData, sizeof(advertisingData));
+    results.append(result);
+}
+
+void simScanDoor(spark::Vector<BleScanResult>& results) {
+    while (nextDoorEvent < doorEvents.size() && doorEvents[nextDoorEvent].ms <= now) {
+        const DoorEvent& event = doorEvents[nextDoorEvent++];
+        doorStatus = event.status & ~HEARTBEAT;
+        doorControlByte = event.controlByte;
+        addDoorScanResult(results, event.status, event.controlByte);
+        stats.doorEventsSent++;
+    }
+
+    // Heartbeats repeat the last door state with the heartbeat bit set
+    if (doorNextHeartbeatMs <= now) {
+        addDoorScanResult(results, doorStatus | HEARTBEAT, doorControlByte);
+        stats.doorHeartbeatsSent++;
+        while (doorNextHeartbeatMs <= now) {
+            doorNextHeartbeatMs += options.doorHeartbeatIntervalMs;
+        }
+    }
+}
+
+bool simCloudConnected() {
+    return now < options.outageStartMs || now >= options.outageEndMs;
+}
+
+uint32_t simWallTime() {
+    return SIM_WALL_CLOCK_START + (uint32_t)(now / 1000);
+}
+
+const char* simJournalDir() {
+    return journalDir.c_str();
+}
+
+void simPublish(const char* eventName, const char* data) {
+    fprintf(publishLog, "%llu\t%s\t%s\n", (unsigned long long)now, eventName, data);
+    publishCounts[eventName]++;
+    stats.publishes++;
+}
+
+void simRegisterFunction(const char* name, int (*function)(String)) {
+    consoleFunctions[name] = function;
+}
+
+void simSetLogLevel(LogLevel level) {
+    logLevel = level;
+}
+
+bool simIsLogEnabled(LogLevel level) {
+    return options.verbose && level >= logLevel;
+}
+
+void simLog(LogLevel level, const char* fmt, va_list args) {
+    if (!simIsLogEnabled(level)) {
+        return;
+    }
+    const char* name = (level >= LOG_LEVEL_ERROR) ? "ERROR" : (level >= LOG_LEVEL_WARN) ? "WARN" : "INFO";
+    fprintf(stderr, "%010llu [%s] ", (unsigned long long)now, name);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+}
+
+// The simulator does not model reboots, the reset is recorded and the run carries on
+void simSystemReset() {
+    stats.resets++;
+    fprintf(publishLog, "# %llu System.reset()\n", (unsigned long long)now);
+}
+
+// ***************************** Summary *****************************
+
+void simPrintSummary(double wallSeconds) {
+    if (publishLog != stdout) {
+        fclose(publishLog);
+    }
+    if (inputRecord != nullptr) {
+        fclose(inputRecord);
+    }
+    if (traceOutput != nullptr) {
+        fclose(traceOutput);
+    }
+
+    uint64_t seconds = now / 1000;
+    fprintf(stderr, "Simulated %llud %02llu:%02llu:%02llu in %.2f s (%.0fx real time)\n", (unsigned long long)(seconds / 86400),
+            (unsigned long long)(seconds / 3600 % 24), (unsigned long long)(seconds / 60 % 60), (unsigned long long)(seconds % 60), wallSeconds,
+            (wallSeconds > 0) ? (now / 1000.0) / wallSeconds : 0.0);
+
+    fprintf(stderr, "Publishes: %lu\n", (unsigned long)stats.publishes);
+    for (const auto& count : publishCounts) {
+        fprintf(stderr, "  %-28s %lu\n", count.first.c_str(), (unsigned long)count.second);
+    }
+
+    InsFrameParserStats parser = getINSFrameParserStats();
+    SpscRingStats insQueue = getINSQueueStats();
+    SpscRingStats bleQueue = getBLEQueueStats();
+    fprintf(stderr, "Radar: %lu frames sent, %lu while stopped, %lu bytes lost to UART overflow\n", (unsigned long)stats.radarFramesSent,
+            (unsigned long)stats.radarFramesDropped, (unsigned long)stats.uartOverflowBytes);
+    fprintf(stderr, "Parser: %lu frames, %lu framing errors, %lu checksum errors\n", (unsigned long)parser.framesParsed,
+            (unsigned long)parser.framingErrors, (unsigned long)parser.checksumErrors);
+    fprintf(stderr, "Door: %lu events, %lu heartbeats\n", (unsigned long)stats.doorEventsSent, (unsigned long)stats.doorHeartbeatsSent);
+    fprintf(stderr, "Queues: INS high water %lu/%lu, %lu overflows; BLE high water %lu/%lu, %lu overflows\n",
+            (unsigned long)insQueue.highWaterMark, (unsigned long)insQueue.capacity, (unsigned long)insQueue.overflows,
+            (unsigned long)bleQueue.highWaterMark, (unsigned long)bleQueue.capacity, (unsigned long)bleQueue.overflows);
+    if (traceOutput != nullptr) {
+        TraceStats trace = getTraceStats();
+        fprintf(stderr, "Trace: %lu records, %lu dropped\n", (unsigned long)trace.records, (unsigned long)trace.dropped);
+    }
+
+    PublishQueueStats publishQueue = getPublishQueueStats();
+    AlertJournalStats journal = getAlertJournalStats();
+    fprintf(stderr, "Publish queue: high water %lu/%d, %lu failed attempts, %lu dropped, %lu rate limited passes\n",
+            (unsigned long)publishQueue.highWaterMark, PUBLISH_QUEUE_SLOTS, (unsigned long)publishQueue.failedAttempts,
+            (unsigned long)publishQueue.dropped, (unsigned long)publishQueue.rateLimited);
+    fprintf(stderr, "Alert journal: %lu alerts, %lu pending, %lu bytes\n", (unsigned long)(journal.nextSequence - 1),
+            (unsigned long)journal.pending, (unsigned long)journal.fileSize);
+
+    StateTransitionCount transitions[32];
+    size_t numTransitions = stateMachine.getTransitionCounts(transitions, sizeof(transitions) / sizeof(transitions[0]));
+    fprintf(stderr, "State transitions:\n");
+    for (size_t i = 0; i < numTransitions && i < sizeof(transitions) / sizeof(transitions[0]); i++) {
+        if (transitions[i].count > 0) {
+            fprintf(stderr, "  %d -> %d  %-44s %lu\n", transitions[i].from, transitions[i].to, transitions[i].reason,
+                    (unsigned long)transitions[i].count);
+        }
+    }
+    if (stats.stalls > 0) {
+        fprintf(stderr, "Stalls: loop() blocked %lu times for %lu ms\n", (unsigned long)stats.stalls,
+                (unsigned long)options.stallLengthMs);
+    }
+    if (options.outageEndMs > options.outageStartMs) {
+        fprintf(stderr, "Cloud outage: %llu ms to %llu ms\n", (unsigned long long)options.outageStartMs,
+                (unsigned long long)options.outageEndMs);
+    }
+    if (stats.consoleCalls > 0 || stats.resets > 0) {
+        fprintf(stderr, "Console calls: %lu, resets requested: %lu\n", (unsigned long)stats.consoleCalls, (unsigned long)stats.resets);
+    }
+
+    if (removeJournalDir) {
+        unlink((journalDir + "/" + ALERT_JOURNAL_FILE_NAME).c_str());
+        rmdir(journalDir.c_str());
+    }
+}
@@ -0,0 +1,88 @@
+/* simulator.h - Host simulator for the Boron firmware
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Runs the real setup()/loop() against the virtual clock (see clock.h). Time only moves
+ * when the firmware calls delay(), and each delay() runs whatever was due in the meantime:
+ * radar frames written into the Serial1 receive buffer, passes of the firmware threads and
+ * console function calls. Door events are handed to the BLE scanner pass as scan results.
+ */
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include "Particle.h"
+
+// ***************************** Macro definitions *****************************
+
+#define SIM_BLE_SCAN_INTERVAL       50        // setScanTimeout(5) in threadBLEScanner(), in 10 ms units
+#define SIM_DOOR_HEARTBEAT_INTERVAL 600000    // IM door sensors send a heartbeat every 10 mins
+#define SIM_DEFAULT_TAIL            60000     // Run this long past the last trace entry by default
+#define SIM_USB_TX_BUFFER           256       // Bytes USBSerial takes per write
+#define SIM_WALL_CLOCK_START        1735689600  // Time.now() at the start of the run, 2025-01-01 00:00:00 UTC
+
+// ***************************** Global typedefs *****************************
+
+typedef struct SimOptions {
+    const char* radarTracePath;
+    const char* doorTracePath;
+    const char* consoleTracePath;      // Optional, console function calls
+    const char* publishLogPath;        // nullptr writes the publish log to stdout
+    uint64_t durationMs;               // 0 runs until SIM_DEFAULT_TAIL after the last trace entry
+    uint64_t uptimeMs;                 // Device uptime when the run starts, trace times are relative to it
+    uint32_t doorHeartbeatIntervalMs;  // 0 disables synthesized door heartbeats
+    uint32_t seed;                     // Seed for radar noise, so runs are repeatable
+    const char* journalDir;            // nullptr journals alerts to a fresh temporary directory
+    uint64_t outageStartMs;            // The cloud is unreachable from outageStartMs until outageEndMs
+    uint64_t outageEndMs;
+    uint32_t stallEveryMs;             // Stall loop() for stallLengthMs this often, 0 never stalls
+    uint32_t stallLengthMs;
+    const char* inputRecordPath;       // Optional, state machine inputs of every tick for braveFleet
+    const char* tracePath;             // Optional, USB serial output with the binary trace records
+    bool verbose;                      // Echo firmware logs to stderr
+} SimOptions;
+
+typedef struct SimStats {
+    uint32_t radarFramesSent;
+    uint32_t radarFramesDropped;  // Sent while the radar application was stopped
+    uint32_t uartOverflowBytes;   // Bytes lost because the Serial1 receive buffer was full
+    uint32_t doorEventsSent;
+    uint32_t doorHeartbeatsSent;
+    uint32_t consoleCalls;
+    uint32_t publishes;
+    uint32_t resets;
+    uint32_t stalls;
+} SimStats;
+
+// ***************************** Function declarations *****************************
+
+// Driver, see simMain.cpp
+bool simLoad(const SimOptions& options);
+uint64_t simEndTime(void);
+void simPrintSummary(double wallSeconds);
+
+// Virtual clock, simMillis() is the time since the start of the run
+uint64_t simMillis(void);
+void simDelay(uint32_t ms);
+void simServiceStall(void);
+void simRecordInputs(void);
+
+// Hooks for the Device OS shim
+void simStartThread(const char* name);
+int simSerialAvailable(void);
+size_t simSerialRead(uint8_t* buffer, size_t length);
+void simSerialWrite(const uint8_t* buffer, size_t length);
+bool simUsbConnected(void);
+void simUsbWrite(const uint8_t* buffer, size_t length);
+void simScanDoor(spark::Vector<BleScanResult>& results);
+bool simCloudConnected(void);
+uint32_t simWallTime(void);
+const char* simJournalDir(void);
+void simPublish(const char* eventName, const char* data);
+void simRegisterFunction(const char* name, int (*function)(String));
+void simSetLogLevel(LogLevel level);
+bool simIsLogEnabled(LogLevel level);
+void simLog(LogLevel level, const char* fmt, va_list args);
+void simSystemReset(void);
+
+#endif
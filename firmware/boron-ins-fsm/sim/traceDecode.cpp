@@ -0,0 +1,155 @@
+/* traceDecode.cpp - Expands the binary trace records written by TRACE() on the device
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "traceDecode.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// ***************************** Local functions *****************************
+
+static uint32_t readWord(const uint8_t* bytes) {
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static const char* levelName(TraceLevel level) {
+    return (level == TRACE_LEVEL_ERROR) ? "ERROR" : (level == TRACE_LEVEL_WARN) ? "WARN" : "INFO";
+}
+
+// Formats with snprintf one conversion at a time, giving each the type the device stored.
+// Length modifiers are dropped since every argument is 32 bits.
+static void expandFormat(const char* format, const uint32_t* args, std::string& out) {
+    size_t arg = 0;
+    for (const char* c = format; *c != '\0'; c++) {
+        if (*c != '%') {
+            out += *c;
+            continue;
+        }
+        if (c[1] == '%') {
+            out += '%';
+            c++;
+            continue;
+        }
+
+        std::string spec = "%";
+        for (c++; *c != '\0' && strchr("-+ #0123456789.", *c) != nullptr; c++) {
+            spec += *c;
+        }
+        while (*c != '\0' && strchr("hlLjzt", *c) != nullptr) {
+            c++;
+        }
+        if (*c == '\0') {
+            break;
+        }
+        spec += *c;
+
+        char text[64];
+        uint32_t word = args[arg++];
+        if (*c == 'f' || *c == 'e' || *c == 'g') {
+            float value;
+            memcpy(&value, &word, sizeof(value));
+            snprintf(text, sizeof(text), spec.c_str(), (double)value);
+        }
+        else if (*c == 'd' || *c == 'i' || *c == 'c') {
+            snprintf(text, sizeof(text), spec.c_str(), (int)(int32_t)word);
+        }
+        else {
+            snprintf(text, sizeof(text), spec.c_str(), (unsigned int)word);
+        }
+        out += text;
+    }
+}
+
+// ***************************** Public functions *****************************
+
+size_t decodeCobs(const uint8_t* frame, size_t length, uint8_t* out, size_t size) {
+    size_t outLength = 0;
+    size_t i = 0;
+    while (i < length) {
+        uint8_t code = frame[i++];
+        if (code == 0 || i + code - 1 > length) {
+            return 0;
+        }
+        for (uint8_t n = 1; n < code; n++) {
+            if (outLength == size) {
+                return 0;
+            }
+            out[outLength++] = frame[i++];
+        }
+        // A code below 0xFF stands for a zero, except after the last block
+        if (code != 0xFF && i < length) {
+            if (outLength == size) {
+                return 0;
+            }
+            out[outLength++] = 0;
+        }
+    }
+    return outLength;
+}
+
+bool formatTraceRecord(const uint8_t* record, size_t length, std::string& line) {
+    if (length < 8 || length % 4 != 0) {
+        return false;
+    }
+
+    uint32_t header = readWord(record);
+    uint32_t id = header & 0xFFFF;
+    size_t count = (header >> 16) & 0xFF;
+    if (id >= TRACE_EVENT_COUNT || count > TRACE_MAX_ARGS || length != 4 * (2 + count) ||
+        count != traceArgCount(traceEvents[id].format)) {
+        return false;
+    }
+
+    uint32_t args[TRACE_MAX_ARGS];
+    for (size_t i = 0; i < count; i++) {
+        args[i] = readWord(record + 8 + 4 * i);
+    }
+
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "%010lu [%s] ", (unsigned long)readWord(record + 4), levelName(traceEvents[id].level));
+    line = prefix;
+    expandFormat(traceEvents[id].format, args, line);
+    return true;
+}
+
+std::string decodeTraceStream(const uint8_t* data, size_t length) {
+    std::string out;
+    size_t i = 0;
+    while (i < length) {
+        // Text up to the opening delimiter of the next frame
+        const uint8_t* open = (const uint8_t*)memchr(data + i, 0, length - i);
+        size_t textEnd = (open == nullptr) ? length : (size_t)(open - data);
+        out.append((const char*)data + i, textEnd - i);
+        if (open == nullptr) {
+            break;
+        }
+
+        // A frame cut off at the end of the capture is left out
+        const uint8_t* close = (const uint8_t*)memchr(open + 1, 0, length - textEnd - 1);
+        if (close == nullptr) {
+            break;
+        }
+
+        // Two delimiters in a row close one frame and open the next. Starting again from the
+        // second also finds the frames again in a capture that began inside one.
+        if (close == open + 1) {
+            i = close - data;
+            continue;
+        }
+
+        uint8_t record[TRACE_MAX_RECORD_BYTES];
+        size_t recordLength = decodeCobs(open + 1, close - open - 1, record, sizeof(record));
+        std::string line;
+        if (formatTraceRecord(record, recordLength, line)) {
+            out += line;
+        }
+        else {
+            out += "<bad trace record>";
+        }
+        out += '\n';
+        i = close - data + 1;
+    }
+    return out;
+}
@@ -0,0 +1,33 @@
+/* traceDecode.h - Expands the binary trace records written by TRACE() on the device
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Host only. The formats come from the TRACE_EVENTS table in traceLog.h, so the decoder
+ * must be built from the same source as the firmware that wrote the trace.
+ */
+
+#ifndef TRACE_DECODE_H
+#define TRACE_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#include "traceLog.h"
+
+// ***************************** Function declarations *****************************
+
+// Reverses the COBS encoding of one frame without its delimiters. Returns the decoded
+// length, or 0 if the frame is malformed.
+size_t decodeCobs(const uint8_t* frame, size_t length, uint8_t* out, size_t size);
+
+// Expands one decoded record into a line like the simulator's log lines, e.g.
+// "0000012345 [INFO] State 0: Door Status = 0x02, INS Magnitude = 1.500000". Returns false
+// for a record that does not match the TRACE_EVENTS table.
+bool formatTraceRecord(const uint8_t* record, size_t length, std::string& line);
+
+// Expands every frame in a captured USB serial stream and passes the text logs between
+// them through unchanged. Each record becomes one line ending in '\n'.
+std::string decodeTraceStream(const uint8_t* data, size_t length);
+
+#endif
@@ -0,0 +1,43 @@
+/* traceDecodeMain.cpp - Expands a captured trace into log lines
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Usage: braveTraceDecode [FILE]
+ *
+ * FILE is a capture of the device's USB serial output, e.g. from
+ * `cat /dev/ttyACM0 > trace.bin`, or a trace written by braveSim --trace. Reads stdin
+ * without FILE. The text logs in the capture are passed through between the records.
+ */
+
+#include "traceDecode.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "--help") == 0)) {
+        fprintf(stderr, "Usage: braveTraceDecode [FILE]\n");
+        return 2;
+    }
+
+    FILE* file = (argc == 2) ? fopen(argv[1], "rb") : stdin;
+    if (file == nullptr) {
+        fprintf(stderr, "traceDecode: cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<uint8_t> capture;
+    uint8_t chunk[4096];
+    size_t length;
+    while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        capture.insert(capture.end(), chunk, chunk + length);
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+
+    std::string decoded = decodeTraceStream(capture.data(), capture.size());
+    fwrite(decoded.data(), 1, decoded.size(), stdout);
+    return 0;
+}
@@ -6,21 +6,47 @@
  */
 
 #include "Particle.h"
+#include "alertJournal.h"
+#include "deadlineScheduler.h"
 #include "imDoorSensor.h"
 #include "ins3331.h"
+#include "profiler.h"
+#include "publishQueue.h"
 #include "stateMachine.h"
 #include "consoleFunctions.h"
 #include "tpl5010watchdog.h"
 #include "statusRGB.h"
+#include "traceLog.h"
 
 // See versioning in README.md
 #define BRAVE_FIRMWARE_VERSION  12031
+#ifndef DEBUG_LEVEL
 #define DEBUG_LEVEL             LOG_LEVEL_WARN
+#endif
 
 PRODUCT_VERSION(BRAVE_FIRMWARE_VERSION);
 SerialLogHandler logHandler(DEBUG_LEVEL);
 SYSTEM_THREAD(ENABLED);
 
+#ifdef BRAVE_TRACE_SERIAL
+// Sends the trace records written since the last pass over USB serial, without waiting for
+// the host. Expand a capture with braveTraceDecode, see traceLog.h.
+static void serviceTraceLog() {
+    static uint8_t frames[256];
+    if (!Serial.isConnected()) {
+        return;
+    }
+
+    WITH_LOCK(Serial) {
+        int room = Serial.availableForWrite();
+        if (room > 0) {
+            size_t length = drainTrace(frames, (room < (int)sizeof(frames)) ? (size_t)room : sizeof(frames));
+            Serial.write(frames, length);
+        }
+    }
+}
+#endif
+
 void setup() {
     System.enableFeature(FEATURE_RESET_INFO);
 
@@ -33,8 +59,15 @@ void setup() {
     setupINS3331();
     setupConsoleFunctions();
     setupStateMachine();
+    setupAlertJournal(ALERT_JOURNAL_DIR);
     setupWatchdog();
     setupStatusRGB();
+    setupProfiler();
+
+#ifdef BRAVE_TRACE_SERIAL
+    // Trace records are kept at the same level as the text logs
+    setTraceLevel((DEBUG_LEVEL >= LOG_LEVEL_ERROR) ? TRACE_LEVEL_ERROR : (DEBUG_LEVEL >= LOG_LEVEL_WARN) ? TRACE_LEVEL_WARN : TRACE_LEVEL_INFO);
+#endif
 
     Particle.publishVitals(900);  // every 15 minutes
 }
@@ -60,9 +93,18 @@ void loop() {
 
     // Do every time loop() is called
     if (initialized) {
-        stateHandler();
+        serviceDeadlines();
+        stateMachineTick();
         getHeartbeat();
     }
 
+    // Replay journalled alerts, then start queued publishes and collect finished ones.
+    // Neither waits on the radio.
+    serviceAlertJournal();
+    servicePublishQueue();
+#ifdef BRAVE_TRACE_SERIAL
+    serviceTraceLog();
+#endif
+
     delay(10);
 }
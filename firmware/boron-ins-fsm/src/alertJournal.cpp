@@ -0,0 +1,327 @@
+/* alertJournal.cpp - Flash journal that keeps alerts until the cloud has them
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "alertJournal.h"
+#include "flashAddresses.h"
+#include "Particle.h"
+
+#define ALERT_JOURNAL_PATH_LENGTH       128
+#define ALERT_PAYLOAD_LENGTH            (PUBLISH_EVENT_NAME_LENGTH + 1 + PUBLISH_DATA_LENGTH)
+
+// ***************************** Local variables *****************************
+
+static char journalPath[ALERT_JOURNAL_PATH_LENGTH];
+static char compactPath[ALERT_JOURNAL_PATH_LENGTH];
+static bool available = false;
+static uint16_t currentBoot = 0;
+
+static uint32_t nextSequence = 1;
+static uint32_t lastAcknowledged = 0;
+static uint32_t fileSize = 0;
+static uint32_t truncatedBytes = 0;
+
+// Replay state. Records before replayOffset are all acknowledged.
+static uint32_t replayOffset = 0;
+static bool replayInFlight = false;
+static uint32_t inFlightSequence = 0;
+
+// ***************************** Local functions *****************************
+
+static uint32_t pendingAlerts() {
+    return nextSequence - 1 - lastAcknowledged;
+}
+
+static uint32_t recordCrc(AlertRecordHeader header, const uint8_t* payload) {
+    header.crc = 0;
+    uint32_t crc = alertJournalCrc32(0, (const uint8_t*)&header, sizeof(header));
+    return alertJournalCrc32(crc, payload, header.length);
+}
+
+// Reads the record at offset into header and payload. Returns false at the end of the
+// file or at a record that does not check out.
+static bool readRecord(int fd, uint32_t offset, AlertRecordHeader& header, uint8_t* payload) {
+    if (lseek(fd, offset, SEEK_SET) < 0 || read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+        return false;
+    }
+    if (header.magic != ALERT_JOURNAL_MAGIC || header.length > ALERT_PAYLOAD_LENGTH ||
+        (header.type != ALERT_RECORD_ALERT && header.type != ALERT_RECORD_ACK)) {
+        return false;
+    }
+    if (read(fd, payload, header.length) != (ssize_t)header.length) {
+        return false;
+    }
+    return recordCrc(header, payload) == header.crc;
+}
+
+// Fills record with the header and payload, returns its size
+static size_t buildRecord(uint8_t* record, uint8_t type, uint8_t priority, uint32_t sequence, uint32_t timestamp,
+                          const uint8_t* payload, uint16_t length) {
+    AlertRecordHeader header = {};
+    header.magic = ALERT_JOURNAL_MAGIC;
+    header.type = type;
+    header.priority = priority;
+    header.sequence = sequence;
+    header.timestamp = timestamp;
+    header.length = length;
+    header.boot = currentBoot;
+    header.crc = recordCrc(header, payload);
+    memcpy(record, &header, sizeof(header));
+    if (length > 0) {
+        memcpy(record + sizeof(header), payload, length);
+    }
+    return sizeof(header) + length;
+}
+
+// Writes the record to path with a single write, so a power loss leaves at most one damaged
+// record at the end of the file, and waits for it to reach flash
+static bool writeRecord(const char* path, int flags, const uint8_t* record, size_t total) {
+    int fd = open(path, O_WRONLY | O_CREAT | flags, 0644);
+    if (fd < 0) {
+        Log.error("Could not open %s: %d", path, errno);
+        return false;
+    }
+    bool written = write(fd, record, total) == (ssize_t)total && fsync(fd) == 0;
+    close(fd);
+
+    if (!written) {
+        Log.error("Could not write to %s: %d", path, errno);
+    }
+    return written;
+}
+
+static bool appendRecord(uint8_t type, uint8_t priority, uint32_t sequence, uint32_t timestamp, const uint8_t* payload,
+                         uint16_t length) {
+    uint8_t record[sizeof(AlertRecordHeader) + ALERT_PAYLOAD_LENGTH];
+    size_t total = buildRecord(record, type, priority, sequence, timestamp, payload, length);
+    if (!writeRecord(journalPath, O_APPEND, record, total)) {
+        return false;
+    }
+    fileSize += total;
+    return true;
+}
+
+// Starts the file over once nothing in it is waiting. The acknowledgement that keeps the
+// sequence numbers going up goes into a new file, which only replaces the journal once it
+// is on flash. A reset before the rename leaves the old journal, and the new file is
+// removed by the next setupAlertJournal().
+static void compactJournal() {
+    uint8_t record[sizeof(AlertRecordHeader)];
+    size_t total = buildRecord(record, ALERT_RECORD_ACK, 0, lastAcknowledged, 0, nullptr, 0);
+    if (!writeRecord(compactPath, O_TRUNC, record, total)) {
+        unlink(compactPath);
+        return;
+    }
+    if (rename(compactPath, journalPath) != 0) {
+        Log.error("Could not compact %s: %d", journalPath, errno);
+        unlink(compactPath);
+        return;
+    }
+    fileSize = total;
+    replayOffset = 0;
+}
+
+// Counts this boot in EEPROM. Only the low 16 bits are kept in records.
+static uint16_t countBoot() {
+    uint16_t bootCountFlag = 0;
+    uint32_t bootCount = 0;
+    EEPROM.get(ADDR_INITIALIZE_BOOT_COUNT_FLAG, bootCountFlag);
+    if (bootCountFlag == ALERT_JOURNAL_BOOT_COUNT_FLAG) {
+        EEPROM.get(ADDR_BOOT_COUNT, bootCount);
+    }
+    else {
+        bootCountFlag = ALERT_JOURNAL_BOOT_COUNT_FLAG;
+        EEPROM.put(ADDR_INITIALIZE_BOOT_COUNT_FLAG, bootCountFlag);
+    }
+    bootCount++;
+    EEPROM.put(ADDR_BOOT_COUNT, bootCount);
+    return (uint16_t)bootCount;
+}
+
+static void onReplayPublished(bool succeeded, void* context) {
+    replayInFlight = false;
+
+    // An alert is only given up if the publish queue evicted it, try again on the next pass
+    if (!succeeded) {
+        return;
+    }
+
+    lastAcknowledged = inFlightSequence;
+    appendRecord(ALERT_RECORD_ACK, 0, lastAcknowledged, 0, nullptr, 0);
+
+    if (pendingAlerts() == 0 && fileSize >= ALERT_JOURNAL_COMPACT_SIZE) {
+        compactJournal();
+    }
+}
+
+// ***************************** Public functions *****************************
+
+void setupAlertJournal(const char* directory) {
+    available = false;
+    nextSequence = 1;
+    lastAcknowledged = 0;
+    fileSize = 0;
+    truncatedBytes = 0;
+    replayOffset = 0;
+    replayInFlight = false;
+    currentBoot = countBoot();
+
+    snprintf(journalPath, sizeof(journalPath), "%s/%s", directory, ALERT_JOURNAL_FILE_NAME);
+    snprintf(compactPath, sizeof(compactPath), "%s/%s", directory, ALERT_JOURNAL_COMPACT_FILE_NAME);
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        Log.error("Could not create %s: %d, alerts will not be journalled", directory, errno);
+        return;
+    }
+
+    // Left by a compaction cut short by a reset, the journal itself is still whole
+    if (unlink(compactPath) == 0) {
+        Log.warn("Removed an unfinished compaction of the alert journal");
+    }
+
+    int fd = open(journalPath, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        Log.error("Could not open %s: %d, alerts will not be journalled", journalPath, errno);
+        return;
+    }
+
+    AlertRecordHeader header;
+    uint8_t payload[ALERT_PAYLOAD_LENGTH];
+    uint32_t offset = 0;
+    while (readRecord(fd, offset, header, payload)) {
+        if (header.type == ALERT_RECORD_ALERT && header.sequence >= nextSequence) {
+            nextSequence = header.sequence + 1;
+        }
+        else if (header.type == ALERT_RECORD_ACK && header.sequence > lastAcknowledged) {
+            lastAcknowledged = header.sequence;
+        }
+        offset += sizeof(header) + header.length;
+    }
+    if (lastAcknowledged >= nextSequence) {
+        nextSequence = lastAcknowledged + 1;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && (uint32_t)info.st_size > offset) {
+        truncatedBytes = (uint32_t)info.st_size - offset;
+        Log.warn("Dropping %lu damaged bytes at the end of the alert journal", (unsigned long)truncatedBytes);
+        ftruncate(fd, offset);
+    }
+    close(fd);
+
+    fileSize = offset;
+    available = true;
+    if (pendingAlerts() > 0) {
+        Log.warn("Alert journal has %lu alerts to replay", (unsigned long)pendingAlerts());
+    }
+}
+
+bool journalAlert(const char* eventName, const char* data, PublishPriority priority) {
+    size_t nameLength = strlen(eventName);
+    size_t dataLength = strlen(data);
+
+    if (available && nameLength <= PUBLISH_EVENT_NAME_LENGTH && dataLength <= PUBLISH_DATA_LENGTH &&
+        fileSize + sizeof(AlertRecordHeader) + nameLength + 1 + dataLength <= ALERT_JOURNAL_MAX_SIZE) {
+        uint8_t payload[ALERT_PAYLOAD_LENGTH];
+        memcpy(payload, eventName, nameLength + 1);
+        memcpy(payload + nameLength + 1, data, dataLength);
+
+        uint32_t timestamp = Time.isValid() ? (uint32_t)Time.now() : 0;
+        if (appendRecord(ALERT_RECORD_ALERT, priority, nextSequence, timestamp, payload, nameLength + 1 + dataLength)) {
+            nextSequence++;
+            return true;
+        }
+    }
+
+    // Still publish it if it could not be journalled, it just will not survive a reset
+    Log.error("%s not journalled, publishing it directly", eventName);
+    return queuePublish(eventName, data, priority);
+}
+
+void serviceAlertJournal() {
+    if (!available || replayInFlight || pendingAlerts() == 0) {
+        return;
+    }
+
+    int fd = open(journalPath, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    AlertRecordHeader header;
+    uint8_t payload[ALERT_PAYLOAD_LENGTH + 1];
+    bool found = false;
+    while (readRecord(fd, replayOffset, header, payload)) {
+        if (header.type == ALERT_RECORD_ALERT && header.sequence > lastAcknowledged) {
+            found = true;
+            break;
+        }
+        replayOffset += sizeof(header) + header.length;
+    }
+    close(fd);
+
+    if (!found) {
+        // Can only happen if the file changed underneath us, nothing left to replay
+        Log.error("Alert journal is missing alerts %lu to %lu", (unsigned long)(lastAcknowledged + 1),
+                  (unsigned long)(nextSequence - 1));
+        lastAcknowledged = nextSequence - 1;
+        return;
+    }
+
+    payload[header.length] = '\0';
+    const char* eventName = (const char*)payload;
+    const char* data = eventName + strlen(eventName) + 1;
+
+    char message[PUBLISH_DATA_LENGTH + 1];
+    if (!formatJournalledAlert(message, sizeof(message), data, header.boot, header.sequence, header.timestamp)) {
+        // The cloud cannot tell a replay of this alert from a new one
+        Log.error("%s %lu is too long for its idempotency key, publishing it without", eventName, (unsigned long)header.sequence);
+        snprintf(message, sizeof(message), "%s", data);
+    }
+
+    inFlightSequence = header.sequence;
+    replayInFlight = queuePublish(eventName, message, (PublishPriority)header.priority, onReplayPublished);
+}
+
+AlertJournalStats getAlertJournalStats() {
+    AlertJournalStats stats;
+    stats.nextSequence = nextSequence;
+    stats.lastAcknowledged = lastAcknowledged;
+    stats.pending = pendingAlerts();
+    stats.fileSize = fileSize;
+    stats.truncatedBytes = truncatedBytes;
+    stats.available = available;
+    return stats;
+}
+
+bool formatJournalledAlert(char* out, size_t size, const char* data, uint16_t boot, uint32_t sequence, uint32_t timestamp) {
+    if (data[0] != '{') {
+        return false;
+    }
+    const char* rest = data + 1;
+    while (*rest == ' ') {
+        rest++;
+    }
+
+    int n = snprintf(out, size, "{\"alertSequence\":%lu,\"alertTime\":%lu,\"idempotencyKey\":\"%04X%08lX%08lX\"%s%s",
+                     (unsigned long)sequence, (unsigned long)timestamp, (unsigned int)boot, (unsigned long)timestamp,
+                     (unsigned long)sequence, (*rest == '}') ? "" : ",", rest);
+    return n > 0 && (size_t)n < size;
+}
+
+// Bitwise CRC-32 (IEEE 802.3), alerts are rare enough not to need a table
+uint32_t alertJournalCrc32(uint32_t crc, const uint8_t* data, size_t length) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,98 @@
+/* alertJournal.h - Flash journal that keeps alerts until the cloud has them
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Alerts are appended to a file on the Boron's flash filesystem before they are published,
+ * so an alert raised during a cellular outage, or just before a reset, is not lost. Records
+ * are replayed one at a time, in sequence order, through the publish queue. Once a publish
+ * goes through an acknowledgement record is appended, so acknowledged alerts are not sent
+ * again after a reset.
+ *
+ * Every record is CRC framed. The scan at startup stops at the first record that does not
+ * check out, e.g. one cut short by a power loss, and truncates the file there.
+ *
+ * Each replayed publish has three fields added at the front of its JSON: a sequence
+ * number, the wall clock time the alert was raised and an idempotency key. The server can
+ * use the key to drop an alert it already has, e.g. when the device resets between the
+ * publish going through and the acknowledgement being written. The key also holds the
+ * boot the alert was raised in, counted in EEPROM, so two alerts raised before the clock
+ * was synced still get different keys if the journal is lost and the sequence starts over.
+ *
+ * Compaction writes the acknowledgement that carries the sequence on to a new file and
+ * renames it over the journal, so a reset part way through leaves one or the other.
+ */
+
+#ifndef ALERT_JOURNAL_H
+#define ALERT_JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "publishQueue.h"
+
+// ***************************** Macro definitions *****************************
+
+// Particle recommends keeping user files under /usr. Host builds point it somewhere else.
+#ifndef ALERT_JOURNAL_DIR
+#define ALERT_JOURNAL_DIR               "/usr"
+#endif
+#define ALERT_JOURNAL_FILE_NAME         "alertJournal"
+#define ALERT_JOURNAL_COMPACT_FILE_NAME "alertJournal.compact"
+
+#define ALERT_JOURNAL_BOOT_COUNT_FLAG   0x8888  // Flag to initialize the boot count
+
+#define ALERT_JOURNAL_MAGIC             0xA1E7
+#define ALERT_RECORD_ALERT              1
+#define ALERT_RECORD_ACK                2       // Every alert up to and including this sequence went through
+
+// Once everything is acknowledged the file is rewritten empty past this size
+#define ALERT_JOURNAL_COMPACT_SIZE      8192    // 8 KB
+// New alerts skip the journal past this size, e.g. during a very long outage
+#define ALERT_JOURNAL_MAX_SIZE          65536   // 64 KB
+
+// ***************************** Global typedefs *****************************
+
+// Stored little endian, as the Boron and the host test machines both are
+typedef struct AlertRecordHeader {
+    uint16_t magic;
+    uint8_t type;
+    uint8_t priority;    // PublishPriority to replay the alert with
+    uint32_t sequence;
+    uint32_t timestamp;  // Time.now() when the alert was raised, 0 if the time was not synced yet
+    uint16_t length;     // Payload bytes after the header: event name, a NUL, then the event data
+    uint16_t boot;       // Low bits of the boot count when the record was written
+    uint32_t crc;        // CRC-32 of the header with this field zeroed, then the payload
+} AlertRecordHeader;
+
+static_assert(sizeof(AlertRecordHeader) == 20, "AlertRecordHeader must have no padding");
+
+typedef struct AlertJournalStats {
+    uint32_t nextSequence;
+    uint32_t lastAcknowledged;
+    uint32_t pending;           // Alerts written but not acknowledged yet
+    uint32_t fileSize;
+    uint32_t truncatedBytes;    // Bytes of damaged records dropped by the last scan
+    bool available;             // False if the file could not be opened, alerts go straight to the publish queue
+} AlertJournalStats;
+
+// ***************************** Function declarations *****************************
+
+// Counts the boot and scans the journal in directory, creating it if needed. Call it once
+// from setup().
+void setupAlertJournal(const char* directory);
+
+// Writes the alert to the journal, it is published from serviceAlertJournal()
+bool journalAlert(const char* eventName, const char* data, PublishPriority priority);
+
+// Hands the oldest unacknowledged alert to the publish queue. Call it from loop().
+void serviceAlertJournal(void);
+
+AlertJournalStats getAlertJournalStats(void);
+
+// Fills out with data plus the sequence, time and idempotency key fields.
+// Returns false if it does not fit in size bytes.
+bool formatJournalledAlert(char* out, size_t size, const char* data, uint16_t boot, uint32_t sequence, uint32_t timestamp);
+
+uint32_t alertJournalCrc32(uint32_t crc, const uint8_t* data, size_t length);
+
+#endif
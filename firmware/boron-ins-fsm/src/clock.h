@@ -0,0 +1,53 @@
+/* clock.h - Millisecond clock used for all firmware timing
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Firmware code reads the time through clockMillis() instead of calling millis() directly.
+ * On the device clockMillis() is an inline call to millis(), so it costs nothing. Host
+ * builds (unit tests, the simulator) define BRAVE_VIRTUAL_CLOCK to read VirtualClock
+ * instead. It only moves when it is stepped, so a 20 minute duration alert or a 49.7 day
+ * millis() rollover takes as long as the code under test does.
+ */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+
+#ifdef BRAVE_VIRTUAL_CLOCK
+
+// Steppable clock for host builds. Time is kept in 64 bits and truncated to 32 bits on
+// read, so millis() rolls over after 2^32 ms exactly as it does on the device.
+class VirtualClock {
+public:
+    static uint32_t millis() { return (uint32_t)nowMs; }
+    static uint64_t elapsedMillis() { return nowMs; }
+
+    static void set(uint64_t ms) { nowMs = ms; }
+    static void advance(uint64_t ms) { nowMs += ms; }
+
+private:
+    static inline uint64_t nowMs = 0;
+};
+
+inline uint32_t clockMillis() {
+    return VirtualClock::millis();
+}
+
+#else
+
+#include "Particle.h"
+
+inline uint32_t clockMillis() {
+    return millis();
+}
+
+#endif
+
+// Milliseconds elapsed since start, an earlier clockMillis() value. Doing the subtraction in
+// 32 bits keeps it right across the rollover, also on hosts where unsigned long is 64 bits.
+inline uint32_t clockMillisSince(uint32_t start) {
+    return clockMillis() - start;
+}
+
+#endif
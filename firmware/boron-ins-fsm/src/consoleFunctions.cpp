@@ -7,10 +7,13 @@
 
 #include "Particle.h"
 #include "consoleFunctions.h"
+#include "clock.h"
 #include "debugFlags.h"
 #include "flashAddresses.h"
+#include "heartbeatEncoding.h"
 #include "stateMachine.h"
 #include "imDoorSensor.h"
+#include "latencyStats.h"
 
 void setupConsoleFunctions() {
     // particle console function declarations, belongs in setup() as per docs
@@ -28,6 +31,15 @@ void setupConsoleFunctions() {
     Particle.function("Stillness_Time", stillness_alert_time_set);
 
     Particle.function("IM21_Door_ID", im21_door_id_set);
+
+    Particle.function("Heartbeat_Format", heartbeat_format_set);
+    Particle.function("Noise_Calibration", noise_calibration_set);
+
+    Particle.function("Latency_Stats", latency_stats);
+
+#ifdef BRAVE_PROFILER
+    Particle.function("Profile_Stats", profile_stats);
+#endif
 }
 
 int force_reset(String command) {
@@ -72,38 +84,9 @@ int reset_state_to_zero(String command) {
     } else if (*holder == '1') {
         returnFlag = 1;
 
-        // reset the state handler to point to state 0
-        stateHandler = state0_idle;
-
-        // Disable state transitions until door cycle
-        allowTransitionToStateOne = false;
-
-        // Reset all state timers
-        state0_start_time = 0;
-        state1_start_time = 0;
-        state2_start_time = 0;
-        state3_start_time = 0;
-
-        // Reset time tracking in states
-        timeInState0 = 0;
-        timeInState1 = 0;
-        timeInState2 = 0;
-        timeInState3 = 0;
-    
-        // Reset duration alert variables
-        numDurationAlertSent = 0;
-        lastDurationAlertTime = 0;
-        timeSinceLastDurationAlert = 0;
-        isDurationAlertThresholdExceeded = false;
-
-        // Reset stillness alert variables
-        numStillnessAlertSent = 0;
-        isStillnessAlertActive = true;
-        isStillnessAlertThresholdExceeded = false;
-
-        // Reset door timing
-        timeWhenDoorClosed = millis();
-        timeSinceDoorClosed = 0;
+        // reset the state machine to state 0, clearing every timer and alert.
+        // State transitions are disabled until door cycle.
+        stateMachine.resetToIdle();
 
         // Reset door monitoring variables
         consecutiveOpenDoorHeartbeatCount = 0;
@@ -138,7 +121,7 @@ int toggle_debugging_publishes(String command) {
     }
     else if (*holder == '1') {
         stateMachineDebugFlag = true;
-        debugFlagTurnedOnAt = millis();
+        debugFlagTurnedOnAt = clockMillis();
         returnFlag = 1;
     }
     else {
@@ -149,6 +132,64 @@ int toggle_debugging_publishes(String command) {
     return returnFlag;
 }
 
+// returns the heartbeat format, 0 for JSON or 1 for compact, otherwise returns -1
+int heartbeat_format_set(String command) {
+    // default to invalid input
+    int returnFlag = -1;
+
+    const char* holder = command.c_str();
+
+    if (*(holder + 1) != 0) {
+        // any string longer than 1 char is invalid input, so
+        returnFlag = -1;
+    }
+    // if e, echo the current heartbeat format
+    else if (*holder == 'e') {
+        EEPROM.get(ADDR_HEARTBEAT_FORMAT, heartbeatFormat);
+        returnFlag = (heartbeatFormat == HEARTBEAT_FORMAT_COMPACT) ? HEARTBEAT_FORMAT_COMPACT : HEARTBEAT_FORMAT_JSON;
+    }
+    else if (*holder == '0' || *holder == '1') {
+        heartbeatFormat = (*holder == '1') ? HEARTBEAT_FORMAT_COMPACT : HEARTBEAT_FORMAT_JSON;
+        EEPROM.put(ADDR_HEARTBEAT_FORMAT, heartbeatFormat);
+        returnFlag = heartbeatFormat;
+    }
+    else {
+        // anything else is bad input so
+        returnFlag = -1;
+    }
+
+    return returnFlag;
+}
+
+// returns 1 if the noise floor thresholds are applied or 0 if not, otherwise returns -1
+int noise_calibration_set(String command) {
+    // default to invalid input
+    int returnFlag = -1;
+
+    const char* holder = command.c_str();
+
+    if (*(holder + 1) != 0) {
+        // any string longer than 1 char is invalid input, so
+        returnFlag = -1;
+    }
+    // if e, echo whether the noise floor thresholds are applied
+    else if (*holder == 'e') {
+        EEPROM.get(ADDR_NOISE_CALIBRATION, noiseCalibration);
+        returnFlag = (noiseCalibration == NOISE_CALIBRATION_ON) ? NOISE_CALIBRATION_ON : NOISE_CALIBRATION_OFF;
+    }
+    else if (*holder == '0' || *holder == '1') {
+        noiseCalibration = (*holder == '1') ? NOISE_CALIBRATION_ON : NOISE_CALIBRATION_OFF;
+        EEPROM.put(ADDR_NOISE_CALIBRATION, noiseCalibration);
+        returnFlag = noiseCalibration;
+    }
+    else {
+        // anything else is bad input so
+        returnFlag = -1;
+    }
+
+    return returnFlag;
+}
+
 int reset_monitoring(String command) {
     // default to invalid input
     int returnFlag = -1;
@@ -160,19 +201,10 @@ int reset_monitoring(String command) {
         returnFlag = -1;
     } 
     else if (*holder == '1') {
-        // Check if the current state is either 2 or 3
-        if (stateHandler == state2_monitoring || stateHandler == state3_stillness) {
+        // Only allowed in state 2 or 3
+        if (stateMachine.resetMonitoring()) {
             returnFlag = 1;
 
-            // Reset duration alerts
-            numDurationAlertSent = 0;
-            timeSinceLastDurationAlert = 0;
-
-            // Reset stillness alerts
-            numStillnessAlertSent = 0;
-            state3_start_time = millis();
-            isStillnessAlertActive = true;
-
             // Publish reset message
             Particle.publish("Reset Monitoring", "Monitoring has been reset.", PRIVATE | WITH_ACK);
         } else {
@@ -196,8 +228,8 @@ int occupancy_detection_ins_threshold_set(String input) {
 
     // if e, echo the current threshold
     if (*holder == 'e') {
-        EEPROM.get(ADDR_OCCUPANCY_DETECTION_INS_THRESHOLD, occupancy_detection_ins_threshold);
-        returnFlag = occupancy_detection_ins_threshold;
+        EEPROM.get(ADDR_OCCUPANCY_DETECTION_INS_THRESHOLD, stateMachine.config().occupancy_detection_ins_threshold);
+        returnFlag = stateMachine.config().occupancy_detection_ins_threshold;
     }
     // else parse new threshold
     else {
@@ -217,8 +249,8 @@ int occupancy_detection_ins_threshold_set(String input) {
         }
         else {
             EEPROM.put(ADDR_OCCUPANCY_DETECTION_INS_THRESHOLD, threshold);
-            occupancy_detection_ins_threshold = threshold;
-            returnFlag = occupancy_detection_ins_threshold;
+            stateMachine.config().occupancy_detection_ins_threshold = threshold;
+            returnFlag = stateMachine.config().occupancy_detection_ins_threshold;
         }
     }
 
@@ -233,8 +265,8 @@ int stillness_ins_threshold_set(String input) {
 
     // if e, echo the current threshold
     if (*holder == 'e') {
-        EEPROM.get(ADDR_STILLNESS_INS_THRESHOLD, stillness_ins_threshold);
-        returnFlag = stillness_ins_threshold;
+        EEPROM.get(ADDR_STILLNESS_INS_THRESHOLD, stateMachine.config().stillness_ins_threshold);
+        returnFlag = stateMachine.config().stillness_ins_threshold;
     }
     // else parse new threshold
     else {
@@ -254,8 +286,8 @@ int stillness_ins_threshold_set(String input) {
         }
         else {
             EEPROM.put(ADDR_STILLNESS_INS_THRESHOLD, threshold);
-            stillness_ins_threshold = threshold;
-            returnFlag = stillness_ins_threshold;
+            stateMachine.config().stillness_ins_threshold = threshold;
+            returnFlag = stateMachine.config().stillness_ins_threshold;
         }
     }
 
@@ -270,8 +302,8 @@ int occupancy_detection_time_set(String input) {
 
     // if e, echo the current time
     if (*holder == 'e') {
-        EEPROM.get(ADDR_STATE0_OCCUPANCY_DETECTION_TIME, state0_occupancy_detection_time);
-        returnFlag = state0_occupancy_detection_time / 1000;
+        EEPROM.get(ADDR_STATE0_OCCUPANCY_DETECTION_TIME, stateMachine.config().state0_occupancy_detection_time);
+        returnFlag = stateMachine.config().state0_occupancy_detection_time / 1000;
     }
     // else parse new time
     else {
@@ -289,8 +321,8 @@ int occupancy_detection_time_set(String input) {
         }
         else {
             EEPROM.put(ADDR_STATE0_OCCUPANCY_DETECTION_TIME, timeout);
-            state0_occupancy_detection_time = timeout;
-            returnFlag = state0_occupancy_detection_time / 1000;
+            stateMachine.config().state0_occupancy_detection_time = timeout;
+            returnFlag = stateMachine.config().state0_occupancy_detection_time / 1000;
         }
     }
     return returnFlag;
@@ -304,8 +336,8 @@ int initial_time_set(String input) {
 
     // if e, echo the current time
     if (*holder == 'e') {
-        EEPROM.get(ADDR_STATE1_INITIAL_TIME, state1_initial_time);
-        returnFlag = state1_initial_time / 1000;
+        EEPROM.get(ADDR_STATE1_INITIAL_TIME, stateMachine.config().state1_initial_time);
+        returnFlag = stateMachine.config().state1_initial_time / 1000;
     }
     // else parse new time
     else {
@@ -323,8 +355,8 @@ int initial_time_set(String input) {
         }
         else {
             EEPROM.put(ADDR_STATE1_INITIAL_TIME, timeout);
-            state1_initial_time = timeout;
-            returnFlag = state1_initial_time / 1000;
+            stateMachine.config().state1_initial_time = timeout;
+            returnFlag = stateMachine.config().state1_initial_time / 1000;
         }
     }
     return returnFlag;
@@ -337,8 +369,8 @@ int duration_alert_time_set(String input) {
 
     // if e, echo the current time
     if (*holder == 'e') {
-        EEPROM.get(ADDR_DURATION_ALERT_TIME, duration_alert_time);
-        returnFlag = duration_alert_time / 1000;
+        EEPROM.get(ADDR_DURATION_ALERT_TIME, stateMachine.config().duration_alert_time);
+        returnFlag = stateMachine.config().duration_alert_time / 1000;
     }
     // else parse new time
     else {
@@ -356,8 +388,8 @@ int duration_alert_time_set(String input) {
         }
         else {
             EEPROM.put(ADDR_DURATION_ALERT_TIME, time);
-            duration_alert_time = time;
-            returnFlag = duration_alert_time / 1000;
+            stateMachine.config().duration_alert_time = time;
+            returnFlag = stateMachine.config().duration_alert_time / 1000;
         }
     }
     return returnFlag;
@@ -370,8 +402,8 @@ int stillness_alert_time_set(String input) {
 
     // if e, echo the current time
     if (*holder == 'e') {
-        EEPROM.get(ADDR_STILLNESS_ALERT_TIME, stillness_alert_time);
-        returnFlag = stillness_alert_time / 1000;
+        EEPROM.get(ADDR_STILLNESS_ALERT_TIME, stateMachine.config().stillness_alert_time);
+        returnFlag = stateMachine.config().stillness_alert_time / 1000;
     }
     // else parse new time
     else {
@@ -389,8 +421,8 @@ int stillness_alert_time_set(String input) {
         }
         else {
             EEPROM.put(ADDR_STILLNESS_ALERT_TIME, time);
-            stillness_alert_time = time;
-            returnFlag = stillness_alert_time / 1000;
+            stateMachine.config().stillness_alert_time = time;
+            returnFlag = stateMachine.config().stillness_alert_time / 1000;
         }
     }
     return returnFlag;
@@ -468,3 +500,84 @@ int im21_door_id_set(String command) {
     return (int)strtol(buffer, NULL, 16);
 }
 
+// particle console function to publish or clear the alert path latency histograms
+int latency_stats(String command) {
+    // default to invalid input
+    int returnFlag = -1;
+
+    const char* holder = command.c_str();
+
+    if (*(holder + 1) != 0) {
+        // any string longer than 1 char is invalid input
+        returnFlag = -1;
+    }
+    // if e, publish every stage's histogram since the last heartbeat
+    else if (*holder == 'e') {
+        char buffer[PUBLISH_LATENCY_STATS_LENGTH];
+        size_t length = snprintf(buffer, sizeof(buffer), "{");
+        for (int stage = 0; stage < LATENCY_STAGE_COUNT && length < sizeof(buffer); stage++) {
+            LatencyHistogram histogram = getLatencyHistogram((LatencyStage)stage);
+            length += snprintf(buffer + length, sizeof(buffer) - length, "%s\"%s\":{\"count\":%lu,\"max\":%lu,\"buckets\":[",
+                               (stage > 0) ? "," : "", latencyStageName((LatencyStage)stage), (unsigned long)histogram.count,
+                               (unsigned long)histogram.max);
+            for (int bucket = 0; bucket < LATENCY_BUCKETS && length < sizeof(buffer); bucket++) {
+                length += snprintf(buffer + length, sizeof(buffer) - length, "%s%lu", (bucket > 0) ? "," : "",
+                                   (unsigned long)histogram.buckets[bucket]);
+            }
+            if (length < sizeof(buffer)) {
+                length += snprintf(buffer + length, sizeof(buffer) - length, "]}");
+            }
+        }
+        if (length < sizeof(buffer)) {
+            snprintf(buffer + length, sizeof(buffer) - length, "}");
+        }
+
+        Particle.publish("Latency Stats", buffer, PRIVATE);
+        returnFlag = 1;
+    }
+    // if 0, start every histogram over
+    else if (*holder == '0') {
+        resetLatencyHistograms();
+        returnFlag = 0;
+    }
+    else {
+        // anything else is bad input
+        returnFlag = -1;
+    }
+
+    return returnFlag;
+}
+
+#ifdef BRAVE_PROFILER
+// particle console function to publish or clear the loop() call timings
+int profile_stats(String command) {
+    // default to invalid input
+    int returnFlag = -1;
+
+    const char* holder = command.c_str();
+
+    if (*(holder + 1) != 0) {
+        // any string longer than 1 char is invalid input
+        returnFlag = -1;
+    }
+    // if e, publish every site's timings since boot or the last reset
+    else if (*holder == 'e') {
+        char buffer[PUBLISH_PROFILE_STATS_LENGTH];
+        formatProfileStats(buffer, sizeof(buffer));
+
+        Particle.publish("Profile Stats", buffer, PRIVATE);
+        returnFlag = 1;
+    }
+    // if 0, start every site over
+    else if (*holder == '0') {
+        resetProfileStats();
+        returnFlag = 0;
+    }
+    else {
+        // anything else is bad input
+        returnFlag = -1;
+    }
+
+    return returnFlag;
+}
+#endif
@@ -8,6 +8,16 @@
 #ifndef CONSOLEFUNCTIONS_H
 #define CONSOLEFUNCTIONS_H
 
+#include "profiler.h"
+
+// ***************************** Macro definitions *****************************
+
+// Four stages of 16 bucket counts fit in one Particle event
+#define PUBLISH_LATENCY_STATS_LENGTH    622
+
+// Seven sites of five counts fit in one Particle event
+#define PUBLISH_PROFILE_STATS_LENGTH    622
+
 // ***************************** Function declarations *****************************
 
 // setup() functions
@@ -29,4 +39,13 @@ int stillness_alert_time_set(String);
 
 int im21_door_id_set(String);
 
+int heartbeat_format_set(String);
+int noise_calibration_set(String);
+
+int latency_stats(String);
+
+#ifdef BRAVE_PROFILER
+int profile_stats(String);
+#endif
+
 #endif
\ No newline at end of file
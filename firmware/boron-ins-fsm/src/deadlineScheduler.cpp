@@ -0,0 +1,168 @@
+/* deadlineScheduler.cpp - Min-heap of firmware deadlines
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "clock.h"
+#include "deadlineScheduler.h"
+
+// ***************************** Local variables *****************************
+
+// The firmware's scheduler, run by the free functions below
+static DeadlineScheduler firmwareDeadlines;
+
+// ***************************** DeadlineScheduler *****************************
+
+DeadlineScheduler::DeadlineScheduler() {
+    reset();
+}
+
+bool DeadlineScheduler::isDueEarlier(DeadlineId a, DeadlineId b) const {
+    return (int32_t)(due[a] - due[b]) < 0;
+}
+
+void DeadlineScheduler::place(int index, DeadlineId id) {
+    heap[index] = id;
+    heapIndex[id] = index;
+}
+
+void DeadlineScheduler::siftUp(int index) {
+    DeadlineId id = heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!isDueEarlier(id, heap[parent])) {
+            break;
+        }
+        place(index, heap[parent]);
+        index = parent;
+    }
+    place(index, id);
+}
+
+void DeadlineScheduler::siftDown(int index) {
+    DeadlineId id = heap[index];
+    while (true) {
+        int child = 2 * index + 1;
+        if (child >= heapSize) {
+            break;
+        }
+        if (child + 1 < heapSize && isDueEarlier(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!isDueEarlier(heap[child], id)) {
+            break;
+        }
+        place(index, heap[child]);
+        index = child;
+    }
+    place(index, id);
+}
+
+void DeadlineScheduler::removeAt(int index) {
+    DeadlineId removed = heap[index];
+    heapIndex[removed] = -1;
+    heapSize--;
+    if (index == heapSize) {
+        return;
+    }
+
+    DeadlineId moved = heap[heapSize];
+    place(index, moved);
+    siftDown(index);
+    siftUp(heapIndex[moved]);
+}
+
+void DeadlineScheduler::arm(DeadlineId id, uint32_t dueAt) {
+    bool armedOrFired = heapIndex[id] >= 0 || fired[id];
+    if (armedOrFired && due[id] == dueAt) {
+        return;
+    }
+
+    fired[id] = false;
+    due[id] = dueAt;
+    if (heapIndex[id] >= 0) {
+        siftUp(heapIndex[id]);
+        siftDown(heapIndex[id]);
+    }
+    else {
+        heapSize++;
+        place(heapSize - 1, id);
+        siftUp(heapSize - 1);
+    }
+}
+
+void DeadlineScheduler::cancel(DeadlineId id) {
+    fired[id] = false;
+    if (heapIndex[id] >= 0) {
+        removeAt(heapIndex[id]);
+    }
+}
+
+void DeadlineScheduler::service(uint32_t now) {
+    while (heapSize > 0 && (int32_t)(now - due[heap[0]]) >= 0) {
+        DeadlineId id = heap[0];
+        removeAt(0);
+        fired[id] = true;
+    }
+}
+
+bool DeadlineScheduler::isArmed(DeadlineId id) const {
+    return heapIndex[id] >= 0;
+}
+
+bool DeadlineScheduler::isFired(DeadlineId id) const {
+    return fired[id];
+}
+
+bool DeadlineScheduler::take(DeadlineId id) {
+    bool wasFired = fired[id];
+    fired[id] = false;
+    return wasFired;
+}
+
+uint32_t DeadlineScheduler::dueAt(DeadlineId id) const {
+    return due[id];
+}
+
+void DeadlineScheduler::reset() {
+    for (int i = 0; i < DEADLINE_COUNT; i++) {
+        heapIndex[i] = -1;
+        fired[i] = false;
+        due[i] = 0;
+    }
+    heapSize = 0;
+}
+
+// ***************************** Public functions *****************************
+
+void armDeadline(DeadlineId id, uint32_t dueAt) {
+    firmwareDeadlines.arm(id, dueAt);
+}
+
+void cancelDeadline(DeadlineId id) {
+    firmwareDeadlines.cancel(id);
+}
+
+void serviceDeadlines() {
+    firmwareDeadlines.service(clockMillis());
+}
+
+bool isDeadlineArmed(DeadlineId id) {
+    return firmwareDeadlines.isArmed(id);
+}
+
+bool isDeadlineFired(DeadlineId id) {
+    return firmwareDeadlines.isFired(id);
+}
+
+bool takeDeadline(DeadlineId id) {
+    return firmwareDeadlines.take(id);
+}
+
+uint32_t deadlineDueAt(DeadlineId id) {
+    return firmwareDeadlines.dueAt(id);
+}
+
+void resetDeadlines() {
+    firmwareDeadlines.reset();
+}
@@ -0,0 +1,95 @@
+/* deadlineScheduler.h - Min-heap of firmware deadlines
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Alert and heartbeat timing used to be checked by comparing elapsed times on every loop()
+ * pass. The duration alert only matched within a 1 second window, so a pass that stalled
+ * past the window skipped the alert. A deadline is instead armed for an absolute
+ * clockMillis() time and fires exactly once, on the first serviceDeadlines() call at or
+ * after that time, however late the call is. Fired deadlines stay fired until they are
+ * taken, armed again or cancelled.
+ *
+ * Deadlines are kept in a binary min-heap ordered by due time, so serviceDeadlines() only
+ * looks at the top while nothing is due. Due times are compared relative to each other, so
+ * the ordering holds across the millis() rollover as long as all deadlines are within
+ * 24 days of each other.
+ *
+ * Each StateMachine keeps its own DeadlineScheduler for its alert deadlines. The free
+ * functions below run the firmware's own scheduler, which holds the heartbeat deadline.
+ * A scheduler is only ever used from one thread, on the device the application thread.
+ */
+
+#ifndef DEADLINE_SCHEDULER_H
+#define DEADLINE_SCHEDULER_H
+
+#include <stdint.h>
+
+// ***************************** Global typedefs *****************************
+
+enum DeadlineId {
+    DEADLINE_DURATION_ALERT = 0,    // Next duration alert, a multiple of duration_alert_time after the door closed
+    DEADLINE_STILLNESS_ALERT,       // stillness_alert_time after entering state 3
+    DEADLINE_HEARTBEAT,             // SM_HEARTBEAT_INTERVAL after the last confirmed heartbeat, or
+                                    // SM_HEARTBEAT_RETRY_INTERVAL after one the publish queue did not keep
+    DEADLINE_COUNT
+};
+
+class DeadlineScheduler {
+public:
+    DeadlineScheduler();
+
+    // Arms id for dueAt, replacing any earlier arming and clearing its fired flag. Arming
+    // again for the due time it already has changes nothing, fired or not.
+    void arm(DeadlineId id, uint32_t dueAt);
+    void cancel(DeadlineId id);
+
+    // Fires every armed deadline whose due time is at or before now
+    void service(uint32_t now);
+
+    bool isArmed(DeadlineId id) const;
+    bool isFired(DeadlineId id) const;
+
+    // Returns whether id has fired and clears the fired flag, so each firing is taken once
+    bool take(DeadlineId id);
+
+    // The due time id was last armed for
+    uint32_t dueAt(DeadlineId id) const;
+
+    // Cancels everything
+    void reset();
+
+private:
+    bool isDueEarlier(DeadlineId a, DeadlineId b) const;
+    void place(int index, DeadlineId id);
+    void siftUp(int index);
+    void siftDown(int index);
+    void removeAt(int index);
+
+    // Heap of armed deadline ids, earliest due first
+    DeadlineId heap[DEADLINE_COUNT];
+    int heapSize;
+
+    // Per deadline, indexed by DeadlineId. heapIndex is -1 when not armed.
+    uint32_t due[DEADLINE_COUNT];
+    int heapIndex[DEADLINE_COUNT];
+    bool fired[DEADLINE_COUNT];
+};
+
+// ***************************** Function declarations *****************************
+
+// The firmware's scheduler, see DeadlineScheduler
+void armDeadline(DeadlineId id, uint32_t dueAt);
+void cancelDeadline(DeadlineId id);
+
+// Services the firmware's scheduler at clockMillis(). Call it once per loop().
+void serviceDeadlines(void);
+
+bool isDeadlineArmed(DeadlineId id);
+bool isDeadlineFired(DeadlineId id);
+bool takeDeadline(DeadlineId id);
+uint32_t deadlineDueAt(DeadlineId id);
+
+// Cancels everything, for tests
+void resetDeadlines(void);
+
+#endif
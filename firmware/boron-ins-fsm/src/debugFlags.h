@@ -17,10 +17,10 @@
 // Whether or not to publish debug messages
 extern bool stateMachineDebugFlag;
 
-// The value of millis() at the most recent time the debug publishes were turned on
+// The value of clockMillis() at the most recent time the debug publishes were turned on
 extern unsigned long debugFlagTurnedOnAt;
 
-// The value of millis() at the time of the most recent debug publish
+// The value of clockMillis() at the time of the most recent debug publish
 extern unsigned long lastDebugPublish;
 
 #endif
\ No newline at end of file
@@ -42,6 +42,18 @@
 #define ADDR_OCCUPANCY_DETECTION_INS_THRESHOLD                  37 // uint32_t = 4 bytes
 #define ADDR_INITIALIZE_OCCUPANCY_DETECTION_INS_THRESHOLD_FLAG  41 // uint16_t = 2 bytes
 
-// next available address is 41 + 4 = 45
+// Heartbeat format, JSON or compact (see heartbeatEncoding.h), and its initialization flag
+#define ADDR_INITIALIZE_HEARTBEAT_FORMAT_FLAG                   45 // uint16_t = 2 bytes
+#define ADDR_HEARTBEAT_FORMAT                                   47 // uint16_t = 2 bytes
+
+// Whether the heartbeat applies the noise floor's thresholds (see noiseFloor.h), and its initialization flag
+#define ADDR_INITIALIZE_NOISE_CALIBRATION_FLAG                  49 // uint16_t = 2 bytes
+#define ADDR_NOISE_CALIBRATION                                  51 // uint16_t = 2 bytes
+
+// Boots since the count was initialized, for the alert journal's idempotency keys (see alertJournal.h), and its initialization flag
+#define ADDR_INITIALIZE_BOOT_COUNT_FLAG                         53 // uint16_t = 2 bytes
+#define ADDR_BOOT_COUNT                                         55 // uint32_t = 4 bytes
+
+// next available address is 55 + 4 = 59
 
 #endif
\ No newline at end of file
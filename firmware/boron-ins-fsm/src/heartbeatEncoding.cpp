@@ -0,0 +1,226 @@
+/* heartbeatEncoding.cpp - JSON and compact encodings of the heartbeat message
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "heartbeatEncoding.h"
+
+#include <string.h>
+
+// ***************************** Local functions *****************************
+
+static uint8_t* putU16(uint8_t* out, uint32_t value) {
+    uint16_t saturated = (value > 0xFFFF) ? 0xFFFF : (uint16_t)value;
+    out[0] = (uint8_t)saturated;
+    out[1] = (uint8_t)(saturated >> 8);
+    return out + 2;
+}
+
+static uint8_t* putU32(uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+    return out + 4;
+}
+
+static uint8_t* putQueue(uint8_t* out, const HeartbeatQueue& queue) {
+    out = putU32(out, queue.overflows);
+    out = putU16(out, queue.highWaterMark);
+    return putU16(out, queue.meanOccupancy);
+}
+
+static uint8_t* putFloat(uint8_t* out, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return putU32(out, bits);
+}
+
+static void writeHistogramJson(JsonWriter& writer, const InsHistogramSnapshot& histogram) {
+    writer.beginArray();
+    for (size_t i = 0; i < histogram.span; i++) {
+        if (histogram.counts[i] == 0) {
+            continue;
+        }
+        writer.beginArray();
+        writer.fixed(insHistogramBucketLower(histogram.first + i), 3);
+        writer.value((unsigned int)insHistogramCodeCount(histogram.counts[i]));
+        writer.endArray();
+    }
+    writer.endArray();
+}
+
+static void writeQueueJson(JsonWriter& writer, const char* name, const HeartbeatQueue& queue) {
+    writer.key(name, strlen(name)).beginArray();
+    writer.value((unsigned int)queue.overflows);
+    writer.value((unsigned int)queue.highWaterMark);
+    writer.value((unsigned int)queue.meanOccupancy);
+    writer.endArray();
+}
+
+// ***************************** Public functions *****************************
+
+void writeHeartbeatJson(const HeartbeatRecord& record, JsonWriter& writer, bool withCompactFields) {
+    writer.beginObject();
+
+    // Time since the last door message, battery and tamper status, or -1 before the first
+    if (record.doorHeard) {
+        writer.name("doorLastMessage").value((unsigned int)record.doorLastMessage);
+        writer.name("doorLowBattery").value(record.doorLowBattery);
+        writer.name("doorTampered").value(record.doorTampered);
+    }
+    else {
+        writer.name("doorLastMessage").value(-1);
+        writer.name("doorLowBattery").value(-1);
+        writer.name("doorTampered").value(-1);
+    }
+
+    writer.name("isINSZero").value(record.isINSZero);
+    writer.name("insReaderLoad").value((unsigned int)record.insReaderLoad);
+
+    writer.name("latency").beginObject();
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        const HeartbeatLatency& latency = record.latency[stage];
+        const char* stageName = latencyStageName((LatencyStage)stage);
+        writer.key(stageName, strlen(stageName)).beginArray();
+        writer.value((unsigned int)latency.count);
+        writer.value((unsigned int)latency.p50);
+        writer.value((unsigned int)latency.p99);
+        writer.value((unsigned int)latency.max);
+        writer.endArray();
+    }
+    writer.endObject();
+
+    writeQueueJson(writer, "insQueue", record.insQueue);
+    writeQueueJson(writer, "bleQueue", record.bleQueue);
+
+    writer.name("consecutiveOpenDoorHeartbeatCount").value((unsigned int)record.consecutiveOpenDoorHeartbeatCount);
+    writer.name("doorMissedCount").value((unsigned int)record.doorMissedCount);
+    writer.name("doorMissedFrequently").value(record.doorMissedFrequently);
+    writer.name("resetReason").value(resetReasonName(record.resetReason));
+
+    writer.name("noiseFloor").beginArray();
+    writer.value((unsigned int)record.noiseFloor.sampleCount);
+    writer.fixed(record.noiseFloor.p50, 1);
+    writer.fixed(record.noiseFloor.p99, 1);
+    writer.value((unsigned int)record.noiseFloor.stillnessThreshold);
+    writer.value((unsigned int)record.noiseFloor.occupancyThreshold);
+    writer.endArray();
+
+    if (withCompactFields) {
+        writer.name("insMagnitude").fixed(record.insMagnitude, 6);
+        writer.name("insFrames").beginArray();
+        writer.value((unsigned int)record.insFramesParsed);
+        writer.value((unsigned int)record.insChecksumErrors);
+        writer.value((unsigned int)record.insFramingErrors);
+        writer.value((unsigned int)record.insBytesDiscarded);
+        writer.endArray();
+
+        writer.name("insHistogram").beginObject();
+        for (int occupancy = 0; occupancy < INS_OCCUPANCY_COUNT; occupancy++) {
+            const char* occupancyName = insOccupancyName((InsOccupancy)occupancy);
+            writer.key(occupancyName, strlen(occupancyName));
+            writeHistogramJson(writer, record.insHistogram[occupancy]);
+        }
+        writer.endObject();
+    }
+
+    writer.endObject();
+}
+
+size_t encodeCompactHeartbeat(const HeartbeatRecord& record, char* out, size_t size) {
+    if (size < HEARTBEAT_COMPACT_MAX_LENGTH + 1) {
+        return 0;
+    }
+
+    uint8_t flags = (record.doorHeard ? HEARTBEAT_FLAG_DOOR_HEARD : 0) | (record.doorLowBattery ? HEARTBEAT_FLAG_DOOR_LOW_BATTERY : 0) |
+                    (record.doorTampered ? HEARTBEAT_FLAG_DOOR_TAMPERED : 0) | (record.isINSZero ? HEARTBEAT_FLAG_INS_ZERO : 0) |
+                    (record.doorMissedFrequently ? HEARTBEAT_FLAG_DOOR_MISSED_FREQUENTLY : 0);
+
+    uint8_t bytes[HEARTBEAT_COMPACT_MAX_BYTES] = {0};
+    uint8_t* next = bytes;
+    *next++ = HEARTBEAT_SCHEMA_ID;
+    *next++ = flags;
+    next = putU16(next, record.resetReason);
+    next = putU32(next, record.doorLastMessage);
+    next = putU16(next, record.insReaderLoad);
+    next = putU16(next, record.consecutiveOpenDoorHeartbeatCount);
+    next = putU16(next, record.doorMissedCount);
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        next = putU32(next, record.latency[stage].count);
+        next = putU32(next, record.latency[stage].p50);
+        next = putU32(next, record.latency[stage].p99);
+        next = putU32(next, record.latency[stage].max);
+    }
+    next = putQueue(next, record.insQueue);
+    next = putQueue(next, record.bleQueue);
+    next = putFloat(next, record.insMagnitude);
+    next = putU32(next, record.insFramesParsed);
+    next = putU32(next, record.insChecksumErrors);
+    next = putU32(next, record.insFramingErrors);
+    putU32(next, record.insBytesDiscarded);
+
+    next = bytes + HEARTBEAT_COMPACT_SCHEMA1_BYTES;
+    next = putU32(next, record.noiseFloor.sampleCount);
+    next = putFloat(next, record.noiseFloor.p50);
+    next = putFloat(next, record.noiseFloor.p99);
+    next = putU16(next, record.noiseFloor.stillnessThreshold);
+    next = putU16(next, record.noiseFloor.occupancyThreshold);
+
+    for (int occupancy = 0; occupancy < INS_OCCUPANCY_COUNT; occupancy++) {
+        const InsHistogramSnapshot& histogram = record.insHistogram[occupancy];
+        uint8_t span = (histogram.span < INS_HISTOGRAM_BUCKETS) ? histogram.span : INS_HISTOGRAM_BUCKETS;
+        *next++ = histogram.first;
+        *next++ = span;
+        memcpy(next, histogram.counts, span);
+        next += span;
+    }
+    size_t byteCount = (size_t)(next - bytes + 3) / 4 * 4;
+
+    // Z85: each 4 bytes, big endian, become 5 base 85 digits
+    size_t length = 0;
+    out[length++] = HEARTBEAT_COMPACT_PREFIX;
+    for (size_t i = 0; i < byteCount; i += 4) {
+        uint32_t value = ((uint32_t)bytes[i] << 24) | ((uint32_t)bytes[i + 1] << 16) | ((uint32_t)bytes[i + 2] << 8) | bytes[i + 3];
+        for (int digit = 4; digit >= 0; digit--) {
+            out[length + digit] = heartbeatZ85Digits[value % 85];
+            value /= 85;
+        }
+        length += 5;
+    }
+    out[length] = '\0';
+    return length;
+}
+
+// Device OS system_reset_reason_t values. The update error and safe mode codes have never
+// been named in the heartbeat, so they are sent as NONE like any other unknown code.
+const char* resetReasonName(uint16_t resetReason) {
+    switch (resetReason) {
+        case 20:
+            return "PIN_RESET";
+        case 30:
+            return "POWER_MANAGEMENT";
+        case 40:
+            return "POWER_DOWN";
+        case 50:
+            return "POWER_BROWNOUT";
+        case 60:
+            return "WATCHDOG";
+        case 70:
+            return "UPDATE";
+        case 90:
+            return "UPDATE_TIMEOUT";
+        case 100:
+            return "FACTORY_RESET";
+        case 120:
+            return "DFU_MODE";
+        case 130:
+            return "PANIC";
+        case 140:
+            return "USER";
+        case 10:
+            return "UNKNOWN";
+        default:
+            return "NONE";
+    }
+}
@@ -0,0 +1,137 @@
+/* heartbeatEncoding.h - JSON and compact encodings of the heartbeat message
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * getHeartbeat() fills a HeartbeatRecord and publishes it in the format chosen with the
+ * Heartbeat_Format console function. The JSON format is the heartbeat described in the
+ * README. The compact format is '~' followed by the Z85 (ZeroMQ base85) text of a fixed
+ * little endian layout. Its first byte is the schema ID, so the server and the decoder in
+ * sim/heartbeatDecode.h can tell the layouts apart as fields are added. '~' is not in the
+ * Z85 alphabet, and a JSON heartbeat starts with '{'.
+ *
+ * Schema 3, 140 to 432 bytes, 176 to 541 characters published:
+ *   offset  size  field
+ *   0       1     schema ID, 3
+ *   1       1     flags: bit 0 door heard from, 1 door low battery, 2 door tampered,
+ *                 3 INS is zero, 4 door missed frequently
+ *   2       2     reset reason, Device OS code
+ *   4       4     ms since the last door message
+ *   8       2     INS reader load, 1/1000
+ *   10      2     consecutive open door heartbeats, saturating
+ *   12      2     door missed count, saturating
+ *   14      64    latency per stage in LatencyStage order: count, p50, p99, max, 4 bytes each
+ *   78      8     INS queue: overflows (4), high water mark (2), mean occupancy (2)
+ *   86      8     BLE queue, as the INS queue
+ *   94      4     INS magnitude, IEEE 754 float
+ *   98      16    INS frames since boot: parsed, checksum errors, framing errors, bytes discarded
+ *   114     2     zero padding
+ *   116     4     INS noise floor values since boot (see noiseFloor.h)
+ *   120     8     INS noise floor p50 and p99, IEEE 754 floats
+ *   128     4     suggested stillness and occupancy detection thresholds (2 each), saturating
+ *   132     3x    INS magnitude histograms since the last heartbeat (see insHistogram.h),
+ *                 empty, moving then still, each: first bucket (1), span (1), span count codes
+ *   ...           zero padding to a multiple of 4 bytes
+ *
+ * Schema 2 is schema 3 without the noise floor, its histograms start at offset 116. Schema 1
+ * is schema 2 without the histograms.
+ *
+ * The INS magnitude, frame counts and histograms are only in the compact format. Append
+ * new fields to a new schema ID rather than changing the layout of one already deployed.
+ */
+
+#ifndef HEARTBEAT_ENCODING_H
+#define HEARTBEAT_ENCODING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "insHistogram.h"
+#include "jsonWriter.h"
+#include "latencyStats.h"
+#include "noiseFloor.h"
+
+// ***************************** Macro definitions *****************************
+
+#define HEARTBEAT_SCHEMA_ID             3
+#define HEARTBEAT_COMPACT_PREFIX        '~'
+
+// Schema 3 layout, see above. Schema 1 is HEARTBEAT_COMPACT_SCHEMA1_BYTES long.
+#define HEARTBEAT_COMPACT_SCHEMA1_BYTES 116
+#define HEARTBEAT_COMPACT_FIXED_BYTES   132
+#define HEARTBEAT_COMPACT_MAX_BYTES     (HEARTBEAT_COMPACT_FIXED_BYTES + INS_OCCUPANCY_COUNT * (2 + INS_HISTOGRAM_BUCKETS))
+#define HEARTBEAT_COMPACT_MAX_LENGTH    (1 + HEARTBEAT_COMPACT_MAX_BYTES / 4 * 5)
+
+#define HEARTBEAT_FLAG_DOOR_HEARD               0x01
+#define HEARTBEAT_FLAG_DOOR_LOW_BATTERY         0x02
+#define HEARTBEAT_FLAG_DOOR_TAMPERED            0x04
+#define HEARTBEAT_FLAG_INS_ZERO                 0x08
+#define HEARTBEAT_FLAG_DOOR_MISSED_FREQUENTLY   0x10
+
+static_assert(HEARTBEAT_COMPACT_SCHEMA1_BYTES % 4 == 0 && HEARTBEAT_COMPACT_FIXED_BYTES % 4 == 0 && HEARTBEAT_COMPACT_MAX_BYTES % 4 == 0, "Z85 encodes whole groups of 4 bytes");
+static_assert(HEARTBEAT_COMPACT_MAX_LENGTH <= PARTICLE_MAX_MESSAGE_LENGTH, "The compact heartbeat must fit in a Particle event");
+
+// Z85 digits in order of value
+inline constexpr char heartbeatZ85Digits[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.-:+=^!/*?&<>()[]{}@%$#";
+
+// ***************************** Global typedefs *****************************
+
+// Stored in EEPROM at ADDR_HEARTBEAT_FORMAT
+enum HeartbeatFormat {
+    HEARTBEAT_FORMAT_JSON = 0,
+    HEARTBEAT_FORMAT_COMPACT = 1,
+};
+
+typedef struct HeartbeatLatency {
+    uint32_t count;
+    uint32_t p50;       // ms
+    uint32_t p99;       // ms
+    uint32_t max;       // ms
+} HeartbeatLatency;
+
+typedef struct HeartbeatQueue {
+    uint32_t overflows;
+    uint16_t highWaterMark;
+    uint16_t meanOccupancy;     // 1/1000 of the capacity
+} HeartbeatQueue;
+
+typedef struct HeartbeatRecord {
+    bool doorHeard;             // Otherwise the door fields are -1 in JSON
+    uint32_t doorLastMessage;   // ms since the last door message
+    bool doorLowBattery;
+    bool doorTampered;
+    bool isINSZero;
+    uint16_t insReaderLoad;
+    HeartbeatLatency latency[LATENCY_STAGE_COUNT];
+    HeartbeatQueue insQueue;
+    HeartbeatQueue bleQueue;
+    uint32_t consecutiveOpenDoorHeartbeatCount;
+    uint32_t doorMissedCount;
+    bool doorMissedFrequently;
+    uint16_t resetReason;       // Device OS reset reason code
+    NoiseFloorSuggestion noiseFloor;
+
+    // Compact format only
+    float insMagnitude;
+    uint32_t insFramesParsed;
+    uint32_t insChecksumErrors;
+    uint32_t insFramingErrors;
+    uint32_t insBytesDiscarded;
+    InsHistogramSnapshot insHistogram[INS_OCCUPANCY_COUNT];
+} HeartbeatRecord;
+
+// ***************************** Function declarations *****************************
+
+// Writes the JSON heartbeat object. The compact only fields are added at the end when
+// withCompactFields is set, which the decoder uses to show them. The histograms are written
+// as [bucket lower bound, count] for each bucket counted in, and need a larger buffer than
+// a Particle event.
+void writeHeartbeatJson(const HeartbeatRecord& record, JsonWriter& writer, bool withCompactFields = false);
+
+// Writes the compact heartbeat and its terminator into out. Returns its length, or 0 if
+// size is less than HEARTBEAT_COMPACT_MAX_LENGTH + 1.
+size_t encodeCompactHeartbeat(const HeartbeatRecord& record, char* out, size_t size);
+
+// Name of a Device OS reset reason code, as sent in the JSON heartbeat
+const char* resetReasonName(uint16_t resetReason);
+
+#endif
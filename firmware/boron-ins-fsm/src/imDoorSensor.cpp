@@ -7,15 +7,20 @@
 
 #include "Particle.h"
 #include "imDoorSensor.h"
+#include "clock.h"
 #include "debugFlags.h"
 #include "flashAddresses.h"
+#include "jsonWriter.h"
+#include "profiler.h"
+#include "publishQueue.h"
 #include "stateMachine.h"
+#include "traceLog.h"
 
 // Global variables
 IMDoorID globalDoorID = {0xAA, 0xAA, 0xAA};
-os_queue_t bleQueue;
 
 int missedDoorEventCount = 0;
+unsigned long missedDoorEventTotal = 0;
 
 bool doorLowBatteryFlag = false;
 bool doorTamperedFlag = false;
@@ -23,11 +28,13 @@ bool doorMessageReceivedFlag = false;
 
 unsigned long doorHeartbeatReceived = 0;
 unsigned long doorLastMessage = 0;
-unsigned long timeWhenDoorClosed = 0;
+unsigned long doorClosedEventCount = 0;
 unsigned long consecutiveOpenDoorHeartbeatCount = 0;
 
+// Filled by the BLE scanner thread, drained by checkIM() on the application thread
+static SpscRing<doorData, BLE_QUEUE_SIZE> bleQueue;
+
 void setupIM() {
-    os_queue_create(&bleQueue, sizeof(doorData), 25, 0);
     new Thread("scanBLEThread", threadBLEScanner);
 }
 
@@ -56,6 +63,8 @@ void initializeDoorID() {
 }
 
 doorData checkIM() {
+    PROFILE_SCOPE(PROFILE_CHECK_IM);
+
     // Static variables to hold door data, retain values across function calls
     static doorData previousDoorData = {0x00, 0x00, 0};
     static doorData currentDoorData = {0x00, 0x00, 0};
@@ -63,7 +72,7 @@ doorData checkIM() {
 
     // Process BLE queue doorData (struct) populated by the thread
     // Thread is fast enough to load duplicate data packets so filter them out 
-    if (os_queue_take(bleQueue, &currentDoorData, 0, 0) == 0) {
+    if (bleQueue.pop(currentDoorData)) {
         static int initialDoorDataFlag = 1;
         
         // Check if door status flags are set to 1
@@ -72,17 +81,15 @@ doorData checkIM() {
 
         // Check if door heartbeat is received
         if ((currentDoorData.doorStatus & (1 << 3)) != 0) {
-            doorHeartbeatReceived = millis();
+            doorHeartbeatReceived = clockMillis();
         }
 
         // Handle door close event
         if ((currentDoorData.doorStatus & 0b0010) == 0) {
             // Reset timer on receiving a door close message or transition from open to closed + heartbeat
             if ((currentDoorData.doorStatus & 0b1000) == 0 || (previousDoorData.doorStatus & 0b0010) != 0) {
-                timeWhenDoorClosed = millis();
-
-                // Enable state transitions when door closes
-                allowTransitionToStateOne = true;
+                // The state machine enables state transitions when it sees the count change
+                doorClosedEventCount++;
                 Log.warn("Door closed - State transitions enabled");
             }
         
@@ -91,7 +98,7 @@ doorData checkIM() {
         }
 
         // Trigger heartbeat if threshold exceeded
-        if (millis() - doorLastMessage >= MSG_TRIGGER_SM_HEARTBEAT_THRESHOLD) {
+        if (clockMillisSince(doorLastMessage) >= MSG_TRIGGER_SM_HEARTBEAT_THRESHOLD) {
             // If the door is open upon sending this heartbeat, increment count
             if (isDoorOpen(currentDoorData.doorStatus)) {
                 consecutiveOpenDoorHeartbeatCount++;
@@ -101,7 +108,7 @@ doorData checkIM() {
         }
 
         // Record the time an IM Door Sensor message was received
-        doorLastMessage = millis();
+        doorLastMessage = clockMillis();
 
         // Handle initial door data
         if (initialDoorDataFlag) {
@@ -118,6 +125,7 @@ doorData checkIM() {
         else if (currentDoorData.controlByte > (previousDoorData.controlByte + 0x01)) {
             Log.error("curr > prev + 1, WARNING WARNING WARNING, missed door event!");
             missedDoorEventCount++;
+            missedDoorEventTotal++;
             logAndPublishDoorWarning(previousDoorData, currentDoorData);
             returnDoorData = currentDoorData;
             previousDoorData = currentDoorData;
@@ -129,89 +137,119 @@ doorData checkIM() {
         }
         // No new data
         else {
-            Log.info("no new data");
+            TRACE(TRACE_DOOR_NO_NEW_DATA, currentDoorData.controlByte);
         }
 
         // Record the time this value was pulled from the queue and control byte was checked
-        returnDoorData.timestamp = millis(); 
+        returnDoorData.timestamp = clockMillis(); 
     }
 
     return returnDoorData;
 }
 
+static constexpr JsonField doorDataFields[] = {
+    {"deviceid", JSON_HEX24},
+    {"data", JSON_HEX8},
+    {"control", JSON_HEX8},
+};
+
+static constexpr JsonField doorWarningFields[] = {
+    {"deviceid", JSON_HEX24},
+    {"prev_control_byte", JSON_HEX8},
+    {"curr_control_byte", JSON_HEX8},
+};
+
+// The door ID for JSON_HEX24, which writes byte1 first
+static uint32_t publishedDoorID() {
+    return ((uint32_t)globalDoorID.byte1 << 16) | ((uint32_t)globalDoorID.byte2 << 8) | globalDoorID.byte3;
+}
+
 void logAndPublishDoorData(doorData previousDoorData, doorData currentDoorData) {
-    char doorPublishBuffer[128];
-    sprintf(doorPublishBuffer, "{ \"deviceid\": \"%02X:%02X:%02X\", \"data\": \"%02X\", \"control\": \"%02X\" }", globalDoorID.byte1,
-            globalDoorID.byte2, globalDoorID.byte3, currentDoorData.doorStatus, currentDoorData.controlByte);
-    Particle.publish("IM Door Sensor Data", doorPublishBuffer, PRIVATE);
-    Log.warn("published, 0x%02X", currentDoorData.controlByte);
+    char doorPublishBuffer[jsonMaxLength(doorDataFields) + 1];
+    writeJson<doorDataFields>(doorPublishBuffer, publishedDoorID(), currentDoorData.doorStatus, currentDoorData.controlByte);
+    queuePublish("IM Door Sensor Data", doorPublishBuffer, PUBLISH_PRIORITY_DEBUG);
+    TRACE(TRACE_DOOR_DATA_PUBLISHED, currentDoorData.controlByte);
 }
 
 void logAndPublishDoorWarning(doorData previousDoorData, doorData currentDoorData) {
-    char doorPublishBuffer[128];
-    sprintf(doorPublishBuffer, "{ \"deviceid\": \"%02X:%02X:%02X\", \"prev_control_byte\": \"%02X\", \"curr_control_byte\": \"%02X\" }",
-            globalDoorID.byte1, globalDoorID.byte2, globalDoorID.byte3, previousDoorData.controlByte, currentDoorData.controlByte);
-    Particle.publish("IM Door Sensor Warning", doorPublishBuffer, PRIVATE);
+    char doorPublishBuffer[jsonMaxLength(doorWarningFields) + 1];
+    writeJson<doorWarningFields>(doorPublishBuffer, publishedDoorID(), previousDoorData.controlByte, currentDoorData.controlByte);
+    queuePublish("IM Door Sensor Warning", doorPublishBuffer, PUBLISH_PRIORITY_WARNING);
     Log.warn("Published IM Door Sensor warning, prev door byte = 0x%02X, curr door byte = 0x%02X", previousDoorData.controlByte,
              currentDoorData.controlByte);
 }
 
+SpscRingStats getBLEQueueStats() {
+    return bleQueue.stats();
+}
+
+SpscRingWindow takeBLEQueueWindow() {
+    return bleQueue.takeWindow();
+}
+
 void threadBLEScanner(void *param) {
-    doorData scanThreadDoorData;
-    unsigned char doorAdvertisingData[BLE_MAX_ADV_DATA_LEN];
     BLE.setScanTimeout(5);
 
     while (true) {
-        // Create a BLE scan filter
-        BleScanFilter filter;
-        char address[18];
-
-        // Format and add multiple types of valid BLE addresses to the filter
-        sprintf(address, "B8:7C:6F:%02X:%02X:%02X", globalDoorID.byte3, globalDoorID.byte2, globalDoorID.byte1);
-        filter.deviceName("iSensor ").address(address);
-        sprintf(address, "8C:9A:22:%02X:%02X:%02X", globalDoorID.byte3, globalDoorID.byte2, globalDoorID.byte1);
-        filter.address(address);
-        sprintf(address, "AC:9A:22:%02X:%02X:%02X", globalDoorID.byte3, globalDoorID.byte2, globalDoorID.byte1);
-        filter.address(address);
-        sprintf(address, "80:FB:F1:%02X:%02X:%02X", globalDoorID.byte3, globalDoorID.byte2, globalDoorID.byte1);
-        filter.address(address);
-
-        // Scan for BLE devices matching the filter
-        spark::Vector<BleScanResult> scanResults = BLE.scanWithFilter(filter);
-
-        for (BleScanResult scanResult : scanResults) {
-            // Extract manufacturer-specific data from BLE scan result
-            // More info: https://drive.google.com/file/d/1ZbnHi7uA_xMWVIiMbQjZlbT3OOoykbr4/view?usp=sharing
-            // dooradvertisingdata structure:
-            // [0]: Firmware Version
-            // [1-3]: Last 3 bytes of door sensor address
-            // [4]: Type ID (sensor type)
-            // [5]: Event Data (bit[0]: tamper, bit[1]: door open, bit[2]: low battery, bit[3]: heartbeat)
-            // [6]: Control Data
-            scanResult.advertisingData().get(BleAdvertisingDataType::MANUFACTURER_SPECIFIC_DATA, doorAdvertisingData, BLE_MAX_ADV_DATA_LEN);
-
-            // Load the neccessary data to the scannerThreadDoorData (doorData struct)
-            scanThreadDoorData.doorStatus = doorAdvertisingData[5];
-            scanThreadDoorData.controlByte = doorAdvertisingData[6];
-            
-            // If the 4th bit of the door status byte is set (indicating a door heartbeat every 10 minutes)
-            // and debugging is enabled, publish a debug message with the BLE advertising data.
-            if ((scanThreadDoorData.doorStatus & (1 << 3)) != 0 && stateMachineDebugFlag) {
-                char debugMessage[622] = "";
-                for (int i = 0; i < BLE_MAX_ADV_DATA_LEN; i++) {
-                    snprintf(debugMessage + strlen(debugMessage), sizeof(debugMessage), "%02X ", doorAdvertisingData[i]);
-                }
-                Particle.publish("Door Heartbeat Received", debugMessage, PRIVATE);
-            }
+        serviceBLEScanner();
 
-            // Put the door sensor data into a queue for further processing
-            if (os_queue_put(bleQueue, (void *)&scanThreadDoorData, 0, 0) != 0) {
-                Log.error("Failed to put data into the queue.");
+        // Yield the thread to allow other threads to run
+        os_thread_yield();
+    }
+}
+
+// One pass of the scanner thread: scan for the paired door sensor and queue what it sent
+void serviceBLEScanner() {
+    doorData scanThreadDoorData = {0x00, 0x00, 0};
+    unsigned char doorAdvertisingData[BLE_MAX_ADV_DATA_LEN];
+
+    // Create a BLE scan filter
+    BleScanFilter filter;
+    char address[18];
+
+    // Format and add multiple types of valid BLE addresses to the filter
+    sprintf(address, "B8:7C:6F:%02X:%02X:%02X", globalDoorID.byte3, globalDoorID.byte2, globalDoorID.byte1);
+    filter.deviceName("iSensor ").address(address);
+    sprintf(address, "8C:9A:22:%02X:%02X:%02X", globalDoorID.byte3, globalDoorID.byte2, globalDoorID.byte1);
+    filter.address(address);
+    sprintf(address, "AC:9A:22:%02X:%02X:%02X", globalDoorID.byte3, globalDoorID.byte2, globalDoorID.byte1);
+    filter.address(address);
+    sprintf(address, "80:FB:F1:%02X:%02X:%02X", globalDoorID.byte3, globalDoorID.byte2, globalDoorID.byte1);
+    filter.address(address);
+
+    // Scan for BLE devices matching the filter
+    spark::Vector<BleScanResult> scanResults = BLE.scanWithFilter(filter);
+
+    for (BleScanResult scanResult : scanResults) {
+        // Extract manufacturer-specific data from BLE scan result
+        // More info: https://drive.google.com/file/d/1ZbnHi7uA_xMWVIiMbQjZlbT3OOoykbr4/view?usp=sharing
+        // dooradvertisingdata structure:
+        // [0]: Firmware Version
+        // [1-3]: Last 3 bytes of door sensor address
+        // [4]: Type ID (sensor type)
+        // [5]: Event Data (bit[0]: tamper, bit[1]: door open, bit[2]: low battery, bit[3]: heartbeat)
+        // [6]: Control Data
+        size_t advertisingLength = scanResult.advertisingData().get(BleAdvertisingDataType::MANUFACTURER_SPECIFIC_DATA, doorAdvertisingData, BLE_MAX_ADV_DATA_LEN);
+
+        // Load the neccessary data to the scannerThreadDoorData (doorData struct)
+        scanThreadDoorData.doorStatus = doorAdvertisingData[5];
+        scanThreadDoorData.controlByte = doorAdvertisingData[6];
+        
+        // If the 4th bit of the door status byte is set (indicating a door heartbeat every 10 minutes)
+        // and debugging is enabled, queue a debug message with the BLE advertising data.
+        // Only the bytes the scan returned are set, the rest of the buffer is left over stack.
+        if ((scanThreadDoorData.doorStatus & (1 << 3)) != 0 && stateMachineDebugFlag) {
+            char debugMessage[622] = "";
+            for (size_t i = 0; i < advertisingLength; i++) {
+                snprintf(debugMessage + strlen(debugMessage), sizeof(debugMessage), "%02X ", doorAdvertisingData[i]);
             }
+            queuePublish("Door Heartbeat Received", debugMessage, PUBLISH_PRIORITY_DEBUG);
         }
 
-        // Yield the thread to allow other threads to run
-        os_thread_yield();
+        // Put the door sensor data into a queue for further processing
+        if (!bleQueue.push(scanThreadDoorData)) {
+            Log.error("Failed to put data into the queue.");
+        }
     }
 }
 
@@ -9,6 +9,7 @@
 #define IM_DOOR_H
 
 #include "Particle.h"
+#include "spscRing.h"
 
 // ***************************** Macro definitions ****************************
 
@@ -25,6 +26,9 @@
 #define HEARTBEAT          0x08     // Heartbeat status
 #define HEARTBEAT_AND_OPEN 0x0A     // Heartbeat and door open status
 
+// Door events buffered between the BLE scanner thread and checkIM(), must be a power of two
+#define BLE_QUEUE_SIZE 32
+
 // Threshold for triggering state machine heartbeat
 #define MSG_TRIGGER_SM_HEARTBEAT_THRESHOLD  540000  // 9 mins in ms
 
@@ -48,12 +52,13 @@ extern os_queue_t bleHeartbeatQueue;
 extern IMDoorID globalDoorID;
 
 extern int missedDoorEventCount;
+extern unsigned long missedDoorEventTotal;     // Missed door events since startup
 extern bool doorLowBatteryFlag;
 extern bool doorTamperedFlag;
 extern bool doorMessageReceivedFlag;
 extern unsigned long doorHeartbeatReceived; 
 extern unsigned long doorLastMessage;
-extern unsigned long timeWhenDoorClosed; 
+extern unsigned long doorClosedEventCount;     // Door close messages received since startup
 extern unsigned long consecutiveOpenDoorHeartbeatCount;
 
 // *************************** Function declarations **************************
@@ -67,8 +72,12 @@ doorData checkIM(void);
 void logAndPublishDoorWarning(doorData previousDoorData, doorData currentDoorData);
 void logAndPublishDoorData(doorData previousDoorData, doorData currentDoorData);
 
+SpscRingStats getBLEQueueStats(void);
+SpscRingWindow takeBLEQueueWindow(void);
+
 // threads
 void threadBLEScanner(void *param);
+void serviceBLEScanner(void);  // One pass of threadBLEScanner, also driven by the host simulator
 
 // Door Sensor Utility Functions
 int isDoorOpen(int doorStatus);
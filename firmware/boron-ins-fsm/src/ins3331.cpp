@@ -8,213 +8,236 @@
 
 #include "Particle.h"
 #include "ins3331.h"
-#include <CircularBuffer.h>
-#include <math.h>
-
-os_queue_t insQueue;
-
-// Outlier rejection state
-static float iQ1 = 0, iQ3 = 0, qQ1 = 0, qQ3 = 0;
-static bool quartilesInitialized = false;
-
-// Helper function: Sort array for median/quartile calculation
-static void sortArray(int16_t arr[], int n) {
-    for (int i = 0; i < n - 1; i++) {
-        for (int j = 0; j < n - i - 1; j++) {
-            if (arr[j] > arr[j + 1]) {
-                int16_t temp = arr[j];
-                arr[j] = arr[j + 1];
-                arr[j + 1] = temp;
-            }
+#include "clock.h"
+#include "insFilter.h"
+#include "insFrameParser.h"
+#include "latencyStats.h"
+#include "profiler.h"
+#include "seqlock.h"
+#include "spscRing.h"
+#include <new>
+
+// Filled by the reader thread, drained by the filter thread. Each reader wake-up pushes
+// its samples and then one mark with their count and arrival time, so the filter thread
+// only pops samples whose mark it has already popped.
+static SpscRing<rawINSData, INS_QUEUE_SIZE> insQueue;
+static SpscRing<InsArrivalMark, INS_ARRIVAL_MARK_COUNT> insArrivals;
+
+// All filter state for the radar, see insFilter.h
+static FirmwareInsFilter insFilter;
+
+// Last filter output with the time it was produced and the queue lag of the last drain,
+// only touched by the filter thread
+static filteredINSData returnINSData = {0, 0, 0, 0, 0};
+
+// returnINSData as published to every other thread
+static Seqlock<filteredINSData> insSnapshot;
+
+// Setup the INS3331 sensor interface
+void setupINS3331() {
+    new Thread("readINSThread", threadINSReader);
+    new Thread("filterINSThread", threadINSFilter);
+}
+
+// Run a block of raw samples that arrived together through the filter chain, oldest first
+filteredINSData processINSBlock(const rawINSData* block, size_t n, uint16_t arrival) {
+    bool updated = false;
+    for (size_t i = 0; i < n; i++) {
+        if (insFilter.push(block[i], arrival)) {
+            recordLatency(LATENCY_FILTER, insFilter.value().groupDelay);
+            updated = true;
         }
     }
-}
 
-// Helper function: Calculate median of a circular buffer
-static float calculateMedian(CircularBuffer<int16_t, MEDIAN_FILTER_SIZE>& buffer) {
-    int16_t sorted[MEDIAN_FILTER_SIZE];
-    for (int i = 0; i < MEDIAN_FILTER_SIZE; i++) {
-        sorted[i] = buffer[i];
+    if (updated) {
+        unsigned int queueLag = returnINSData.queueLag;
+        uint32_t now = clockMillis();
+        returnINSData = insFilter.value();
+        returnINSData.timestamp = now;
+        returnINSData.queueLag = queueLag;
+
+        // Widen the 16 bit arrival time, the sample arrived less than 65 s ago
+        returnINSData.sampleTime = now - (uint16_t)((uint16_t)now - arrival);
     }
-    sortArray(sorted, MEDIAN_FILTER_SIZE);
-    return (float)sorted[MEDIAN_FILTER_SIZE / 2];
+    return returnINSData;
 }
 
-// Helper function: Update quartiles for outlier detection
-static void updateQuartiles(CircularBuffer<int16_t, QUARTILE_BUFFER_SIZE>& iHistory,
-                            CircularBuffer<int16_t, QUARTILE_BUFFER_SIZE>& qHistory) {
-    if (!iHistory.isFull()) return;
+// Drop everything the filter has seen, the next value needs the filter windows to fill again.
+// Only call from the filter thread or before it starts.
+void resetINSFilter() {
+    insFilter.reset();
+    returnINSData = {0, 0, 0, 0, 0};
+    insSnapshot.write(returnINSData);
+}
 
-    int16_t iSorted[QUARTILE_BUFFER_SIZE], qSorted[QUARTILE_BUFFER_SIZE];
-    for (int i = 0; i < QUARTILE_BUFFER_SIZE; i++) {
-        iSorted[i] = iHistory[i];
-        qSorted[i] = qHistory[i];
+// Thread that filters radar samples as the reader thread queues them
+// Runs apart from the application loop so the filter rate does not depend on how often
+// the state machine or the heartbeat look at the radar, and looking never advances it.
+void threadINSFilter(void *param) {
+    while (true) {
+        serviceINSFilter();
+        delay(INS_FILTER_WAIT_INTERVAL);
     }
-    sortArray(iSorted, QUARTILE_BUFFER_SIZE);
-    sortArray(qSorted, QUARTILE_BUFFER_SIZE);
+}
 
-    int q1Idx = QUARTILE_BUFFER_SIZE / 4;
-    int q3Idx = (3 * QUARTILE_BUFFER_SIZE) / 4;
+// One wake-up of the filter thread: drain every frame queued by the reader thread, filter
+// them as a batch and publish the result, so the snapshot always reflects the newest radar data
+void serviceINSFilter() {
+    // The mark being drained, kept across passes that stop part way through it
+    static InsArrivalMark mark = {0, 0};
 
-    iQ1 = iSorted[q1Idx];
-    iQ3 = iSorted[q3Idx];
-    qQ1 = qSorted[q1Idx];
-    qQ3 = qSorted[q3Idx];
-    quartilesInitialized = true;
-}
+    rawINSData block[INS_BLOCK_SIZE];
+    unsigned int drained = 0;
 
-// Helper function: Check if value is an outlier using IQR method
-static bool isOutlier(int16_t value, float q1, float q3) {
-    if (!quartilesInitialized) return false;
-    float iqr = q3 - q1;
-    float lowerBound = q1 - (IQR_MULTIPLIER * iqr);
-    float upperBound = q3 + (IQR_MULTIPLIER * iqr);
-    return (value < lowerBound || value > upperBound);
-}
+    // Bounded by the queue depth so a producer that keeps pace with us cannot hold the
+    // filter thread here; anything left over is picked up on the next pass
+    while (drained < INS_QUEUE_SIZE) {
+        if (mark.count == 0 && !insArrivals.pop(mark)) {
+            break;
+        }
 
-// Setup the INS3331 sensor interface
-void setupINS3331() {
-    os_queue_create(&insQueue, sizeof(rawINSData), 128, 0);
-    new Thread("readINSThread", threadINSReader);
-}
+        // The mark was pushed after its samples, so they are all there to pop
+        size_t n = insQueue.popBulk(block, (mark.count < INS_BLOCK_SIZE) ? mark.count : INS_BLOCK_SIZE);
+        if (n == 0) {
+            break;
+        }
+        mark.count -= n;
 
-// Check and filter INS3331 sensor data
-filteredINSData checkINS3331() {
-    rawINSData dataToParse;
+        uint16_t queueLatency = (uint16_t)((uint16_t)clockMillis() - mark.arrival);
+        for (size_t i = 0; i < n; i++) {
+            recordLatency(LATENCY_QUEUE, queueLatency);
+        }
 
-    // Stage 1: Median filter buffers (raw samples)
-    static CircularBuffer<int16_t, MEDIAN_FILTER_SIZE> iMedianBuffer, qMedianBuffer;
+        processINSBlock(block, n, mark.arrival);
+        drained += n;
+    }
+
+    // Nothing new, the published snapshot still holds
+    if (drained == 0) {
+        return;
+    }
 
-    // Stage 2: Moving average buffers (median-filtered values)
-    static CircularBuffer<float, MOVING_AVERAGE_BUFFER_SIZE> iMABuffer, qMABuffer;
+    // Number of frames that were waiting in the queue for this pass
+    returnINSData.queueLag = drained;
+    insSnapshot.write(returnINSData);
+}
 
-    // History buffers for quartile calculation (outlier rejection)
-    static CircularBuffer<int16_t, QUARTILE_BUFFER_SIZE> iHistory, qHistory;
+// Latest filtered value published by the filter thread. Never blocks and leaves the filter
+// untouched, so any thread can call it as often as it likes.
+filteredINSData readINSSnapshot() {
+    PROFILE_SCOPE(PROFILE_READ_INS);
+    return insSnapshot.read();
+}
 
-    // Running sums for efficient moving average
-    static float iSum = 0;
-    static float qSum = 0;
+// Samples queued by the reader thread that no mark has counted yet. Frames are parsed
+// when the reader thread wakes, so their arrival time is the wake-up and leaves out up to
+// INS_READER_WAIT_INTERVAL ms the frames spent in the UART receive buffer.
+static InsArrivalMark unmarkedSamples = {0, 0};
 
-    // Quartile update counter (update every 10 samples for efficiency)
-    static int sampleCount = 0;
+// Frame parser sink: queue each valid sample for the filter thread
+static void queueINSSample(int16_t inPhase, int16_t quadrature, void* context) {
+    rawINSData rawData = {inPhase, quadrature};
+    if (insQueue.push(rawData)) {
+        unmarkedSamples.count++;
+    }
+}
 
-    static filteredINSData returnINSData = {0, 0, 0, 0};
+static InsFrameParser insFrameParser(queueINSSample, nullptr);
 
-    if (os_queue_take(insQueue, &dataToParse, 0, 0) == 0) {
-        // Skip invalid frames (checksum failed)
-        if (!dataToParse.isValid) {
-            return returnINSData;
-        }
+InsFrameParserStats getINSFrameParserStats() {
+    return insFrameParser.stats();
+}
 
-        // Use absolute values to get signal magnitude components
-        int16_t iAbs = abs(dataToParse.inPhase);
-        int16_t qAbs = abs(dataToParse.quadrature);
+SpscRingStats getINSQueueStats() {
+    return insQueue.stats();
+}
 
-        // Update history for quartile calculation
-        iHistory.push(iAbs);
-        qHistory.push(qAbs);
+SpscRingWindow takeINSQueueWindow() {
+    return insQueue.takeWindow();
+}
 
-        // Update quartiles periodically (once buffer is full)
-        sampleCount++;
-        if (sampleCount >= 10 && iHistory.isFull()) {
-            updateQuartiles(iHistory, qHistory);
-            sampleCount = 0;
-        }
+// Reader thread CPU accounting, written only by the reader thread
+static volatile uint32_t insReaderBusyMicros = 0;
+static volatile uint32_t insReaderWakeups = 0;
+static volatile uint32_t insReaderBytesRead = 0;
 
-        // Outlier rejection: skip samples that are statistical outliers
-        if (isOutlier(iAbs, iQ1, iQ3) || isOutlier(qAbs, qQ1, qQ3)) {
-            return returnINSData;
-        }
+// Thread to read data from INS3331 sensor
+// Sleeps between reads instead of spinning on SerialRadar.available(): the enlarged UART
+// receive buffer holds several frame periods of data, so waking every
+// INS_READER_WAIT_INTERVAL and taking everything buffered loses nothing and leaves the
+// CPU to the application thread (or idle) the rest of the time.
+void threadINSReader(void *param) {
+    while (true) {
+        serviceINSReader();
+        delay(INS_READER_WAIT_INTERVAL);
+    }
+}
 
-        // Stage 1: Push to median filter buffers
-        iMedianBuffer.push(iAbs);
-        qMedianBuffer.push(qAbs);
+// One wake-up of the reader thread: parse everything buffered by the UART
+void serviceINSReader() {
+    uint8_t chunk[INS_READ_CHUNK_SIZE];
+    uint32_t wokeAt = micros();
+    insReaderWakeups = insReaderWakeups + 1;
 
-        // Only proceed when median buffer is full
-        if (!iMedianBuffer.isFull()) {
-            return returnINSData;
-        }
+    // While the mark ring is full the samples join the waiting mark and keep its older time
+    if (unmarkedSamples.count == 0) {
+        unmarkedSamples.arrival = (uint16_t)clockMillis();
+    }
 
-        // Calculate median of current window
-        float iMedian = calculateMedian(iMedianBuffer);
-        float qMedian = calculateMedian(qMedianBuffer);
-
-        // Stage 2: Push median values to moving average buffer
-        iMABuffer.push(iMedian);
-        qMABuffer.push(qMedian);
-
-        // Calculate initial moving average when buffer reaches sample size
-        if (iMABuffer.size() == MOVING_AVERAGE_SAMPLE_SIZE) {
-            iSum = 0;
-            qSum = 0;
-            for (int i = 0; i < MOVING_AVERAGE_SAMPLE_SIZE; i++) {
-                iSum += iMABuffer[i];
-                qSum += qMABuffer[i];
-            }
-            returnINSData.iAverage = iSum / MOVING_AVERAGE_SAMPLE_SIZE;
-            returnINSData.qAverage = qSum / MOVING_AVERAGE_SAMPLE_SIZE;
-            returnINSData.magnitude = sqrtf(returnINSData.iAverage * returnINSData.iAverage +
-                                            returnINSData.qAverage * returnINSData.qAverage);
-            returnINSData.timestamp = millis();
+    int available = SerialRadar.available();
+    while (available > 0) {
+        size_t length = ((size_t)available < sizeof(chunk)) ? (size_t)available : sizeof(chunk);
+        length = SerialRadar.readBytes((char *)chunk, length);
+        if (length == 0) {
+            break;
         }
+        insFrameParser.feed(chunk, length);
+        insReaderBytesRead = insReaderBytesRead + length;
+        available = SerialRadar.available();
+    }
 
-        // Update moving average with sliding window
-        if (iMABuffer.size() == MOVING_AVERAGE_BUFFER_SIZE) {
-            // CircularBuffer: [0] is oldest, [size-1] is newest
-            iSum = iSum - iMABuffer[0] + iMABuffer[MOVING_AVERAGE_BUFFER_SIZE - 1];
-            qSum = qSum - qMABuffer[0] + qMABuffer[MOVING_AVERAGE_BUFFER_SIZE - 1];
-            returnINSData.iAverage = iSum / MOVING_AVERAGE_SAMPLE_SIZE;
-            returnINSData.qAverage = qSum / MOVING_AVERAGE_SAMPLE_SIZE;
-            returnINSData.magnitude = sqrtf(returnINSData.iAverage * returnINSData.iAverage +
-                                            returnINSData.qAverage * returnINSData.qAverage);
-            returnINSData.timestamp = millis();
-        }
+    if (unmarkedSamples.count > 0 && insArrivals.push(unmarkedSamples)) {
+        unmarkedSamples.count = 0;
     }
 
-    return returnINSData;
+    insReaderBusyMicros = insReaderBusyMicros + (micros() - wokeAt);
 }
 
-// Thread to read data from INS3331 sensor
-void threadINSReader(void *param) {
-    static signed char receiveBuffer[14];
-    static int receiveBufferIndex;
-    signed char iHighByte, iLowByte, qHighByte, qLowByte;
-    rawINSData rawData;
+InsReaderStats getINSReaderStats() {
+    InsReaderStats stats;
+    stats.busyMicros = insReaderBusyMicros;
+    stats.wakeups = insReaderWakeups;
+    stats.bytesRead = insReaderBytesRead;
+    return stats;
+}
 
-    while (true) {
-        if (SerialRadar.available()) {
-            unsigned char c = SerialRadar.read();
-
-            // Start of new data frame
-            if (c == START_DELIMITER) receiveBufferIndex = 0;
-
-            receiveBuffer[receiveBufferIndex++] = c;
-
-            // End of data frame
-            if (c == END_DELIMITER) {
-                // Validate checksum before processing
-                // Receive frame (no WAKEUP_BYTE): [0]=START, [1-11]=data, [12]=checksum, [13]=END
-                // Checksum is sum of bytes 1-11 (data portion)
-                unsigned char receivedChecksum = (unsigned char)receiveBuffer[12];
-                unsigned char calculatedChecksum = 0;
-                for (int i = 1; i <= 11; i++) {
-                    calculatedChecksum += (unsigned char)receiveBuffer[i];
-                }
-                rawData.isValid = (receivedChecksum == calculatedChecksum);
-
-                iHighByte = receiveBuffer[7];
-                iLowByte = receiveBuffer[8];
-                qHighByte = receiveBuffer[9];
-                qLowByte = receiveBuffer[10];
-
-                rawData.inPhase = (int16_t)(iHighByte << 8 | iLowByte);
-                rawData.quadrature = (int16_t)(qHighByte << 8 | qLowByte);
-
-                os_queue_put(insQueue, (void *)&rawData, 0, 0);
-            }
-        }
-        os_thread_yield();
-    }
+// The wall time is in ms, as a window can outlast the 71 minutes micros() takes to wrap,
+// e.g. while a heartbeat waits out a cloud outage
+InsReaderWindow takeINSReaderWindow() {
+    static uint32_t lastBusyMicros = 0;
+    static uint32_t lastCallMillis = 0;
+
+    uint32_t busy = insReaderBusyMicros;
+    InsReaderWindow window;
+    window.busyMicros = busy - lastBusyMicros;
+    window.elapsedMillis = clockMillisSince(lastCallMillis);
+
+    lastBusyMicros = busy;
+    lastCallMillis = clockMillis();
+    return window;
+}
+
+// Device OS hook: give the radar UART a larger receive buffer than the 64 byte default so
+// the reader thread can sleep for whole frame periods without the UART overflowing
+hal_usart_buffer_config_t acquireSerial1Buffer() {
+    hal_usart_buffer_config_t config = {
+        .size = sizeof(hal_usart_buffer_config_t),
+        .rx_buffer = new (std::nothrow) uint8_t[INS_SERIAL_RX_BUFFER_SIZE],
+        .rx_buffer_size = INS_SERIAL_RX_BUFFER_SIZE,
+        .tx_buffer = new (std::nothrow) uint8_t[INS_SERIAL_TX_BUFFER_SIZE],
+        .tx_buffer_size = INS_SERIAL_TX_BUFFER_SIZE
+    };
+    return config;
 }
 
 // Start INS3331 serial communication
@@ -9,6 +9,8 @@
 #define INS3331_H
 
 #include "Particle.h"
+#include "insFrameParser.h"
+#include "spscRing.h"
 
 // ***************************** Macro definitions *****************************
 
@@ -24,30 +26,78 @@
 #define APPLICATION_STOP  0xE4
 #define APPLICATION_START 0xEB
 
-// Filter configuration
+// Filter configuration, the window sizes of FirmwareInsFilter (see insFilter.h)
 #define MEDIAN_FILTER_SIZE 5          // Odd number for median calculation
 #define MOVING_AVERAGE_SAMPLE_SIZE 20 // MA window after median filter
-#define MOVING_AVERAGE_BUFFER_SIZE 21 // Buffer size = sample size + 1
 
 // Outlier rejection (IQR-based)
 #define IQR_MULTIPLIER 1.5f           // Samples outside Q1-1.5*IQR to Q3+1.5*IQR are rejected
 #define QUARTILE_BUFFER_SIZE 50       // Samples used for quartile estimation
 
+// Build option: run the filter chain on integers only (int32 running sums, integer
+// square root, Q-format outputs) instead of float. See insMovingAverage.h.
+// #define INS_FIXED_POINT
+
+// Raw sample ring between the reader and filter threads, must be a power of two
+#define INS_QUEUE_SIZE 128            // Frames buffered before the reader starts dropping them
+#define INS_BLOCK_SIZE 16             // Frames taken from the ring per filter batch
+#define INS_ARRIVAL_MARK_COUNT 16     // Reader wake-ups whose arrival times can wait, a power of two
+#define INS_READ_CHUNK_SIZE 64        // Bytes read from the UART per parser call
+
+// Reader thread wake-up interval. At 38400 baud the UART receives ~3.8 bytes/ms, so the
+// receive buffer below holds ~65 ms of data: several wake-up intervals of headroom.
+#define INS_READER_WAIT_INTERVAL   20    // 20 ms
+#define INS_SERIAL_RX_BUFFER_SIZE  256
+#define INS_SERIAL_TX_BUFFER_SIZE  64
+
+// Filter thread wake-up interval. Each pass filters everything the reader queued since the
+// last one, so this bounds how stale the published snapshot is behind the reader.
+#define INS_FILTER_WAIT_INTERVAL   10    // 10 ms
+
 // ***************************** Global typedefs *****************************
 
+// Only frames that pass checksum validation are queued, so a sample is just its I/Q pair
 typedef struct rawINSData {
     int16_t inPhase;
     int16_t quadrature;
-    bool isValid;         // Checksum validation result
 } rawINSData;
 
+static_assert(sizeof(rawINSData) == 4, "rawINSData should pack into 4 bytes");
+
+// The samples one reader wake-up queued, in a ring of their own beside the sample ring so
+// the sample record stays 4 bytes. 16 bits of ms are plenty for samples that wait a few ms.
+typedef struct InsArrivalMark {
+    uint16_t arrival;     // Low 16 bits of clockMillis() when the reader woke
+    uint16_t count;       // Samples queued since the previous mark
+} InsArrivalMark;
+
 typedef struct filteredINSData {
     float iAverage;
     float qAverage;
     float magnitude;      // sqrt(I² + Q²) - primary metric for motion detection
     unsigned long timestamp;
+    unsigned int queueLag;  // Frames drained from the queue by the filter pass that produced this value
+    unsigned long sampleTime;  // clockMillis() when the newest sample in this value arrived
+    uint16_t groupDelay;    // ms from the sample at the centre of the filter windows to the newest
+
+    // Q-format views of the averages and magnitude, only filled with INS_FIXED_POINT
+    int32_t iAverageQ;
+    int32_t qAverageQ;
+    int32_t magnitudeQ;
 } filteredINSData;
 
+typedef struct InsReaderStats {
+    uint32_t busyMicros;  // Time the reader thread spent awake (wraps, use differences)
+    uint32_t wakeups;     // Times the reader thread woke up
+    uint32_t bytesRead;   // Bytes read from the radar UART
+} InsReaderStats;
+
+// Reader thread time since the previous takeINSReaderWindow(), for periodic telemetry
+typedef struct InsReaderWindow {
+    uint32_t busyMicros;     // Time the reader thread spent awake
+    uint32_t elapsedMillis;  // Wall time
+} InsReaderWindow;
+
 extern os_queue_t insHeartbeatQueue;
 
 // ***************************** Function declarations *****************************
@@ -55,8 +105,19 @@ extern os_queue_t insHeartbeatQueue;
 // setup() functions
 void setupINS3331(void);
 
-// loop() functions
-filteredINSData checkINS3331(void);
+// loop() functions, safe from any thread
+filteredINSData readINSSnapshot(void);
+InsFrameParserStats getINSFrameParserStats(void);
+InsReaderStats getINSReaderStats(void);
+SpscRingStats getINSQueueStats(void);
+
+// Telemetry windows, from one thread at a time
+SpscRingWindow takeINSQueueWindow(void);
+InsReaderWindow takeINSReaderWindow(void);
+
+// Filter thread functions
+filteredINSData processINSBlock(const rawINSData* block, size_t n, uint16_t arrival);
+void resetINSFilter(void);
 
 // loop() functions that only execute once
 void startINSSerial(void);
@@ -66,5 +127,8 @@ unsigned char calculateChecksum(unsigned char myArray[], int arrayLength);
 
 // threads
 void threadINSReader(void *param);
+void serviceINSReader(void);  // One pass of threadINSReader, also driven by the host simulator
+void threadINSFilter(void *param);
+void serviceINSFilter(void);  // One pass of threadINSFilter, also driven by the host simulator
 
 #endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+/* insFilter.h - INS3331 filter chain: outlier rejection, median and moving average
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#ifndef INS_FILTER_H
+#define INS_FILTER_H
+
+#include "ins3331.h"
+#include "insMovingAverage.h"
+#include "medianNetwork.h"
+#include "orderStatistics.h"
+#include <CircularBuffer.h>
+
+/*
+ * All state of the filter chain for one radar, so it can be reset, run side by side with
+ * other window sizes and driven sample by sample from tests and benchmarks.
+ *
+ * push() runs one raw sample through three stages:
+ *  1. Outlier rejection: the absolute I and Q values are added to QuartileN sample
+ *     histories, and once those are full, samples outside Q1 - IQR_MULTIPLIER * IQR to
+ *     Q3 + IQR_MULTIPLIER * IQR are dropped.
+ *  2. Median of the last MedianN accepted samples, I and Q through one selection network.
+ *  3. Moving average of the last MaN medians and the magnitude of the averages, float or
+ *     INS_FIXED_POINT.
+ *
+ * push() returns true when value() was updated, i.e. once the median and moving average
+ * windows have filled and for every accepted sample after that. The filter fills
+ * groupDelay from the arrival times passed with the samples; timestamp, queueLag and
+ * sampleTime of value() are left for the caller to fill.
+ */
+template <size_t MedianN, size_t MaN, size_t QuartileN>
+class InsFilter {
+public:
+    static_assert(MedianN % 2 == 1, "The median window must be odd");
+    static_assert(MaN > 0 && QuartileN >= 4, "The moving average and quartile windows must not be empty");
+
+    InsFilter();
+
+    bool push(rawINSData sample, uint16_t arrival);
+    const filteredINSData& value() const;
+
+    // Back to an empty filter, as if no samples had been pushed
+    void reset();
+
+private:
+    void updateQuartiles();
+    bool isOutlier(int16_t value, int16_t q1, int16_t q3) const;
+
+    // Outlier rejection
+    SortedWindow<int16_t, QuartileN> iHistory, qHistory;
+    int16_t iQ1, iQ3, qQ1, qQ3;
+    bool quartilesInitialized;
+
+    // Stage 1
+    CircularBuffer<int16_t, MedianN> iMedianBuffer, qMedianBuffer;
+
+    // Arrival times of the accepted samples, back to the one at the centre of the median
+    // window of the median at the centre of the moving average window
+    CircularBuffer<uint16_t, MedianN / 2 + (MaN - 1) / 2 + 1> arrivals;
+
+    // Stage 2
+#ifdef INS_FIXED_POINT
+    FixedPointMovingAverage<MaN> movingAverage;
+#else
+    FloatMovingAverage<MaN> movingAverage;
+#endif
+
+    filteredINSData output;
+};
+
+// The filter the firmware runs
+typedef InsFilter<MEDIAN_FILTER_SIZE, MOVING_AVERAGE_SAMPLE_SIZE, QUARTILE_BUFFER_SIZE> FirmwareInsFilter;
+
+#include "insFilter.tpp"
+
+#endif
@@ -0,0 +1,121 @@
+/* insFilter.tpp - INS3331 filter chain template implementation
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include <stdlib.h>
+
+template <size_t MedianN, size_t MaN, size_t QuartileN>
+InsFilter<MedianN, MaN, QuartileN>::InsFilter() {
+    reset();
+}
+
+template <size_t MedianN, size_t MaN, size_t QuartileN>
+bool InsFilter<MedianN, MaN, QuartileN>::push(rawINSData sample, uint16_t arrival) {
+    // Use absolute values to get signal magnitude components
+    int16_t iAbs = abs(sample.inPhase);
+    int16_t qAbs = abs(sample.quadrature);
+
+    // Update history for quartile calculation
+    iHistory.push(iAbs);
+    qHistory.push(qAbs);
+
+    // Quartiles are exact for every sample once the history window is full
+    updateQuartiles();
+
+    // Outlier rejection: skip samples that are statistical outliers
+    if (isOutlier(iAbs, iQ1, iQ3) || isOutlier(qAbs, qQ1, qQ3)) {
+        return false;
+    }
+
+    // Stage 1: Push to median filter buffers
+    iMedianBuffer.push(iAbs);
+    qMedianBuffer.push(qAbs);
+    arrivals.push(arrival);
+
+    // Only proceed when median buffer is full
+    if (!iMedianBuffer.isFull()) {
+        return false;
+    }
+
+    // Calculate median of current window, I and Q through the same selection network
+    int16_t iWindow[MedianN], qWindow[MedianN];
+    for (size_t i = 0; i < MedianN; i++) {
+        iWindow[i] = iMedianBuffer[i];
+        qWindow[i] = qMedianBuffer[i];
+    }
+
+    int16_t iMedian, qMedian;
+    MedianNetwork<MedianN>::medianPair(iWindow, qWindow, iMedian, qMedian);
+
+    // Stage 2: Moving average of the medians and magnitude
+    if (!movingAverage.push(iMedian, qMedian, output)) {
+        return false;
+    }
+
+    // Both windows have filled, so arrivals has too
+    output.groupDelay = (uint16_t)(arrival - arrivals.first());
+    return true;
+}
+
+template <size_t MedianN, size_t MaN, size_t QuartileN>
+const filteredINSData& InsFilter<MedianN, MaN, QuartileN>::value() const {
+    return output;
+}
+
+template <size_t MedianN, size_t MaN, size_t QuartileN>
+void InsFilter<MedianN, MaN, QuartileN>::reset() {
+    iHistory.clear();
+    qHistory.clear();
+    iQ1 = 0;
+    iQ3 = 0;
+    qQ1 = 0;
+    qQ3 = 0;
+    quartilesInitialized = false;
+
+    iMedianBuffer.clear();
+    qMedianBuffer.clear();
+    arrivals.clear();
+    movingAverage.reset();
+
+    output = {};
+}
+
+template <size_t MedianN, size_t MaN, size_t QuartileN>
+void InsFilter<MedianN, MaN, QuartileN>::updateQuartiles() {
+    if (!iHistory.isFull()) return;
+
+    const size_t q1Idx = QuartileN / 4;
+    const size_t q3Idx = (3 * QuartileN) / 4;
+
+    iQ1 = iHistory.at(q1Idx);
+    iQ3 = iHistory.at(q3Idx);
+    qQ1 = qHistory.at(q1Idx);
+    qQ3 = qHistory.at(q3Idx);
+    quartilesInitialized = true;
+}
+
+// Check if value is an outlier using IQR method
+#ifdef INS_FIXED_POINT
+// Same bounds in integers, everything scaled by 2 so a multiplier of 1.5 stays exact
+static_assert(IQR_MULTIPLIER * 2 == (int)(IQR_MULTIPLIER * 2), "IQR_MULTIPLIER must be a multiple of 0.5");
+
+template <size_t MedianN, size_t MaN, size_t QuartileN>
+bool InsFilter<MedianN, MaN, QuartileN>::isOutlier(int16_t value, int16_t q1, int16_t q3) const {
+    if (!quartilesInitialized) return false;
+    const int32_t multiplierX2 = (int32_t)(IQR_MULTIPLIER * 2);
+    int32_t iqr = q3 - q1;
+    int32_t lowerBoundX2 = 2 * q1 - multiplierX2 * iqr;
+    int32_t upperBoundX2 = 2 * q3 + multiplierX2 * iqr;
+    return (2 * value < lowerBoundX2 || 2 * value > upperBoundX2);
+}
+#else
+template <size_t MedianN, size_t MaN, size_t QuartileN>
+bool InsFilter<MedianN, MaN, QuartileN>::isOutlier(int16_t value, int16_t q1, int16_t q3) const {
+    if (!quartilesInitialized) return false;
+    float iqr = (float)q3 - (float)q1;
+    float lowerBound = q1 - (IQR_MULTIPLIER * iqr);
+    float upperBound = q3 + (IQR_MULTIPLIER * iqr);
+    return (value < lowerBound || value > upperBound);
+}
+#endif
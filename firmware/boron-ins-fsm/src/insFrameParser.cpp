@@ -0,0 +1,123 @@
+/* insFrameParser.cpp - Streaming parser for INS3331 radar data frames
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "insFrameParser.h"
+#include <string.h>
+
+InsFrameParser::InsFrameParser(InsSampleSink sink, void* context)
+    : sink(sink), context(context), partialLength(0), framesParsed(0), framingErrors(0), checksumErrors(0), resyncs(0), bytesDiscarded(0) {}
+
+void InsFrameParser::feed(const uint8_t* bytes, size_t length) {
+    size_t pos = 0;
+
+    while (pos < length) {
+        // Finish a frame that was split across chunks
+        if (partialLength > 0) {
+            size_t needed = INS_FRAME_LENGTH - partialLength;
+            size_t available = length - pos;
+            size_t toCopy = (available < needed) ? available : needed;
+            memcpy(partial + partialLength, bytes + pos, toCopy);
+            partialLength += toCopy;
+            pos += toCopy;
+
+            if (partialLength < INS_FRAME_LENGTH) {
+                return;
+            }
+
+            if (parseFrame(partial)) {
+                partialLength = 0;
+            }
+            else {
+                // Keep whatever follows the bad START, starting at the next START byte
+                count(resyncs, 1);
+                size_t next = findStart(partial, 1, INS_FRAME_LENGTH);
+                partialLength = INS_FRAME_LENGTH - next;
+                memmove(partial, partial + next, partialLength);
+            }
+            continue;
+        }
+
+        // Look for the start of the next frame
+        size_t start = findStart(bytes, pos, length);
+        pos = start;
+        if (pos == length) {
+            return;
+        }
+
+        if (length - pos >= INS_FRAME_LENGTH) {
+            // Whole frame in this chunk, decode it where it is
+            if (parseFrame(bytes + pos)) {
+                pos += INS_FRAME_LENGTH;
+            }
+            else {
+                count(resyncs, 1);
+                pos += 1;
+            }
+        }
+        else {
+            // Frame continues in the next chunk
+            partialLength = length - pos;
+            memcpy(partial, bytes + pos, partialLength);
+            return;
+        }
+    }
+}
+
+InsFrameParserStats InsFrameParser::stats() const {
+    InsFrameParserStats snapshot = {framesParsed.load(std::memory_order_relaxed), framingErrors.load(std::memory_order_relaxed),
+                                    checksumErrors.load(std::memory_order_relaxed), resyncs.load(std::memory_order_relaxed),
+                                    bytesDiscarded.load(std::memory_order_relaxed)};
+    return snapshot;
+}
+
+// Only call from the thread that feeds the parser
+void InsFrameParser::reset() {
+    partialLength = 0;
+    framesParsed.store(0, std::memory_order_relaxed);
+    framingErrors.store(0, std::memory_order_relaxed);
+    checksumErrors.store(0, std::memory_order_relaxed);
+    resyncs.store(0, std::memory_order_relaxed);
+    bytesDiscarded.store(0, std::memory_order_relaxed);
+}
+
+// Only the feeding thread writes the counters, so a plain load and store is enough
+void InsFrameParser::count(std::atomic<uint32_t>& counter, uint32_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// Validate one candidate frame starting with INS_FRAME_START and emit its sample
+bool InsFrameParser::parseFrame(const uint8_t* frame) {
+    if (frame[INS_FRAME_LENGTH - 1] != INS_FRAME_END) {
+        count(framingErrors, 1);
+        return false;
+    }
+
+    // Checksum is the sum of the data bytes 1-11
+    uint8_t checksum = 0;
+    for (int i = 1; i < INS_FRAME_CHECKSUM_INDEX; i++) {
+        checksum += frame[i];
+    }
+    if (checksum != frame[INS_FRAME_CHECKSUM_INDEX]) {
+        count(checksumErrors, 1);
+        return false;
+    }
+
+    int16_t inPhase = (int16_t)((frame[INS_FRAME_I_HIGH_INDEX] << 8) | frame[INS_FRAME_I_HIGH_INDEX + 1]);
+    int16_t quadrature = (int16_t)((frame[INS_FRAME_Q_HIGH_INDEX] << 8) | frame[INS_FRAME_Q_HIGH_INDEX + 1]);
+    count(framesParsed, 1);
+    sink(inPhase, quadrature, context);
+    return true;
+}
+
+// Index of the first START byte at or after from, or length if there is none.
+// Skipped bytes are counted as discarded.
+size_t InsFrameParser::findStart(const uint8_t* bytes, size_t from, size_t length) {
+    size_t i = from;
+    while (i < length && bytes[i] != INS_FRAME_START) {
+        i++;
+    }
+    count(bytesDiscarded, (uint32_t)(i - from));
+    return i;
+}
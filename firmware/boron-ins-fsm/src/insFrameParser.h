@@ -0,0 +1,76 @@
+/* insFrameParser.h - Streaming parser for INS3331 radar data frames
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Deliberately free of Particle headers so it can be unit tested on the host.
+ */
+
+#ifndef INS_FRAME_PARSER_H
+#define INS_FRAME_PARSER_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Receive frame layout (no WAKEUP_BYTE): [0]=START, [1-11]=data, [12]=checksum, [13]=END
+#define INS_FRAME_LENGTH          14
+#define INS_FRAME_START           0xA2
+#define INS_FRAME_END             0x16
+#define INS_FRAME_CHECKSUM_INDEX  12
+#define INS_FRAME_I_HIGH_INDEX    7
+#define INS_FRAME_Q_HIGH_INDEX    9
+
+// Called once per valid frame with the decoded I/Q sample
+typedef void (*InsSampleSink)(int16_t inPhase, int16_t quadrature, void* context);
+
+// Snapshot of a parser's counters for telemetry
+typedef struct InsFrameParserStats {
+    uint32_t framesParsed;      // Valid frames handed to the sink
+    uint32_t framingErrors;     // A START byte not followed by END 13 bytes later
+    uint32_t checksumErrors;    // Well framed, but the checksum did not match
+    uint32_t resyncs;           // Times the parser dropped a bad frame and rescanned for START
+    uint32_t bytesDiscarded;    // Bytes skipped while looking for a START byte
+} InsFrameParserStats;
+
+/*
+ * Feed it the bytes read from the radar UART in chunks of any size. Frames are found by
+ * their START byte and fixed length rather than by the first END byte, so data bytes that
+ * happen to equal END (0x16) or START (0xA2) do not cut frames short. A frame that fails
+ * framing or checksum validation is dropped and the parser rescans from the byte after its
+ * START, so one corrupt or truncated frame costs at most that frame.
+ *
+ * Frames that arrive whole inside a chunk are decoded in place; only a frame split across
+ * two chunks is assembled in the small internal buffer.
+ *
+ * Only the thread that feeds the parser writes the counters, but they are atomic so that
+ * stats() can take a snapshot from any other thread.
+ */
+class InsFrameParser {
+public:
+    InsFrameParser(InsSampleSink sink, void* context);
+
+    void feed(const uint8_t* bytes, size_t length);
+
+    InsFrameParserStats stats() const;
+    void reset();
+
+private:
+    bool parseFrame(const uint8_t* frame);
+    size_t findStart(const uint8_t* bytes, size_t from, size_t length);
+
+    InsSampleSink sink;
+    void* context;
+
+    uint8_t partial[INS_FRAME_LENGTH];
+    size_t partialLength;
+
+    void count(std::atomic<uint32_t>& counter, uint32_t n);
+
+    std::atomic<uint32_t> framesParsed;
+    std::atomic<uint32_t> framingErrors;
+    std::atomic<uint32_t> checksumErrors;
+    std::atomic<uint32_t> resyncs;
+    std::atomic<uint32_t> bytesDiscarded;
+};
+
+#endif
@@ -0,0 +1,118 @@
+/* insHistogram.cpp - Histograms of the filtered INS magnitude per kind of occupancy
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "insHistogram.h"
+
+#include <math.h>
+#include <string.h>
+
+static_assert(INS_HISTOGRAM_BUCKETS <= 255, "Snapshot bucket numbers are 8 bits");
+
+// ***************************** Local variables *****************************
+
+static InsHistogram insHistograms[INS_OCCUPANCY_COUNT];
+
+static const char* const occupancyNames[INS_OCCUPANCY_COUNT] = {"empty", "moving", "still"};
+
+// ***************************** Public functions *****************************
+
+void recordInsMagnitude(InsOccupancy occupancy, float magnitude) {
+    InsHistogram& histogram = insHistograms[occupancy];
+    histogram.count++;
+    histogram.buckets[insHistogramBucket(magnitude)]++;
+}
+
+InsHistogram takeInsHistogram(InsOccupancy occupancy) {
+    InsHistogram snapshot = insHistograms[occupancy];
+    memset(&insHistograms[occupancy], 0, sizeof(insHistograms[occupancy]));
+    return snapshot;
+}
+
+void mergeInsHistogram(InsHistogram& into, const InsHistogram& from) {
+    into.count += from.count;
+    for (size_t i = 0; i < INS_HISTOGRAM_BUCKETS; i++) {
+        into.buckets[i] += from.buckets[i];
+    }
+}
+
+void resetInsHistograms() {
+    memset(insHistograms, 0, sizeof(insHistograms));
+}
+
+size_t insHistogramBucket(float magnitude) {
+    // Also takes negative magnitudes and NaN
+    if (!(magnitude >= 1.0f)) {
+        return 0;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &magnitude, sizeof(bits));
+    uint32_t octave = ((bits >> 23) & 0xFF) - 127;
+    if (octave >= INS_HISTOGRAM_OCTAVES) {
+        return INS_HISTOGRAM_BUCKETS - 1;
+    }
+    uint32_t subBucket = (bits >> (23 - INS_HISTOGRAM_SUB_BUCKET_BITS)) & (INS_HISTOGRAM_SUB_BUCKETS - 1);
+    return 1 + octave * INS_HISTOGRAM_SUB_BUCKETS + subBucket;
+}
+
+float insHistogramBucketLower(size_t bucket) {
+    if (bucket == 0) {
+        return 0.0f;
+    }
+    if (bucket >= INS_HISTOGRAM_BUCKETS - 1) {
+        return ldexpf(1.0f, INS_HISTOGRAM_OCTAVES);
+    }
+    size_t octave = (bucket - 1) / INS_HISTOGRAM_SUB_BUCKETS;
+    size_t subBucket = (bucket - 1) % INS_HISTOGRAM_SUB_BUCKETS;
+    return ldexpf(1.0f + (float)subBucket / INS_HISTOGRAM_SUB_BUCKETS, (int)octave);
+}
+
+uint8_t insHistogramCountCode(uint32_t count) {
+    if (count < 16) {
+        return (uint8_t)count;
+    }
+
+    // Shift the count down to 4 bits, 8 to 15, and keep the shift and the low 3 of them
+    uint32_t shift = 0;
+    while ((count >> shift) >= 16) {
+        shift++;
+    }
+    return (uint8_t)(16 + (shift - 1) * 8 + ((count >> shift) - 8));
+}
+
+uint32_t insHistogramCodeCount(uint8_t code) {
+    if (code < 16) {
+        return code;
+    }
+    uint32_t shift = (code - 16) / 8 + 1;
+    uint32_t mantissa = (code - 16) % 8 + 8;
+    return (mantissa << shift) + (1u << (shift - 1));
+}
+
+InsHistogramSnapshot snapshotInsHistogram(const InsHistogram& histogram) {
+    InsHistogramSnapshot snapshot = {};
+    size_t first = 0;
+    while (first < INS_HISTOGRAM_BUCKETS && histogram.buckets[first] == 0) {
+        first++;
+    }
+    if (first == INS_HISTOGRAM_BUCKETS) {
+        return snapshot;
+    }
+    size_t last = INS_HISTOGRAM_BUCKETS - 1;
+    while (histogram.buckets[last] == 0) {
+        last--;
+    }
+
+    snapshot.first = (uint8_t)first;
+    snapshot.span = (uint8_t)(last - first + 1);
+    for (size_t i = 0; i < snapshot.span; i++) {
+        snapshot.counts[i] = insHistogramCountCode(histogram.buckets[first + i]);
+    }
+    return snapshot;
+}
+
+const char* insOccupancyName(InsOccupancy occupancy) {
+    return occupancyNames[occupancy];
+}
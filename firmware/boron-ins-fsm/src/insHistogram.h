@@ -0,0 +1,87 @@
+/* insHistogram.h - Histograms of the filtered INS magnitude per kind of occupancy
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Every new filtered INS value is recorded against what the state machine made of the room
+ * when it read it:
+ *  - empty: state 0
+ *  - moving: states 1 and 2
+ *  - still: state 3
+ * so the magnitudes can be compared with occupancy_detection_ins_threshold and
+ * stillness_ins_threshold across the fleet without debug publishes.
+ *
+ * The histograms are log-linear, as in HdrHistogram. Each power of two from 1 to 4096 is
+ * split into 8 buckets of equal width, so a bucket is at most 1/8 of its lower bound wide
+ * wherever the thresholds are set. Bucket 0 holds magnitudes below 1, including 0 when the
+ * radar is silent, and the last bucket holds 4096 and up. The bucket is taken from the
+ * float's exponent and top mantissa bits, so recording is O(1) and memory is fixed.
+ *
+ * Recorded and taken from loop() only.
+ */
+
+#ifndef INS_HISTOGRAM_H
+#define INS_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ***************************** Macro definitions *****************************
+
+#define INS_HISTOGRAM_SUB_BUCKET_BITS   3
+#define INS_HISTOGRAM_SUB_BUCKETS       (1 << INS_HISTOGRAM_SUB_BUCKET_BITS)
+#define INS_HISTOGRAM_OCTAVES           12      // 1 up to 2^12
+#define INS_HISTOGRAM_BUCKETS           (2 + INS_HISTOGRAM_OCTAVES * INS_HISTOGRAM_SUB_BUCKETS)
+
+// ***************************** Global typedefs *****************************
+
+enum InsOccupancy {
+    INS_OCCUPANCY_EMPTY = 0,
+    INS_OCCUPANCY_MOVING,
+    INS_OCCUPANCY_STILL,
+    INS_OCCUPANCY_COUNT
+};
+
+typedef struct InsHistogram {
+    uint32_t count;
+    uint32_t buckets[INS_HISTOGRAM_BUCKETS];
+} InsHistogram;
+
+// The buckets from first up to first + span - 1, which hold every value recorded, with each
+// count as an 8 bit code from insHistogramCountCode(). span is 0 for an empty histogram.
+typedef struct InsHistogramSnapshot {
+    uint8_t first;
+    uint8_t span;
+    uint8_t counts[INS_HISTOGRAM_BUCKETS];
+} InsHistogramSnapshot;
+
+// ***************************** Function declarations *****************************
+
+void recordInsMagnitude(InsOccupancy occupancy, float magnitude);
+
+// Returns the histogram and starts it over, e.g. once per heartbeat
+InsHistogram takeInsHistogram(InsOccupancy occupancy);
+
+// Adds the values of from to into, e.g. to carry a taken histogram over to the next heartbeat
+void mergeInsHistogram(InsHistogram& into, const InsHistogram& from);
+
+void resetInsHistograms(void);
+
+// Bucket a magnitude is counted in
+size_t insHistogramBucket(float magnitude);
+
+// Smallest magnitude counted in the bucket
+float insHistogramBucketLower(size_t bucket);
+
+// Counts up to 15 are kept exactly. Larger ones keep their top 4 bits, so the code is
+// within 1/8 of the count.
+uint8_t insHistogramCountCode(uint32_t count);
+
+// Middle of the counts a code stands for
+uint32_t insHistogramCodeCount(uint8_t code);
+
+InsHistogramSnapshot snapshotInsHistogram(const InsHistogram& histogram);
+
+// Short name for heartbeats, e.g. "still"
+const char* insOccupancyName(InsOccupancy occupancy);
+
+#endif
@@ -0,0 +1,30 @@
+/* insMovingAverage.cpp - Moving average and magnitude stage of the INS filter chain
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "insMovingAverage.h"
+
+// Digit-by-digit (base 4) square root, one result bit per iteration
+uint32_t isqrt64(uint64_t value) {
+    if (value == 0) {
+        return 0;
+    }
+
+    // Start at the highest power of four not above value instead of scanning down to it
+    uint64_t result = 0;
+    uint64_t bit = 1ULL << ((63 - __builtin_clzll(value)) & ~1);
+
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)result;
+}
@@ -0,0 +1,62 @@
+/* insMovingAverage.h - Moving average and magnitude stage of the INS filter chain
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#ifndef INS_MOVING_AVERAGE_H
+#define INS_MOVING_AVERAGE_H
+
+#include "ins3331.h"
+#include <CircularBuffer.h>
+
+// Fractional bits of the Q-format outputs of the fixed point stage (Q23.8)
+#define INS_Q_FRACTION_BITS 8
+
+/*
+ * Both stages take the I and Q medians of each sample and keep a running sum over the
+ * last N of them. push() returns true when the output was
+ * updated and fills iAverage, qAverage and magnitude of the given filteredINSData.
+ *
+ * FloatMovingAverage is the original float implementation. FixedPointMovingAverage does
+ * the same with int32 running sums, which never accumulate rounding error over weeks of
+ * uptime, and an integer square root, so it needs no FPU. It also fills the Q-format
+ * fields of filteredINSData. InsFilter picks one with the INS_FIXED_POINT build option.
+ *
+ * The buffers hold N + 1 samples so the one leaving the window is still there when the
+ * running sums are updated.
+ */
+
+template <size_t N>
+class FloatMovingAverage {
+public:
+    FloatMovingAverage();
+    bool push(int16_t iMedian, int16_t qMedian, filteredINSData& output);
+    void reset();
+
+private:
+    CircularBuffer<float, N + 1> iBuffer, qBuffer;
+    float iSum;
+    float qSum;
+};
+
+template <size_t N>
+class FixedPointMovingAverage {
+public:
+    FixedPointMovingAverage();
+    bool push(int16_t iMedian, int16_t qMedian, filteredINSData& output);
+    void reset();
+
+private:
+    void fillOutput(filteredINSData& output) const;
+
+    CircularBuffer<int16_t, N + 1> iBuffer, qBuffer;
+    int32_t iSum;
+    int32_t qSum;
+};
+
+// Integer square root, rounded down
+uint32_t isqrt64(uint64_t value);
+
+#include "insMovingAverage.tpp"
+
+#endif
@@ -0,0 +1,106 @@
+/* insMovingAverage.tpp - Moving average and magnitude stage template implementation
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include <math.h>
+
+template <size_t N>
+FloatMovingAverage<N>::FloatMovingAverage() : iSum(0), qSum(0) {}
+
+template <size_t N>
+bool FloatMovingAverage<N>::push(int16_t iMedian, int16_t qMedian, filteredINSData& output) {
+    iBuffer.push((float)iMedian);
+    qBuffer.push((float)qMedian);
+
+    // Calculate initial moving average when buffer reaches sample size
+    if (iBuffer.size() == N) {
+        iSum = 0;
+        qSum = 0;
+        for (size_t i = 0; i < N; i++) {
+            iSum += iBuffer[i];
+            qSum += qBuffer[i];
+        }
+    }
+    // Update moving average with sliding window
+    else if (iBuffer.size() == N + 1) {
+        // CircularBuffer: [0] is oldest, [size-1] is newest
+        iSum = iSum - iBuffer[0] + iBuffer[N];
+        qSum = qSum - qBuffer[0] + qBuffer[N];
+    }
+    else {
+        return false;
+    }
+
+    output.iAverage = iSum / N;
+    output.qAverage = qSum / N;
+    output.magnitude = sqrtf(output.iAverage * output.iAverage + output.qAverage * output.qAverage);
+    return true;
+}
+
+template <size_t N>
+void FloatMovingAverage<N>::reset() {
+    iBuffer.clear();
+    qBuffer.clear();
+    iSum = 0;
+    qSum = 0;
+}
+
+template <size_t N>
+FixedPointMovingAverage<N>::FixedPointMovingAverage() : iSum(0), qSum(0) {}
+
+template <size_t N>
+bool FixedPointMovingAverage<N>::push(int16_t iMedian, int16_t qMedian, filteredINSData& output) {
+    iBuffer.push(iMedian);
+    qBuffer.push(qMedian);
+
+    if (iBuffer.size() == N) {
+        iSum = 0;
+        qSum = 0;
+        for (size_t i = 0; i < N; i++) {
+            iSum += iBuffer[i];
+            qSum += qBuffer[i];
+        }
+    }
+    else if (iBuffer.size() == N + 1) {
+        // Exact in integers, so the sums cannot drift however long the device runs
+        iSum = iSum - iBuffer[0] + iBuffer[N];
+        qSum = qSum - qBuffer[0] + qBuffer[N];
+    }
+    else {
+        return false;
+    }
+
+    fillOutput(output);
+    return true;
+}
+
+template <size_t N>
+void FixedPointMovingAverage<N>::fillOutput(filteredINSData& output) const {
+    const int32_t n = N;
+
+    // Sums are at most N * 32767, so for the window sizes we use shifting them by the
+    // fraction bits still fits comfortably in 32 bits
+    static_assert(N * 32767 < (1u << (31 - INS_Q_FRACTION_BITS)), "Moving average window too long for Q-format sums");
+    output.iAverageQ = ((iSum << INS_Q_FRACTION_BITS) + n / 2) / n;
+    output.qAverageQ = ((qSum << INS_Q_FRACTION_BITS) + n / 2) / n;
+
+    // |(iSum, qSum)| / n, taking the root of the sums before dividing keeps the rounding
+    // to a single step. Squares of the sums need 64 bits.
+    uint64_t sumOfSquares = (uint64_t)((int64_t)iSum * iSum) + (uint64_t)((int64_t)qSum * qSum);
+    uint32_t rootQ = isqrt64(sumOfSquares << (2 * INS_Q_FRACTION_BITS));
+    output.magnitudeQ = (int32_t)((rootQ + n / 2) / n);
+
+    // Float views for the state machine thresholds
+    output.iAverage = (float)output.iAverageQ / (1 << INS_Q_FRACTION_BITS);
+    output.qAverage = (float)output.qAverageQ / (1 << INS_Q_FRACTION_BITS);
+    output.magnitude = (float)output.magnitudeQ / (1 << INS_Q_FRACTION_BITS);
+}
+
+template <size_t N>
+void FixedPointMovingAverage<N>::reset() {
+    iBuffer.clear();
+    qBuffer.clear();
+    iSum = 0;
+    qSum = 0;
+}
@@ -0,0 +1,257 @@
+/* jsonWriter.cpp - Fixed buffer JSON writer for published payloads
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "jsonWriter.h"
+
+#include <math.h>
+#include <string.h>
+
+// ***************************** Local variables *****************************
+
+static const char digitPairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+static const uint32_t powersOfTen[JSON_MAX_DECIMALS + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+// ***************************** Local functions *****************************
+
+// Writes value in decimal, at least minDigits long, ending just before end. Returns where
+// the text starts. Two digits per division keeps it to 5 divisions for any uint32_t.
+static char* formatUnsigned(uint32_t value, char* end, size_t minDigits) {
+    char* start = end;
+    while (value >= 100) {
+        uint32_t pair = (value % 100) * 2;
+        value /= 100;
+        *--start = digitPairs[pair + 1];
+        *--start = digitPairs[pair];
+    }
+    if (value >= 10) {
+        *--start = digitPairs[value * 2 + 1];
+        *--start = digitPairs[value * 2];
+    }
+    else {
+        *--start = (char)('0' + value);
+    }
+    while ((size_t)(end - start) < minDigits) {
+        *--start = '0';
+    }
+    return start;
+}
+
+// ***************************** Public functions *****************************
+
+JsonWriter::JsonWriter(char* buffer, size_t size) : buffer(buffer), size(size), written(0), needsComma(false), isOverflowed(false) {
+    if (size > 0) {
+        buffer[0] = '\0';
+    }
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    separate();
+    append("{", 1);
+    needsComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    append("}", 1);
+    needsComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separate();
+    append("[", 1);
+    needsComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    append("]", 1);
+    needsComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* name, size_t length) {
+    separate();
+    appendQuoted(name, length, JSON_QUOTED) && append(":", 1);
+    needsComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::integer(int32_t value, JsonQuoting quoting) {
+    separate();
+    char text[11];
+    char* end = text + sizeof(text);
+    // Negated as unsigned so INT32_MIN does not overflow
+    char* start = formatUnsigned((value < 0) ? 0u - (uint32_t)value : (uint32_t)value, end, 1);
+    if (value < 0) {
+        *--start = '-';
+    }
+    appendQuoted(start, end - start, quoting);
+    needsComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::unsignedInteger(uint32_t value, JsonQuoting quoting) {
+    separate();
+    char text[10];
+    char* end = text + sizeof(text);
+    char* start = formatUnsigned(value, end, 1);
+    appendQuoted(start, end - start, quoting);
+    needsComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::boolean(bool value, JsonQuoting quoting) {
+    separate();
+    appendQuoted(value ? "true" : "false", value ? 4 : 5, quoting);
+    needsComma = true;
+    return *this;
+}
+
+// Matches %.*f digit for digit. A float has at most 24 significant bits and 10^9 fits in 30
+// with 9 trailing zero bits, so the fraction scaled by 10^decimals is exact in a double and
+// the tie is broken half to even like printf.
+JsonWriter& JsonWriter::fixed(float value, uint8_t decimals, JsonQuoting quoting) {
+    separate();
+    if (decimals > JSON_MAX_DECIMALS) {
+        decimals = JSON_MAX_DECIMALS;
+    }
+
+    char text[1 + 10 + 1 + JSON_MAX_DECIMALS];
+    char* end = text + sizeof(text);
+    char* start;
+    double magnitude = fabs((double)value);
+    if (isnan(magnitude) || isinf(magnitude)) {
+        start = end - 3;
+        memcpy(start, isnan(magnitude) ? "nan" : "inf", 3);
+    }
+    else {
+        double whole = floor(magnitude);
+        if (whole > 4294967295.0) {
+            whole = 4294967295.0;
+            magnitude = whole;
+        }
+        uint32_t integerPart = (uint32_t)whole;
+
+        double scaled = (magnitude - whole) * powersOfTen[decimals];
+        double fractionFloor = floor(scaled);
+        double remainder = scaled - fractionFloor;
+        uint32_t fraction = (uint32_t)fractionFloor;
+        bool isOdd = (decimals > 0) ? (fraction & 1) : (integerPart & 1);
+        if (remainder > 0.5 || (remainder == 0.5 && isOdd)) {
+            fraction++;
+            if (fraction == powersOfTen[decimals]) {
+                fraction = 0;
+                integerPart++;
+            }
+        }
+
+        start = end;
+        if (decimals > 0) {
+            start = formatUnsigned(fraction, end, decimals);
+            *--start = '.';
+        }
+        start = formatUnsigned(integerPart, start, 1);
+    }
+    if (signbit(value)) {
+        *--start = '-';
+    }
+    appendQuoted(start, end - start, quoting);
+    needsComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::hex8(uint8_t value, bool prefix) {
+    separate();
+    char text[4] = {'0', 'x', hexDigits[value >> 4], hexDigits[value & 0x0F]};
+    appendQuoted(prefix ? text : text + 2, prefix ? 4 : 2, JSON_QUOTED);
+    needsComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::hex24(uint32_t value) {
+    separate();
+    char text[8];
+    for (int byte = 0; byte < 3; byte++) {
+        uint8_t bits = (uint8_t)(value >> (16 - 8 * byte));
+        text[3 * byte] = hexDigits[bits >> 4];
+        text[3 * byte + 1] = hexDigits[bits & 0x0F];
+        if (byte < 2) {
+            text[3 * byte + 2] = ':';
+        }
+    }
+    appendQuoted(text, sizeof(text), JSON_QUOTED);
+    needsComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::string(const char* value) {
+    separate();
+
+    // Escaped into place, then dropped whole if it did not fit
+    size_t start = written;
+    bool fits = append("\"", 1);
+    for (const char* c = value; fits && *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            char escaped[2] = {'\\', *c};
+            fits = append(escaped, 2);
+        }
+        else if ((uint8_t)*c < 0x20) {
+            char escaped[6] = {'\\', 'u', '0', '0', hexDigits[(uint8_t)*c >> 4], hexDigits[*c & 0x0F]};
+            fits = append(escaped, 6);
+        }
+        else {
+            fits = append(c, 1);
+        }
+    }
+    if (!fits || !append("\"", 1)) {
+        written = start;
+        buffer[written] = '\0';
+    }
+    needsComma = true;
+    return *this;
+}
+
+// ***************************** Private functions *****************************
+
+void JsonWriter::separate() {
+    if (needsComma) {
+        append(",", 1);
+    }
+}
+
+// Appends all of text or none of it, and keeps the buffer terminated
+bool JsonWriter::append(const char* text, size_t length) {
+    if (isOverflowed || written + length >= size) {
+        isOverflowed = true;
+        return false;
+    }
+    memcpy(buffer + written, text, length);
+    written += length;
+    buffer[written] = '\0';
+    return true;
+}
+
+bool JsonWriter::appendQuoted(const char* text, size_t length, JsonQuoting quoting) {
+    if (quoting == JSON_BARE) {
+        return append(text, length);
+    }
+    if (isOverflowed || written + length + 2 >= size) {
+        isOverflowed = true;
+        return false;
+    }
+    buffer[written] = '"';
+    memcpy(buffer + written + 1, text, length);
+    buffer[written + length + 1] = '"';
+    written += length + 2;
+    buffer[written] = '\0';
+    return true;
+}
@@ -0,0 +1,204 @@
+/* jsonWriter.h - Fixed buffer JSON writer for published payloads
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * JsonWriter appends JSON into a caller's buffer with its own integer and fixed point
+ * formatters, so building a payload never calls snprintf, never touches the heap (newlib's
+ * %f allocates) and never clears the buffer first. Writing stops at the first value that
+ * does not fit, the buffer stays terminated and overflowed() is set.
+ *
+ * Payloads with a fixed set of fields are described by a constexpr JsonField array and
+ * written with writeJson<schema>(buffer, args...). The key lengths are taken at compile time,
+ * the argument types are checked against the field formats, and the longest payload the
+ * schema can produce is checked against the buffer and PARTICLE_MAX_MESSAGE_LENGTH, so
+ * these payloads cannot be cut short:
+ *
+ *   static constexpr JsonField doorFields[] = {{"data", JSON_HEX8}, {"open", JSON_BOOL}};
+ *   char message[jsonMaxLength(doorFields) + 1];
+ *   writeJson<doorFields>(message, status, isOpen);   // {"data":"0A","open":true}
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+// ***************************** Macro definitions *****************************
+
+// Particle event data is at most 622 bytes
+#define PARTICLE_MAX_MESSAGE_LENGTH     622
+
+// Most decimals JSON_FIXED can write, the fraction is kept in 32 bits
+#define JSON_MAX_DECIMALS               9
+
+// ***************************** Global typedefs *****************************
+
+enum JsonFormat {
+    JSON_INT = 0,   // Signed 32 bit integer
+    JSON_UINT,      // Unsigned 32 bit integer
+    JSON_BOOL,      // true or false
+    JSON_FIXED,     // Float with a fixed number of decimals, as %.*f writes it
+    JSON_HEX8,      // Byte as a string of two hex digits, "0A"
+    JSON_HEX8_0X,   // Byte as a C hex literal string, "0x0A"
+    JSON_HEX24,     // Low three bytes of a uint32_t, most significant first, "0A:0B:0C"
+};
+
+// JSON_INT, JSON_UINT, JSON_BOOL and JSON_FIXED can be written as strings, "12". The hex
+// formats are always strings.
+enum JsonQuoting {
+    JSON_BARE = 0,
+    JSON_QUOTED
+};
+
+typedef struct JsonField {
+    const char* name;       // Written as it is, must not need escaping
+    JsonFormat format;
+    JsonQuoting quoting;
+    uint8_t decimals;       // JSON_FIXED only
+} JsonField;
+
+class JsonWriter {
+public:
+    // size includes the terminator
+    JsonWriter(char* buffer, size_t size);
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    template <size_t N>
+    JsonWriter& name(const char (&name)[N]) {
+        return key(name, N - 1);
+    }
+
+    // Writes "name": for a name of the given length, which must not need escaping
+    JsonWriter& key(const char* name, size_t length);
+
+    JsonWriter& integer(int32_t value, JsonQuoting quoting = JSON_BARE);
+    JsonWriter& unsignedInteger(uint32_t value, JsonQuoting quoting = JSON_BARE);
+    JsonWriter& boolean(bool value, JsonQuoting quoting = JSON_BARE);
+    // Magnitudes of 2^32 and up are written as 4294967295
+    JsonWriter& fixed(float value, uint8_t decimals, JsonQuoting quoting = JSON_BARE);
+    JsonWriter& hex8(uint8_t value, bool prefix = false);
+    JsonWriter& hex24(uint32_t value);
+    // Escapes quotes, backslashes and control characters
+    JsonWriter& string(const char* value);
+
+    // Same overloads as Particle's JSONBufferWriter, integers are written as 32 bits
+    JsonWriter& value(bool value) { return boolean(value); }
+    JsonWriter& value(int value) { return integer((int32_t)value); }
+    JsonWriter& value(unsigned value) { return unsignedInteger((uint32_t)value); }
+    JsonWriter& value(long value) { return integer((int32_t)value); }
+    JsonWriter& value(unsigned long value) { return unsignedInteger((uint32_t)value); }
+    JsonWriter& value(const char* value) { return string(value); }
+
+    const char* c_str() const { return buffer; }
+    size_t length() const { return written; }
+    bool overflowed() const { return isOverflowed; }
+
+private:
+    void separate();
+    bool append(const char* text, size_t length);
+    bool appendQuoted(const char* text, size_t length, JsonQuoting quoting);
+
+    char* buffer;
+    size_t size;
+    size_t written;
+    bool needsComma;
+    bool isOverflowed;
+};
+
+// ***************************** Schema checks *****************************
+
+constexpr size_t jsonNameLength(const char* name) {
+    size_t length = 0;
+    while (name[length] != '\0') {
+        length++;
+    }
+    return length;
+}
+
+// Longest text a field's value can take, with its quotes
+constexpr size_t jsonValueMaxLength(const JsonField& field) {
+    size_t quotes = (field.quoting == JSON_QUOTED) ? 2 : 0;
+    switch (field.format) {
+        case JSON_INT:
+            return 11 + quotes;
+        case JSON_UINT:
+            return 10 + quotes;
+        case JSON_BOOL:
+            return 5 + quotes;
+        case JSON_FIXED:
+            return 1 + 10 + ((field.decimals > 0) ? 1 + field.decimals : 0) + quotes;
+        case JSON_HEX8:
+            return 4;
+        case JSON_HEX8_0X:
+            return 6;
+        case JSON_HEX24:
+            return 10;
+    }
+    return 0;
+}
+
+// Longest text the fields can take inside an object, without the braces
+template <size_t N>
+constexpr size_t jsonFieldsMaxLength(const JsonField (&fields)[N]) {
+    size_t length = N - 1;
+    for (size_t i = 0; i < N; i++) {
+        length += jsonNameLength(fields[i].name) + 3 + jsonValueMaxLength(fields[i]);
+    }
+    return length;
+}
+
+// Longest payload writeJson() can write for the fields, without the terminator
+template <size_t N>
+constexpr size_t jsonMaxLength(const JsonField (&fields)[N]) {
+    return 2 + jsonFieldsMaxLength(fields);
+}
+
+template <size_t N>
+constexpr bool jsonDecimalsValid(const JsonField (&fields)[N]) {
+    for (size_t i = 0; i < N; i++) {
+        if (fields[i].format == JSON_FIXED && fields[i].decimals > JSON_MAX_DECIMALS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+constexpr bool jsonAccepts(JsonFormat format) {
+    switch (format) {
+        case JSON_INT:
+            return (std::is_integral<T>::value && !std::is_same<T, bool>::value) || std::is_enum<T>::value;
+        case JSON_UINT:
+            return std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value;
+        case JSON_BOOL:
+            return std::is_same<T, bool>::value;
+        case JSON_FIXED:
+            return std::is_floating_point<T>::value;
+        case JSON_HEX8:
+        case JSON_HEX8_0X:
+            return std::is_same<T, uint8_t>::value;
+        case JSON_HEX24:
+            return std::is_same<T, uint32_t>::value;
+    }
+    return false;
+}
+
+// ***************************** Template declarations *****************************
+
+// Writes the fields into an object the writer has open
+template <const auto& Fields, typename... Args>
+void writeJsonFields(JsonWriter& writer, Args... args);
+
+// Writes {fields} into buffer and returns its length
+template <const auto& Fields, size_t Size, typename... Args>
+size_t writeJson(char (&buffer)[Size], Args... args);
+
+#include "jsonWriter.tpp"
+
+#endif
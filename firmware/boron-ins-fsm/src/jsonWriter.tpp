@@ -0,0 +1,57 @@
+/* jsonWriter.tpp - Schema writers for fixed buffer JSON payloads
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include <utility>
+
+template <const auto& Fields, size_t I, typename T>
+inline void writeJsonField(JsonWriter& writer, T value) {
+    constexpr JsonField field = Fields[I];
+    constexpr size_t nameLength = jsonNameLength(field.name);
+    static_assert(jsonAccepts<T>(field.format), "JSON argument type does not match the field format");
+
+    writer.key(field.name, nameLength);
+    if constexpr (field.format == JSON_INT) {
+        writer.integer((int32_t)value, field.quoting);
+    }
+    else if constexpr (field.format == JSON_UINT) {
+        writer.unsignedInteger((uint32_t)value, field.quoting);
+    }
+    else if constexpr (field.format == JSON_BOOL) {
+        writer.boolean(value, field.quoting);
+    }
+    else if constexpr (field.format == JSON_FIXED) {
+        writer.fixed((float)value, field.decimals, field.quoting);
+    }
+    else if constexpr (field.format == JSON_HEX24) {
+        writer.hex24(value);
+    }
+    else {
+        writer.hex8(value, field.format == JSON_HEX8_0X);
+    }
+}
+
+template <const auto& Fields, typename... Args, size_t... I>
+inline void writeJsonFieldsAt(JsonWriter& writer, std::index_sequence<I...>, Args... args) {
+    (writeJsonField<Fields, I>(writer, args), ...);
+}
+
+template <const auto& Fields, typename... Args>
+void writeJsonFields(JsonWriter& writer, Args... args) {
+    static_assert(sizeof(Fields) / sizeof(Fields[0]) == sizeof...(Args), "JSON argument count does not match the fields");
+    static_assert(jsonDecimalsValid(Fields), "JSON_FIXED takes at most JSON_MAX_DECIMALS decimals");
+    static_assert(jsonFieldsMaxLength(Fields) + 2 <= PARTICLE_MAX_MESSAGE_LENGTH, "JSON fields may not fit in a Particle event");
+    writeJsonFieldsAt<Fields>(writer, std::index_sequence_for<Args...>(), args...);
+}
+
+template <const auto& Fields, size_t Size, typename... Args>
+size_t writeJson(char (&buffer)[Size], Args... args) {
+    static_assert(jsonMaxLength(Fields) < Size, "JSON payload may not fit its buffer");
+
+    JsonWriter writer(buffer, Size);
+    writer.beginObject();
+    writeJsonFields<Fields>(writer, args...);
+    writer.endObject();
+    return writer.length();
+}
@@ -0,0 +1,187 @@
+/* kllSketch.cpp - Fixed memory quantile sketch
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "kllSketch.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+static_assert(KLL_SKETCH_MAX_ITEMS <= 0xFFFF, "Level starts are 16 bits");
+
+// Any nonzero xorshift32 seed, fixed so runs can be repeated
+#define KLL_SKETCH_COIN_SEED    0x9E3779B9u
+
+// ***************************** Local variables *****************************
+
+// kllLevelCapacity() by depth, as makeRoom() looks at every level each time it is called
+typedef struct KllLevelCapacities {
+    uint16_t depth[KLL_SKETCH_MAX_LEVELS];
+} KllLevelCapacities;
+
+static constexpr KllLevelCapacities makeLevelCapacities() {
+    KllLevelCapacities capacities = {};
+    for (uint32_t depth = 0; depth < KLL_SKETCH_MAX_LEVELS; depth++) {
+        capacities.depth[depth] = (uint16_t)kllLevelCapacity(depth);
+    }
+    return capacities;
+}
+
+static constexpr KllLevelCapacities levelCapacities = makeLevelCapacities();
+
+// ***************************** Public functions *****************************
+
+KllSketch::KllSketch() {
+    clear();
+}
+
+void KllSketch::update(float value) {
+    if (isnan(value) || valueCount == UINT32_MAX) {
+        return;
+    }
+
+    while (retained() >= capacity) {
+        if (!makeRoom()) {
+            return;
+        }
+    }
+    items[--levelStart[0]] = value;
+    valueCount++;
+}
+
+void KllSketch::merge(const KllSketch& other) {
+    while (levelCount < other.levelCount && addLevel()) {
+    }
+
+    // Each value keeps its weight by going into the level it came from
+    for (size_t level = 0; level < other.levelCount; level++) {
+        for (size_t i = other.levelStart[level]; i < other.levelStart[level + 1]; i++) {
+            while (retained() >= capacity) {
+                if (!makeRoom()) {
+                    return;
+                }
+            }
+            insert(level, other.items[i]);
+        }
+    }
+    valueCount = (other.valueCount > UINT32_MAX - valueCount) ? UINT32_MAX : valueCount + other.valueCount;
+}
+
+float KllSketch::quantile(float fraction) {
+    if (retained() == 0) {
+        return 0.0f;
+    }
+
+    // The weights are counted up from the smallest value, taking the smallest next value of
+    // any level each step
+    uint64_t totalWeight = 0;
+    uint16_t next[KLL_SKETCH_MAX_LEVELS];
+    for (size_t level = 0; level < levelCount; level++) {
+        std::sort(items + levelStart[level], items + levelStart[level + 1]);
+        totalWeight += (uint64_t)levelSize(level) << level;
+        next[level] = levelStart[level];
+    }
+
+    // A float fraction can be a little over the one meant, 0.99f is 0.9900000095
+    double clamped = (fraction < 0.0f) ? 0.0 : (fraction > 1.0f) ? 1.0 : (double)fraction;
+    uint64_t target = (uint64_t)ceil(clamped * (double)totalWeight * (1.0 - FLT_EPSILON));
+    if (target < 1) {
+        target = 1;
+    }
+
+    uint64_t weight = 0;
+    float value = 0.0f;
+    while (weight < target) {
+        size_t smallest = levelCount;
+        for (size_t level = 0; level < levelCount; level++) {
+            if (next[level] < levelStart[level + 1] && (smallest == levelCount || items[next[level]] < items[next[smallest]])) {
+                smallest = level;
+            }
+        }
+        value = items[next[smallest]++];
+        weight += (uint64_t)1 << smallest;
+    }
+    return value;
+}
+
+void KllSketch::clear() {
+    levelCount = 1;
+    levelStart[0] = KLL_SKETCH_MAX_ITEMS;
+    levelStart[1] = KLL_SKETCH_MAX_ITEMS;
+    capacity = (uint16_t)kllSketchCapacity(levelCount);
+    valueCount = 0;
+    coinState = KLL_SKETCH_COIN_SEED;
+}
+
+// ***************************** Private functions *****************************
+
+// Compacts the lowest level that is full, adding a level above the top if it is the top.
+// Returns false only when every level is in use.
+bool KllSketch::makeRoom() {
+    size_t level = 0;
+    while (level + 1 < levelCount && levelSize(level) < levelCapacities.depth[levelCount - 1 - level]) {
+        level++;
+    }
+    if (level + 1 == levelCount && !addLevel()) {
+        return false;
+    }
+    compactLevel(level);
+    return true;
+}
+
+bool KllSketch::addLevel() {
+    if (levelCount == KLL_SKETCH_MAX_LEVELS) {
+        return false;
+    }
+    levelStart[levelCount + 1] = KLL_SKETCH_MAX_ITEMS;
+    levelCount++;
+    capacity = (uint16_t)kllSketchCapacity(levelCount);
+    return true;
+}
+
+// Sorts the level and moves every other value to the bottom of the level above. With an
+// odd number of values the smallest stays behind, so the total weight is unchanged.
+void KllSketch::compactLevel(size_t level) {
+    size_t start = levelStart[level];
+    size_t end = levelStart[level + 1];
+    std::sort(items + start, items + end);
+
+    size_t odd = (end - start) & 1;
+    size_t half = (end - start) / 2;
+    size_t first = start + odd + (nextCoin() ? 1 : 0);
+
+    // From the top down, each value moves up at least as far as the one it overwrites
+    for (size_t i = half; i-- > 0;) {
+        items[end - half + i] = items[first + 2 * i];
+    }
+
+    // The levels below and the value left behind move up into the room freed
+    size_t bottom = levelStart[0];
+    memmove(items + bottom + half, items + bottom, (start + odd - bottom) * sizeof(float));
+    for (size_t i = 0; i <= level; i++) {
+        levelStart[i] += (uint16_t)half;
+    }
+    levelStart[level + 1] = (uint16_t)(end - half);
+}
+
+// Adds a value to the top of a level, moving the levels below it down
+void KllSketch::insert(size_t level, float value) {
+    size_t bottom = levelStart[0];
+    size_t end = levelStart[level + 1];
+    memmove(items + bottom - 1, items + bottom, (end - bottom) * sizeof(float));
+    items[end - 1] = value;
+    for (size_t i = 0; i <= level; i++) {
+        levelStart[i]--;
+    }
+}
+
+// xorshift32
+bool KllSketch::nextCoin() {
+    coinState ^= coinState << 13;
+    coinState ^= coinState >> 17;
+    coinState ^= coinState << 5;
+    return (coinState >> 31) != 0;
+}
@@ -0,0 +1,105 @@
+/* latencyStats.cpp - Latency histograms for the radar to cloud alert path
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "latencyStats.h"
+
+#include <atomic>
+
+// ***************************** Local typedefs *****************************
+
+typedef struct AtomicLatencyHistogram {
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> max;
+    std::atomic<uint32_t> buckets[LATENCY_BUCKETS];
+} AtomicLatencyHistogram;
+
+// ***************************** Local variables *****************************
+
+static AtomicLatencyHistogram histograms[LATENCY_STAGE_COUNT];
+
+static const char* const stageNames[LATENCY_STAGE_COUNT] = {"queue", "filter", "decision", "publish"};
+
+// ***************************** Local functions *****************************
+
+static size_t bucketFor(uint32_t ms) {
+    size_t bucket = 0;
+    while (ms != 0 && bucket < LATENCY_BUCKETS - 1) {
+        ms >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// ***************************** Public functions *****************************
+
+void recordLatency(LatencyStage stage, uint32_t ms) {
+    AtomicLatencyHistogram& histogram = histograms[stage];
+
+    // Increments are read-modify-writes so a take on another thread never loses its reset.
+    // Only the recording thread raises max, so a load and store are enough there.
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    histogram.buckets[bucketFor(ms)].fetch_add(1, std::memory_order_relaxed);
+    if (ms > histogram.max.load(std::memory_order_relaxed)) {
+        histogram.max.store(ms, std::memory_order_relaxed);
+    }
+}
+
+LatencyHistogram getLatencyHistogram(LatencyStage stage) {
+    const AtomicLatencyHistogram& histogram = histograms[stage];
+    LatencyHistogram snapshot;
+    snapshot.count = histogram.count.load(std::memory_order_relaxed);
+    snapshot.max = histogram.max.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        snapshot.buckets[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+LatencyHistogram takeLatencyHistogram(LatencyStage stage) {
+    AtomicLatencyHistogram& histogram = histograms[stage];
+    LatencyHistogram snapshot;
+    snapshot.count = histogram.count.exchange(0, std::memory_order_relaxed);
+    snapshot.max = histogram.max.exchange(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        snapshot.buckets[i] = histogram.buckets[i].exchange(0, std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+void mergeLatencyHistogram(LatencyHistogram& into, const LatencyHistogram& from) {
+    into.count += from.count;
+    into.max = (from.max > into.max) ? from.max : into.max;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        into.buckets[i] += from.buckets[i];
+    }
+}
+
+void resetLatencyHistograms() {
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        takeLatencyHistogram((LatencyStage)stage);
+    }
+}
+
+uint32_t latencyPercentile(const LatencyHistogram& histogram, unsigned int percent) {
+    if (histogram.count == 0) {
+        return 0;
+    }
+
+    // Smallest bucket holding at least percent of the samples, rounding the rank up
+    uint64_t rank = ((uint64_t)histogram.count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += histogram.buckets[bucket];
+        if (seen >= rank && seen > 0) {
+            uint32_t upper = (bucket == 0) ? 0 : (1u << bucket) - 1;
+            return (upper < histogram.max) ? upper : histogram.max;
+        }
+    }
+    return histogram.max;
+}
+
+const char* latencyStageName(LatencyStage stage) {
+    return stageNames[stage];
+}
@@ -0,0 +1,69 @@
+/* latencyStats.h - Latency histograms for the radar to cloud alert path
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Each stage of the path from a radar frame to a published alert records how long it took
+ * into a histogram of power of two buckets in ms:
+ *  - queue: a sample's wait in the ring between the reader and filter threads
+ *  - filter: group delay of the filter chain, from the sample at the centre of the median
+ *    and moving average windows to the newest one in the same value
+ *  - decision: from the arrival of the newest sample in the value a state transition was
+ *    made on to the transition, so it includes the queue wait. Only transitions whose
+ *    guard fires on the radar reading count, not the door or timed ones.
+ *  - publish: from queueing an alert or "Door Opened" to its publish Future resolving
+ *
+ * Every stage is recorded by a single thread. Counters are relaxed atomics so the
+ * heartbeat and console can read them from the application thread, and a histogram read
+ * while it is recorded into may be off by the sample in progress.
+ */
+
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ***************************** Macro definitions *****************************
+
+// Bucket 0 holds 0 ms, bucket b holds [2^(b-1), 2^b) ms, and the last bucket also holds
+// everything above, i.e. from 2^14 ms (16 s) up
+#define LATENCY_BUCKETS     16
+
+// ***************************** Global typedefs *****************************
+
+enum LatencyStage {
+    LATENCY_QUEUE = 0,
+    LATENCY_FILTER,
+    LATENCY_DECISION,
+    LATENCY_PUBLISH,
+    LATENCY_STAGE_COUNT
+};
+
+typedef struct LatencyHistogram {
+    uint32_t count;
+    uint32_t max;                       // Largest latency recorded, in ms
+    uint32_t buckets[LATENCY_BUCKETS];
+} LatencyHistogram;
+
+// ***************************** Function declarations *****************************
+
+void recordLatency(LatencyStage stage, uint32_t ms);
+
+LatencyHistogram getLatencyHistogram(LatencyStage stage);
+
+// Returns the histogram of the stage and starts it over, e.g. once per heartbeat
+LatencyHistogram takeLatencyHistogram(LatencyStage stage);
+
+// Adds the samples of from to into, e.g. to carry a taken histogram over to the next heartbeat
+void mergeLatencyHistogram(LatencyHistogram& into, const LatencyHistogram& from);
+
+void resetLatencyHistograms(void);
+
+// Upper bound in ms of the bucket holding the given percentile, capped at the max recorded.
+// 0 for an empty histogram.
+uint32_t latencyPercentile(const LatencyHistogram& histogram, unsigned int percent);
+
+// Short name for heartbeats and console output, e.g. "queue"
+const char* latencyStageName(LatencyStage stage);
+
+#endif
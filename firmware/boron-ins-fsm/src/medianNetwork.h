@@ -0,0 +1,130 @@
+/* medianNetwork.h - Compile-time median selection network for the INS median filter
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#ifndef MEDIAN_NETWORK_H
+#define MEDIAN_NETWORK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+
+/*
+ * The median stage used to copy its window and bubble sort it, once for I and once for Q.
+ * Instead we generate Batcher's odd-even merge sort network for the window size at compile
+ * time, then prune every comparator that cannot influence the middle wire. What is left is
+ * a fixed, branch-free sequence of compare-exchanges (8 for a 5 sample window) that the
+ * compiler fully unrolls, and I and Q run through it side by side.
+ */
+
+struct NetworkComparator {
+    uint8_t low;
+    uint8_t high;
+};
+
+namespace MedianNetworkDetail {
+
+// Walk Batcher's odd-even merge sort for n wires. Works for any n, not just powers of two.
+// Writes comparators to out when it is non-null and returns how many there are.
+constexpr size_t batcher(size_t n, NetworkComparator* out) {
+    size_t count = 0;
+    for (size_t p = 1; p < n; p += p) {
+        for (size_t k = p; k >= 1; k /= 2) {
+            for (size_t j = k % p; j + k < n; j += 2 * k) {
+                for (size_t i = 0; i < k && i + j + k < n; i++) {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p)) {
+                        if (out != nullptr) {
+                            out[count] = {(uint8_t)(i + j), (uint8_t)(i + j + k)};
+                        }
+                        count++;
+                    }
+                }
+            }
+        }
+    }
+    return count;
+}
+
+template <size_t N>
+constexpr std::array<NetworkComparator, batcher(N, nullptr)> sortingNetwork() {
+    std::array<NetworkComparator, batcher(N, nullptr)> network{};
+    batcher(N, network.data());
+    return network;
+}
+
+// Walk the sorting network backwards, keeping only comparators that touch a wire the
+// middle output still depends on. Same out/return convention as batcher().
+template <size_t N>
+constexpr size_t pruneToMedian(NetworkComparator* out) {
+    constexpr auto network = sortingNetwork<N>();
+    bool needed[N] = {};
+    bool keep[network.size() + 1] = {};
+    needed[N / 2] = true;
+
+    for (size_t c = network.size(); c-- > 0;) {
+        if (needed[network[c].low] || needed[network[c].high]) {
+            needed[network[c].low] = true;
+            needed[network[c].high] = true;
+            keep[c] = true;
+        }
+    }
+
+    size_t count = 0;
+    for (size_t c = 0; c < network.size(); c++) {
+        if (keep[c]) {
+            if (out != nullptr) {
+                out[count] = network[c];
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+template <size_t N>
+constexpr std::array<NetworkComparator, pruneToMedian<N>(nullptr)> selectionNetwork() {
+    std::array<NetworkComparator, pruneToMedian<N>(nullptr)> network{};
+    pruneToMedian<N>(network.data());
+    return network;
+}
+
+template <typename T>
+inline void compareExchange(T& a, T& b) {
+    T low = (a < b) ? a : b;
+    T high = (a < b) ? b : a;
+    a = low;
+    b = high;
+}
+
+}  // namespace MedianNetworkDetail
+
+template <size_t N>
+struct MedianNetwork {
+    static_assert(N % 2 == 1, "Median network needs an odd window size");
+    static_assert(N <= 255, "Comparator wires are stored as uint8_t");
+
+    static constexpr auto comparators = MedianNetworkDetail::selectionNetwork<N>();
+
+    // Median of N samples. The arrays are scratch space and are left partially ordered.
+    template <typename T>
+    static T median(T values[N]) {
+        for (const NetworkComparator& c : comparators) {
+            MedianNetworkDetail::compareExchange(values[c.low], values[c.high]);
+        }
+        return values[N / 2];
+    }
+
+    // Medians of two windows sharing the same comparator schedule, e.g. I and Q
+    template <typename T>
+    static void medianPair(T first[N], T second[N], T& firstMedian, T& secondMedian) {
+        for (const NetworkComparator& c : comparators) {
+            MedianNetworkDetail::compareExchange(first[c.low], first[c.high]);
+            MedianNetworkDetail::compareExchange(second[c.low], second[c.high]);
+        }
+        firstMedian = first[N / 2];
+        secondMedian = second[N / 2];
+    }
+};
+
+#endif
@@ -0,0 +1,41 @@
+/* noiseFloor.cpp - Empty washroom INS noise floor and the thresholds it suggests
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "noiseFloor.h"
+
+#include <math.h>
+
+#include "kllSketch.h"
+
+// ***************************** Local variables *****************************
+
+static KllSketch noiseSketch;
+
+// ***************************** Public functions *****************************
+
+void recordNoiseFloor(float magnitude) {
+    // Also leaves out NaN
+    if (magnitude > 0.0f) {
+        noiseSketch.update(magnitude);
+    }
+}
+
+NoiseFloorSuggestion suggestNoiseFloorThresholds() {
+    NoiseFloorSuggestion suggestion = {};
+    suggestion.sampleCount = noiseSketch.count();
+    suggestion.p50 = noiseSketch.quantile(0.5f);
+    suggestion.p99 = noiseSketch.quantile(NOISE_FLOOR_PERCENTILE);
+
+    if (suggestion.sampleCount >= NOISE_FLOOR_MIN_SAMPLES) {
+        uint32_t floor = (uint32_t)ceilf((suggestion.p99 < NOISE_FLOOR_MAX) ? suggestion.p99 : NOISE_FLOOR_MAX);
+        suggestion.stillnessThreshold = floor + NOISE_FLOOR_STILLNESS_MARGIN;
+        suggestion.occupancyThreshold = floor + NOISE_FLOOR_OCCUPANCY_MARGIN;
+    }
+    return suggestion;
+}
+
+void resetNoiseFloor() {
+    noiseSketch.clear();
+}
@@ -0,0 +1,53 @@
+/* noiseFloor.h - Empty washroom INS noise floor and the thresholds it suggests
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * The radar's magnitude in an empty washroom depends on how and where it is mounted, so
+ * the default thresholds suit some washrooms better than others. Every new filtered INS
+ * value read in state 0 with the door open, when nobody can be inside yet, is recorded in
+ * a KllSketch (see kllSketch.h). Values of 0, when the radar is silent, are left out.
+ *
+ * Once there are NOISE_FLOOR_MIN_SAMPLES of them, the 99th percentile of the noise gives:
+ *  - stillness_ins_threshold: the percentile plus NOISE_FLOOR_STILLNESS_MARGIN, so someone
+ *    still in the washroom reads below it even where the noise is high
+ *  - occupancy_detection_ins_threshold: the percentile plus NOISE_FLOOR_OCCUPANCY_MARGIN,
+ *    so the noise alone does not start a session
+ * A 99th percentile of 15 suggests the default thresholds. The suggestions are sent in the
+ * heartbeat and applied by it when Noise_Calibration is on.
+ *
+ * Recorded and read from loop() only. The sketch covers every value since startup.
+ */
+
+#ifndef NOISE_FLOOR_H
+#define NOISE_FLOOR_H
+
+#include <stdint.h>
+
+// ***************************** Macro definitions *****************************
+
+#define NOISE_FLOOR_PERCENTILE          0.99f
+#define NOISE_FLOOR_MIN_SAMPLES         6000    // About 5 min of the door open at 20 values a second
+#define NOISE_FLOOR_STILLNESS_MARGIN    5
+#define NOISE_FLOOR_OCCUPANCY_MARGIN    45
+#define NOISE_FLOOR_MAX                 60000.0f    // Higher percentiles are taken as this
+
+// ***************************** Global typedefs *****************************
+
+typedef struct NoiseFloorSuggestion {
+    uint32_t sampleCount;
+    float p50;
+    float p99;
+    // 0 until there are NOISE_FLOOR_MIN_SAMPLES
+    uint32_t stillnessThreshold;
+    uint32_t occupancyThreshold;
+} NoiseFloorSuggestion;
+
+// ***************************** Function declarations *****************************
+
+void recordNoiseFloor(float magnitude);
+
+NoiseFloorSuggestion suggestNoiseFloorThresholds(void);
+
+void resetNoiseFloor(void);
+
+#endif
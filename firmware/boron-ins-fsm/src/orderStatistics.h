@@ -0,0 +1,50 @@
+/* orderStatistics.h - Sliding window order statistics for the INS filter chain
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#ifndef ORDER_STATISTICS_H
+#define ORDER_STATISTICS_H
+
+#include <stddef.h>
+#include <CircularBuffer.h>
+
+/*
+ * SortedWindow keeps the last S samples twice: in arrival order in a CircularBuffer, so
+ * we know which sample leaves the window next, and in ascending order in a flat array,
+ * so any rank (median, quartile) is a single array read.
+ *
+ * A push finds the evicted and inserted positions with binary search and shifts only the
+ * elements between them, so an update is O(log S) compares plus a short memmove instead
+ * of re-sorting the whole window.
+ */
+template <typename T, size_t S>
+class SortedWindow {
+public:
+    SortedWindow();
+
+    // Add a sample, evicting the oldest one once the window is full
+    void push(T value);
+
+    // k-th smallest sample in the window, 0 <= rank < size()
+    T at(size_t rank) const;
+
+    // Middle sample of the window (upper middle for even sizes)
+    T median() const;
+
+    size_t size() const;
+    bool isFull() const;
+    void clear();
+
+private:
+    size_t lowerBound(T value) const;
+    size_t upperBound(T value) const;
+
+    CircularBuffer<T, S> arrivals;
+    T sorted[S];
+    size_t count;
+};
+
+#include "orderStatistics.tpp"
+
+#endif
@@ -0,0 +1,101 @@
+/* orderStatistics.tpp - Sliding window order statistics template implementation
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+template <typename T, size_t S>
+SortedWindow<T, S>::SortedWindow() : count(0) {}
+
+template <typename T, size_t S>
+void SortedWindow<T, S>::push(T value) {
+    if (count < S) {
+        // Window still filling: plain sorted insert
+        size_t insertAt = upperBound(value);
+        for (size_t i = count; i > insertAt; i--) {
+            sorted[i] = sorted[i - 1];
+        }
+        sorted[insertAt] = value;
+        count++;
+        arrivals.push(value);
+        return;
+    }
+
+    // Window full: replace the oldest sample in place, shifting only the span between
+    // the slot it vacates and the slot the new sample belongs in
+    T oldest = arrivals.first();
+    arrivals.push(value);
+
+    size_t removeAt = lowerBound(oldest);
+    if (value >= oldest) {
+        size_t insertAt = upperBound(value) - 1;
+        for (size_t i = removeAt; i < insertAt; i++) {
+            sorted[i] = sorted[i + 1];
+        }
+        sorted[insertAt] = value;
+    }
+    else {
+        size_t insertAt = upperBound(value);
+        for (size_t i = removeAt; i > insertAt; i--) {
+            sorted[i] = sorted[i - 1];
+        }
+        sorted[insertAt] = value;
+    }
+}
+
+template <typename T, size_t S>
+T SortedWindow<T, S>::at(size_t rank) const {
+    return sorted[rank];
+}
+
+template <typename T, size_t S>
+T SortedWindow<T, S>::median() const {
+    return sorted[count / 2];
+}
+
+template <typename T, size_t S>
+size_t SortedWindow<T, S>::size() const {
+    return count;
+}
+
+template <typename T, size_t S>
+bool SortedWindow<T, S>::isFull() const {
+    return count == S;
+}
+
+template <typename T, size_t S>
+void SortedWindow<T, S>::clear() {
+    arrivals.clear();
+    count = 0;
+}
+
+// First index whose value is not less than the given value
+template <typename T, size_t S>
+size_t SortedWindow<T, S>::lowerBound(T value) const {
+    size_t low = 0, high = count;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (sorted[mid] < value) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// First index whose value is greater than the given value
+template <typename T, size_t S>
+size_t SortedWindow<T, S>::upperBound(T value) const {
+    size_t low = 0, high = count;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (value < sorted[mid]) {
+            high = mid;
+        }
+        else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
@@ -0,0 +1,130 @@
+/* profiler.cpp - Scoped timers for the calls loop() makes
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "profiler.h"
+
+#ifdef BRAVE_PROFILER
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __arm__
+
+// ***************************** Macro definitions *****************************
+
+// Cortex-M4 debug registers, see the ARMv7-M Architecture Reference Manual C1.6 and C1.8
+#define DEMCR               (*(volatile uint32_t*)0xE000EDFC)
+#define DEMCR_TRCENA        (1u << 24)
+#define DWT_CTRL            (*(volatile uint32_t*)0xE0001000)
+#define DWT_CTRL_CYCCNTENA  (1u << 0)
+#define DWT_CYCCNT          (*(volatile uint32_t*)0xE0001004)
+
+#else
+
+#include <chrono>
+
+#endif
+
+// ***************************** Local variables *****************************
+
+static ProfileStats profileStats[PROFILE_SITE_COUNT];
+
+static const char* const siteNames[PROFILE_SITE_COUNT] = {"checkIM", "readINSSnapshot", "idle", "countdown", "monitoring", "stillness", "getHeartbeat"};
+
+// ***************************** Local functions *****************************
+
+static size_t bucketFor(uint32_t ticks) {
+    size_t bucket = 0;
+    while (ticks != 0 && bucket < PROFILE_BUCKETS - 1) {
+        ticks >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// ***************************** Public functions *****************************
+
+void setupProfiler() {
+#ifdef __arm__
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+#endif
+    resetProfileStats();
+}
+
+uint32_t profileTicks() {
+#ifdef __arm__
+    return DWT_CYCCNT;
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+const char* profileTickUnit() {
+#ifdef __arm__
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+void recordProfile(ProfileSite site, uint32_t ticks) {
+    ProfileStats& stats = profileStats[site];
+    stats.count++;
+    stats.total += ticks;
+    stats.buckets[bucketFor(ticks)]++;
+    if (stats.count == 1 || ticks < stats.min) {
+        stats.min = ticks;
+    }
+    if (ticks > stats.max) {
+        stats.max = ticks;
+    }
+}
+
+const ProfileStats& getProfileStats(ProfileSite site) {
+    return profileStats[site];
+}
+
+void resetProfileStats() {
+    memset(profileStats, 0, sizeof(profileStats));
+}
+
+uint32_t profilePercentile(const ProfileStats& stats, unsigned int percent) {
+    if (stats.count == 0) {
+        return 0;
+    }
+
+    // Smallest bucket holding at least percent of the calls, rounding the rank up
+    uint64_t rank = ((uint64_t)stats.count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < PROFILE_BUCKETS; bucket++) {
+        seen += stats.buckets[bucket];
+        if (seen >= rank && seen > 0) {
+            uint32_t upper = (bucket == 0) ? 0 : (uint32_t)((1ull << bucket) - 1);
+            return (upper < stats.max) ? upper : stats.max;
+        }
+    }
+    return stats.max;
+}
+
+const char* profileSiteName(ProfileSite site) {
+    return siteNames[site];
+}
+
+size_t formatProfileStats(char* buffer, size_t size) {
+    size_t length = snprintf(buffer, size, "{\"unit\":\"%s\"", profileTickUnit());
+    for (int site = 0; site < PROFILE_SITE_COUNT; site++) {
+        const ProfileStats& stats = profileStats[site];
+        unsigned long mean = (stats.count > 0) ? (unsigned long)(stats.total / stats.count) : 0;
+        length += snprintf(buffer + ((length < size) ? length : size), (length < size) ? size - length : 0,
+                           ",\"%s\":[%lu,%lu,%lu,%lu,%lu]", siteNames[site], (unsigned long)stats.count, (unsigned long)stats.min, mean,
+                           (unsigned long)stats.max, (unsigned long)profilePercentile(stats, 99));
+    }
+    length += snprintf(buffer + ((length < size) ? length : size), (length < size) ? size - length : 0, "}");
+    return length;
+}
+
+#endif
@@ -0,0 +1,114 @@
+/* profiler.h - Scoped timers for the calls loop() makes
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * PROFILE_SCOPE(site) times the rest of the enclosing block and records it against the
+ * call site: count, min, mean, max and a p99 taken from power of two buckets, all in fixed
+ * memory. Time is read from the Cortex-M4 DWT cycle counter on the device and from
+ * std::chrono::steady_clock in ns on hosts.
+ *
+ * The profiler is only built with BRAVE_PROFILER. Without it PROFILE_SCOPE expands to
+ * nothing, setupProfiler() is empty and the Profile_Stats console function is not
+ * registered, so the release firmware is unchanged.
+ *
+ * Every site runs on the application thread, as does the console function reading the
+ * stats, so they are plain variables. braveFleet runs state machines on many threads and
+ * must not be built with the profiler.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ***************************** Macro definitions *****************************
+
+// Uncomment to time the sites below and register the Profile_Stats console function
+// #define BRAVE_PROFILER
+
+// Bucket 0 holds 0 ticks, bucket b holds [2^(b-1), 2^b) ticks, and the last bucket also
+// holds everything above
+#define PROFILE_BUCKETS     32
+
+// ***************************** Global typedefs *****************************
+
+// One per timed call site. The state sites are indexed by StateId.
+enum ProfileSite {
+    PROFILE_CHECK_IM = 0,
+    PROFILE_READ_INS,
+    PROFILE_STATE_IDLE,
+    PROFILE_STATE_INITIAL_COUNTDOWN,
+    PROFILE_STATE_MONITORING,
+    PROFILE_STATE_STILLNESS,
+    PROFILE_HEARTBEAT,
+    PROFILE_SITE_COUNT
+};
+
+typedef struct ProfileStats {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t buckets[PROFILE_BUCKETS];
+} ProfileStats;
+
+#ifdef BRAVE_PROFILER
+
+// ***************************** Function declarations *****************************
+
+// Starts the DWT cycle counter, call once from setup()
+void setupProfiler(void);
+
+// Cycles on the device, ns on hosts. Differences are right across the 32 bit wrap, which
+// is 67 s at 64 MHz and 4.3 s in ns.
+uint32_t profileTicks(void);
+
+// "cycles" or "ns"
+const char* profileTickUnit(void);
+
+void recordProfile(ProfileSite site, uint32_t ticks);
+
+const ProfileStats& getProfileStats(ProfileSite site);
+
+void resetProfileStats(void);
+
+// Upper bound in ticks of the bucket holding the given percentile, capped at the max
+// recorded. 0 for a site that has not run.
+uint32_t profilePercentile(const ProfileStats& stats, unsigned int percent);
+
+// Short name for console output, e.g. "checkIM"
+const char* profileSiteName(ProfileSite site);
+
+// Writes {"unit":"cycles","checkIM":[count,min,mean,max,p99],...} into buffer, truncated
+// to size. Returns the length it needed, like snprintf.
+size_t formatProfileStats(char* buffer, size_t size);
+
+// ***************************** Scoped timer *****************************
+
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileSite site) : site(site), start(profileTicks()) {}
+    ~ProfileScope() { recordProfile(site, profileTicks() - start); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfileSite site;
+    uint32_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b)  a##b
+#define PROFILE_CONCAT(a, b)        PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(site)         ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(site)
+
+#else
+
+inline void setupProfiler() {}
+
+#define PROFILE_SCOPE(site)         ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,311 @@
+/* publishQueue.cpp - Prioritized, rate limited asynchronous Particle publishes
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include <mutex>
+
+#include "clock.h"
+#include "latencyStats.h"
+#include "publishQueue.h"
+#include "Particle.h"
+
+// ***************************** Local typedefs *****************************
+
+enum PublishSlotState {
+    SLOT_FREE,
+    SLOT_QUEUED,
+    SLOT_IN_FLIGHT
+};
+
+typedef struct PublishSlot {
+    PublishSlotState state;
+    PublishPriority priority;
+    uint32_t sequence;          // Order the item was queued in, oldest goes first within a priority
+    uint32_t attempts;
+    uint32_t queuedAt;
+    uint32_t waitStartedAt;     // The item is ready once waitInterval has passed since this time
+    uint32_t waitInterval;
+    PublishCallback callback;
+    void* context;
+    particle::Future<bool> future;
+    char eventName[PUBLISH_EVENT_NAME_LENGTH + 1];
+    char data[PUBLISH_DATA_LENGTH + 1];
+} PublishSlot;
+
+typedef struct PublishNotification {
+    PublishCallback callback;
+    void* context;
+    bool succeeded;
+} PublishNotification;
+
+// ***************************** Local variables *****************************
+
+// queuePublish() may run on the BLE scanner thread, so everything below except the
+// in-flight slot (only touched by servicePublishQueue()) is guarded by queueMutex
+static std::mutex queueMutex;
+static PublishSlot slots[PUBLISH_QUEUE_SLOTS];
+static uint32_t nextSlotSequence = 0;
+static int inFlightSlot = -1;
+static PublishQueueStats stats = {};
+
+// Callbacks of evicted items, called from the next servicePublishQueue()
+static PublishNotification evictions[PUBLISH_QUEUE_SLOTS];
+static size_t numEvictions = 0;
+
+// Token bucket
+static bool bucketStarted = false;
+static uint32_t tokens = 0;
+static uint32_t lastRefill = 0;
+
+// ***************************** Local functions *****************************
+
+static void refillTokens() {
+    if (!bucketStarted) {
+        tokens = PUBLISH_RATE_BURST;
+        lastRefill = clockMillis();
+        bucketStarted = true;
+        return;
+    }
+
+    uint32_t earned = clockMillisSince(lastRefill) / PUBLISH_RATE_INTERVAL;
+    if (earned == 0) {
+        return;
+    }
+    if (tokens + earned >= PUBLISH_RATE_BURST) {
+        tokens = PUBLISH_RATE_BURST;
+        lastRefill = clockMillis();
+    }
+    else {
+        tokens += earned;
+        lastRefill += earned * PUBLISH_RATE_INTERVAL;
+    }
+}
+
+static bool isReady(const PublishSlot& slot) {
+    return slot.state == SLOT_QUEUED && clockMillisSince(slot.waitStartedAt) >= slot.waitInterval;
+}
+
+// Slot to give up for an incoming item, or -1. The in-flight slot is never evicted.
+static int findEvictable(PublishPriority incoming) {
+    int victim = -1;
+    for (int i = 0; i < PUBLISH_QUEUE_SLOTS; i++) {
+        const PublishSlot& slot = slots[i];
+        if (slot.state != SLOT_QUEUED) {
+            continue;
+        }
+        bool lower = slot.priority > incoming || (slot.priority == PUBLISH_PRIORITY_DEBUG && incoming == PUBLISH_PRIORITY_DEBUG);
+        if (!lower || (slot.callback != nullptr && numEvictions >= PUBLISH_QUEUE_SLOTS)) {
+            continue;
+        }
+        // Lowest priority first, then oldest
+        if (victim < 0 || slot.priority > slots[victim].priority ||
+            (slot.priority == slots[victim].priority && (int32_t)(slot.sequence - slots[victim].sequence) < 0)) {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+static int findNextReady() {
+    int next = -1;
+    for (int i = 0; i < PUBLISH_QUEUE_SLOTS; i++) {
+        const PublishSlot& slot = slots[i];
+        if (!isReady(slot)) {
+            continue;
+        }
+        if (next < 0 || slot.priority < slots[next].priority ||
+            (slot.priority == slots[next].priority && (int32_t)(slot.sequence - slots[next].sequence) < 0)) {
+            next = i;
+        }
+    }
+    return next;
+}
+
+static uint32_t queueDepth() {
+    uint32_t depth = 0;
+    for (int i = 0; i < PUBLISH_QUEUE_SLOTS; i++) {
+        if (slots[i].state != SLOT_FREE) {
+            depth++;
+        }
+    }
+    return depth;
+}
+
+// Called with queueMutex held after an attempt on the in-flight slot failed
+static bool retryOrGiveUp(PublishSlot& slot) {
+    stats.failedAttempts++;
+    if ((slot.priority == PUBLISH_PRIORITY_DEBUG && slot.attempts >= PUBLISH_DEBUG_MAX_ATTEMPTS) ||
+        (slot.priority == PUBLISH_PRIORITY_WARNING && slot.attempts >= PUBLISH_WARNING_MAX_ATTEMPTS)) {
+        stats.dropped++;
+        slot.state = SLOT_FREE;
+        return false;
+    }
+
+    // Exponential backoff, capped
+    uint32_t interval = PUBLISH_RETRY_INTERVAL;
+    for (uint32_t i = 1; i < slot.attempts && interval < PUBLISH_RETRY_MAX_INTERVAL; i++) {
+        interval *= 2;
+    }
+    slot.waitStartedAt = clockMillis();
+    slot.waitInterval = (interval < PUBLISH_RETRY_MAX_INTERVAL) ? interval : PUBLISH_RETRY_MAX_INTERVAL;
+    slot.state = SLOT_QUEUED;
+    return true;
+}
+
+// ***************************** Public functions *****************************
+
+bool queuePublish(const char* eventName, const char* data, PublishPriority priority, PublishCallback callback, void* context) {
+    if (strlen(eventName) > PUBLISH_EVENT_NAME_LENGTH || strlen(data) > PUBLISH_DATA_LENGTH) {
+        Log.error("Publish of %s does not fit in a queue slot", eventName);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+
+    int index = -1;
+    for (int i = 0; i < PUBLISH_QUEUE_SLOTS; i++) {
+        if (slots[i].state == SLOT_FREE) {
+            index = i;
+            break;
+        }
+    }
+
+    if (index < 0) {
+        index = findEvictable(priority);
+        if (index < 0) {
+            stats.dropped++;
+            Log.error("Publish queue full, dropped %s", eventName);
+            return false;
+        }
+
+        PublishSlot& victim = slots[index];
+        Log.warn("Publish queue full, evicted %s for %s", victim.eventName, eventName);
+        stats.dropped++;
+        if (victim.callback != nullptr) {
+            evictions[numEvictions++] = {victim.callback, victim.context, false};
+        }
+    }
+
+    PublishSlot& slot = slots[index];
+    slot.state = SLOT_QUEUED;
+    slot.priority = priority;
+    slot.sequence = nextSlotSequence++;
+    slot.attempts = 0;
+    slot.queuedAt = clockMillis();
+    slot.waitStartedAt = slot.queuedAt;
+    slot.waitInterval = 0;
+    slot.callback = callback;
+    slot.context = context;
+    strcpy(slot.eventName, eventName);
+    strcpy(slot.data, data);
+
+    stats.queued++;
+    uint32_t depth = queueDepth();
+    if (depth > stats.highWaterMark) {
+        stats.highWaterMark = depth;
+    }
+    return true;
+}
+
+void servicePublishQueue() {
+    PublishNotification notifications[PUBLISH_QUEUE_SLOTS + 1];
+    size_t numNotifications = 0;
+    int startSlot = -1;
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+
+        for (size_t i = 0; i < numEvictions; i++) {
+            notifications[numNotifications++] = evictions[i];
+        }
+        numEvictions = 0;
+
+        refillTokens();
+
+        // Resolve the in-flight publish without blocking
+        if (inFlightSlot >= 0) {
+            PublishSlot& slot = slots[inFlightSlot];
+            bool resolved = true;
+
+            if (slot.future.isDone() && slot.future.isSucceeded()) {
+                stats.published++;
+                if (slot.priority <= PUBLISH_PRIORITY_SESSION_END) {
+                    recordLatency(LATENCY_PUBLISH, clockMillisSince(slot.queuedAt));
+                }
+                slot.state = SLOT_FREE;
+                if (slot.callback != nullptr) {
+                    notifications[numNotifications++] = {slot.callback, slot.context, true};
+                }
+            }
+            else if (slot.future.isDone() || clockMillisSince(slot.waitStartedAt) > PUBLISH_TIMEOUT) {
+                if (!slot.future.isDone()) {
+                    Log.warn("Publish of %s timed out", slot.eventName);
+                }
+                if (!retryOrGiveUp(slot)) {
+                    Log.warn("Gave up publishing %s after %lu attempts", slot.eventName, (unsigned long)slot.attempts);
+                    if (slot.callback != nullptr) {
+                        notifications[numNotifications++] = {slot.callback, slot.context, false};
+                    }
+                }
+            }
+            else {
+                resolved = false;
+            }
+
+            if (resolved) {
+                inFlightSlot = -1;
+            }
+        }
+
+        // Start the next publish, one at a time so the cloud sees them in priority order
+        if (inFlightSlot < 0 && Particle.connected()) {
+            int next = findNextReady();
+            if (next >= 0) {
+                if (tokens == 0) {
+                    stats.rateLimited++;
+                }
+                else {
+                    tokens--;
+                    PublishSlot& slot = slots[next];
+                    slot.state = SLOT_IN_FLIGHT;
+                    slot.attempts++;
+                    slot.waitStartedAt = clockMillis();
+                    inFlightSlot = next;
+                    startSlot = next;
+                }
+            }
+        }
+    }
+
+    // The in-flight slot is only touched here, so the publish itself runs without the lock.
+    // Holding the Future instead of testing a bool return is what keeps this from blocking.
+    if (startSlot >= 0) {
+        PublishSlot& slot = slots[startSlot];
+        slot.future = Particle.publish(slot.eventName, slot.data, PRIVATE);
+    }
+
+    for (size_t i = 0; i < numNotifications; i++) {
+        notifications[i].callback(notifications[i].succeeded, notifications[i].context);
+    }
+}
+
+PublishQueueStats getPublishQueueStats() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    PublishQueueStats snapshot = stats;
+    snapshot.depth = queueDepth();
+    return snapshot;
+}
+
+void resetPublishQueue() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (int i = 0; i < PUBLISH_QUEUE_SLOTS; i++) {
+        slots[i].state = SLOT_FREE;
+        slots[i].future = particle::Future<bool>();
+    }
+    nextSlotSequence = 0;
+    inFlightSlot = -1;
+    stats = {};
+    numEvictions = 0;
+    bucketStarted = false;
+}
@@ -0,0 +1,84 @@
+/* publishQueue.h - Prioritized, rate limited asynchronous Particle publishes
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Firmware code queues a publish and returns straight away. servicePublishQueue(), called
+ * from loop(), starts one publish at a time and polls its particle::Future on later passes,
+ * so no state handler ever waits on the radio. Ready items go out highest priority first,
+ * oldest first within a priority, and never faster than the cloud rate limit (1/sec with a
+ * burst of 4). A failed publish is retried with exponential backoff.
+ */
+
+#ifndef PUBLISH_QUEUE_H
+#define PUBLISH_QUEUE_H
+
+#include <stdint.h>
+
+// ***************************** Macro definitions *****************************
+
+#define PUBLISH_QUEUE_SLOTS             8
+#define PUBLISH_EVENT_NAME_LENGTH       64          // Particle event names are at most 64 chars
+#define PUBLISH_DATA_LENGTH             622         // Particle event data is at most 622 bytes
+
+// Token bucket matching the Particle cloud publish limit
+#define PUBLISH_RATE_INTERVAL           1000        // 1 sec per token
+#define PUBLISH_RATE_BURST              4           // Tokens held at most
+
+// A failed publish waits PUBLISH_RETRY_INTERVAL, doubling per attempt up to PUBLISH_RETRY_MAX_INTERVAL
+#define PUBLISH_RETRY_INTERVAL          2000        // 2 sec
+#define PUBLISH_RETRY_MAX_INTERVAL      60000       // 1 min
+
+// Debug traffic is not worth retrying and door sensor warnings only a few times, anything
+// else is retried until it goes through
+#define PUBLISH_DEBUG_MAX_ATTEMPTS      1
+#define PUBLISH_WARNING_MAX_ATTEMPTS    3
+
+// Defensive upper bound on waiting for an in-flight publish to resolve. Device OS normally
+// resolves the Future well within this window; this only guards against a Future that never
+// completes, which would otherwise wedge the queue. A timed out publish counts as failed.
+#define PUBLISH_TIMEOUT                 30000       // 30 sec
+
+// ***************************** Global typedefs *****************************
+
+// Lower values go first. When the queue is full a new item evicts the oldest queued item of
+// a lower priority, and a new debug item evicts the oldest queued debug item.
+enum PublishPriority {
+    PUBLISH_PRIORITY_ALERT = 0,        // Duration and stillness alerts
+    PUBLISH_PRIORITY_SESSION_END,      // Door opened
+    PUBLISH_PRIORITY_HEARTBEAT,        // Heartbeats
+    PUBLISH_PRIORITY_WARNING,          // Door sensor warnings
+    PUBLISH_PRIORITY_DEBUG,            // Debug messages and state transitions
+    PUBLISH_PRIORITY_COUNT
+};
+
+// Called from servicePublishQueue() once the publish went through, or once it was given up
+// (debug items after PUBLISH_DEBUG_MAX_ATTEMPTS, warnings after PUBLISH_WARNING_MAX_ATTEMPTS,
+// or any item evicted from a full queue)
+typedef void (*PublishCallback)(bool succeeded, void* context);
+
+typedef struct PublishQueueStats {
+    uint32_t queued;          // Items accepted by queuePublish()
+    uint32_t published;       // Items that went through
+    uint32_t failedAttempts;  // Publish attempts that failed or timed out
+    uint32_t dropped;         // Items evicted, rejected or given up
+    uint32_t rateLimited;     // Service passes that had a ready item but no token
+    uint32_t highWaterMark;   // Most items ever waiting
+    uint32_t depth;           // Items waiting when the snapshot was taken
+} PublishQueueStats;
+
+// ***************************** Function declarations *****************************
+
+// Copies the event into a free slot. Safe to call from any thread. Returns false if the
+// queue is full of items that may not be evicted, or the event does not fit in a slot.
+bool queuePublish(const char* eventName, const char* data, PublishPriority priority, PublishCallback callback = nullptr,
+                  void* context = nullptr);
+
+// Starts and resolves publishes. Call it from loop() only.
+void servicePublishQueue(void);
+
+PublishQueueStats getPublishQueueStats(void);
+
+// Drops everything queued without calling callbacks, for tests
+void resetPublishQueue(void);
+
+#endif
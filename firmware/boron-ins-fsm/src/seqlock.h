@@ -0,0 +1,58 @@
+/* seqlock.h - Lock-free snapshot of a value written by one thread and read by any
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+/*
+ * Publishes the latest value from one writer thread (e.g. the radar filter) to any number
+ * of reader threads without locks, and without readers changing anything the writer sees.
+ *
+ * The value is kept twice. A write bumps the sequence to odd, so readers use the second
+ * copy while the first is rewritten, then bumps it to even and rewrites the second copy.
+ * A reader picks the copy the sequence points at, copies it and checks the sequence did
+ * not move meanwhile, retrying if it did. Because one copy is always stable, a writer
+ * preempted halfway through a write never holds readers up; a reader only retries when a
+ * whole write lands during its copy.
+ *
+ * The copies are stored as atomic words so a reader racing the writer is well defined,
+ * and T must be trivially copyable. The words are release stores and acquire loads rather
+ * than fences, which ThreadSanitizer can check; on the Boron each is a single barrier.
+ */
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock values are copied word by word");
+
+public:
+    Seqlock();
+
+    // Writer side, from a single thread
+    void write(const T& value);
+
+    // Any thread. The value last written, or a zeroed T before the first write.
+    T read() const;
+
+    // Writes so far, readable from any thread
+    uint32_t writeCount() const;
+
+    // Reads that had to copy the value again because a write landed during them
+    uint32_t readRetries() const;
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> copies[2][WORDS];
+    mutable std::atomic<uint32_t> retries;
+};
+
+#include "seqlock.tpp"
+
+#endif
@@ -0,0 +1,67 @@
+/* seqlock.tpp - Lock-free snapshot template implementation
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include <string.h>
+
+template <typename T>
+Seqlock<T>::Seqlock() : sequence(0), retries(0) {
+    for (size_t copy = 0; copy < 2; copy++) {
+        for (size_t i = 0; i < WORDS; i++) {
+            copies[copy][i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+void Seqlock<T>::write(const T& value) {
+    uint32_t words[WORDS] = {};
+    memcpy(words, &value, sizeof(T));
+
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    for (uint32_t copy = 0; copy < 2; copy++) {
+        // Point readers at the other copy before this one changes. The release stores
+        // publish the copy written before, and keep this copy's words after the sequence.
+        sequence.store(seq + copy + 1, std::memory_order_release);
+
+        for (size_t i = 0; i < WORDS; i++) {
+            copies[copy][i].store(words[i], std::memory_order_release);
+        }
+    }
+}
+
+template <typename T>
+T Seqlock<T>::read() const {
+    uint32_t words[WORDS];
+    while (true) {
+        uint32_t seq = sequence.load(std::memory_order_acquire);
+
+        // Even: both copies are done and the first was rewritten last. Odd: the first copy
+        // is being rewritten, the second still holds the previous value.
+        const std::atomic<uint32_t>* copy = copies[seq & 1];
+        // A word from a newer write makes that write's sequence visible to the check below
+        for (size_t i = 0; i < WORDS; i++) {
+            words[i] = copy[i].load(std::memory_order_acquire);
+        }
+
+        if (sequence.load(std::memory_order_relaxed) == seq) {
+            break;
+        }
+        retries.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    T value;
+    memcpy(&value, words, sizeof(T));
+    return value;
+}
+
+template <typename T>
+uint32_t Seqlock<T>::writeCount() const {
+    return sequence.load(std::memory_order_relaxed) / 2;
+}
+
+template <typename T>
+uint32_t Seqlock<T>::readRetries() const {
+    return retries.load(std::memory_order_relaxed);
+}
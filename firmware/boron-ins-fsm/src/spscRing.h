@@ -0,0 +1,95 @@
+/* spscRing.h - Lock-free single-producer/single-consumer ring buffer
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Snapshot of a ring's counters for telemetry
+typedef struct SpscRingStats {
+    uint32_t overflows;      // Items rejected because the ring was full
+    uint32_t highWaterMark;  // Largest number of items ever waiting
+    uint32_t depth;          // Items waiting when the snapshot was taken
+    uint32_t capacity;
+} SpscRingStats;
+
+// Producer side counters since the previous takeWindow(), for periodic telemetry
+typedef struct SpscRingWindow {
+    uint32_t overflows;      // Items rejected because the ring was full
+    uint32_t highWaterMark;  // Largest number of items waiting after a push
+    uint32_t pushes;         // Push calls, each of which samples the occupancy
+    uint32_t occupancySum;   // Items waiting after each push call, summed
+} SpscRingWindow;
+
+// Adds the counters of from to into, as if the two windows were one
+inline void mergeSpscRingWindow(SpscRingWindow& into, const SpscRingWindow& from) {
+    into.overflows += from.overflows;
+    into.highWaterMark = (from.highWaterMark > into.highWaterMark) ? from.highWaterMark : into.highWaterMark;
+    into.pushes += from.pushes;
+    into.occupancySum += from.occupancySum;
+}
+
+/*
+ * Hands items from one producer thread (e.g. the radar reader) to one consumer thread
+ * (e.g. the application loop) without going through the RTOS kernel. Each side only
+ * writes its own index: the producer publishes filled slots with a release store of head
+ * and the consumer returns them with a release store of tail, each reading the other's
+ * index with an acquire load.
+ *
+ * A push into a full ring fails and is counted instead of overwriting unread items.
+ * Indices run freely and are masked into the buffer, so S must be a power of two.
+ *
+ * Every push call also samples the occupancy into a window of counters that one
+ * telemetry reader, e.g. the heartbeat, takes and restarts. The producer only adds to the
+ * window, so it never waits on the reader.
+ */
+template <typename T, size_t S>
+class SpscRing {
+    static_assert(S >= 2 && (S & (S - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    SpscRing();
+
+    // Producer side
+    bool push(const T& item);
+    size_t pushBulk(const T* items, size_t count);
+
+    // Consumer side
+    bool pop(T& item);
+    size_t popBulk(T* items, size_t maxCount);
+
+    // Items waiting, exact from either side and approximate from any other thread
+    size_t size() const;
+    static constexpr size_t capacity() { return S; }
+
+    // Producer side statistics, readable from any thread
+    uint32_t overflowCount() const;   // Items rejected because the ring was full
+    uint32_t highWaterMark() const;   // Largest number of items ever waiting
+    SpscRingStats stats() const;
+
+    // Counters since the previous call, from one reader thread at a time. The window high
+    // water mark may miss the pushes that race with the take.
+    SpscRingWindow takeWindow();
+
+private:
+    void recordOccupancy(uint32_t occupancy);
+
+    std::atomic<uint32_t> head;  // Next slot the producer fills
+    std::atomic<uint32_t> tail;  // Next slot the consumer empties
+    std::atomic<uint32_t> overflows;
+    std::atomic<uint32_t> highWater;
+    std::atomic<uint32_t> windowOverflows;
+    std::atomic<uint32_t> windowHighWater;
+    std::atomic<uint32_t> windowPushes;
+    std::atomic<uint32_t> windowOccupancySum;
+    T buffer[S];
+};
+
+#include "spscRing.tpp"
+
+#endif
@@ -0,0 +1,99 @@
+/* spscRing.tpp - Lock-free single-producer/single-consumer ring buffer implementation
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+template <typename T, size_t S>
+SpscRing<T, S>::SpscRing()
+    : head(0), tail(0), overflows(0), highWater(0), windowOverflows(0), windowHighWater(0), windowPushes(0), windowOccupancySum(0) {}
+
+template <typename T, size_t S>
+bool SpscRing<T, S>::push(const T& item) {
+    return pushBulk(&item, 1) == 1;
+}
+
+template <typename T, size_t S>
+size_t SpscRing<T, S>::pushBulk(const T* items, size_t count) {
+    uint32_t currentHead = head.load(std::memory_order_relaxed);
+    uint32_t currentTail = tail.load(std::memory_order_acquire);
+    uint32_t free = S - (currentHead - currentTail);
+
+    size_t toPush = (count < free) ? count : free;
+    for (size_t i = 0; i < toPush; i++) {
+        buffer[(currentHead + i) & (S - 1)] = items[i];
+    }
+    head.store(currentHead + (uint32_t)toPush, std::memory_order_release);
+
+    if (toPush < count) {
+        overflows.fetch_add((uint32_t)(count - toPush), std::memory_order_relaxed);
+        windowOverflows.fetch_add((uint32_t)(count - toPush), std::memory_order_relaxed);
+    }
+    recordOccupancy(currentHead + (uint32_t)toPush - currentTail);
+    return toPush;
+}
+
+template <typename T, size_t S>
+bool SpscRing<T, S>::pop(T& item) {
+    return popBulk(&item, 1) == 1;
+}
+
+template <typename T, size_t S>
+size_t SpscRing<T, S>::popBulk(T* items, size_t maxCount) {
+    uint32_t currentTail = tail.load(std::memory_order_relaxed);
+    uint32_t currentHead = head.load(std::memory_order_acquire);
+    uint32_t waiting = currentHead - currentTail;
+
+    size_t toPop = (maxCount < waiting) ? maxCount : waiting;
+    for (size_t i = 0; i < toPop; i++) {
+        items[i] = buffer[(currentTail + i) & (S - 1)];
+    }
+    tail.store(currentTail + (uint32_t)toPop, std::memory_order_release);
+    return toPop;
+}
+
+template <typename T, size_t S>
+size_t SpscRing<T, S>::size() const {
+    uint32_t currentTail = tail.load(std::memory_order_acquire);
+    uint32_t currentHead = head.load(std::memory_order_acquire);
+    return currentHead - currentTail;
+}
+
+template <typename T, size_t S>
+uint32_t SpscRing<T, S>::overflowCount() const {
+    return overflows.load(std::memory_order_relaxed);
+}
+
+template <typename T, size_t S>
+uint32_t SpscRing<T, S>::highWaterMark() const {
+    return highWater.load(std::memory_order_relaxed);
+}
+
+template <typename T, size_t S>
+SpscRingStats SpscRing<T, S>::stats() const {
+    SpscRingStats snapshot = {overflowCount(), highWaterMark(), (uint32_t)size(), (uint32_t)S};
+    return snapshot;
+}
+
+template <typename T, size_t S>
+SpscRingWindow SpscRing<T, S>::takeWindow() {
+    SpscRingWindow window;
+    window.overflows = windowOverflows.exchange(0, std::memory_order_relaxed);
+    window.highWaterMark = windowHighWater.exchange(0, std::memory_order_relaxed);
+    window.pushes = windowPushes.exchange(0, std::memory_order_relaxed);
+    window.occupancySum = windowOccupancySum.exchange(0, std::memory_order_relaxed);
+    return window;
+}
+
+// Only the producer writes the high water marks, so a plain load/compare/store is enough.
+// The window sums are read-modify-writes so a take on another thread never loses its reset.
+template <typename T, size_t S>
+void SpscRing<T, S>::recordOccupancy(uint32_t occupancy) {
+    if (occupancy > highWater.load(std::memory_order_relaxed)) {
+        highWater.store(occupancy, std::memory_order_relaxed);
+    }
+    if (occupancy > windowHighWater.load(std::memory_order_relaxed)) {
+        windowHighWater.store(occupancy, std::memory_order_relaxed);
+    }
+    windowPushes.fetch_add(1, std::memory_order_relaxed);
+    windowOccupancySum.fetch_add(occupancy, std::memory_order_relaxed);
+}
@@ -7,85 +7,148 @@
 
 #include <queue>
 
+#include "alertJournal.h"
+#include "clock.h"
+#include "deadlineScheduler.h"
 #include "debugFlags.h"
 #include "flashAddresses.h"
+#include "heartbeatEncoding.h"
 #include "imDoorSensor.h"
 #include "ins3331.h"
+#include "insHistogram.h"
+#include "jsonWriter.h"
+#include "latencyStats.h"
+#include "noiseFloor.h"
+#include "profiler.h"
+#include "publishQueue.h"
 #include "stateMachine.h"
+#include "traceLog.h"
 #include "Particle.h"
 
-#define PARTICLE_MAX_MESSAGE_LENGTH    622
+// Reset reason
+int resetReason = System.resetReason();
 
-// State machine pointer
-StateHandler stateHandler = state0_idle;
+// resetReasonName() names the reasons by their Device OS codes
+static_assert(RESET_REASON_PIN_RESET == 20 && RESET_REASON_WATCHDOG == 60 && RESET_REASON_USER == 140, "Device OS reset reason codes changed");
 
-// State machine constants firmware code
-unsigned long occupancy_detection_ins_threshold = OCCUPANCY_DETECTION_INS_THRESHOLD;
-unsigned long stillness_ins_threshold = STILLNESS_INS_THRESHOLD;
+// JSON or compact, set with the Heartbeat_Format console function
+uint16_t heartbeatFormat = HEARTBEAT_FORMAT_JSON;
 
-unsigned long state0_occupancy_detection_time = STATE0_OCCUPANCY_DETECTION_TIME;
-unsigned long state1_initial_time = STATE1_INITIAL_TIME;
-unsigned long duration_alert_time = DURATION_ALERT_TIME;
-unsigned long stillness_alert_time = STILLNESS_ALERT_TIME;
+// Set with the Noise_Calibration console function
+uint16_t noiseCalibration = NOISE_CALIBRATION_OFF;
 
-// Start timers for different states
-unsigned long state0_start_time;
-unsigned long state1_start_time;
-unsigned long state2_start_time;
-unsigned long state3_start_time;
+// Door close events the state machine has seen, compared with doorClosedEventCount
+static unsigned long lastDoorClosedEventCount = 0;
 
-// Time spent in different states
-unsigned long timeInState0;
-unsigned long timeInState1;
-unsigned long timeInState2;
-unsigned long timeInState3;
+// Missed door events the state machine has seen, compared with missedDoorEventTotal
+static unsigned long lastMissedDoorEventTotal = 0;
 
-// Time since the door was closed
-unsigned long timeSinceDoorClosed = 0;
+// Newest radar sample in the last INS value put in a histogram
+static uint32_t lastHistogramSampleTime = 0;
 
-// Duration alert variables
-unsigned long numDurationAlertSent = 0;
-unsigned long lastDurationAlertTime = 0;
-unsigned long timeSinceLastDurationAlert = 0;
-bool isDurationAlertThresholdExceeded = false;
+/*
+ * Helper Function - calculateTimeSince
+ * Calculates elapsed time since the given time.
+ * Overflow is handled automatically by unsigned arithmetic.
+ */
+unsigned long calculateTimeSince(unsigned long startTime) {
+    return clockMillisSince(startTime);
+}
 
-// Stillness alert variables 
-unsigned long numStillnessAlertSent = 0;
-bool isStillnessAlertActive = false;
-bool isStillnessAlertThresholdExceeded = false;
+// ***************************** State machine I/O *****************************
 
-// Allow state transitions
-bool allowTransitionToStateOne = true;
+static uint32_t firmwareNow(void* context) {
+    return clockMillis();
+}
 
-// Reset reason
-int resetReason = System.resetReason();
+static void readFirmwareInputs(void* context, StateMachineInputs* inputs) {
+    doorData door = checkIM();
+    filteredINSData ins = readINSSnapshot();
+
+    inputs->doorStatus = door.doorStatus;
+    inputs->isDoorOpen = isDoorOpen(door.doorStatus);
+    inputs->isDoorStatusUnknown = isDoorStatusUnknown(door.doorStatus);
+    inputs->isDoorClosedEvent = doorClosedEventCount != lastDoorClosedEventCount;
+    inputs->insMagnitude = ins.magnitude;
+    inputs->insSampleTime = ins.sampleTime;
+    inputs->missedDoorEvents = (uint32_t)(missedDoorEventTotal - lastMissedDoorEventTotal);
+    lastDoorClosedEventCount = doorClosedEventCount;
+    lastMissedDoorEventTotal = missedDoorEventTotal;
+}
 
-void setupStateMachine() {
-    // From debugFlags.h (default to not publish debug messages)
-    stateMachineDebugFlag = 0;
+// Only allow the device to reset while idle, and only if the door sensor has gone quiet
+static void allowFirmwareReset(void* context, bool stateAllowsReset) {
+    if (stateAllowsReset && calculateTimeSince(doorHeartbeatReceived) > DEVICE_RESET_THRESHOLD) {
+        System.enableReset();
+    }
+    else {
+        System.disableReset();
+    }
+}
 
-    state0_start_time = 0;
-    state1_start_time = 0;
-    state2_start_time = 0;
-    state3_start_time = 0;
+// Formats the line only if it is going to be logged, the state is logged every tick
+static void logFirmware(void* context, StateMachineLogLevel level, const char* fmt, va_list args) {
+    if (!Log.isLevelEnabled((level == STATE_MACHINE_LOG_WARN) ? LOG_LEVEL_WARN : LOG_LEVEL_INFO)) {
+        return;
+    }
 
-    timeInState0 = 0;
-    timeInState1 = 0;
-    timeInState2 = 0;
-    timeInState3 = 0;
+    char message[PARTICLE_MAX_MESSAGE_LENGTH];
+    vsnprintf(message, sizeof(message), fmt, args);
+    if (level == STATE_MACHINE_LOG_WARN) {
+        Log.warn("%s", message);
+    }
+    else {
+        Log.info("%s", message);
+    }
+}
 
-    timeSinceDoorClosed = 0;
+static void reportFirmwareState(void* context, StateId state, const StateMachineInputs& inputs, unsigned long timeInState) {
+    TRACE(TRACE_STATE, state, inputs.doorStatus, inputs.insMagnitude);
 
-    numDurationAlertSent = 0;
-    lastDurationAlertTime = 0;
-    timeSinceLastDurationAlert = 0;
-    isDurationAlertThresholdExceeded = false;
+    // Each filtered value once, as the state machine ticks more often than the filter runs
+    if (inputs.insSampleTime != lastHistogramSampleTime) {
+        InsOccupancy occupancy = (state == STATE_IDLE) ? INS_OCCUPANCY_EMPTY : (state == STATE_STILLNESS) ? INS_OCCUPANCY_STILL : INS_OCCUPANCY_MOVING;
+        recordInsMagnitude(occupancy, inputs.insMagnitude);
+        lastHistogramSampleTime = inputs.insSampleTime;
 
-    numStillnessAlertSent = 0;
-    isStillnessAlertActive = false;
-    isStillnessAlertThresholdExceeded = false;
+        // Nobody can be inside yet
+        if (state == STATE_IDLE && inputs.isDoorOpen && !inputs.isDoorStatusUnknown) {
+            recordNoiseFloor(inputs.insMagnitude);
+        }
+    }
+    publishDebugMessage(state, inputs.doorStatus, inputs.insMagnitude, timeInState);
+}
 
-    allowTransitionToStateOne = true;
+static void reportFirmwareTransition(void* context, StateId from, StateId to, bool isRadarDecision, const StateMachineInputs& inputs) {
+    // Transitions taken on the door or a timer have no radar sample to measure from
+    if (isRadarDecision) {
+        recordLatency(LATENCY_DECISION, clockMillisSince(inputs.insSampleTime));
+    }
+    publishStateTransition(from, to, inputs.doorStatus, inputs.insMagnitude);
+}
+
+static void journalSessionMessage(void* context, const char* eventName, const char* message, SessionMessageKind kind) {
+    journalAlert(eventName, message, (kind == SESSION_MESSAGE_END) ? PUBLISH_PRIORITY_SESSION_END : PUBLISH_PRIORITY_ALERT);
+}
+
+static const StateMachineIO firmwareIO = {
+    firmwareNow,
+    readFirmwareInputs,
+    allowFirmwareReset,
+    logFirmware,
+    reportFirmwareState,
+    reportFirmwareTransition,
+    journalSessionMessage,
+    nullptr,
+};
+
+StateMachine stateMachine(firmwareIO, defaultStateMachineConfig);
+
+void setupStateMachine() {
+    // From debugFlags.h (default to not publish debug messages)
+    stateMachineDebugFlag = 0;
+
+    stateMachine.reset();
 }
 
 void initializeStateMachineConsts() {
@@ -94,417 +157,113 @@ void initializeStateMachineConsts() {
     uint16_t initializeHighConfINSThresholdFlag;
     uint16_t initializeOccupancyDetectionINSThresholdFlag;
     uint16_t initializeAlertTimeFlag;
+    uint16_t initializeHeartbeatFormatFlag;
+    uint16_t initializeNoiseCalibrationFlag;
+    StateMachineConfig& config = stateMachine.config();
 
     EEPROM.get(ADDR_INITIALIZE_SM_CONSTS_FLAG, initializeConstsFlag);
     Log.warn("State machine initialization flag read: 0x%04X", initializeConstsFlag);
     if (initializeConstsFlag != INITIALIZATION_FLAG_SET) {
-        EEPROM.put(ADDR_STILLNESS_INS_THRESHOLD, stillness_ins_threshold);
-        EEPROM.put(ADDR_STATE1_INITIAL_TIME, state1_initial_time);
-        EEPROM.put(ADDR_DURATION_ALERT_TIME, duration_alert_time);
-        EEPROM.put(ADDR_STILLNESS_ALERT_TIME, stillness_alert_time);
+        EEPROM.put(ADDR_STILLNESS_INS_THRESHOLD, config.stillness_ins_threshold);
+        EEPROM.put(ADDR_STATE1_INITIAL_TIME, config.state1_initial_time);
+        EEPROM.put(ADDR_DURATION_ALERT_TIME, config.duration_alert_time);
+        EEPROM.put(ADDR_STILLNESS_ALERT_TIME, config.stillness_alert_time);
 
         initializeConstsFlag = INITIALIZATION_FLAG_SET;
         EEPROM.put(ADDR_INITIALIZE_SM_CONSTS_FLAG, initializeConstsFlag);
         Log.warn("State machine constants initialized and written to EEPROM.");
     } else {
-        EEPROM.get(ADDR_STILLNESS_INS_THRESHOLD, stillness_ins_threshold);
-        EEPROM.get(ADDR_STATE1_INITIAL_TIME, state1_initial_time);
-        EEPROM.get(ADDR_DURATION_ALERT_TIME, duration_alert_time);
-        EEPROM.get(ADDR_STILLNESS_ALERT_TIME, stillness_alert_time);
+        EEPROM.get(ADDR_STILLNESS_INS_THRESHOLD, config.stillness_ins_threshold);
+        EEPROM.get(ADDR_STATE1_INITIAL_TIME, config.state1_initial_time);
+        EEPROM.get(ADDR_DURATION_ALERT_TIME, config.duration_alert_time);
+        EEPROM.get(ADDR_STILLNESS_ALERT_TIME, config.stillness_alert_time);
         Log.warn("State machine constants read from EEPROM.");
     }
 
     EEPROM.get(ADDR_INITIALIZE_STATE0_OCCUPANCY_DETECTION_TIME_FLAG, initializeState0OccupantDetectionTimeFlag);
     Log.warn("State 0 Occupancy Detection Time flag read: 0x%04X", initializeState0OccupantDetectionTimeFlag);
     if (initializeState0OccupantDetectionTimeFlag != INITIALIZATION_FLAG_SET) {
-        EEPROM.put(ADDR_STATE0_OCCUPANCY_DETECTION_TIME, state0_occupancy_detection_time);
+        EEPROM.put(ADDR_STATE0_OCCUPANCY_DETECTION_TIME, config.state0_occupancy_detection_time);
 
         initializeState0OccupantDetectionTimeFlag = INITIALIZATION_FLAG_SET;
         EEPROM.put(ADDR_INITIALIZE_STATE0_OCCUPANCY_DETECTION_TIME_FLAG, initializeState0OccupantDetectionTimeFlag);
         Log.warn("State 0 Occupancy Detection Time initialized and written to EEPROM.");
     } else {
-        EEPROM.get(ADDR_STATE0_OCCUPANCY_DETECTION_TIME, state0_occupancy_detection_time);
+        EEPROM.get(ADDR_STATE0_OCCUPANCY_DETECTION_TIME, config.state0_occupancy_detection_time);
         Log.warn("State 0 Occupancy Detection Time read from EEPROM.");
     }
 
     EEPROM.get(ADDR_INITIALIZE_OCCUPANCY_DETECTION_INS_THRESHOLD_FLAG, initializeOccupancyDetectionINSThresholdFlag);
     Log.warn("OccupancyDetectionINSThresholdFlag is 0x%04X", initializeOccupancyDetectionINSThresholdFlag);
     if (initializeOccupancyDetectionINSThresholdFlag != INITIALIZATION_FLAG_SET) {
-        EEPROM.put(ADDR_OCCUPANCY_DETECTION_INS_THRESHOLD, occupancy_detection_ins_threshold);
+        EEPROM.put(ADDR_OCCUPANCY_DETECTION_INS_THRESHOLD, config.occupancy_detection_ins_threshold);
 
         initializeOccupancyDetectionINSThresholdFlag = INITIALIZATION_FLAG_SET;
         EEPROM.put(ADDR_INITIALIZE_OCCUPANCY_DETECTION_INS_THRESHOLD_FLAG, initializeOccupancyDetectionINSThresholdFlag);
         Log.warn("Occupancy Detection INS Threshold initialize written to EEPROM");
     } else {
-        EEPROM.get(ADDR_OCCUPANCY_DETECTION_INS_THRESHOLD, occupancy_detection_ins_threshold);
+        EEPROM.get(ADDR_OCCUPANCY_DETECTION_INS_THRESHOLD, config.occupancy_detection_ins_threshold);
         Log.warn("Occupancy Detection INS Threshold read from EEPROM.");
     }
 
-}
-
-/*
- * Helper Function - calculateTimeSince
- * Calculates elapsed time since the given time.
- * Overflow is handled automatically by unsigned arithmetic.
- */
-unsigned long calculateTimeSince(unsigned long startTime) {
-    return millis() - startTime;
-}
-
-/*
- * Duration Alert Logic:
- * - Can trigger from states 2 and 3
- * - Duration alerts can only trigger if stillness alerts are active as well
- * - First duration alert is triggered when time since door close exceeds the duration alert threshold
- * - Subsequent duration alerts are triggered when time since the last alert exceeds the duration alert threshold
- * - Uses modulo to ensure alerts align with intervals with 1s interval
- */
-void updateDurationAlertStatus() {
-    if (isStillnessAlertActive) {
-        timeSinceDoorClosed = calculateTimeSince(timeWhenDoorClosed);
-        timeSinceLastDurationAlert = (numDurationAlertSent > 0) ? calculateTimeSince(lastDurationAlertTime) : 0;
-         
-        // First duration alert
-        if (numDurationAlertSent == 0) {
-            isDurationAlertThresholdExceeded = (
-                (timeSinceDoorClosed >= duration_alert_time) &&
-                (timeSinceDoorClosed % duration_alert_time < 1000)
-            );
-        }
-        // Subsequent duration alerts
-        else {
-            isDurationAlertThresholdExceeded = (
-                (timeSinceDoorClosed % duration_alert_time < 1000) &&
-                (timeSinceLastDurationAlert >= duration_alert_time - 1000)
-            );
-        }
-    }
-}
+    EEPROM.get(ADDR_INITIALIZE_HEARTBEAT_FORMAT_FLAG, initializeHeartbeatFormatFlag);
+    Log.warn("Heartbeat format flag read: 0x%04X", initializeHeartbeatFormatFlag);
+    if (initializeHeartbeatFormatFlag != INITIALIZATION_FLAG_SET) {
+        EEPROM.put(ADDR_HEARTBEAT_FORMAT, heartbeatFormat);
 
-/*
- * Stillness Alert Logic:
- * - Only triggers in state 3
- * - isStillnessAlertActive must be true
- * - One-time alert when continuous stillness exceeds threshold
- * - When triggered, pauses both duration and stillness alerts
- * - Requires state reset or door open to re-enable
- */
-void updateStillnessAlertStatus() {
-    if (isStillnessAlertActive) {
-        isStillnessAlertThresholdExceeded = timeInState3 >= stillness_alert_time;
+        initializeHeartbeatFormatFlag = INITIALIZATION_FLAG_SET;
+        EEPROM.put(ADDR_INITIALIZE_HEARTBEAT_FORMAT_FLAG, initializeHeartbeatFormatFlag);
+        Log.warn("Heartbeat format initialized and written to EEPROM.");
+    } else {
+        EEPROM.get(ADDR_HEARTBEAT_FORMAT, heartbeatFormat);
+        Log.warn("Heartbeat format read from EEPROM.");
     }
-}
 
-/*
- * State 0 - Idle State
- * This is the normal state of the sensor where:
- * Door is open/closed and we don't see any movement inside the washroom stall.
- */
-void state0_idle() {
-    // Check if device needs to be reset
-    unsigned long timeSinceDoorHeartbeat = calculateTimeSince(doorHeartbeatReceived);
-    if (timeSinceDoorHeartbeat > DEVICE_RESET_THRESHOLD) {
-        System.enableReset();
-    } 
-    else {
-        System.disableReset();
-    }
+    EEPROM.get(ADDR_INITIALIZE_NOISE_CALIBRATION_FLAG, initializeNoiseCalibrationFlag);
+    Log.warn("Noise calibration flag read: 0x%04X", initializeNoiseCalibrationFlag);
+    if (initializeNoiseCalibrationFlag != INITIALIZATION_FLAG_SET) {
+        EEPROM.put(ADDR_NOISE_CALIBRATION, noiseCalibration);
 
-    // Scan inputs
-    doorData checkDoor = checkIM();
-    filteredINSData checkINS = checkINS3331();
-
-    // Reset alert flags
-    isStillnessAlertActive = true;
-    numDurationAlertSent = 0;
-    numStillnessAlertSent = 0;
-    timeSinceLastDurationAlert = 0;
-    isDurationAlertThresholdExceeded = false;
-    isStillnessAlertThresholdExceeded = false;
-
-    // Reset the other variables
-    state1_start_time = 0;
-    state2_start_time = 0;
-    state3_start_time = 0;
-    timeSinceDoorClosed = 0;
-
-    // If the door is closed, calculate the time spent in state 0
-    // State 0 only requires timeWhenDoorClosed
-    if (!isDoorOpen(checkDoor.doorStatus)) {
-        state0_start_time = timeWhenDoorClosed;
-        timeInState0 = calculateTimeSince(state0_start_time);
-    }
-    // If door status is unknown 
-    else if (isDoorStatusUnknown(checkDoor.doorStatus)) {
-        state0_start_time = 0;
-        timeInState0 = 0; 
-    }
-    // If door is open, default to 0
-    else {
-        state0_start_time = 0;
-        timeInState0 = 0;
-    }
-    
-    // Log current state
-    Log.info("State 0 (Idle): Door Status = 0x%02X, INS Magnitude = %f", checkDoor.doorStatus, checkINS.magnitude);
-    publishDebugMessage(0, checkDoor.doorStatus, checkINS.magnitude, timeInState0);
-
-    // Check state transition conditions
-    // Transition to state 1 if:
-    // 1. The door has been closed for less than the occupancy detection time (person has entered and washroom is now occupied).
-    // 2. The INS magnitude indicates movement (using high threshold for hysteresis).
-    // 3. The door is closed.
-    // 4. The door status is known.
-    // 5. State transitions are enabled.
-    if (timeInState0 < state0_occupancy_detection_time &&
-        (checkINS.magnitude > (occupancy_detection_ins_threshold + HYSTERESIS_OFFSET)) &&
-        !isDoorOpen(checkDoor.doorStatus) &&
-        !isDoorStatusUnknown(checkDoor.doorStatus) &&
-        allowTransitionToStateOne) {
-        
-        Log.warn("State 0 --> State 1: Door closed and seeing movement");
-        publishStateTransition(0, 1, checkDoor.doorStatus, checkINS.magnitude);
-
-        // Update state 1 timer and transition to state 1
-        state1_start_time = millis();
-        stateHandler = state1_initial_countdown;
+        initializeNoiseCalibrationFlag = INITIALIZATION_FLAG_SET;
+        EEPROM.put(ADDR_INITIALIZE_NOISE_CALIBRATION_FLAG, initializeNoiseCalibrationFlag);
+        Log.warn("Noise calibration initialized and written to EEPROM.");
+    } else {
+        EEPROM.get(ADDR_NOISE_CALIBRATION, noiseCalibration);
+        Log.warn("Noise calibration read from EEPROM.");
     }
-}
 
-/*
- * State 1 - Initial Countdown State
- * This state is entered when the door is closed and movement is detected.
- * The system countdowns for a short period to confirm occupancy.
- */
-void state1_initial_countdown() {
-    // Disable system reset
-    System.disableReset();
-
-    // Scan inputs
-    doorData checkDoor = checkIM();
-    filteredINSData checkINS = checkINS3331();
-
-    // Calculate the time spent in state 1
-    timeInState1 = calculateTimeSince(state1_start_time);
-
-    // Log current state
-    Log.info("State 1 (Countdown): Door Status = 0x%02X, INS Magnitude = %f", checkDoor.doorStatus, checkINS.magnitude);
-    publishDebugMessage(1, checkDoor.doorStatus, checkINS.magnitude, timeInState1);
-
-    // Check state transition conditions
-    // Transition to state 0 if no movement is detected (using low threshold for hysteresis) OR the door is opened.
-    if (checkINS.magnitude > 0 && checkINS.magnitude < (occupancy_detection_ins_threshold - HYSTERESIS_OFFSET)) {
-        Log.warn("State 1 --> State 0: No movement detected");
-        publishStateTransition(1, 0, checkDoor.doorStatus, checkINS.magnitude);
-        stateHandler = state0_idle;
-    }
-    else if (isDoorOpen(checkDoor.doorStatus)) {
-        Log.warn("State 1 --> State 0: Door opened, session over");
-        publishStateTransition(1, 0, checkDoor.doorStatus, checkINS.magnitude);
-        stateHandler = state0_idle;
-    }
-    // Transition to state 2 if the door remains closed and movement is detected for the maximum allowed time.
-    else if (timeInState1 >= state1_initial_time) {
-        Log.warn("State 1 --> State 2: Movemented detected for max detection time");
-        publishStateTransition(1, 2, checkDoor.doorStatus, checkINS.magnitude);
-
-        // Reset state 2 timer and transition to state 2
-        state2_start_time = millis();
-        allowTransitionToStateOne = false;
-        stateHandler = state2_monitoring;
-    }
 }
 
-/*
- * State 2 - Monitoring State
- * This state is entered when the door is closed and movement is detected for a confirmed period.
- * The system monitors the duration of occupancy and stillness.
- * Sends a duration alert if the not sent before and duration exceeds a threshold.
- */
-void state2_monitoring() {
-    // Scan inputs
-    doorData checkDoor = checkIM();
-    filteredINSData checkINS = checkINS3331();
-
-    // Calculate timing data
-    timeInState2 = calculateTimeSince(state2_start_time);
-
-    // Update the alert status
-    updateDurationAlertStatus(); 
-
-    // Log current state
-    Log.info("State 2 (Monitoring): Door Status = 0x%02X, INS Magnitude = %f", checkDoor.doorStatus, checkINS.magnitude);
-    publishDebugMessage(2, checkDoor.doorStatus, checkINS.magnitude, timeInState2);
-
-    // Check state transition conditions
-    // Transition to state 0 if the door is opened
-    if (isDoorOpen(checkDoor.doorStatus)) {
-        Log.warn("State 2 --> State 0: Door opened, session over");
-        publishStateTransition(2, 0, checkDoor.doorStatus, checkINS.magnitude);
-
-        // Publish door opened message to particle 
-        unsigned long occupancy_duration = timeSinceDoorClosed / 60000;
-        char doorOpenedMessage[PARTICLE_MAX_MESSAGE_LENGTH];
-        snprintf(doorOpenedMessage, sizeof(doorOpenedMessage), 
-                "{\"alertSentFromState\": %d, \"numDurationAlertsSent\": %lu, \"numStillnessAlertsSent\": %lu, \"occupancyDuration\": %lu}",
-                2, numDurationAlertSent, numStillnessAlertSent, occupancy_duration);
-        Particle.publish("Door Opened", doorOpenedMessage, PRIVATE);
-
-        // Transition to state 0
-        stateHandler = state0_idle;
-    }
-    // A new door close event while in State 2 means the door opened and closed
-    // without us seeing the open. Reset to State 0 to end the session.
-    else if (allowTransitionToStateOne) {
-        Log.warn("State 2 --> State 0: Door close event detected, missed door open");
-        publishStateTransition(2, 0, checkDoor.doorStatus, checkINS.magnitude);
-
-        unsigned long occupancy_duration = timeSinceDoorClosed / 60000;
-        char doorOpenedMessage[PARTICLE_MAX_MESSAGE_LENGTH];
-        snprintf(doorOpenedMessage, sizeof(doorOpenedMessage),
-                "{\"alertSentFromState\": %d, \"numDurationAlertsSent\": %lu, \"numStillnessAlertsSent\": %lu, \"occupancyDuration\": %lu, \"missedDoorReset\": true}",
-                2, numDurationAlertSent, numStillnessAlertSent, occupancy_duration);
-        Particle.publish("Door Opened", doorOpenedMessage, PRIVATE);
-
-        stateHandler = state0_idle;
-    }
-    // Transition to state 3 if stillness is detected (using low threshold for hysteresis)
-    else if (checkINS.magnitude > 0 && checkINS.magnitude < (stillness_ins_threshold - HYSTERESIS_OFFSET)) {
-        Log.warn("State 2 --> State 3: Stillness detected");
-        publishStateTransition(2, 3, checkDoor.doorStatus, checkINS.magnitude);
-
-        // Reset the state 3 timer and transition to state 3
-        state3_start_time = millis();
-        stateHandler = state3_stillness;
-    }
-    // Send duration alert if threshold is exceeded
-    else if (isStillnessAlertActive && isDurationAlertThresholdExceeded) {
-        Log.warn("--Duration Alert-- TimeSinceDoorClosed: %lu, TimeSinceLastDurationAlert: %lu, TimeInState: %lu", timeSinceDoorClosed, timeSinceLastDurationAlert, timeInState2);
-
-        // Update the duration alert counter and time
-        numDurationAlertSent += 1;
-        lastDurationAlertTime = millis();
-
-        // Publish duration alert to particle
-        unsigned long occupancy_duration = timeSinceDoorClosed / 60000;
-        char alertMessage[PARTICLE_MAX_MESSAGE_LENGTH];
-        snprintf(alertMessage, sizeof(alertMessage),
-                 "{\"alertSentFromState\": %d, \"numDurationAlertsSent\": %lu, \"numStillnessAlertsSent\": %lu, \"occupancyDuration\": %lu}",
-                 2, numDurationAlertSent, numStillnessAlertSent, occupancy_duration);
-        Particle.publish("Duration Alert", alertMessage, PRIVATE);
-    }
+void stateMachineTick() {
+    stateMachine.tick();
 }
 
-/*
- * State 3 - Stillness State
- * This state is entered when the door is closed and stillness is detected.
- * The system monitors the stillness duration.
- * Sends a stillness alert if the stillness duration exceeds a threshold.
- */
-void state3_stillness() {
-    // Scan inputs
-    doorData checkDoor = checkIM();
-    filteredINSData checkINS = checkINS3331();
-  
-    // Calculate timing data
-    timeInState3 = calculateTimeSince(state3_start_time);
-
-    // Update alert statuses
-    updateDurationAlertStatus(); 
-    updateStillnessAlertStatus();
-    
-    Log.info("State 3 (Stillness): Door Status = 0x%02X, INS Magnitude = %f", checkDoor.doorStatus, checkINS.magnitude);
-    publishDebugMessage(3, checkDoor.doorStatus, checkINS.magnitude, timeInState3);
-
-    // Check state transition conditions  
-    // Transition to state 0 if the door is opened
-    if (isDoorOpen(checkDoor.doorStatus)) {
-        Log.warn("State 3 --> State 0: Door opened, session over");
-        publishStateTransition(3, 0, checkDoor.doorStatus, checkINS.magnitude);
-
-        // Publish door opened message to particle
-        unsigned long occupancy_duration = timeSinceDoorClosed / 60000;
-        char doorOpenedMessage[PARTICLE_MAX_MESSAGE_LENGTH];
-        snprintf(doorOpenedMessage, sizeof(doorOpenedMessage), 
-                "{\"alertSentFromState\": %d, \"numDurationAlertsSent\": %lu, \"numStillnessAlertsSent\": %lu, \"occupancyDuration\": %lu}",
-                3, numDurationAlertSent, numStillnessAlertSent, occupancy_duration);
-        Particle.publish("Door Opened", doorOpenedMessage, PRIVATE);
-
-        // Transition to state 0
-        stateHandler = state0_idle;
-    } 
-    // A new door close event while in State 3 means the door opened and closed
-    // without us seeing the open. Reset to State 0 to end the session.
-    else if (allowTransitionToStateOne) {
-        Log.warn("State 3 --> State 0: Door close event detected, missed door open");
-        publishStateTransition(3, 0, checkDoor.doorStatus, checkINS.magnitude);
-
-        unsigned long occupancy_duration = timeSinceDoorClosed / 60000;
-        char doorOpenedMessage[PARTICLE_MAX_MESSAGE_LENGTH];
-        snprintf(doorOpenedMessage, sizeof(doorOpenedMessage),
-                "{\"alertSentFromState\": %d, \"numDurationAlertsSent\": %lu, \"numStillnessAlertsSent\": %lu, \"occupancyDuration\": %lu, \"missedDoorReset\": true}",
-                3, numDurationAlertSent, numStillnessAlertSent, occupancy_duration);
-        Particle.publish("Door Opened", doorOpenedMessage, PRIVATE);
-
-        stateHandler = state0_idle;
-    }
-    // Transition to state 2 if movement exceeds the stillness threshold (using high threshold for hysteresis)
-    else if (checkINS.magnitude > (stillness_ins_threshold + HYSTERESIS_OFFSET)) {
-        Log.warn("State 3 --> State 2: Motion detected again.");
-        publishStateTransition(3, 2, checkDoor.doorStatus, checkINS.magnitude);
-
-        // Reset the state 2 timer and transition to state 2
-        state2_start_time = millis();
-        stateHandler = state2_monitoring;
-    }
-    // Duration alert condition based on time elapsed since door closed or last alert
-    else if (isStillnessAlertActive && isDurationAlertThresholdExceeded) {
-        Log.warn("--Duration Alert-- TimeSinceDoorClosed: %lu, TimeSinceLastAlert: %lu, TimeInState: %lu", timeSinceDoorClosed, timeSinceLastDurationAlert, timeInState3);
-
-        // Update the duration alert counter and time
-        numDurationAlertSent += 1;
-        lastDurationAlertTime = millis();
-
-        // Publish duration alert to particle
-        unsigned long occupancy_duration = timeSinceDoorClosed / 60000;
-        char alertMessage[PARTICLE_MAX_MESSAGE_LENGTH];
-        snprintf(alertMessage, sizeof(alertMessage),
-                    "{\"alertSentFromState\": %d, \"numDurationAlertsSent\": %lu, \"numStillnessAlertsSent\": %lu, \"occupancyDuration\": %lu}",
-                    3, numDurationAlertSent, numStillnessAlertSent, occupancy_duration);
-        Particle.publish("Duration Alert", alertMessage, PRIVATE);
-    }
-    // Stillness alert condition based on time elapsed since entering state 3
-    else if (isStillnessAlertActive && isStillnessAlertThresholdExceeded) {
-        Log.warn("--Stillness Alert-- TimeSinceDoorClosed: %lu, TimeInState: %lu", timeSinceDoorClosed, timeInState3);
-
-        // Update the stillness alert counter
-        numStillnessAlertSent += 1;
-
-        // Turning off this flag will pause both duration and stillness alerts
-        isStillnessAlertActive = false;
-
-        // Publish stillness alert to particle
-        unsigned long occupancy_duration = timeSinceDoorClosed / 60000; // Convert to minutes
-        char alertMessage[PARTICLE_MAX_MESSAGE_LENGTH];
-        snprintf(alertMessage, sizeof(alertMessage), 
-                 "{\"alertSentFromState\": %d, \"numDurationAlertsSent\": %lu, \"numStillnessAlertsSent\": %lu, \"occupancyDuration\": %lu}", 
-                 3, numDurationAlertSent, numStillnessAlertSent, occupancy_duration);
-        Particle.publish("Stillness Alert", alertMessage, PRIVATE);
-    }
-}
+// The debug publishes send every value as a string, as the dashboards expect
+static constexpr JsonField stateTransitionFields[] = {
+    {"prev_state", JSON_INT, JSON_QUOTED},
+    {"next_state", JSON_INT, JSON_QUOTED},
+    {"door_status", JSON_HEX8_0X},
+    {"INS_val", JSON_FIXED, JSON_QUOTED, 6},
+};
+
+static constexpr JsonField debugMessageFields[] = {
+    {"state", JSON_INT, JSON_QUOTED},
+    {"door_status", JSON_HEX8_0X},
+    {"time_in_curr_state", JSON_UINT, JSON_QUOTED},
+    {"INS_val", JSON_FIXED, JSON_QUOTED, 6},
+    {"occupancy_detection_INS", JSON_UINT, JSON_QUOTED},
+    {"stillness_INS", JSON_UINT, JSON_QUOTED},
+    {"occupancy_detection_timer", JSON_UINT, JSON_QUOTED},
+    {"initial_timer", JSON_UINT, JSON_QUOTED},
+    {"duration_alert_time", JSON_UINT, JSON_QUOTED},
+    {"stillness_alert_time", JSON_UINT, JSON_QUOTED},
+};
 
 void publishStateTransition(int prevState, int nextState, unsigned char doorStatus, float INSValue) {
     if (stateMachineDebugFlag) {
-        char stateTransition[PARTICLE_MAX_MESSAGE_LENGTH];
-        snprintf(stateTransition, sizeof(stateTransition),
-                 "{"
-                    "\"prev_state\":\"%d\", "
-                    "\"next_state\":\"%d\", "
-                    "\"door_status\":\"0x%02X\", "
-                    "\"INS_val\":\"%f\" "
-                 "}",
-                prevState, nextState, doorStatus, INSValue);
-        Particle.publish("State Transition", stateTransition, PRIVATE);
+        char stateTransition[jsonMaxLength(stateTransitionFields) + 1];
+        writeJson<stateTransitionFields>(stateTransition, prevState, nextState, doorStatus, INSValue);
+        queuePublish("State Transition", stateTransition, PUBLISH_PRIORITY_DEBUG);
     }
 }
 
@@ -514,119 +273,196 @@ void publishDebugMessage(int state, unsigned char doorStatus, float INSValue, un
             stateMachineDebugFlag = false;
         }
         else if (calculateTimeSince(lastDebugPublish) > DEBUG_PUBLISH_INTERVAL) {
-            char debugMessage[PARTICLE_MAX_MESSAGE_LENGTH];
-            snprintf(debugMessage, sizeof(debugMessage),
-                     "{"
-                        "\"state\":\"%d\", "
-                        "\"door_status\":\"0x%02X\", "
-                        "\"time_in_curr_state\":\"%lu\", "
-                        "\"INS_val\":\"%f\", "
-                        "\"occupancy_detection_INS\":\"%lu\", "
-                        "\"stillness_INS\":\"%lu\", "
-                        "\"occupancy_detection_timer\":\"%lu\", "
-                        "\"initial_timer\":\"%lu\", "
-                        "\"duration_alert_time\":\"%lu\", "
-                        "\"stillness_alert_time\":\"%lu\" "
-                     "}",
-                     state, doorStatus, state_timer, INSValue, occupancy_detection_ins_threshold, stillness_ins_threshold,
-                     state0_occupancy_detection_time, state1_initial_time, 
-                     duration_alert_time, stillness_alert_time);
-            Particle.publish("Debug Message", debugMessage, PRIVATE);
-            lastDebugPublish = millis();
+            const StateMachineConfig& config = stateMachine.config();
+            char debugMessage[jsonMaxLength(debugMessageFields) + 1];
+            writeJson<debugMessageFields>(debugMessage, state, doorStatus, state_timer, INSValue, config.occupancy_detection_ins_threshold,
+                                          config.stillness_ins_threshold, config.state0_occupancy_detection_time, config.state1_initial_time,
+                                          config.duration_alert_time, config.stillness_alert_time);
+            queuePublish("Debug Message", debugMessage, PUBLISH_PRIORITY_DEBUG);
+            lastDebugPublish = clockMillis();
         }
     }
 }
 
-const char *resetReasonString(int resetReason) {
-    switch (resetReason) {
-        case RESET_REASON_PIN_RESET:
-            return "PIN_RESET";
-        case RESET_REASON_POWER_MANAGEMENT:
-            return "POWER_MANAGEMENT";
-        case RESET_REASON_POWER_DOWN:
-            return "POWER_DOWN";
-        case RESET_REASON_POWER_BROWNOUT:
-            return "POWER_BROWNOUT";
-        case RESET_REASON_WATCHDOG:
-            return "WATCHDOG";
-        case RESET_REASON_UPDATE:
-            return "UPDATE";
-        case RESET_REASON_UPDATE_TIMEOUT:
-            return "UPDATE_TIMEOUT";
-        case RESET_REASON_FACTORY_RESET:
-            return "FACTORY_RESET";
-        case RESET_REASON_DFU_MODE:
-            return "DFU_MODE";
-        case RESET_REASON_PANIC:
-            return "PANIC";
-        case RESET_REASON_USER:
-            return "USER";
-        case RESET_REASON_UNKNOWN:
-            return "UNKNOWN";
-        default:
-            return "NONE";
+// Heartbeat publish state, shared with onHeartbeatPublished()
+static unsigned long lastHeartbeatPublish = 0;
+static unsigned int didMissQueueSum = 0;
+static std::queue<bool> didMissQueue;
+static bool hasPendingHeartbeat = false;
+static bool isRetryingHeartbeat = false;
+static int pendingMissedDoorEventCount = 0;
+static bool pendingDidMiss = false;
+
+// Windows taken for the pending heartbeat. They are cleared once it is published, or merged
+// into the next heartbeat if it is given up, so telemetry is never lost to an eviction.
+static InsReaderWindow pendingReaderWindow = {};
+static LatencyHistogram pendingLatency[LATENCY_STAGE_COUNT] = {};
+static SpscRingWindow pendingInsQueue = {};
+static SpscRingWindow pendingBleQueue = {};
+static InsHistogram pendingInsHistogram[INS_OCCUPANCY_COUNT] = {};
+
+// A heartbeat the publish queue rejected or evicted is built again once
+// SM_HEARTBEAT_RETRY_INTERVAL has passed, and not before. The queue is full of alerts at
+// that point, so building one on every pass would only be rejected again.
+static void retryHeartbeatLater() {
+    isRetryingHeartbeat = true;
+    armDeadline(DEADLINE_HEARTBEAT, clockMillis() + SM_HEARTBEAT_RETRY_INTERVAL);
+}
+
+// Called from servicePublishQueue() once the queued heartbeat is resolved
+static void onHeartbeatPublished(bool succeeded, void* context) {
+    hasPendingHeartbeat = false;
+
+    // A heartbeat is only given up if it was evicted by alerts. The missed door counts are
+    // only subtracted below, and the pending windows are kept, so the retry sends them
+    // again along with whatever came after.
+    if (!succeeded) {
+        retryHeartbeatLater();
+        return;
+    }
+    isRetryingHeartbeat = false;
+
+    pendingReaderWindow = {};
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        pendingLatency[stage] = {};
+    }
+    pendingInsQueue = {};
+    pendingBleQueue = {};
+    for (int occupancy = 0; occupancy < INS_OCCUPANCY_COUNT; occupancy++) {
+        pendingInsHistogram[occupancy] = {};
     }
+
+    // Advance timer and clear flags only after a confirmed publish
+    lastHeartbeatPublish = clockMillis();
+    armDeadline(DEADLINE_HEARTBEAT, lastHeartbeatPublish + SM_HEARTBEAT_INTERVAL);
+    doorMessageReceivedFlag = false;
+
+    // Reset reason is only logged once after startup
+    resetReason = RESET_REASON_NONE;
+
+    // Subtract only what was captured; any misses that arrived during a retry are
+    // preserved for the next heartbeat
+    missedDoorEventCount -= pendingMissedDoorEventCount;
+
+    // Update the missed door events queue
+    if (didMissQueue.size() > SM_HEARTBEAT_DID_MISS_QUEUE_SIZE) {
+        if (didMissQueue.front()) didMissQueueSum--;
+        didMissQueue.pop();
+    }
+    didMissQueueSum += (int)pendingDidMiss;
+    didMissQueue.push(pendingDidMiss);
+}
+
+// Applies the thresholds the noise floor suggests, only in state 0 so a session is judged
+// by the thresholds it started with
+static void applyNoiseFloorThresholds(const NoiseFloorSuggestion& suggestion) {
+    StateMachineConfig& config = stateMachine.config();
+    if (suggestion.stillnessThreshold == 0 || stateMachine.currentState() != STATE_IDLE ||
+        (config.stillness_ins_threshold == suggestion.stillnessThreshold && config.occupancy_detection_ins_threshold == suggestion.occupancyThreshold)) {
+        return;
+    }
+
+    Log.warn("Noise floor p99 %.1f from %lu values, INS thresholds: stillness %lu to %lu, occupancy detection %lu to %lu", suggestion.p99,
+             (unsigned long)suggestion.sampleCount, config.stillness_ins_threshold, (unsigned long)suggestion.stillnessThreshold,
+             config.occupancy_detection_ins_threshold, (unsigned long)suggestion.occupancyThreshold);
+    config.stillness_ins_threshold = suggestion.stillnessThreshold;
+    config.occupancy_detection_ins_threshold = suggestion.occupancyThreshold;
+    EEPROM.put(ADDR_STILLNESS_INS_THRESHOLD, config.stillness_ins_threshold);
+    EEPROM.put(ADDR_OCCUPANCY_DETECTION_INS_THRESHOLD, config.occupancy_detection_ins_threshold);
+}
+
+// High water mark and mean occupancy in thousandths of the capacity
+static HeartbeatQueue heartbeatQueue(const SpscRingWindow& window, uint32_t capacity) {
+    HeartbeatQueue queue;
+    queue.overflows = window.overflows;
+    queue.highWaterMark = (uint16_t)window.highWaterMark;
+    queue.meanOccupancy = (window.pushes > 0) ? (uint16_t)((uint64_t)window.occupancySum * 1000 / ((uint64_t)window.pushes * capacity)) : 0;
+    return queue;
 }
 
 void getHeartbeat() {
-    static unsigned long lastHeartbeatPublish = 0;
-    static unsigned int didMissQueueSum = 0;
-    static std::queue<bool> didMissQueue;
-    static char pendingHeartbeat[PARTICLE_MAX_MESSAGE_LENGTH] = {0};
-    static bool hasPendingHeartbeat = false;
-    static int pendingMissedDoorEventCount = 0;
-    static bool pendingDidMiss = false;
-
-    // Async publish state. The publish result is held in a Future, NOT a bool:
-    // testing a bool return from Particle.publish() blocks this (application)
-    // thread until the publish resolves, which would freeze stateHandler() and
-    // stop checkIM() from draining the BLE queue while the scanner thread keeps
-    // filling it. Instead we kick the publish off and poll the Future across
-    // loop iterations, so the loop keeps running at full speed.
-    static particle::Future<bool> publishFuture;
-    static bool publishInFlight = false;
-    static unsigned long publishStartedAt = 0;
-
-    // Build a new heartbeat message only when there is no pending retry.
+    PROFILE_SCOPE(PROFILE_HEARTBEAT);
+
+    // Build a new heartbeat message only when the last one has been resolved. The publish
+    // queue retries it until it goes through, see publishQueue.h.
     // Conditions to build:
     // 1. This is the first heartbeat since startup.
     // 2. A door message was received and enough time has passed since the last "door" heartbeat.
     //    The delay (HEARTBEAT_PUBLISH_DELAY) is to restrict the door heartbeat publish to 1 instead of 3 because the door broadcasts 3 messages.
     //    The doorMessageReceivedFlag is set to true when any IM Door Sensor message is received, but only after a certain threshold (see checkIM function)
-    // 3. The heartbeat hasn't been published in the last SM_HEARTBEAT_INTERVAL.
-    if (!hasPendingHeartbeat && (
-        lastHeartbeatPublish == 0 ||
-        (doorMessageReceivedFlag && (calculateTimeSince(doorHeartbeatReceived) >= HEARTBEAT_PUBLISH_DELAY)) ||
-        (calculateTimeSince(lastHeartbeatPublish) > SM_HEARTBEAT_INTERVAL))) {
-
-        memset(pendingHeartbeat, 0, sizeof(pendingHeartbeat));
-        JSONBufferWriter writer(pendingHeartbeat, sizeof(pendingHeartbeat) - 1);
-        writer.beginObject();
-
-        // Log the time since the last door message, battery status, and tamper status
-        // if a door message has been received, otherwise default to -1
-        if (doorLastMessage == 0) {
-            writer.name("doorLastMessage").value(-1);
-            writer.name("doorLowBattery").value(-1);
-            writer.name("doorTampered").value(-1);
-        } else {
-            writer.name("doorLastMessage").value((unsigned int)calculateTimeSince(doorLastMessage));
-            writer.name("doorLowBattery").value(doorLowBatteryFlag);
-            writer.name("doorTampered").value(doorTamperedFlag);
+    // 3. The heartbeat deadline, SM_HEARTBEAT_INTERVAL after the last one, has passed.
+    // While a rejected or evicted heartbeat waits to be retried, only the deadline counts.
+    bool isDue = isDeadlineFired(DEADLINE_HEARTBEAT) ||
+                 (!isRetryingHeartbeat &&
+                  (lastHeartbeatPublish == 0 || (doorMessageReceivedFlag && (calculateTimeSince(doorHeartbeatReceived) >= HEARTBEAT_PUBLISH_DELAY))));
+    if (!hasPendingHeartbeat && isDue) {
+
+        HeartbeatRecord record;
+
+        // The time since the last door message, battery status, and tamper status are
+        // only sent once a door message has been received
+        record.doorHeard = (doorLastMessage != 0);
+        record.doorLastMessage = record.doorHeard ? calculateTimeSince(doorLastMessage) : 0;
+        record.doorLowBattery = record.doorHeard && doorLowBatteryFlag;
+        record.doorTampered = record.doorHeard && doorTamperedFlag;
+
+        // If a previous heartbeat has been published, then log if the INS is zero. Reading
+        // the snapshot leaves the filter alone, so this costs the state machine no samples.
+        filteredINSData checkINS = readINSSnapshot();
+        bool isINSZero = (checkINS.magnitude < 0.0001);
+        record.isINSZero = isINSZero && lastHeartbeatPublish > 0;
+        record.insMagnitude = checkINS.magnitude;
+
+        // Share of CPU time the radar reader thread used since the last heartbeat, in 1/1000
+        InsReaderWindow readerWindow = takeINSReaderWindow();
+        pendingReaderWindow.busyMicros += readerWindow.busyMicros;
+        pendingReaderWindow.elapsedMillis += readerWindow.elapsedMillis;
+        record.insReaderLoad = (pendingReaderWindow.elapsedMillis > 0)
+                                   ? (uint16_t)(pendingReaderWindow.busyMicros / pendingReaderWindow.elapsedMillis)
+                                   : 0;
+
+        // Alert path latencies since the last heartbeat, per stage [count, p50, p99, max] in ms
+        for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+            mergeLatencyHistogram(pendingLatency[stage], takeLatencyHistogram((LatencyStage)stage));
+            const LatencyHistogram& histogram = pendingLatency[stage];
+            record.latency[stage].count = histogram.count;
+            record.latency[stage].p50 = latencyPercentile(histogram, 50);
+            record.latency[stage].p99 = latencyPercentile(histogram, 99);
+            record.latency[stage].max = histogram.max;
         }
 
-        // If a previous heartbeat has been published, then log if the INS is zero
-        filteredINSData checkINS = checkINS3331();
-        bool isINSZero = (checkINS.magnitude < 0.0001);
-        writer.name("isINSZero").value(isINSZero && lastHeartbeatPublish > 0);
+        // Radar frames and door events the reader threads queued since the last heartbeat
+        mergeSpscRingWindow(pendingInsQueue, takeINSQueueWindow());
+        mergeSpscRingWindow(pendingBleQueue, takeBLEQueueWindow());
+        record.insQueue = heartbeatQueue(pendingInsQueue, INS_QUEUE_SIZE);
+        record.bleQueue = heartbeatQueue(pendingBleQueue, BLE_QUEUE_SIZE);
+
+        // Radar frames since boot, compact heartbeats only
+        InsFrameParserStats parserStats = getINSFrameParserStats();
+        record.insFramesParsed = parserStats.framesParsed;
+        record.insChecksumErrors = parserStats.checksumErrors;
+        record.insFramingErrors = parserStats.framingErrors;
+        record.insBytesDiscarded = parserStats.bytesDiscarded;
+
+        // INS magnitudes per occupancy since the last heartbeat, compact heartbeats only
+        for (int occupancy = 0; occupancy < INS_OCCUPANCY_COUNT; occupancy++) {
+            mergeInsHistogram(pendingInsHistogram[occupancy], takeInsHistogram((InsOccupancy)occupancy));
+            record.insHistogram[occupancy] = snapshotInsHistogram(pendingInsHistogram[occupancy]);
+        }
+
+        // Empty washroom noise since startup and the thresholds it suggests
+        record.noiseFloor = suggestNoiseFloorThresholds();
+        if (noiseCalibration == NOISE_CALIBRATION_ON) {
+            applyNoiseFloorThresholds(record.noiseFloor);
+        }
 
         // Add consecutive open door heartbeat count
-        writer.name("consecutiveOpenDoorHeartbeatCount").value(consecutiveOpenDoorHeartbeatCount);
+        record.consecutiveOpenDoorHeartbeatCount = consecutiveOpenDoorHeartbeatCount;
 
         // Snapshot missed door event count — do not reset yet; reset only after confirmed publish
         pendingMissedDoorEventCount = missedDoorEventCount;
         pendingDidMiss = pendingMissedDoorEventCount > 0;
-        writer.name("doorMissedCount").value(pendingMissedDoorEventCount);
+        record.doorMissedCount = pendingMissedDoorEventCount;
 
         // Preview what the queue sum will be after this heartbeat is confirmed, so that
         // doorMissedFrequently reflects the current heartbeat (matching original behaviour)
@@ -635,59 +471,27 @@ void getHeartbeat() {
             if (didMissQueue.front()) previewSum--;
         }
         previewSum += (int)pendingDidMiss;
-        writer.name("doorMissedFrequently").value(previewSum > SM_HEARTBEAT_DID_MISS_THRESHOLD);
+        record.doorMissedFrequently = previewSum > SM_HEARTBEAT_DID_MISS_THRESHOLD;
 
         // Log the reason for the last reset
-        writer.name("resetReason").value(resetReasonString(resetReason));
+        record.resetReason = (uint16_t)resetReason;
 
-        writer.endObject();
-        hasPendingHeartbeat = true;
-    }
-
-    // Resolve an in-flight publish without blocking.
-    if (publishInFlight) {
-        if (publishFuture.isDone()) {
-            if (publishFuture.isSucceeded()) {
-                // Advance timer and clear flags only after a confirmed publish
-                lastHeartbeatPublish = millis();
-                doorMessageReceivedFlag = false;
-
-                // Reset reason is only logged once after startup
-                resetReason = RESET_REASON_NONE;
-
-                // Subtract only what was captured; any misses that arrived during a retry are
-                // preserved for the next heartbeat
-                missedDoorEventCount -= pendingMissedDoorEventCount;
-
-                // Update the missed door events queue
-                if (didMissQueue.size() > SM_HEARTBEAT_DID_MISS_QUEUE_SIZE) {
-                    if (didMissQueue.front()) didMissQueueSum--;
-                    didMissQueue.pop();
-                }
-                didMissQueueSum += (int)pendingDidMiss;
-                didMissQueue.push(pendingDidMiss);
-
-                hasPendingHeartbeat = false;
+        char heartbeatMessage[PARTICLE_MAX_MESSAGE_LENGTH + 1];
+        if (heartbeatFormat == HEARTBEAT_FORMAT_COMPACT) {
+            encodeCompactHeartbeat(record, heartbeatMessage, sizeof(heartbeatMessage));
+        }
+        else {
+            JsonWriter writer(heartbeatMessage, sizeof(heartbeatMessage));
+            writeHeartbeatJson(record, writer);
+            if (writer.overflowed()) {
+                Log.error("Heartbeat cut short at %u bytes", (unsigned int)writer.length());
             }
-            // On failure hasPendingHeartbeat stays true, so the message is retried below.
-            publishInFlight = false;
-        } else if (calculateTimeSince(publishStartedAt) > HEARTBEAT_PUBLISH_TIMEOUT) {
-            // Defensive: a Future that never resolves would wedge every future
-            // heartbeat. Abandon it and let the retry path start a fresh publish.
-            Log.warn("Heartbeat publish timed out; will retry");
-            publishInFlight = false;
         }
-    }
 
-    // Start (or retry) a publish attempt when one is needed and we are connected.
-    // Kicking off the publish and storing the Future does NOT block; the result
-    // is collected above on a later loop iteration. The retry-interval guard
-    // spaces attempts out so a fast-failing publish cannot hit the rate limit.
-    if (hasPendingHeartbeat && !publishInFlight && Particle.connected() &&
-        calculateTimeSince(publishStartedAt) >= HEARTBEAT_PUBLISH_RETRY_INTERVAL) {
-        Log.warn(pendingHeartbeat);
-        publishFuture = Particle.publish("Heartbeat", pendingHeartbeat, PRIVATE);
-        publishInFlight = true;
-        publishStartedAt = millis();
+        Log.warn("%s", heartbeatMessage);
+        hasPendingHeartbeat = queuePublish("Heartbeat", heartbeatMessage, PUBLISH_PRIORITY_HEARTBEAT, onHeartbeatPublished);
+        if (!hasPendingHeartbeat) {
+            retryHeartbeatLater();
+        }
     }
-}
\ No newline at end of file
+}
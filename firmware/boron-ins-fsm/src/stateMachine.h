@@ -8,42 +8,26 @@
 #ifndef STATEMACHINE_H
 #define STATEMACHINE_H
 
+#include "stateMachineCore.h"
+
 // ***************************** Macro defintions *****************************
 
 // This flag determines if the state machine constants are set
 #define INITIALIZATION_FLAG_SET             0x8888
 #define INITIALIZATION_FLAG_HIGH_CONF       0x9999
 
-// Initial values for state machine, can be changed via console function
-#define STILLNESS_INS_THRESHOLD             20
-#define OCCUPANCY_DETECTION_INS_THRESHOLD   60
-
-// Hysteresis offset: thresholds become base ± this value
-#define HYSTERESIS_OFFSET                   2
-
-#define STATE0_OCCUPANCY_DETECTION_TIME     30000       // 30 secs
-#define STATE1_INITIAL_TIME                 3000        // 3 secs
-
-#define DURATION_ALERT_TIME                 1200000     // 20 mins          
-#define STILLNESS_ALERT_TIME                180000      // 3 mins
-
 // Minimize time between restart and first Heartbeat message
 #define DEVICE_RESET_THRESHOLD              540000      // 9 mins
 
 // Heartbeat message intervals and thresholds
 #define SM_HEARTBEAT_INTERVAL               660000      // 11 mins
+#define SM_HEARTBEAT_RETRY_INTERVAL         60000       // 1 min after the publish queue rejected or evicted one
 #define SM_HEARTBEAT_DID_MISS_QUEUE_SIZE    3           // Track last 3 heartbeats
 #define SM_HEARTBEAT_DID_MISS_THRESHOLD     1           // Threshold for missed heartbeats
 
-// Minimum spacing between heartbeat publish attempts, so a fast-failing publish
-// while connected cannot spin and exhaust the cloud publish rate limit (1/sec)
-#define HEARTBEAT_PUBLISH_RETRY_INTERVAL    2000        // 2 sec
-
-// Defensive upper bound on waiting for an in-flight async publish to resolve.
-// Device OS normally resolves the publish Future well within this window; this
-// only guards against a Future that never completes, which would otherwise
-// wedge every future heartbeat.
-#define HEARTBEAT_PUBLISH_TIMEOUT           30000       // 30 sec
+// Noise_Calibration values, see noiseFloor.h
+#define NOISE_CALIBRATION_OFF               0
+#define NOISE_CALIBRATION_ON                1
 
 // The IM door sensor always broadcasts 3 of the same messages
 // This delay restrict SM heartbeat to being published once from 3 IM Door Sensor broadcasts
@@ -51,49 +35,15 @@
 
 // ***************************** Global variables *****************************
 
-// Function pointer type for state handlers
-typedef void (*StateHandler)();
-
-// Extern declaration of the state handler pointer
-extern StateHandler stateHandler;
+// The firmware's state machine, reading the door sensor and radar and journalling its
+// alerts. Console functions change its config in place.
+extern StateMachine stateMachine;
 
-// State machine constants firmware code definition
-extern unsigned long stillness_ins_threshold;
-extern unsigned long occupancy_detection_ins_threshold;
+// HEARTBEAT_FORMAT_JSON or HEARTBEAT_FORMAT_COMPACT, kept in EEPROM
+extern uint16_t heartbeatFormat;
 
-extern unsigned long state0_occupancy_detection_time;
-extern unsigned long state1_initial_time;
-extern unsigned long duration_alert_time;
-extern unsigned long stillness_alert_time;
-
-// Start timers for different states
-extern unsigned long state0_start_time;
-extern unsigned long state1_start_time;
-extern unsigned long state2_start_time;
-extern unsigned long state3_start_time;
-
-// Time spent in different states
-extern unsigned long timeInState0;
-extern unsigned long timeInState1;
-extern unsigned long timeInState2;
-extern unsigned long timeInState3;
-
-// Time since the door was closed
-extern unsigned long timeSinceDoorClosed;
-
-// Duration alert variables
-extern unsigned long numDurationAlertSent;
-extern unsigned long lastDurationAlertTime;
-extern unsigned long timeSinceLastDurationAlert;
-extern bool isDurationAlertThresholdExceeded;
-
-// Stillness alert variables
-extern unsigned long numStillnessAlertSent;
-extern bool isStillnessAlertActive;
-extern bool isStillnessAlertThresholdExceeded;
-
-// Allow state transitions
-extern bool allowTransitionToStateOne;
+// NOISE_CALIBRATION_ON to apply the thresholds the noise floor suggests, kept in EEPROM
+extern uint16_t noiseCalibration;
 
 // ************************** Function declarations **************************
 
@@ -102,14 +52,9 @@ void setupStateMachine();
 
 // loop() functions
 void initializeStateMachineConsts();
+void stateMachineTick();
 void getHeartbeat();
 
-// state functions, called by stateHandler
-void state0_idle();
-void state1_initial_countdown();
-void state2_monitoring();
-void state3_stillness();
-
 void publishDebugMessage(int, unsigned char, float, unsigned long);
 void publishStateTransition(int, int, unsigned char, float);
 
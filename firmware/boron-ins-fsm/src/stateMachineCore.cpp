@@ -0,0 +1,654 @@
+/* stateMachineCore.cpp - Washroom occupancy state machine, one instance per sensor
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#include "stateMachineCore.h"
+#include "jsonWriter.h"
+#include "profiler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// The state handlers are profiled at PROFILE_STATE_IDLE + StateId
+static_assert(PROFILE_STATE_STILLNESS - PROFILE_STATE_IDLE == STATE_STILLNESS && PROFILE_HEARTBEAT - PROFILE_STATE_IDLE == STATE_COUNT,
+              "One profile site per state, in StateId order");
+
+// ***************************** State table *****************************
+
+typedef struct StateDescriptor {
+    bool allowsDeviceReset;                                             // Otherwise System reset is held off
+    void (StateMachine::*update)(const StateMachineInputs& inputs);     // Runs every tick before the transitions are checked
+    void (StateMachine::*enter)();                                      // Optional
+    void (StateMachine::*exit)();                                       // Optional
+    unsigned long StateMachineStatus::*timeInState;                     // Reported in debug messages
+} StateDescriptor;
+
+// A transition with from == to is internal: the action runs, but the state is not exited
+// or entered and no state transition is published. Only the first transition whose guard
+// passes is taken each tick.
+typedef struct StateTransition {
+    StateId from;
+    StateId to;
+    bool (StateMachine::*guard)(const StateMachineInputs& inputs);
+    void (StateMachine::*action)(const StateMachineInputs& inputs);     // Optional
+    bool isRadarDecision;                                               // The guard fires on a radar reading
+    const char* reason;
+} StateTransition;
+
+struct StateMachineTables {
+    // Indexed by StateId
+    static constexpr StateDescriptor states[STATE_COUNT] = {
+        {true,  &StateMachine::updateIdle,             nullptr,                              nullptr,                      &StateMachineStatus::timeInState0},
+        {false, &StateMachine::updateInitialCountdown, &StateMachine::enterInitialCountdown, nullptr,                      &StateMachineStatus::timeInState1},
+        {false, &StateMachine::updateMonitoring,       &StateMachine::enterMonitoring,       nullptr,                      &StateMachineStatus::timeInState2},
+        {false, &StateMachine::updateStillness,        &StateMachine::enterStillness,        &StateMachine::exitStillness, &StateMachineStatus::timeInState3},
+    };
+
+    // Grouped by from state in StateId order, then in the order the guards are checked
+    static constexpr StateTransition transitions[STATE_MACHINE_TRANSITION_COUNT] = {
+        {STATE_IDLE,              STATE_INITIAL_COUNTDOWN, &StateMachine::isOccupancyDetected,  nullptr,                             true,  "Door closed and seeing movement"},
+
+        {STATE_INITIAL_COUNTDOWN, STATE_IDLE,              &StateMachine::isOccupancyLost,      nullptr,                             true,  "No movement detected"},
+        {STATE_INITIAL_COUNTDOWN, STATE_IDLE,              &StateMachine::isDoorOpened,         nullptr,                             false, "Door opened, session over"},
+        {STATE_INITIAL_COUNTDOWN, STATE_MONITORING,        &StateMachine::isOccupancyConfirmed, &StateMachine::startMonitoring,      false, "Movemented detected for max detection time"},
+
+        {STATE_MONITORING,        STATE_IDLE,              &StateMachine::isDoorOpened,         &StateMachine::sendDoorOpened,       false, "Door opened, session over"},
+        {STATE_MONITORING,        STATE_IDLE,              &StateMachine::isMissedDoorOpen,     &StateMachine::sendMissedDoorOpened, false, "Door close event detected, missed door open"},
+        {STATE_MONITORING,        STATE_STILLNESS,         &StateMachine::isStillnessDetected,  nullptr,                             true,  "Stillness detected"},
+        {STATE_MONITORING,        STATE_MONITORING,        &StateMachine::isDurationAlertDue,   &StateMachine::sendDurationAlert,    false, "Duration alert"},
+
+        {STATE_STILLNESS,         STATE_IDLE,              &StateMachine::isDoorOpened,         &StateMachine::sendDoorOpened,       false, "Door opened, session over"},
+        {STATE_STILLNESS,         STATE_IDLE,              &StateMachine::isMissedDoorOpen,     &StateMachine::sendMissedDoorOpened, false, "Door close event detected, missed door open"},
+        {STATE_STILLNESS,         STATE_MONITORING,        &StateMachine::isMotionDetected,     nullptr,                             true,  "Motion detected again"},
+        {STATE_STILLNESS,         STATE_STILLNESS,         &StateMachine::isDurationAlertDue,   &StateMachine::sendDurationAlert,    false, "Duration alert"},
+        {STATE_STILLNESS,         STATE_STILLNESS,         &StateMachine::isStillnessAlertDue,  &StateMachine::sendStillnessAlert,   false, "Stillness alert"},
+    };
+};
+
+// Rows of transitions for state s are firstTransition[s] up to firstTransition[s + 1]
+typedef struct StateTransitionIndex {
+    size_t firstTransition[STATE_COUNT + 1];
+} StateTransitionIndex;
+
+static constexpr StateTransitionIndex indexTransitions() {
+    StateTransitionIndex index = {};
+    size_t row = 0;
+    for (int state = 0; state < STATE_COUNT; state++) {
+        index.firstTransition[state] = row;
+        while (row < STATE_MACHINE_TRANSITION_COUNT && StateMachineTables::transitions[row].from == state) {
+            row++;
+        }
+    }
+    index.firstTransition[STATE_COUNT] = row;
+    return index;
+}
+
+static constexpr StateTransitionIndex transitionIndex = indexTransitions();
+static_assert(transitionIndex.firstTransition[STATE_COUNT] == STATE_MACHINE_TRANSITION_COUNT,
+              "transitions must be grouped by from state in StateId order");
+
+// ***************************** Engine *****************************
+
+StateMachine::StateMachine(const StateMachineIO& io, const StateMachineConfig& config) : io(io), machineConfig(config) {
+    reset();
+}
+
+void StateMachine::reset() {
+    memset(&machineStatus, 0, sizeof(machineStatus));
+    machineStatus.currentState = STATE_IDLE;
+    machineStatus.allowTransitionToStateOne = true;
+    memset(&tickRecord, 0, sizeof(tickRecord));
+    memset(&session, 0, sizeof(session));
+    memset(transitionCounts, 0, sizeof(transitionCounts));
+    deadlines.reset();
+    armedDurationAlertTime = 0;
+    tickTime = 0;
+}
+
+StateMachineConfig& StateMachine::config() {
+    return machineConfig;
+}
+
+const StateMachineConfig& StateMachine::config() const {
+    return machineConfig;
+}
+
+const StateMachineStatus& StateMachine::status() const {
+    return machineStatus;
+}
+
+StateId StateMachine::currentState() const {
+    return machineStatus.currentState;
+}
+
+const StateMachineTick& StateMachine::lastTick() const {
+    return tickRecord;
+}
+
+const SessionSummary& StateMachine::sessionSummary() const {
+    return session;
+}
+
+/*
+ * Calculates elapsed time since the given time at the tick in progress.
+ * Done in 32 bits so it stays right across the millis() rollover.
+ */
+unsigned long StateMachine::calculateTimeSince(unsigned long startTime) {
+    return (uint32_t)(tickTime - (uint32_t)startTime);
+}
+
+void StateMachine::log(StateMachineLogLevel level, const char* fmt, ...) {
+    if (io.log == nullptr) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    io.log(io.context, level, fmt, args);
+    va_end(args);
+}
+
+void StateMachine::enterState(StateId next) {
+    const StateDescriptor& current = StateMachineTables::states[machineStatus.currentState];
+    if (current.exit != nullptr) {
+        (this->*current.exit)();
+    }
+    machineStatus.currentState = next;
+    const StateDescriptor& entered = StateMachineTables::states[next];
+    if (entered.enter != nullptr) {
+        (this->*entered.enter)();
+    }
+}
+
+void StateMachine::tick() {
+    tickTime = io.now(io.context);
+    deadlines.service(tickTime);
+
+    const StateDescriptor& state = StateMachineTables::states[machineStatus.currentState];
+
+    // Only allow the device to reset while idle
+    if (io.allowReset != nullptr) {
+        io.allowReset(io.context, state.allowsDeviceReset);
+    }
+
+    // Scan inputs
+    StateMachineInputs inputs;
+    io.readInputs(io.context, &inputs);
+    if (inputs.isDoorClosedEvent) {
+        // Enable state transitions when door closes
+        machineStatus.timeWhenDoorClosed = tickTime;
+        machineStatus.allowTransitionToStateOne = true;
+
+        // In states 2 and 3 the session in progress is sent first, see sendMissedDoorOpened()
+        if (machineStatus.currentState == STATE_IDLE || machineStatus.currentState == STATE_INITIAL_COUNTDOWN) {
+            startSession(tickTime);
+        }
+    }
+    tickRecord.count++;
+    tickRecord.time = tickTime;
+    tickRecord.inputs = inputs;
+
+    // Times the state's handler: its update, the state report and the transitions
+    PROFILE_SCOPE((ProfileSite)(PROFILE_STATE_IDLE + machineStatus.currentState));
+    (this->*state.update)(inputs);
+
+    // Report the current state, the firmware traces it every tick
+    if (io.reportState != nullptr) {
+        io.reportState(io.context, machineStatus.currentState, inputs, machineStatus.*state.timeInState);
+    }
+
+    if (session.isActive) {
+        recordSessionTick(inputs);
+    }
+
+    StateId current = machineStatus.currentState;
+    for (size_t row = transitionIndex.firstTransition[current]; row < transitionIndex.firstTransition[current + 1]; row++) {
+        const StateTransition& transition = StateMachineTables::transitions[row];
+        if (!(this->*transition.guard)(inputs)) {
+            continue;
+        }
+
+        transitionCounts[row]++;
+        bool isInternal = transition.to == transition.from;
+        if (!isInternal) {
+            session.transitionCount++;
+            log(STATE_MACHINE_LOG_WARN, "State %d --> State %d: %s", transition.from, transition.to, transition.reason);
+            if (io.reportTransition != nullptr) {
+                io.reportTransition(io.context, transition.from, transition.to, transition.isRadarDecision, inputs);
+            }
+        }
+        if (transition.action != nullptr) {
+            (this->*transition.action)(inputs);
+        }
+        if (!isInternal) {
+            enterState(transition.to);
+        }
+        break;
+    }
+
+    // The session is over once the door opens, "Door Opened" has been sent by now if it was
+    // in state 2 or 3
+    if (inputs.isDoorOpen) {
+        session.isActive = false;
+    }
+}
+
+size_t StateMachine::getTransitionCounts(StateTransitionCount* counts, size_t size) const {
+    for (size_t row = 0; row < STATE_MACHINE_TRANSITION_COUNT && row < size; row++) {
+        const StateTransition& transition = StateMachineTables::transitions[row];
+        counts[row] = {transition.from, transition.to, transition.reason, transitionCounts[row]};
+    }
+    return STATE_MACHINE_TRANSITION_COUNT;
+}
+
+void StateMachine::resetToIdle() {
+    tickTime = io.now(io.context);
+    enterState(STATE_IDLE);
+
+    // Disable state transitions until door cycle
+    machineStatus.allowTransitionToStateOne = false;
+    session.isActive = false;
+
+    // Reset all state timers
+    machineStatus.state0_start_time = 0;
+    machineStatus.state1_start_time = 0;
+    machineStatus.state2_start_time = 0;
+    machineStatus.state3_start_time = 0;
+
+    // Reset time tracking in states
+    machineStatus.timeInState0 = 0;
+    machineStatus.timeInState1 = 0;
+    machineStatus.timeInState2 = 0;
+    machineStatus.timeInState3 = 0;
+
+    // Reset duration alert variables
+    machineStatus.numDurationAlertSent = 0;
+    machineStatus.lastDurationAlertTime = 0;
+    machineStatus.timeSinceLastDurationAlert = 0;
+    machineStatus.isDurationAlertThresholdExceeded = false;
+
+    // Reset stillness alert variables
+    machineStatus.numStillnessAlertSent = 0;
+    machineStatus.isStillnessAlertActive = true;
+    machineStatus.isStillnessAlertThresholdExceeded = false;
+
+    // Reset door timing
+    machineStatus.timeWhenDoorClosed = tickTime;
+    machineStatus.timeSinceDoorClosed = 0;
+}
+
+bool StateMachine::resetMonitoring() {
+    if (machineStatus.currentState != STATE_MONITORING && machineStatus.currentState != STATE_STILLNESS) {
+        return false;
+    }
+    tickTime = io.now(io.context);
+
+    // Reset duration alerts
+    machineStatus.numDurationAlertSent = 0;
+    machineStatus.timeSinceLastDurationAlert = 0;
+
+    // Reset stillness alerts
+    machineStatus.numStillnessAlertSent = 0;
+    machineStatus.state3_start_time = tickTime;
+    machineStatus.isStillnessAlertActive = true;
+    return true;
+}
+
+static constexpr JsonField sessionMessageFields[] = {
+    {"alertSentFromState", JSON_INT},
+    {"numDurationAlertsSent", JSON_UINT},
+    {"numStillnessAlertsSent", JSON_UINT},
+    {"occupancyDuration", JSON_UINT},
+};
+
+// "session":{"stateTime":[s per state],"transitions":n,"ins":[[min,mean,max] per state],
+// "durationAlerts":[s],"stillnessAlerts":[s],"missedDoorEvents":n}. Times are in seconds, alert
+// times are since the door closed, and a state the session never entered has no INS values.
+// With every field at its longest "Door Opened" is 487 bytes, which leaves room for the
+// alert journal's sequence and idempotency key in one event.
+static void writeSessionSummary(JsonWriter& writer, const SessionSummary& session) {
+    writer.name("session").beginObject();
+
+    writer.name("stateTime").beginArray();
+    for (int state = 0; state < STATE_COUNT; state++) {
+        writer.value((unsigned long)(session.timeInState[state] / 1000));
+    }
+    writer.endArray();
+
+    writer.name("transitions").value((unsigned long)session.transitionCount);
+
+    writer.name("ins").beginArray();
+    for (int state = 0; state < STATE_COUNT; state++) {
+        const SessionInsStats& ins = session.ins[state];
+        writer.beginArray();
+        if (ins.ticks > 0) {
+            writer.fixed(ins.min, 1).fixed(ins.mean, 1).fixed(ins.max, 1);
+        }
+        writer.endArray();
+    }
+    writer.endArray();
+
+    uint32_t durationAlertTimes = (session.durationAlertCount < SESSION_SUMMARY_ALERT_TIMES) ? session.durationAlertCount : SESSION_SUMMARY_ALERT_TIMES;
+    writer.name("durationAlerts").beginArray();
+    for (uint32_t i = 0; i < durationAlertTimes; i++) {
+        writer.value((unsigned long)(session.durationAlertTimes[i] / 1000));
+    }
+    writer.endArray();
+
+    uint32_t stillnessAlertTimes = (session.stillnessAlertCount < SESSION_SUMMARY_ALERT_TIMES) ? session.stillnessAlertCount : SESSION_SUMMARY_ALERT_TIMES;
+    writer.name("stillnessAlerts").beginArray();
+    for (uint32_t i = 0; i < stillnessAlertTimes; i++) {
+        writer.value((unsigned long)(session.stillnessAlertTimes[i] / 1000));
+    }
+    writer.endArray();
+
+    writer.name("missedDoorEvents").value((unsigned long)session.missedDoorEvents);
+    writer.endObject();
+}
+
+// Sends a session message with the alert counts and occupancy so far, and the session
+// summary at the end of the session
+void StateMachine::sendSessionMessage(const char* eventName, SessionMessageKind kind, bool missedDoorReset) {
+    unsigned long occupancy_duration = machineStatus.timeSinceDoorClosed / 60000;
+    char message[PARTICLE_MAX_MESSAGE_LENGTH + 1];
+    JsonWriter writer(message, sizeof(message));
+    writer.beginObject();
+    writeJsonFields<sessionMessageFields>(writer, machineStatus.currentState, machineStatus.numDurationAlertSent,
+                                          machineStatus.numStillnessAlertSent, occupancy_duration);
+    if (missedDoorReset) {
+        writer.name("missedDoorReset").value(true);
+    }
+    if (kind == SESSION_MESSAGE_END) {
+        writeSessionSummary(writer, session);
+    }
+    writer.endObject();
+    if (writer.overflowed()) {
+        log(STATE_MACHINE_LOG_WARN, "%s cut short at %u bytes", eventName, (unsigned int)writer.length());
+    }
+    io.sendSessionMessage(io.context, eventName, message, kind);
+}
+
+// ***************************** Session summary *****************************
+
+void StateMachine::startSession(uint32_t startTime) {
+    memset(&session, 0, sizeof(session));
+    session.isActive = true;
+    session.startTime = startTime;
+    session.lastTickTime = tickTime;
+}
+
+// The time since the last tick was spent in the current state, since transitions are
+// taken after this
+void StateMachine::recordSessionTick(const StateMachineInputs& inputs) {
+    StateId state = machineStatus.currentState;
+    session.timeInState[state] += calculateTimeSince(session.lastTickTime);
+    session.lastTickTime = tickTime;
+    session.missedDoorEvents += inputs.missedDoorEvents;
+
+    float magnitude = (inputs.insMagnitude < SESSION_SUMMARY_INS_MAX) ? inputs.insMagnitude : SESSION_SUMMARY_INS_MAX;
+    SessionInsStats& ins = session.ins[state];
+    ins.ticks++;
+    if (ins.ticks == 1) {
+        ins.min = magnitude;
+        ins.mean = magnitude;
+        ins.max = magnitude;
+    }
+    else {
+        ins.min = (magnitude < ins.min) ? magnitude : ins.min;
+        ins.max = (magnitude > ins.max) ? magnitude : ins.max;
+        // Running mean, a float sum would stop counting small magnitudes in a long session
+        ins.mean += (magnitude - ins.mean) / ins.ticks;
+    }
+}
+
+void StateMachine::recordSessionAlert(uint32_t* times, uint32_t& count) {
+    if (!session.isActive) {
+        return;
+    }
+    if (count < SESSION_SUMMARY_ALERT_TIMES) {
+        times[count] = calculateTimeSince(session.startTime);
+    }
+    count++;
+}
+
+// ***************************** Alert logic *****************************
+
+/*
+ * Duration Alert Logic:
+ * - Can trigger from states 2 and 3
+ * - Duration alerts can only trigger if stillness alerts are active as well
+ * - Alerts are due at every multiple of the duration alert threshold since the door closed
+ * - The next multiple is armed as a deadline, so an alert is raised once per multiple even
+ *   if loop() was held up past it. The flag stays set until the alert is sent.
+ */
+void StateMachine::updateDurationAlertStatus() {
+    StateMachineStatus& s = machineStatus;
+    unsigned long duration_alert_time = machineConfig.duration_alert_time;
+
+    if (s.isStillnessAlertActive) {
+        s.timeSinceDoorClosed = calculateTimeSince(s.timeWhenDoorClosed);
+        s.timeSinceLastDurationAlert = (s.numDurationAlertSent > 0) ? calculateTimeSince(s.lastDurationAlertTime) : 0;
+
+        if (deadlines.take(DEADLINE_DURATION_ALERT)) {
+            s.isDurationAlertThresholdExceeded = true;
+        }
+        // A new duration_alert_time from the console moves the next alert to a multiple of it
+        if (deadlines.isArmed(DEADLINE_DURATION_ALERT) && armedDurationAlertTime != duration_alert_time) {
+            deadlines.cancel(DEADLINE_DURATION_ALERT);
+        }
+        if (!deadlines.isArmed(DEADLINE_DURATION_ALERT) && duration_alert_time > 0) {
+            unsigned long multiples = s.timeSinceDoorClosed / duration_alert_time + 1;
+            deadlines.arm(DEADLINE_DURATION_ALERT, s.timeWhenDoorClosed + multiples * duration_alert_time);
+            armedDurationAlertTime = duration_alert_time;
+        }
+    }
+    // Paused by a stillness alert, picks up at the next multiple once monitoring is reset
+    else {
+        deadlines.cancel(DEADLINE_DURATION_ALERT);
+        s.isDurationAlertThresholdExceeded = false;
+    }
+}
+
+/*
+ * Stillness Alert Logic:
+ * - Only triggers in state 3
+ * - isStillnessAlertActive must be true
+ * - One-time alert when continuous stillness exceeds threshold
+ * - When triggered, pauses both duration and stillness alerts
+ * - Requires state reset or door open to re-enable
+ */
+void StateMachine::updateStillnessAlertStatus() {
+    if (machineStatus.isStillnessAlertActive) {
+        // Armed every pass so a reset_monitoring or a new stillness_alert_time moves the deadline
+        deadlines.arm(DEADLINE_STILLNESS_ALERT, machineStatus.state3_start_time + machineConfig.stillness_alert_time);
+        machineStatus.isStillnessAlertThresholdExceeded = deadlines.isFired(DEADLINE_STILLNESS_ALERT);
+    }
+}
+
+// ***************************** States *****************************
+
+/*
+ * State 0 - Idle State
+ * This is the normal state of the sensor where:
+ * Door is open/closed and we don't see any movement inside the washroom stall.
+ */
+void StateMachine::updateIdle(const StateMachineInputs& inputs) {
+    StateMachineStatus& s = machineStatus;
+
+    // Reset alert flags
+    s.isStillnessAlertActive = true;
+    s.numDurationAlertSent = 0;
+    s.numStillnessAlertSent = 0;
+    s.timeSinceLastDurationAlert = 0;
+    s.isDurationAlertThresholdExceeded = false;
+    s.isStillnessAlertThresholdExceeded = false;
+    deadlines.cancel(DEADLINE_DURATION_ALERT);
+    deadlines.cancel(DEADLINE_STILLNESS_ALERT);
+
+    // Reset the other variables
+    s.state1_start_time = 0;
+    s.state2_start_time = 0;
+    s.state3_start_time = 0;
+    s.timeSinceDoorClosed = 0;
+
+    // If the door is closed, calculate the time spent in state 0
+    // State 0 only requires timeWhenDoorClosed
+    if (!inputs.isDoorOpen) {
+        s.state0_start_time = s.timeWhenDoorClosed;
+        s.timeInState0 = calculateTimeSince(s.state0_start_time);
+    }
+    // If the door is open or its status is unknown, default to 0
+    else {
+        s.state0_start_time = 0;
+        s.timeInState0 = 0;
+    }
+}
+
+// Transition to state 1 if:
+// 1. The door has been closed for less than the occupancy detection time (person has entered and washroom is now occupied).
+// 2. The INS magnitude indicates movement (using high threshold for hysteresis).
+// 3. The door is closed.
+// 4. The door status is known.
+// 5. State transitions are enabled.
+bool StateMachine::isOccupancyDetected(const StateMachineInputs& inputs) {
+    return machineStatus.timeInState0 < machineConfig.state0_occupancy_detection_time &&
+           (inputs.insMagnitude > (machineConfig.occupancy_detection_ins_threshold + HYSTERESIS_OFFSET)) &&
+           !inputs.isDoorOpen &&
+           !inputs.isDoorStatusUnknown &&
+           machineStatus.allowTransitionToStateOne;
+}
+
+/*
+ * State 1 - Initial Countdown State
+ * This state is entered when the door is closed and movement is detected.
+ * The system countdowns for a short period to confirm occupancy.
+ */
+void StateMachine::enterInitialCountdown() {
+    machineStatus.state1_start_time = tickTime;
+
+    // Without a door close since startup, the session starts here
+    if (!session.isActive) {
+        startSession(machineStatus.timeWhenDoorClosed);
+    }
+}
+
+void StateMachine::updateInitialCountdown(const StateMachineInputs& inputs) {
+    machineStatus.timeInState1 = calculateTimeSince(machineStatus.state1_start_time);
+}
+
+// Using low threshold for hysteresis
+bool StateMachine::isOccupancyLost(const StateMachineInputs& inputs) {
+    return inputs.insMagnitude > 0 && inputs.insMagnitude < (machineConfig.occupancy_detection_ins_threshold - HYSTERESIS_OFFSET);
+}
+
+bool StateMachine::isDoorOpened(const StateMachineInputs& inputs) {
+    return inputs.isDoorOpen;
+}
+
+// The door remains closed and movement is detected for the maximum allowed time
+bool StateMachine::isOccupancyConfirmed(const StateMachineInputs& inputs) {
+    return machineStatus.timeInState1 >= machineConfig.state1_initial_time;
+}
+
+void StateMachine::startMonitoring(const StateMachineInputs& inputs) {
+    machineStatus.allowTransitionToStateOne = false;
+}
+
+/*
+ * State 2 - Monitoring State
+ * This state is entered when the door is closed and movement is detected for a confirmed period.
+ * The system monitors the duration of occupancy and stillness.
+ * Sends a duration alert if the not sent before and duration exceeds a threshold.
+ */
+void StateMachine::enterMonitoring() {
+    machineStatus.state2_start_time = tickTime;
+}
+
+void StateMachine::updateMonitoring(const StateMachineInputs& inputs) {
+    machineStatus.timeInState2 = calculateTimeSince(machineStatus.state2_start_time);
+    updateDurationAlertStatus();
+}
+
+// A new door close event while in State 2 or 3 means the door opened and closed without
+// us seeing the open
+bool StateMachine::isMissedDoorOpen(const StateMachineInputs& inputs) {
+    return machineStatus.allowTransitionToStateOne;
+}
+
+// Using low threshold for hysteresis
+bool StateMachine::isStillnessDetected(const StateMachineInputs& inputs) {
+    return inputs.insMagnitude > 0 && inputs.insMagnitude < (machineConfig.stillness_ins_threshold - HYSTERESIS_OFFSET);
+}
+
+bool StateMachine::isDurationAlertDue(const StateMachineInputs& inputs) {
+    return machineStatus.isStillnessAlertActive && machineStatus.isDurationAlertThresholdExceeded;
+}
+
+void StateMachine::sendDoorOpened(const StateMachineInputs& inputs) {
+    sendSessionMessage("Door Opened", SESSION_MESSAGE_END, false);
+}
+
+// The door close that gave the missed open away starts the next session
+void StateMachine::sendMissedDoorOpened(const StateMachineInputs& inputs) {
+    sendSessionMessage("Door Opened", SESSION_MESSAGE_END, true);
+    startSession(tickTime);
+}
+
+void StateMachine::sendDurationAlert(const StateMachineInputs& inputs) {
+    StateMachineStatus& s = machineStatus;
+    log(STATE_MACHINE_LOG_WARN, "--Duration Alert-- TimeSinceDoorClosed: %lu, TimeSinceLastDurationAlert: %lu, TimeInState: %lu",
+        s.timeSinceDoorClosed, s.timeSinceLastDurationAlert, (s.currentState == STATE_STILLNESS) ? s.timeInState3 : s.timeInState2);
+
+    // Update the duration alert counter and time
+    s.numDurationAlertSent += 1;
+    s.lastDurationAlertTime = tickTime;
+    s.isDurationAlertThresholdExceeded = false;
+    recordSessionAlert(session.durationAlertTimes, session.durationAlertCount);
+
+    sendSessionMessage("Duration Alert", SESSION_MESSAGE_ALERT, false);
+}
+
+/*
+ * State 3 - Stillness State
+ * This state is entered when the door is closed and stillness is detected.
+ * The system monitors the stillness duration.
+ * Sends a stillness alert if the stillness duration exceeds a threshold.
+ */
+void StateMachine::enterStillness() {
+    machineStatus.state3_start_time = tickTime;
+}
+
+void StateMachine::updateStillness(const StateMachineInputs& inputs) {
+    machineStatus.timeInState3 = calculateTimeSince(machineStatus.state3_start_time);
+    updateDurationAlertStatus();
+    updateStillnessAlertStatus();
+}
+
+void StateMachine::exitStillness() {
+    deadlines.cancel(DEADLINE_STILLNESS_ALERT);
+    machineStatus.isStillnessAlertThresholdExceeded = false;
+}
+
+// Using high threshold for hysteresis
+bool StateMachine::isMotionDetected(const StateMachineInputs& inputs) {
+    return inputs.insMagnitude > (machineConfig.stillness_ins_threshold + HYSTERESIS_OFFSET);
+}
+
+bool StateMachine::isStillnessAlertDue(const StateMachineInputs& inputs) {
+    return machineStatus.isStillnessAlertActive && machineStatus.isStillnessAlertThresholdExceeded;
+}
+
+void StateMachine::sendStillnessAlert(const StateMachineInputs& inputs) {
+    StateMachineStatus& s = machineStatus;
+    log(STATE_MACHINE_LOG_WARN, "--Stillness Alert-- TimeSinceDoorClosed: %lu, TimeInState: %lu", s.timeSinceDoorClosed, s.timeInState3);
+
+    // Update the stillness alert counter
+    s.numStillnessAlertSent += 1;
+
+    // Turning off this flag will pause both duration and stillness alerts
+    s.isStillnessAlertActive = false;
+    recordSessionAlert(session.stillnessAlertTimes, session.stillnessAlertCount);
+
+    sendSessionMessage("Stillness Alert", SESSION_MESSAGE_ALERT, false);
+}
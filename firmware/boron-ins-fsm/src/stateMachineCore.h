@@ -0,0 +1,290 @@
+/* stateMachineCore.h - Washroom occupancy state machine, one instance per sensor
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Deliberately free of Particle headers so it can be built on the host. Each StateMachine
+ * has its own thresholds, session state and alert deadlines, and reads its inputs and the
+ * time and sends its alerts through the StateMachineIO it is given. The firmware runs one
+ * instance wired to the door sensor, the radar and the publish queue (see stateMachine.h).
+ * Host tools run as many as they like, e.g. one per recorded session and threshold, and
+ * instances on different threads share nothing.
+ */
+
+#ifndef STATE_MACHINE_CORE_H
+#define STATE_MACHINE_CORE_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "deadlineScheduler.h"
+
+// ***************************** Macro definitions *****************************
+
+// Initial values for state machine, can be changed via console function
+#define STILLNESS_INS_THRESHOLD             20
+#define OCCUPANCY_DETECTION_INS_THRESHOLD   60
+
+// Hysteresis offset: thresholds become base ± this value
+#define HYSTERESIS_OFFSET                   2
+
+#define STATE0_OCCUPANCY_DETECTION_TIME     30000       // 30 secs
+#define STATE1_INITIAL_TIME                 3000        // 3 secs
+
+#define DURATION_ALERT_TIME                 1200000     // 20 mins
+#define STILLNESS_ALERT_TIME                180000      // 3 mins
+
+// Rows in the transition table, see stateMachineCore.cpp
+#define STATE_MACHINE_TRANSITION_COUNT      13
+
+// Alert times kept in a session summary per kind, later alerts are only counted
+#define SESSION_SUMMARY_ALERT_TIMES         4
+
+// INS magnitudes in a session summary are clamped to this, so "Door Opened" stays in one event
+#define SESSION_SUMMARY_INS_MAX             99999.9f
+
+// ***************************** Global typedefs *****************************
+
+// Values are the state numbers used in logs, debug messages and alerts
+enum StateId {
+    STATE_IDLE = 0,
+    STATE_INITIAL_COUNTDOWN,
+    STATE_MONITORING,
+    STATE_STILLNESS,
+    STATE_COUNT
+};
+
+// How often one row of the transition table has been taken
+typedef struct StateTransitionCount {
+    StateId from;
+    StateId to;             // Same as from for alerts, which do not leave the state
+    const char* reason;
+    uint32_t count;
+} StateTransitionCount;
+
+// Thresholds and times, field names match their console functions and EEPROM addresses
+typedef struct StateMachineConfig {
+    unsigned long stillness_ins_threshold;
+    unsigned long occupancy_detection_ins_threshold;
+    unsigned long state0_occupancy_detection_time;
+    unsigned long state1_initial_time;
+    unsigned long duration_alert_time;
+    unsigned long stillness_alert_time;
+} StateMachineConfig;
+
+const StateMachineConfig defaultStateMachineConfig = {
+    STILLNESS_INS_THRESHOLD,
+    OCCUPANCY_DETECTION_INS_THRESHOLD,
+    STATE0_OCCUPANCY_DETECTION_TIME,
+    STATE1_INITIAL_TIME,
+    DURATION_ALERT_TIME,
+    STILLNESS_ALERT_TIME,
+};
+
+// Read once at the start of each tick and shared by every hook, guard and action
+typedef struct StateMachineInputs {
+    uint8_t doorStatus;         // Last door sensor status byte, for logs and debug messages
+    bool isDoorOpen;
+    bool isDoorStatusUnknown;   // No door sensor message since startup
+    bool isDoorClosedEvent;     // The door sensor reported the door closing since the last tick
+    float insMagnitude;         // Filtered radar magnitude
+    uint32_t insSampleTime;     // now() when the newest radar sample in insMagnitude arrived
+    uint32_t missedDoorEvents;  // Door sensor messages missed since the last tick
+} StateMachineInputs;
+
+// Session state of one instance, reset by the console functions
+typedef struct StateMachineStatus {
+    StateId currentState;
+
+    // Start timers for different states
+    unsigned long state0_start_time;
+    unsigned long state1_start_time;
+    unsigned long state2_start_time;
+    unsigned long state3_start_time;
+
+    // Time spent in different states
+    unsigned long timeInState0;
+    unsigned long timeInState1;
+    unsigned long timeInState2;
+    unsigned long timeInState3;
+
+    // Door close time, from the last door closed event
+    unsigned long timeWhenDoorClosed;
+    unsigned long timeSinceDoorClosed;
+
+    // Duration alert variables
+    unsigned long numDurationAlertSent;
+    unsigned long lastDurationAlertTime;
+    unsigned long timeSinceLastDurationAlert;
+    bool isDurationAlertThresholdExceeded;
+
+    // Stillness alert variables
+    unsigned long numStillnessAlertSent;
+    bool isStillnessAlertActive;
+    bool isStillnessAlertThresholdExceeded;
+
+    // Set by a door closed event, cleared once monitoring starts
+    bool allowTransitionToStateOne;
+} StateMachineStatus;
+
+// INS magnitude over the ticks a session spent in one state
+typedef struct SessionInsStats {
+    uint32_t ticks;
+    float min;
+    float mean;
+    float max;
+} SessionInsStats;
+
+// Built up every tick from the door closing to the door opening and sent with "Door Opened",
+// so a session can be tuned from without turning on debug publishes. Fixed size, nothing
+// is allocated.
+typedef struct SessionSummary {
+    bool isActive;
+    uint32_t startTime;                     // now() when the door closed
+    uint32_t lastTickTime;
+    uint32_t timeInState[STATE_COUNT];      // ms, indexed by StateId
+    SessionInsStats ins[STATE_COUNT];
+    uint32_t transitionCount;               // State changes, alerts are not counted
+    uint32_t durationAlertCount;
+    uint32_t stillnessAlertCount;
+    uint32_t durationAlertTimes[SESSION_SUMMARY_ALERT_TIMES];   // ms since startTime, the first ones
+    uint32_t stillnessAlertTimes[SESSION_SUMMARY_ALERT_TIMES];
+    uint32_t missedDoorEvents;
+} SessionSummary;
+
+// The last tick, for tools that record the inputs of a run
+typedef struct StateMachineTick {
+    uint32_t count;             // Ticks since the instance was made or reset
+    uint32_t time;              // now() at the tick
+    StateMachineInputs inputs;
+} StateMachineTick;
+
+enum StateMachineLogLevel {
+    STATE_MACHINE_LOG_INFO,
+    STATE_MACHINE_LOG_WARN
+};
+
+// Session messages are journalled as alerts ("Duration Alert", "Stillness Alert") or as
+// the end of a session ("Door Opened")
+enum SessionMessageKind {
+    SESSION_MESSAGE_ALERT,
+    SESSION_MESSAGE_END
+};
+
+// Everything an instance reads or does outside itself. Hooks marked optional may be
+// nullptr, e.g. host tools that only count alerts leave out logging.
+typedef struct StateMachineIO {
+    uint32_t (*now)(void* context);
+    void (*readInputs)(void* context, StateMachineInputs* inputs);
+
+    // Optional, called first each tick with whether the current state allows a device reset
+    void (*allowReset)(void* context, bool stateAllowsReset);
+
+    // Optional, a log line to format if the level is enabled
+    void (*log)(void* context, StateMachineLogLevel level, const char* fmt, va_list args);
+
+    // Optional, called every tick once the state has been updated
+    void (*reportState)(void* context, StateId state, const StateMachineInputs& inputs, unsigned long timeInState);
+
+    // Optional, called when the state changes, before the transition's action. isRadarDecision
+    // is set when the guard fired on the radar reading in inputs rather than on the door or a timer.
+    void (*reportTransition)(void* context, StateId from, StateId to, bool isRadarDecision, const StateMachineInputs& inputs);
+
+    // message is a JSON object with the alert counts and occupancy of the session. At the
+    // end of a session it also has the session summary.
+    void (*sendSessionMessage)(void* context, const char* eventName, const char* message, SessionMessageKind kind);
+
+    void* context;
+} StateMachineIO;
+
+class StateMachine {
+public:
+    StateMachine(const StateMachineIO& io, const StateMachineConfig& config);
+
+    // Reads the inputs, updates the current state and takes at most one transition
+    void tick();
+
+    // Thresholds and times are read every tick, so changes apply from the next one
+    StateMachineConfig& config();
+    const StateMachineConfig& config() const;
+
+    const StateMachineStatus& status() const;
+    StateId currentState() const;
+    const StateMachineTick& lastTick() const;
+
+    // The session in progress, or the last one once the door has opened
+    const SessionSummary& sessionSummary() const;
+
+    // Fills counts with up to size rows of the transition table, returns the number of rows
+    size_t getTransitionCounts(StateTransitionCount* counts, size_t size) const;
+
+    // Back to the state the instance was made in, keeping its config
+    void reset();
+
+    // Enters state 0 with every timer and alert cleared. State 1 is not entered again
+    // until the door closes.
+    void resetToIdle();
+
+    // Clears the alerts of the current session and restarts the stillness timer. Only
+    // allowed in states 2 and 3, returns false otherwise.
+    bool resetMonitoring();
+
+private:
+    // The state and transition tables, see stateMachineCore.cpp
+    friend struct StateMachineTables;
+
+    void enterState(StateId next);
+    unsigned long calculateTimeSince(unsigned long startTime);
+    void log(StateMachineLogLevel level, const char* fmt, ...);
+    void sendSessionMessage(const char* eventName, SessionMessageKind kind, bool missedDoorReset);
+    void startSession(uint32_t startTime);
+    void recordSessionTick(const StateMachineInputs& inputs);
+    void recordSessionAlert(uint32_t* times, uint32_t& count);
+    void updateDurationAlertStatus();
+    void updateStillnessAlertStatus();
+
+    // State hooks, guards and actions
+    void updateIdle(const StateMachineInputs& inputs);
+    void enterInitialCountdown();
+    void updateInitialCountdown(const StateMachineInputs& inputs);
+    void enterMonitoring();
+    void updateMonitoring(const StateMachineInputs& inputs);
+    void enterStillness();
+    void updateStillness(const StateMachineInputs& inputs);
+    void exitStillness();
+
+    bool isOccupancyDetected(const StateMachineInputs& inputs);
+    bool isOccupancyLost(const StateMachineInputs& inputs);
+    bool isDoorOpened(const StateMachineInputs& inputs);
+    bool isOccupancyConfirmed(const StateMachineInputs& inputs);
+    bool isMissedDoorOpen(const StateMachineInputs& inputs);
+    bool isStillnessDetected(const StateMachineInputs& inputs);
+    bool isDurationAlertDue(const StateMachineInputs& inputs);
+    bool isMotionDetected(const StateMachineInputs& inputs);
+    bool isStillnessAlertDue(const StateMachineInputs& inputs);
+
+    void startMonitoring(const StateMachineInputs& inputs);
+    void sendDoorOpened(const StateMachineInputs& inputs);
+    void sendMissedDoorOpened(const StateMachineInputs& inputs);
+    void sendDurationAlert(const StateMachineInputs& inputs);
+    void sendStillnessAlert(const StateMachineInputs& inputs);
+
+    StateMachineIO io;
+    StateMachineConfig machineConfig;
+    StateMachineStatus machineStatus;
+    StateMachineTick tickRecord;
+    SessionSummary session;
+
+    // Duration and stillness alert deadlines
+    DeadlineScheduler deadlines;
+
+    // duration_alert_time the duration alert deadline was armed with
+    unsigned long armedDurationAlertTime;
+
+    // now() for the tick in progress
+    uint32_t tickTime;
+
+    uint32_t transitionCounts[STATE_MACHINE_TRANSITION_COUNT];
+};
+
+#endif
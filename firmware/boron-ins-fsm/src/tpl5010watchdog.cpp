@@ -7,6 +7,7 @@
 
 #include "Particle.h"
 #include "tpl5010watchdog.h"
+#include "clock.h"
 
 // Pin used to service the watchdog
 const pin_t WATCHDOG_PIN = D6;
@@ -25,8 +26,8 @@ void setupWatchdog() {
 void serviceWatchdog() {
     static unsigned long lastWatchdogMillis = 0;
 
-    if (millis() - lastWatchdogMillis >= WATCHDOG_PERIOD.count()) {
-        lastWatchdogMillis = millis();
+    if (clockMillisSince(lastWatchdogMillis) >= WATCHDOG_PERIOD.count()) {
+        lastWatchdogMillis = clockMillis();
 
         Log.warn("service watchdog");
 
@@ -0,0 +1,120 @@
+/* traceLog.cpp - Binary trace records for the logs loop() writes every pass
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * A record is a header word (event id in the low 16 bits, argument count in the next 8),
+ * the clockMillis() time and one word per argument. Frames carry the words little endian.
+ */
+
+#include "traceLog.h"
+#include "clock.h"
+
+static_assert((TRACE_RING_WORDS & (TRACE_RING_WORDS - 1)) == 0, "TRACE_RING_WORDS must be a power of two");
+
+// ***************************** Local variables *****************************
+
+static uint32_t ring[TRACE_RING_WORDS];
+static uint32_t head = 0;  // Next word written
+static uint32_t tail = 0;  // Next word drained
+static uint32_t recordCount = 0;
+static uint32_t droppedCount = 0;
+static uint32_t unreportedDrops = 0;
+static TraceLevel minimumLevel = TRACE_LEVEL_OFF;
+
+// ***************************** Local functions *****************************
+
+static void putRecord(TraceId id, const uint32_t* args, size_t count) {
+    ring[head++ & (TRACE_RING_WORDS - 1)] = (uint32_t)id | ((uint32_t)count << 16);
+    ring[head++ & (TRACE_RING_WORDS - 1)] = clockMillis();
+    for (size_t i = 0; i < count; i++) {
+        ring[head++ & (TRACE_RING_WORDS - 1)] = args[i];
+    }
+    recordCount++;
+}
+
+// COBS: every zero byte becomes the distance to the next one, so the frame has none
+static size_t encodeCobs(const uint8_t* data, size_t length, uint8_t* out) {
+    size_t codeIndex = 0;
+    size_t outIndex = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] == 0) {
+            out[codeIndex] = code;
+            codeIndex = outIndex++;
+            code = 1;
+            continue;
+        }
+        out[outIndex++] = data[i];
+        if (++code == 0xFF) {
+            out[codeIndex] = code;
+            codeIndex = outIndex++;
+            code = 1;
+        }
+    }
+    out[codeIndex] = code;
+    return outIndex;
+}
+
+// ***************************** Public functions *****************************
+
+void traceWrite(TraceId id, const uint32_t* args, size_t count) {
+    if (traceEvents[id].level < minimumLevel) {
+        return;
+    }
+
+    uint32_t free = TRACE_RING_WORDS - (head - tail);
+    if (unreportedDrops > 0 && free >= 3 + 2 + count) {
+        putRecord(TRACE_DROPPED, &unreportedDrops, 1);
+        unreportedDrops = 0;
+        free -= 3;
+    }
+    if (unreportedDrops > 0 || free < 2 + count) {
+        droppedCount++;
+        unreportedDrops++;
+        return;
+    }
+    putRecord(id, args, count);
+}
+
+size_t drainTrace(uint8_t* buffer, size_t size) {
+    size_t length = 0;
+    while (tail != head) {
+        uint32_t header = ring[tail & (TRACE_RING_WORDS - 1)];
+        size_t words = 2 + ((header >> 16) & 0xFF);
+        if (length + 4 * words + 4 * words / 254 + 3 > size) {
+            break;
+        }
+
+        uint8_t record[TRACE_MAX_RECORD_BYTES];
+        for (size_t w = 0; w < words; w++) {
+            uint32_t word = ring[(tail + w) & (TRACE_RING_WORDS - 1)];
+            record[4 * w] = (uint8_t)word;
+            record[4 * w + 1] = (uint8_t)(word >> 8);
+            record[4 * w + 2] = (uint8_t)(word >> 16);
+            record[4 * w + 3] = (uint8_t)(word >> 24);
+        }
+        tail += words;
+
+        buffer[length++] = 0x00;
+        length += encodeCobs(record, 4 * words, buffer + length);
+        buffer[length++] = 0x00;
+    }
+    return length;
+}
+
+void setTraceLevel(TraceLevel level) {
+    minimumLevel = level;
+}
+
+TraceStats getTraceStats() {
+    TraceStats stats = {recordCount, droppedCount, head - tail};
+    return stats;
+}
+
+void resetTraceLog() {
+    head = 0;
+    tail = 0;
+    recordCount = 0;
+    droppedCount = 0;
+    unreportedDrops = 0;
+}
@@ -0,0 +1,198 @@
+/* traceLog.h - Binary trace records for the logs loop() writes every pass
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * TRACE(id, args...) writes the event id, the time and the raw arguments into a RAM ring
+ * instead of formatting a log line. The format strings only live in the TRACE_EVENTS table
+ * below, which the host decoder (sim/traceDecode.h) shares to expand the records again.
+ * Argument counts and types are checked against the format at compile time, so a record
+ * always decodes, and writing one costs a few dozen cycles.
+ *
+ * Records below the level given to setTraceLevel() are not written. The level starts at
+ * TRACE_LEVEL_OFF, so nothing is written unless the firmware is built with
+ * BRAVE_TRACE_SERIAL. Then setup() sets the level from DEBUG_LEVEL, and the application
+ * loop drains the ring over USB serial as frames of 0x00, the COBS encoded record, 0x00
+ * (see serviceTraceLog() in the .ino). Text logs never contain 0x00, so the decoder passes
+ * them through unchanged around the frames. The frames are written with Serial locked, but
+ * a text log from another thread that does not take the lock can still land inside one. The
+ * decoder reports that record as bad and picks up again at the next 0x00.
+ *
+ * Records are written and drained on the application thread only, so the ring is plain
+ * memory. A record that does not fit is dropped and counted, and a TRACE_DROPPED record
+ * with the count is written once there is room again.
+ */
+
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+// ***************************** Macro definitions *****************************
+
+// Uncomment to drain the trace log to USB serial, also set by make sim-trace
+// #define BRAVE_TRACE_SERIAL
+
+// Ring size in 32 bit words, must be a power of two. A state record is 5 words.
+#define TRACE_RING_WORDS    512
+
+// Most arguments a format may take
+#define TRACE_MAX_ARGS      6
+
+// Record header, time and arguments
+#define TRACE_MAX_RECORD_BYTES      (4 * (2 + TRACE_MAX_ARGS))
+
+// Largest drained frame: two delimiters around at most one COBS overhead byte per 254
+#define TRACE_MAX_FRAME_BYTES       (TRACE_MAX_RECORD_BYTES + TRACE_MAX_RECORD_BYTES / 254 + 3)
+
+// Formats take %d, %i, %u, %x, %X, %o and %c for integers and %f, %e and %g for floats, with
+// any flags, width and precision. There is no %s, name the string in the format instead.
+// Append new events at the end so recorded traces still decode. TRACE_DOOR_CLOSED is no longer
+// written, the door close is a text log again so it is seen without BRAVE_TRACE_SERIAL.
+#define TRACE_EVENTS(X)                                                                                             \
+    X(TRACE_DROPPED,             TRACE_LEVEL_WARN, "%u trace records dropped")                                      \
+    X(TRACE_STATE,               TRACE_LEVEL_INFO, "State %d: Door Status = 0x%02X, INS Magnitude = %f")            \
+    X(TRACE_DOOR_CLOSED,         TRACE_LEVEL_WARN, "Door closed - State transitions enabled")                       \
+    X(TRACE_DOOR_NO_NEW_DATA,    TRACE_LEVEL_INFO, "no new data, control byte = 0x%02X")                            \
+    X(TRACE_DOOR_DATA_PUBLISHED, TRACE_LEVEL_WARN, "published, 0x%02X")
+
+// ***************************** Global typedefs *****************************
+
+enum TraceLevel {
+    TRACE_LEVEL_INFO = 0,
+    TRACE_LEVEL_WARN,
+    TRACE_LEVEL_ERROR,
+    TRACE_LEVEL_OFF     // Only for setTraceLevel()
+};
+
+#define TRACE_EVENT_ID(id, level, format) id,
+enum TraceId {
+    TRACE_EVENTS(TRACE_EVENT_ID)
+    TRACE_EVENT_COUNT
+};
+#undef TRACE_EVENT_ID
+
+typedef struct TraceEvent {
+    TraceLevel level;
+    const char* format;
+} TraceEvent;
+
+#define TRACE_EVENT_ENTRY(id, level, format) {level, format},
+inline constexpr TraceEvent traceEvents[TRACE_EVENT_COUNT] = {
+    TRACE_EVENTS(TRACE_EVENT_ENTRY)
+};
+#undef TRACE_EVENT_ENTRY
+
+typedef struct TraceStats {
+    uint32_t records;   // Written since boot
+    uint32_t dropped;   // Did not fit in the ring
+    uint32_t pending;   // Words waiting to be drained
+} TraceStats;
+
+// ***************************** Format checks *****************************
+
+constexpr bool traceIsOneOf(char c, const char* set) {
+    for (size_t i = 0; set[i] != '\0'; i++) {
+        if (set[i] == c) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The conversion character of the index-th argument in format, or 0 past the last one
+constexpr char traceConversion(const char* format, size_t index) {
+    for (size_t i = 0; format[i] != '\0'; i++) {
+        if (format[i] != '%') {
+            continue;
+        }
+        i++;
+        if (format[i] == '%') {
+            continue;
+        }
+        while (format[i] != '\0' && traceIsOneOf(format[i], "-+ #0123456789.hlLjzt")) {
+            i++;
+        }
+        if (index == 0) {
+            return format[i];
+        }
+        index--;
+    }
+    return 0;
+}
+
+constexpr size_t traceArgCount(const char* format) {
+    size_t count = 0;
+    while (traceConversion(format, count) != 0) {
+        count++;
+    }
+    return count;
+}
+
+template <typename T>
+constexpr bool traceAccepts(char conversion) {
+    if constexpr (std::is_floating_point<T>::value) {
+        return conversion == 'f' || conversion == 'e' || conversion == 'g';
+    }
+    else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+        return conversion != 0 && traceIsOneOf(conversion, "diuxXoc");
+    }
+    return false;
+}
+
+template <typename... Args>
+struct TraceArgs {
+    template <size_t... I>
+    static constexpr bool match(const char* format, std::index_sequence<I...>) {
+        return (true && ... && traceAccepts<Args>(traceConversion(format, I)));
+    }
+};
+
+// Integers are kept as 32 bits, floats as their IEEE 754 bits
+template <typename T>
+inline uint32_t traceWord(T arg) {
+    if constexpr (std::is_floating_point<T>::value) {
+        float value = (float)arg;
+        uint32_t word;
+        memcpy(&word, &value, sizeof(word));
+        return word;
+    }
+    else {
+        return (uint32_t)arg;
+    }
+}
+
+// ***************************** Function declarations *****************************
+
+// Copies a record into the ring, use TRACE() instead
+void traceWrite(TraceId id, const uint32_t* args, size_t count);
+
+// Writes whole records as frames into buffer, never more than size bytes, and returns the
+// number of bytes written. Records that do not fit wait for the next call.
+size_t drainTrace(uint8_t* buffer, size_t size);
+
+// Records of events below level are not written or counted
+void setTraceLevel(TraceLevel level);
+
+TraceStats getTraceStats(void);
+
+void resetTraceLog(void);
+
+template <TraceId Id, typename... Args>
+inline void trace(Args... args) {
+    constexpr const char* format = traceEvents[Id].format;
+    static_assert(sizeof...(Args) <= TRACE_MAX_ARGS, "Too many trace arguments");
+    static_assert(traceArgCount(format) == sizeof...(Args), "Trace argument count does not match the format");
+    static_assert(TraceArgs<Args...>::match(format, std::index_sequence_for<Args...>()), "Trace argument type does not match the format");
+
+    // One spare word so an event without arguments still has an array
+    const uint32_t words[sizeof...(Args) + 1] = {traceWord(args)...};
+    traceWrite(Id, words, sizeof...(Args));
+}
+
+#define TRACE(id, ...)  trace<id>(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,300 @@
+/* alertJournalTests.cpp - Unit tests for the flash alert journal
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * The journal runs against the host filesystem in a fresh temporary directory per test,
+ * standing in for the Boron's flash filesystem.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "base.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../src/publishQueue.cpp"
+#include "../src/latencyStats.cpp"
+#include "../src/alertJournal.cpp"
+#include "../src/alertJournal.h"
+
+static std::string journalDir;
+
+static std::string journalFile() {
+    return journalDir + "/" + ALERT_JOURNAL_FILE_NAME;
+}
+
+static void resetJournalTest() {
+    if (!journalDir.empty()) {
+        unlink(journalFile().c_str());
+        unlink((journalDir + "/" + ALERT_JOURNAL_COMPACT_FILE_NAME).c_str());
+        rmdir(journalDir.c_str());
+    }
+    char pattern[] = "/tmp/alertJournalTestsXXXXXX";
+    REQUIRE(mkdtemp(pattern) != nullptr);
+    journalDir = pattern;
+
+    resetPublishQueue();
+    VirtualClock::set(1000);
+    Time.nowValue = 1735689600;
+    Time.valid = true;
+    Particle.isConnected = true;
+    Particle.resolvePublishes = true;
+    Particle.publishCount = 0;
+    fullPublishString = "";
+    setupAlertJournal(journalDir.c_str());
+}
+
+// Runs loop() passes until the next publish goes out, returns it as event name + data
+static String publishNext() {
+    int before = Particle.publishCount;
+    for (int i = 0; i < 10 && Particle.publishCount == before; i++) {
+        VirtualClock::advance(PUBLISH_RATE_INTERVAL);
+        serviceAlertJournal();
+        servicePublishQueue();
+    }
+    // Let the publish queue report the result back to the journal
+    servicePublishQueue();
+    return (Particle.publishCount == before) ? String("") : fullPublishString;
+}
+
+static uint32_t journalFileSize() {
+    struct stat info;
+    return (stat(journalFile().c_str(), &info) == 0) ? (uint32_t)info.st_size : 0;
+}
+
+SCENARIO("Alerts raised while offline", "[alertJournal]") {
+    GIVEN("Two alerts journalled while the cloud is unreachable") {
+        resetJournalTest();
+        Particle.isConnected = false;
+        REQUIRE(journalAlert("Stillness Alert", "{\"n\": 1}", PUBLISH_PRIORITY_ALERT));
+        Time.nowValue += 60;
+        REQUIRE(journalAlert("Door Opened", "{\"n\": 2}", PUBLISH_PRIORITY_SESSION_END));
+        REQUIRE(publishNext() == "");
+
+        THEN("Both are pending") {
+            AlertJournalStats stats = getAlertJournalStats();
+            REQUIRE(stats.pending == 2);
+            REQUIRE(stats.nextSequence == 3);
+        }
+
+        WHEN("The cloud comes back") {
+            Particle.isConnected = true;
+
+            THEN("They are published in order with their sequence, time and idempotency key") {
+                REQUIRE(publishNext() ==
+                        "Stillness Alert{\"alertSequence\":1,\"alertTime\":1735689600,\"idempotencyKey\":\"00016774858000000001\",\"n\": 1}");
+                REQUIRE(publishNext() ==
+                        "Door Opened{\"alertSequence\":2,\"alertTime\":1735689660,\"idempotencyKey\":\"0001677485BC00000002\",\"n\": 2}");
+                REQUIRE(publishNext() == "");
+                REQUIRE(getAlertJournalStats().pending == 0);
+                REQUIRE(getAlertJournalStats().lastAcknowledged == 2);
+            }
+        }
+
+        WHEN("The device resets before the cloud comes back") {
+            resetPublishQueue();
+            setupAlertJournal(journalDir.c_str());
+            Particle.isConnected = true;
+
+            THEN("The alerts are still replayed") {
+                REQUIRE(getAlertJournalStats().pending == 2);
+                REQUIRE(publishNext().startsWith("Stillness Alert{\"alertSequence\":1,"));
+                REQUIRE(publishNext().startsWith("Door Opened{\"alertSequence\":2,"));
+            }
+        }
+    }
+
+    GIVEN("An alert that leaves no room for the sequence, time and idempotency key") {
+        resetJournalTest();
+        std::string data = "{\"pad\": \"" + std::string(PUBLISH_DATA_LENGTH - 20, 'x') + "\"}";
+        REQUIRE(journalAlert("Door Opened", data.c_str(), PUBLISH_PRIORITY_SESSION_END));
+
+        THEN("It is still published, as it was raised") {
+            REQUIRE(publishNext() == String(("Door Opened" + data).c_str()));
+            REQUIRE(getAlertJournalStats().pending == 0);
+        }
+    }
+
+    GIVEN("An alert that was published and acknowledged") {
+        resetJournalTest();
+        journalAlert("Stillness Alert", "{\"n\": 1}", PUBLISH_PRIORITY_ALERT);
+        REQUIRE(publishNext().startsWith("Stillness Alert"));
+
+        WHEN("The device resets") {
+            resetPublishQueue();
+            setupAlertJournal(journalDir.c_str());
+
+            THEN("It is not published again and the sequence carries on") {
+                REQUIRE(getAlertJournalStats().pending == 0);
+                REQUIRE(publishNext() == "");
+                journalAlert("Duration Alert", "{\"n\": 2}", PUBLISH_PRIORITY_ALERT);
+                REQUIRE(publishNext().startsWith("Duration Alert{\"alertSequence\":2,"));
+            }
+        }
+    }
+
+    GIVEN("An alert whose publish went out but was not acknowledged before a reset") {
+        resetJournalTest();
+        Particle.resolvePublishes = false;
+        journalAlert("Stillness Alert", "{\"n\": 1}", PUBLISH_PRIORITY_ALERT);
+        String first = publishNext();
+
+        WHEN("The device resets and replays it") {
+            Particle.resolvePublishes = true;
+            resetPublishQueue();
+            setupAlertJournal(journalDir.c_str());
+
+            THEN("The replay carries the same idempotency key") {
+                REQUIRE(first != "");
+                REQUIRE(publishNext() == first);
+            }
+        }
+    }
+
+    GIVEN("The wall clock has not been synced yet") {
+        resetJournalTest();
+        Time.valid = false;
+        journalAlert("Stillness Alert", "{\"n\": 1}", PUBLISH_PRIORITY_ALERT);
+
+        THEN("The alert time is 0") {
+            REQUIRE(publishNext().startsWith("Stillness Alert{\"alertSequence\":1,\"alertTime\":0,"));
+        }
+    }
+}
+
+SCENARIO("Damaged alert journal", "[alertJournal]") {
+    GIVEN("A journal whose last record was cut short") {
+        resetJournalTest();
+        Particle.isConnected = false;
+        journalAlert("Stillness Alert", "{\"n\": 1}", PUBLISH_PRIORITY_ALERT);
+        journalAlert("Duration Alert", "{\"n\": 2}", PUBLISH_PRIORITY_ALERT);
+        uint32_t goodSize = journalFileSize();
+        REQUIRE(truncate(journalFile().c_str(), goodSize - 5) == 0);
+
+        WHEN("It is scanned at startup") {
+            setupAlertJournal(journalDir.c_str());
+
+            THEN("The damaged record is dropped and the rest is kept") {
+                AlertJournalStats stats = getAlertJournalStats();
+                REQUIRE(stats.pending == 1);
+                REQUIRE(stats.nextSequence == 2);
+                REQUIRE(stats.truncatedBytes > 0);
+                REQUIRE(journalFileSize() == stats.fileSize);
+            }
+        }
+    }
+
+    GIVEN("A journal with a flipped bit in the last record") {
+        resetJournalTest();
+        Particle.isConnected = false;
+        journalAlert("Stillness Alert", "{\"n\": 1}", PUBLISH_PRIORITY_ALERT);
+        journalAlert("Duration Alert", "{\"n\": 2}", PUBLISH_PRIORITY_ALERT);
+
+        int fd = open(journalFile().c_str(), O_RDWR);
+        uint8_t last;
+        lseek(fd, -1, SEEK_END);
+        read(fd, &last, 1);
+        last ^= 0x01;
+        lseek(fd, -1, SEEK_END);
+        write(fd, &last, 1);
+        close(fd);
+
+        WHEN("It is scanned at startup") {
+            setupAlertJournal(journalDir.c_str());
+            Particle.isConnected = true;
+
+            THEN("Only the intact alert is replayed") {
+                REQUIRE(getAlertJournalStats().pending == 1);
+                REQUIRE(publishNext().startsWith("Stillness Alert"));
+                REQUIRE(publishNext() == "");
+            }
+        }
+    }
+}
+
+SCENARIO("Alert journal compaction", "[alertJournal]") {
+    GIVEN("Enough acknowledged alerts to pass the compaction size") {
+        resetJournalTest();
+        uint32_t alerts = 0;
+        while (getAlertJournalStats().fileSize < ALERT_JOURNAL_COMPACT_SIZE - 100) {
+            journalAlert("Stillness Alert", "{\"n\": 1}", PUBLISH_PRIORITY_ALERT);
+            REQUIRE(publishNext() != "");
+            alerts++;
+        }
+        journalAlert("Stillness Alert", "{\"n\": 1}", PUBLISH_PRIORITY_ALERT);
+        REQUIRE(publishNext() != "");
+        alerts++;
+
+        THEN("The file starts over and the sequence carries on across a reset") {
+            REQUIRE(journalFileSize() == sizeof(AlertRecordHeader));
+            setupAlertJournal(journalDir.c_str());
+            REQUIRE(getAlertJournalStats().nextSequence == alerts + 1);
+            REQUIRE(getAlertJournalStats().pending == 0);
+        }
+
+        WHEN("A reset cuts short the next compaction before the new file replaces the journal") {
+            uint32_t sizeBefore = journalFileSize();
+            std::string compactFile = journalDir + "/" + ALERT_JOURNAL_COMPACT_FILE_NAME;
+            FILE* partial = fopen(compactFile.c_str(), "wb");
+            REQUIRE(partial != nullptr);
+            fputs("cut short", partial);
+            fclose(partial);
+            setupAlertJournal(journalDir.c_str());
+
+            THEN("The journal is kept as it was and the new file is removed") {
+                REQUIRE(journalFileSize() == sizeBefore);
+                REQUIRE(getAlertJournalStats().nextSequence == alerts + 1);
+                REQUIRE(access(compactFile.c_str(), F_OK) != 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Alert journal unavailable", "[alertJournal]") {
+    GIVEN("A directory that cannot be created") {
+        resetJournalTest();
+        setupAlertJournal("/proc/alertJournalTests");
+
+        THEN("Alerts are still published, straight from the publish queue") {
+            REQUIRE_FALSE(getAlertJournalStats().available);
+            REQUIRE(journalAlert("Stillness Alert", "{\"n\": 1}", PUBLISH_PRIORITY_ALERT));
+            REQUIRE(publishNext() == "Stillness Alert{\"n\": 1}");
+        }
+    }
+}
+
+SCENARIO("Journalled alert format", "[alertJournal]") {
+    char out[PUBLISH_DATA_LENGTH + 1];
+
+    GIVEN("An empty JSON object") {
+        THEN("Only the added fields are in it") {
+            REQUIRE(formatJournalledAlert(out, sizeof(out), "{}", 3, 7, 16));
+            REQUIRE(String(out) == "{\"alertSequence\":7,\"alertTime\":16,\"idempotencyKey\":\"00030000001000000007\"}");
+        }
+
+        THEN("The same sequence and time in another boot has another key") {
+            char other[PUBLISH_DATA_LENGTH + 1];
+            REQUIRE(formatJournalledAlert(other, sizeof(other), "{}", 4, 7, 16));
+            REQUIRE(String(other) != String(out));
+        }
+    }
+
+    GIVEN("Data that is not a JSON object") {
+        THEN("It is not changed") {
+            REQUIRE_FALSE(formatJournalledAlert(out, sizeof(out), "stillness alert", 3, 7, 16));
+        }
+    }
+
+    GIVEN("Data that leaves no room for the added fields") {
+        std::string data = "{\"pad\": \"" + std::string(PUBLISH_DATA_LENGTH - 20, 'x') + "\"}";
+
+        THEN("It is not changed") {
+            REQUIRE_FALSE(formatJournalledAlert(out, sizeof(out), data.c_str(), 3, 7, 16));
+        }
+    }
+
+    GIVEN("The standard CRC-32 check input") {
+        THEN("The CRC matches the published check value") {
+            REQUIRE(alertJournalCrc32(0, (const uint8_t*)"123456789", 9) == 0xCBF43926);
+        }
+    }
+}
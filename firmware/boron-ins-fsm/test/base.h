@@ -3,6 +3,9 @@
  * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
  */
 
+// Firmware timing reads the steppable host clock instead of real time
+#define BRAVE_VIRTUAL_CLOCK
+
 #include "catch.hpp"
 #include <cstdarg>
 #include <cstring>
@@ -16,6 +19,7 @@
 #include "mocks/mock_ble.h"
 #include "mocks/mock_logging.h"
 #include "mocks/mock_ticks.h"
+#include "mocks/mock_time.h"
 
 #include "mocks/mock_stateMachine.h" 
 #include "mocks/mock_imDoorSensor.h" 
@@ -34,3 +38,4 @@ MockParticle Particle;
 MockSystem System;
 MockLogger Log;
 MockBLE BLE;
+MockTime Time;
@@ -0,0 +1,55 @@
+/* benchmark.h - Minimal timing helpers for host micro-benchmarks
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Host numbers are only useful relative to each other: the Boron's Cortex-M4 has no
+ * branch predictor or cache worth mentioning, so compare kernels here and confirm the
+ * absolute cost on device.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCHMARK_HAS_CYCLE_COUNTER 1
+#endif
+
+// Keeps the optimizer from discarding results we never otherwise read
+static volatile int64_t benchmarkSink;
+
+struct BenchmarkResult {
+    double nanosPerIteration;
+    double cyclesPerIteration;  // 0 when the host has no cycle counter
+};
+
+// Times iterations calls of body(i), after a short warm-up, and prints one result row
+template <typename Body>
+BenchmarkResult runBenchmark(const char* name, uint64_t iterations, Body body) {
+    for (uint64_t i = 0; i < iterations / 10; i++) {
+        body(i);
+    }
+
+#ifdef BENCHMARK_HAS_CYCLE_COUNTER
+    uint64_t startCycles = __rdtsc();
+#endif
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        body(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    BenchmarkResult result;
+    result.nanosPerIteration = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+#ifdef BENCHMARK_HAS_CYCLE_COUNTER
+    result.cyclesPerIteration = (double)(__rdtsc() - startCycles) / iterations;
+#else
+    result.cyclesPerIteration = 0;
+#endif
+
+    printf("  %-40s %10.2f ns %10.1f cycles\n", name, result.nanosPerIteration, result.cyclesPerIteration);
+    return result;
+}
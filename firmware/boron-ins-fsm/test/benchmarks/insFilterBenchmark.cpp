@@ -0,0 +1,68 @@
+/* insFilterBenchmark.cpp - Per-sample cost of the INS filter chain
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Compares the float moving average/magnitude stage with the INS_FIXED_POINT one, then
+ * times the whole InsFilter for a few window sizes, e.g. to size a parameter sweep.
+ */
+
+#include "../base.h"
+#include "benchmark.h"
+#include "../../src/insFilter.h"
+#include "../../src/insMovingAverage.cpp"
+
+#define BENCHMARK_ITERATIONS 10000000
+#define SAMPLE_COUNT         4096  // Power of two so the sample index is a mask
+
+static int16_t iSamples[SAMPLE_COUNT], qSamples[SAMPLE_COUNT];
+static rawINSData rawSamples[SAMPLE_COUNT];
+
+template <size_t MedianN, size_t MaN, size_t QuartileN>
+static void benchmarkInsFilter() {
+    InsFilter<MedianN, MaN, QuartileN> filter;
+    char name[64];
+    snprintf(name, sizeof(name), "median %zu, average %zu, quartiles %zu", MedianN, MaN, QuartileN);
+    runBenchmark(name, BENCHMARK_ITERATIONS, [&](uint64_t n) {
+        filter.push(rawSamples[n & (SAMPLE_COUNT - 1)], 0);
+        benchmarkSink = (int64_t)filter.value().magnitude;
+    });
+}
+
+int main() {
+    srand(42);
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        iSamples[i] = (int16_t)(rand() % 400);
+        qSamples[i] = (int16_t)(rand() % 400);
+
+        // Radar samples are signed and the occasional one is a spike for the outlier rejection
+        int16_t spike = (rand() % 64 == 0) ? 3000 : 0;
+        rawSamples[i] = {(int16_t)(rand() % 400 - 200 + spike), (int16_t)(rand() % 400 - 200)};
+    }
+
+    printf("Moving average of %d medians, per I/Q sample\n", MOVING_AVERAGE_SAMPLE_SIZE);
+
+    {
+        FloatMovingAverage<MOVING_AVERAGE_SAMPLE_SIZE> stage;
+        filteredINSData output = {};
+        runBenchmark("float sums + sqrtf", BENCHMARK_ITERATIONS, [&](uint64_t n) {
+            stage.push(iSamples[n & (SAMPLE_COUNT - 1)], qSamples[n & (SAMPLE_COUNT - 1)], output);
+            benchmarkSink = (int64_t)output.magnitude;
+        });
+    }
+
+    {
+        FixedPointMovingAverage<MOVING_AVERAGE_SAMPLE_SIZE> stage;
+        filteredINSData output = {};
+        runBenchmark("int32 sums + isqrt64 (INS_FIXED_POINT)", BENCHMARK_ITERATIONS, [&](uint64_t n) {
+            stage.push(iSamples[n & (SAMPLE_COUNT - 1)], qSamples[n & (SAMPLE_COUNT - 1)], output);
+            benchmarkSink = output.magnitudeQ;
+        });
+    }
+
+    printf("InsFilter, per raw I/Q sample\n");
+    benchmarkInsFilter<MEDIAN_FILTER_SIZE, MOVING_AVERAGE_SAMPLE_SIZE, QUARTILE_BUFFER_SIZE>();
+    benchmarkInsFilter<3, 10, 50>();
+    benchmarkInsFilter<7, 40, 100>();
+
+    return 0;
+}
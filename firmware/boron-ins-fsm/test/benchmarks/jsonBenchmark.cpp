@@ -0,0 +1,97 @@
+/* jsonBenchmark.cpp - Cost of building the debug, transition and door payloads
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Each payload is built once with the snprintf formats the firmware used before the JSON
+ * writer and once with writeJson(). The %f in the debug payloads is most of the difference
+ * on the Boron too, where newlib formats floats through its heap backed dtoa.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "../../src/jsonWriter.cpp"
+
+#define BENCHMARK_ITERATIONS 2000000
+#define SAMPLE_COUNT         4096  // Power of two so the sample index is a mask
+
+static constexpr JsonField stateTransitionFields[] = {
+    {"prev_state", JSON_INT, JSON_QUOTED},
+    {"next_state", JSON_INT, JSON_QUOTED},
+    {"door_status", JSON_HEX8_0X},
+    {"INS_val", JSON_FIXED, JSON_QUOTED, 6},
+};
+
+static constexpr JsonField debugMessageFields[] = {
+    {"state", JSON_INT, JSON_QUOTED},
+    {"door_status", JSON_HEX8_0X},
+    {"time_in_curr_state", JSON_UINT, JSON_QUOTED},
+    {"INS_val", JSON_FIXED, JSON_QUOTED, 6},
+    {"occupancy_detection_INS", JSON_UINT, JSON_QUOTED},
+    {"stillness_INS", JSON_UINT, JSON_QUOTED},
+    {"occupancy_detection_timer", JSON_UINT, JSON_QUOTED},
+    {"initial_timer", JSON_UINT, JSON_QUOTED},
+    {"duration_alert_time", JSON_UINT, JSON_QUOTED},
+    {"stillness_alert_time", JSON_UINT, JSON_QUOTED},
+};
+
+static constexpr JsonField doorDataFields[] = {
+    {"deviceid", JSON_HEX24},
+    {"data", JSON_HEX8},
+    {"control", JSON_HEX8},
+};
+
+static float insSamples[SAMPLE_COUNT];
+static uint8_t doorSamples[SAMPLE_COUNT];
+
+int main() {
+    srand(42);
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        insSamples[i] = (float)(rand() % 100000) / 37.0f;
+        doorSamples[i] = (uint8_t)rand();
+    }
+
+    printf("State Transition\n");
+    runBenchmark("snprintf (previous)", BENCHMARK_ITERATIONS, [](uint64_t n) {
+        char message[PARTICLE_MAX_MESSAGE_LENGTH];
+        benchmarkSink = snprintf(message, sizeof(message), "{\"prev_state\":\"%d\", \"next_state\":\"%d\", \"door_status\":\"0x%02X\", \"INS_val\":\"%f\" }",
+                                 (int)(n & 3), (int)((n + 1) & 3), doorSamples[n & (SAMPLE_COUNT - 1)], insSamples[n & (SAMPLE_COUNT - 1)]);
+    });
+    runBenchmark("writeJson", BENCHMARK_ITERATIONS, [](uint64_t n) {
+        char message[jsonMaxLength(stateTransitionFields) + 1];
+        benchmarkSink = writeJson<stateTransitionFields>(message, (int)(n & 3), (int)((n + 1) & 3), doorSamples[n & (SAMPLE_COUNT - 1)],
+                                                         insSamples[n & (SAMPLE_COUNT - 1)]);
+    });
+
+    printf("\nDebug Message\n");
+    runBenchmark("snprintf (previous)", BENCHMARK_ITERATIONS, [](uint64_t n) {
+        char message[PARTICLE_MAX_MESSAGE_LENGTH];
+        benchmarkSink = snprintf(message, sizeof(message),
+                                 "{\"state\":\"%d\", \"door_status\":\"0x%02X\", \"time_in_curr_state\":\"%lu\", \"INS_val\":\"%f\", "
+                                 "\"occupancy_detection_INS\":\"%lu\", \"stillness_INS\":\"%lu\", \"occupancy_detection_timer\":\"%lu\", "
+                                 "\"initial_timer\":\"%lu\", \"duration_alert_time\":\"%lu\", \"stillness_alert_time\":\"%lu\" }",
+                                 (int)(n & 3), doorSamples[n & (SAMPLE_COUNT - 1)], (unsigned long)n, insSamples[n & (SAMPLE_COUNT - 1)], 60ul, 10ul,
+                                 15000ul, 15000ul, 1200000ul, 300000ul);
+    });
+    runBenchmark("writeJson", BENCHMARK_ITERATIONS, [](uint64_t n) {
+        char message[jsonMaxLength(debugMessageFields) + 1];
+        benchmarkSink = writeJson<debugMessageFields>(message, (int)(n & 3), doorSamples[n & (SAMPLE_COUNT - 1)], (unsigned long)n,
+                                                      insSamples[n & (SAMPLE_COUNT - 1)], 60ul, 10ul, 15000ul, 15000ul, 1200000ul, 300000ul);
+    });
+
+    printf("\nIM Door Sensor Data\n");
+    runBenchmark("sprintf (previous)", BENCHMARK_ITERATIONS, [](uint64_t n) {
+        char message[128];
+        benchmarkSink = sprintf(message, "{ \"deviceid\": \"%02X:%02X:%02X\", \"data\": \"%02X\", \"control\": \"%02X\" }", 0xAA, 0xBB, 0xCC,
+                                doorSamples[n & (SAMPLE_COUNT - 1)], (unsigned)(n & 0xFF));
+    });
+    runBenchmark("writeJson", BENCHMARK_ITERATIONS, [](uint64_t n) {
+        char message[jsonMaxLength(doorDataFields) + 1];
+        benchmarkSink = writeJson<doorDataFields>(message, (uint32_t)0xAABBCC, doorSamples[n & (SAMPLE_COUNT - 1)], (uint8_t)n);
+    });
+
+    printf("\nLongest payloads: State Transition %zu, Debug Message %zu, IM Door Sensor Data %zu bytes\n", jsonMaxLength(stateTransitionFields),
+           jsonMaxLength(debugMessageFields), jsonMaxLength(doorDataFields));
+    return 0;
+}
@@ -0,0 +1,91 @@
+/* medianBenchmark.cpp - Per-sample cost of the INS median filter kernels
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Each iteration pushes one I/Q sample and takes both medians, which is what the
+ * filter chain does per radar frame.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "../../src/medianNetwork.h"
+#include "../../src/orderStatistics.h"
+
+#define BENCHMARK_ITERATIONS 5000000
+#define SAMPLE_COUNT         4096  // Power of two so the sample index is a mask
+
+static int16_t iSamples[SAMPLE_COUNT], qSamples[SAMPLE_COUNT];
+
+// The median stage before the selection network: copy each window and bubble sort it
+template <size_t N>
+static int16_t bubbleSortMedian(const CircularBuffer<int16_t, N>& buffer) {
+    int16_t sorted[N];
+    for (size_t i = 0; i < N; i++) {
+        sorted[i] = buffer[i];
+    }
+    for (size_t i = 0; i < N - 1; i++) {
+        for (size_t j = 0; j < N - i - 1; j++) {
+            if (sorted[j] > sorted[j + 1]) {
+                int16_t temp = sorted[j];
+                sorted[j] = sorted[j + 1];
+                sorted[j + 1] = temp;
+            }
+        }
+    }
+    return sorted[N / 2];
+}
+
+template <size_t N>
+static void benchmarkWindow() {
+    printf("Median window of %zu samples (%zu compare-exchanges in the network)\n", N, MedianNetwork<N>::comparators.size());
+
+    {
+        CircularBuffer<int16_t, N> iBuffer, qBuffer;
+        runBenchmark("bubble sort copy (previous)", BENCHMARK_ITERATIONS, [&](uint64_t n) {
+            iBuffer.push(iSamples[n & (SAMPLE_COUNT - 1)]);
+            qBuffer.push(qSamples[n & (SAMPLE_COUNT - 1)]);
+            benchmarkSink = bubbleSortMedian(iBuffer) + bubbleSortMedian(qBuffer);
+        });
+    }
+
+    {
+        SortedWindow<int16_t, N> iWindow, qWindow;
+        runBenchmark("sorted sliding window", BENCHMARK_ITERATIONS, [&](uint64_t n) {
+            iWindow.push(iSamples[n & (SAMPLE_COUNT - 1)]);
+            qWindow.push(qSamples[n & (SAMPLE_COUNT - 1)]);
+            benchmarkSink = iWindow.median() + qWindow.median();
+        });
+    }
+
+    {
+        CircularBuffer<int16_t, N> iBuffer, qBuffer;
+        runBenchmark("selection network, I/Q paired", BENCHMARK_ITERATIONS, [&](uint64_t n) {
+            iBuffer.push(iSamples[n & (SAMPLE_COUNT - 1)]);
+            qBuffer.push(qSamples[n & (SAMPLE_COUNT - 1)]);
+            int16_t iWindow[N], qWindow[N];
+            for (size_t i = 0; i < N; i++) {
+                iWindow[i] = iBuffer[i];
+                qWindow[i] = qBuffer[i];
+            }
+            int16_t iMedian, qMedian;
+            MedianNetwork<N>::medianPair(iWindow, qWindow, iMedian, qMedian);
+            benchmarkSink = iMedian + qMedian;
+        });
+    }
+    printf("\n");
+}
+
+int main() {
+    srand(42);
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        iSamples[i] = (int16_t)(rand() % 200);
+        qSamples[i] = (int16_t)(rand() % 200);
+    }
+
+    benchmarkWindow<5>();
+    benchmarkWindow<9>();
+    benchmarkWindow<15>();
+    return 0;
+}
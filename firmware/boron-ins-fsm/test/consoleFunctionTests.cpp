@@ -6,10 +6,67 @@
 #define CATCH_CONFIG_MAIN
 #include "base.h"
 #include "../src/consoleFunctions.cpp"
+#include "../src/latencyStats.cpp"
 #include "../src/consoleFunctions.h"
 #include "../src/flashAddresses.h"
 #include "../src/stateMachine.h"
 #include "../src/imDoorSensor.h"
+#include "../src/deadlineScheduler.cpp"
+#include "../src/stateMachineCore.cpp"
+#include "../src/jsonWriter.cpp"
+#include "mocks/mock_stateMachineIO.h"
+
+// Short alert times so a session with alerts takes 30 simulated seconds
+#define TEST_DURATION_ALERT_TIME    10000
+#define TEST_STILLNESS_ALERT_TIME   20000
+
+#define MOVING_MAGNITUDE            100.0f
+#define STILL_MAGNITUDE             10.0f
+
+// What the state machine reads on its next tick. It runs on the virtual clock, which the
+// console functions read too.
+static TestSensor testSensor;
+
+static StateMachineIO makeConsoleTestIO() {
+    StateMachineIO io = makeTestIO(&testSensor);
+    io.now = testClockNow;
+    return io;
+}
+
+StateMachine stateMachine(makeConsoleTestIO(), defaultStateMachineConfig);
+
+// Ticks the state machine once a second for ms with the door closed
+static void runTestSession(unsigned long ms, float magnitude) {
+    testSensor.inputs.insMagnitude = magnitude;
+    for (unsigned long elapsed = 0; elapsed < ms; elapsed += 1000) {
+        stateMachine.tick();
+        VirtualClock::advance(1000);
+    }
+}
+
+// The door closes and there is movement until the state machine is in state 2
+static void startTestSession() {
+    VirtualClock::set(1000);
+    stateMachine.reset();
+    stateMachine.config() = defaultStateMachineConfig;
+    stateMachine.config().duration_alert_time = TEST_DURATION_ALERT_TIME;
+    stateMachine.config().stillness_alert_time = TEST_STILLNESS_ALERT_TIME;
+
+    testSensor.inputs = {CLOSED, false, false, true, MOVING_MAGNITUDE};
+    runTestSession(5000, MOVING_MAGNITUDE);
+    REQUIRE(stateMachine.currentState() == STATE_MONITORING);
+}
+
+static void requireMonitoringUnchanged(const StateMachineStatus& before) {
+    const StateMachineStatus& status = stateMachine.status();
+    REQUIRE(stateMachine.currentState() == before.currentState);
+    REQUIRE(status.numDurationAlertSent == before.numDurationAlertSent);
+    REQUIRE(status.timeSinceLastDurationAlert == before.timeSinceLastDurationAlert);
+    REQUIRE(status.numStillnessAlertSent == before.numStillnessAlertSent);
+    REQUIRE(status.state3_start_time == before.state3_start_time);
+    REQUIRE(status.isStillnessAlertActive == before.isStillnessAlertActive);
+}
+
 
 SCENARIO("Force_Reset", "[force reset]") {
     GIVEN("Any possible scenario") {
@@ -38,94 +95,91 @@ SCENARIO("Force_Reset", "[force reset]") {
 }
 
 SCENARIO("Reset State to Zero", "[reset state to zero]") {
-    GIVEN("The state handler is set to a non-zero state with various state variables set") {
-        // Set initial state
-        stateHandler = state1_initial_countdown;
-        
-        // Set state timers
-        state0_start_time = 1000;
-        state1_start_time = 2000;
-        state2_start_time = 3000;
-        state3_start_time = 4000;
-        
-        // Set time in states
-        timeInState0 = 100;
-        timeInState1 = 200;
-        timeInState2 = 300;
-        timeInState3 = 400;
-        
-        // Set alert variables
-        numDurationAlertSent = 2;
-        lastDurationAlertTime = 5000;
-        timeSinceLastDurationAlert = 1000;
-        isDurationAlertThresholdExceeded = true;
-        
-        numStillnessAlertSent = 1;
-        isStillnessAlertActive = false;
-        isStillnessAlertThresholdExceeded = true;
-        
+    GIVEN("A session in state 3 that has sent duration and stillness alerts") {
+        startTestSession();
+        runTestSession(30000, STILL_MAGNITUDE);
+        REQUIRE(stateMachine.currentState() == STATE_STILLNESS);
+        REQUIRE(stateMachine.status().numDurationAlertSent == 2);
+        REQUIRE(stateMachine.status().numStillnessAlertSent == 1);
+
         // Set door-related variables
-        timeWhenDoorClosed = 6000;
-        timeSinceDoorClosed = 500;
         doorMessageReceivedFlag = true;
         consecutiveOpenDoorHeartbeatCount = 3;
-        allowTransitionToStateOne = true;
+
+        // Just under a second before millis() rolls over
+        VirtualClock::set(0xFFFFFC18);
 
         WHEN("the function is called with '1'") {
             int returnFlag = reset_state_to_zero("1");
+            const StateMachineStatus& status = stateMachine.status();
 
             THEN("the function should return 1 to indicate success") {
                 REQUIRE(returnFlag == 1);
             }
 
-            THEN("the state handler should be reset to state0_idle") {
-                REQUIRE(stateHandler == state0_idle);
+            THEN("the state machine should be reset to state 0") {
+                REQUIRE(stateMachine.currentState() == STATE_IDLE);
             }
 
             THEN("all state timers should be reset to 0") {
-                REQUIRE(state0_start_time == 0);
-                REQUIRE(state1_start_time == 0);
-                REQUIRE(state2_start_time == 0);
-                REQUIRE(state3_start_time == 0);
+                REQUIRE(status.state0_start_time == 0);
+                REQUIRE(status.state1_start_time == 0);
+                REQUIRE(status.state2_start_time == 0);
+                REQUIRE(status.state3_start_time == 0);
             }
 
             THEN("all time in states should be reset to 0") {
-                REQUIRE(timeInState0 == 0);
-                REQUIRE(timeInState1 == 0);
-                REQUIRE(timeInState2 == 0);
-                REQUIRE(timeInState3 == 0);
+                REQUIRE(status.timeInState0 == 0);
+                REQUIRE(status.timeInState1 == 0);
+                REQUIRE(status.timeInState2 == 0);
+                REQUIRE(status.timeInState3 == 0);
             }
 
             THEN("duration alert variables should be reset") {
-                REQUIRE(numDurationAlertSent == 0);
-                REQUIRE(lastDurationAlertTime == 0);
-                REQUIRE(timeSinceLastDurationAlert == 0);
-                REQUIRE(isDurationAlertThresholdExceeded == false);
+                REQUIRE(status.numDurationAlertSent == 0);
+                REQUIRE(status.lastDurationAlertTime == 0);
+                REQUIRE(status.timeSinceLastDurationAlert == 0);
+                REQUIRE(status.isDurationAlertThresholdExceeded == false);
             }
 
             THEN("stillness alert variables should be reset") {
-                REQUIRE(numStillnessAlertSent == 0);
-                REQUIRE(isStillnessAlertActive == true);
-                REQUIRE(isStillnessAlertThresholdExceeded == false);
+                REQUIRE(status.numStillnessAlertSent == 0);
+                REQUIRE(status.isStillnessAlertActive == true);
+                REQUIRE(status.isStillnessAlertThresholdExceeded == false);
             }
 
             THEN("door monitoring variables should be reset") {
                 REQUIRE(doorMessageReceivedFlag == false);
                 REQUIRE(consecutiveOpenDoorHeartbeatCount == 0);
-                REQUIRE(allowTransitionToStateOne == false);
+                REQUIRE(status.allowTransitionToStateOne == false);
             }
 
             THEN("door timing should be updated") {
-                REQUIRE(timeSinceDoorClosed == 0);
-                REQUIRE(timeWhenDoorClosed != 6000); // Should be updated to current millis
+                REQUIRE(status.timeSinceDoorClosed == 0);
+                REQUIRE(status.timeWhenDoorClosed == 0xFFFFFC18);
+            }
+
+            THEN("the time since the door closed is measured correctly across the millis() rollover") {
+                VirtualClock::advance(2000);
+                REQUIRE(clockMillis() == 1000);
+                REQUIRE(clockMillisSince(status.timeWhenDoorClosed) == 2000);
+            }
+
+            THEN("state 1 is not entered again until the door closes") {
+                runTestSession(5000, MOVING_MAGNITUDE);
+                REQUIRE(stateMachine.currentState() == STATE_IDLE);
+
+                testSensor.inputs.isDoorClosedEvent = true;
+                runTestSession(1000, MOVING_MAGNITUDE);
+                REQUIRE(stateMachine.currentState() == STATE_INITIAL_COUNTDOWN);
             }
         }
     }
 
     GIVEN("Invalid inputs") {
-        stateHandler = state1_initial_countdown;
-        timeInState0 = 100;
+        startTestSession();
         doorMessageReceivedFlag = true;
+        StateMachineStatus before = stateMachine.status();
 
         WHEN("the function is called with a string longer than 1 character") {
             int returnFlag = reset_state_to_zero("invalid");
@@ -135,8 +189,9 @@ SCENARIO("Reset State to Zero", "[reset state to zero]") {
             }
 
             THEN("state variables should not be changed") {
-                REQUIRE(stateHandler == state1_initial_countdown);
-                REQUIRE(timeInState0 == 100);
+                REQUIRE(stateMachine.currentState() == STATE_MONITORING);
+                REQUIRE(stateMachine.status().state2_start_time == before.state2_start_time);
+                REQUIRE(stateMachine.status().timeWhenDoorClosed == before.timeWhenDoorClosed);
                 REQUIRE(doorMessageReceivedFlag == true);
             }
         }
@@ -149,8 +204,9 @@ SCENARIO("Reset State to Zero", "[reset state to zero]") {
             }
 
             THEN("state variables should not be changed") {
-                REQUIRE(stateHandler == state1_initial_countdown);
-                REQUIRE(timeInState0 == 100);
+                REQUIRE(stateMachine.currentState() == STATE_MONITORING);
+                REQUIRE(stateMachine.status().state2_start_time == before.state2_start_time);
+                REQUIRE(stateMachine.status().timeWhenDoorClosed == before.timeWhenDoorClosed);
                 REQUIRE(doorMessageReceivedFlag == true);
             }
         }
@@ -256,71 +312,67 @@ SCENARIO("Turn_Debugging_Publishes_On_Off", "[toggle debug flag]") {
 }
 
 SCENARIO("Reset Monitoring", "[reset monitoring]") {
-    GIVEN("The state handler is set to state2_monitoring with active alerts") {
-        // Set initial state
-        stateHandler = state2_monitoring;
-        
-        // Set monitoring variables
-        numDurationAlertSent = 2;
-        timeSinceLastDurationAlert = 1000;
-        numStillnessAlertSent = 3;
-        state3_start_time = 4000;
-        isStillnessAlertActive = false;
+    GIVEN("The state machine is in state 2 after duration and stillness alerts") {
+        startTestSession();
+        runTestSession(30000, STILL_MAGNITUDE);
+        runTestSession(1000, MOVING_MAGNITUDE);
+        REQUIRE(stateMachine.currentState() == STATE_MONITORING);
+        REQUIRE(stateMachine.status().isStillnessAlertActive == false);
 
         WHEN("the function is called with '1'") {
             int returnFlag = reset_monitoring("1");
+            const StateMachineStatus& status = stateMachine.status();
 
             THEN("the function should return 1 to indicate success") {
                 REQUIRE(returnFlag == 1);
             }
 
             THEN("monitoring variables should be reset") {
-                REQUIRE(numDurationAlertSent == 0);
-                REQUIRE(timeSinceLastDurationAlert == 0);
-                REQUIRE(numStillnessAlertSent == 0);
-                REQUIRE(isStillnessAlertActive == true);
-                REQUIRE(state3_start_time != 4000); // Should be updated to current millis
+                REQUIRE(status.numDurationAlertSent == 0);
+                REQUIRE(status.timeSinceLastDurationAlert == 0);
+                REQUIRE(status.numStillnessAlertSent == 0);
+                REQUIRE(status.isStillnessAlertActive == true);
+                REQUIRE(status.state3_start_time == clockMillis());
             }
         }
     }
 
-    GIVEN("The state handler is set to state3_stillness with active alerts") {
-        // Set initial state
-        stateHandler = state3_stillness;
-        
-        // Set monitoring variables
-        numDurationAlertSent = 2;
-        timeSinceLastDurationAlert = 1000;
-        numStillnessAlertSent = 3;
-        state3_start_time = 4000;
-        isStillnessAlertActive = false;
+    GIVEN("The state machine is in state 3 after duration and stillness alerts") {
+        startTestSession();
+        runTestSession(30000, STILL_MAGNITUDE);
+        REQUIRE(stateMachine.currentState() == STATE_STILLNESS);
+        REQUIRE(stateMachine.status().isStillnessAlertActive == false);
 
         WHEN("the function is called with '1'") {
             int returnFlag = reset_monitoring("1");
+            const StateMachineStatus& status = stateMachine.status();
 
             THEN("the function should return 1 to indicate success") {
                 REQUIRE(returnFlag == 1);
             }
 
             THEN("monitoring variables should be reset") {
-                REQUIRE(numDurationAlertSent == 0);
-                REQUIRE(timeSinceLastDurationAlert == 0);
-                REQUIRE(numStillnessAlertSent == 0);
-                REQUIRE(isStillnessAlertActive == true);
-                REQUIRE(state3_start_time != 4000); // Should be updated to current millis
+                REQUIRE(status.numDurationAlertSent == 0);
+                REQUIRE(status.timeSinceLastDurationAlert == 0);
+                REQUIRE(status.numStillnessAlertSent == 0);
+                REQUIRE(status.isStillnessAlertActive == true);
+                REQUIRE(status.state3_start_time == clockMillis());
+            }
+
+            THEN("the stillness alert is sent again after the stillness alert time") {
+                runTestSession(TEST_STILLNESS_ALERT_TIME + 1000, STILL_MAGNITUDE);
+                REQUIRE(stateMachine.status().numStillnessAlertSent == 1);
             }
         }
     }
 
-    GIVEN("The state handler is set to a state other than 2 or 3") {
-        stateHandler = state1_initial_countdown;
-
-        // Set monitoring variables that shouldn't be reset
-        numDurationAlertSent = 2;
-        numStillnessAlertSent = 3;
-        timeSinceLastDurationAlert = 1000;
-        state3_start_time = 4000;
-        isStillnessAlertActive = false;
+    GIVEN("The state machine is in a state other than 2 or 3") {
+        startTestSession();
+        runTestSession(30000, STILL_MAGNITUDE);
+        testSensor.inputs.isDoorOpen = true;
+        runTestSession(1000, STILL_MAGNITUDE);
+        REQUIRE(stateMachine.currentState() == STATE_IDLE);
+        StateMachineStatus before = stateMachine.status();
 
         WHEN("the function is called with '1'") {
             int returnFlag = reset_monitoring("1");
@@ -330,24 +382,15 @@ SCENARIO("Reset Monitoring", "[reset monitoring]") {
             }
 
             THEN("monitoring variables should not be changed") {
-                REQUIRE(numDurationAlertSent == 2);
-                REQUIRE(timeSinceLastDurationAlert == 1000);
-                REQUIRE(numStillnessAlertSent == 3);
-                REQUIRE(state3_start_time == 4000);
-                REQUIRE(isStillnessAlertActive == false);
+                requireMonitoringUnchanged(before);
             }
         }
     }
 
     GIVEN("Invalid inputs") {
-        stateHandler = state2_monitoring;
-        
-        // Set monitoring variables that shouldn't be reset
-        numDurationAlertSent = 2;
-        numStillnessAlertSent = 3;
-        timeSinceLastDurationAlert = 1000;
-        state3_start_time = 4000;
-        isStillnessAlertActive = false;
+        startTestSession();
+        runTestSession(30000, STILL_MAGNITUDE);
+        StateMachineStatus before = stateMachine.status();
 
         WHEN("the function is called with a string longer than 1 character") {
             int returnFlag = reset_monitoring("invalid");
@@ -357,11 +400,7 @@ SCENARIO("Reset Monitoring", "[reset monitoring]") {
             }
 
             THEN("monitoring variables should not be changed") {
-                REQUIRE(numDurationAlertSent == 2);
-                REQUIRE(timeSinceLastDurationAlert == 1000);
-                REQUIRE(numStillnessAlertSent == 3);
-                REQUIRE(state3_start_time == 4000);
-                REQUIRE(isStillnessAlertActive == false);
+                requireMonitoringUnchanged(before);
             }
         }
 
@@ -373,11 +412,7 @@ SCENARIO("Reset Monitoring", "[reset monitoring]") {
             }
 
             THEN("monitoring variables should not be changed") {
-                REQUIRE(numDurationAlertSent == 2);
-                REQUIRE(timeSinceLastDurationAlert == 1000);
-                REQUIRE(numStillnessAlertSent == 3);
-                REQUIRE(state3_start_time == 4000);
-                REQUIRE(isStillnessAlertActive == false);
+                requireMonitoringUnchanged(before);
             }
         }
     }
@@ -385,17 +420,17 @@ SCENARIO("Reset Monitoring", "[reset monitoring]") {
 
 SCENARIO("Set Occupancy Detection INS Threshold", "[occupancy detection threshold]") {
     GIVEN("A starting initial threshold of 10") {
-        occupancy_detection_ins_threshold = 10;
+        stateMachine.config().occupancy_detection_ins_threshold = 10;
 
         WHEN("the function is called with 'e'") {
             int returnFlag = occupancy_detection_ins_threshold_set("e");
 
             THEN("the initial time value should remain the same") {
-                REQUIRE(occupancy_detection_ins_threshold == 10);
+                REQUIRE(stateMachine.config().occupancy_detection_ins_threshold == 10);
             }
 
             THEN("the function should return the stored value") {
-                REQUIRE(occupancy_detection_ins_threshold == 10);
+                REQUIRE(stateMachine.config().occupancy_detection_ins_threshold == 10);
             }
         }
 
@@ -403,11 +438,11 @@ SCENARIO("Set Occupancy Detection INS Threshold", "[occupancy detection threshol
             int returnFlag = occupancy_detection_ins_threshold_set("15");
 
             THEN("the initial time value should be updated to the input") {
-                REQUIRE(occupancy_detection_ins_threshold == 15);
+                REQUIRE(stateMachine.config().occupancy_detection_ins_threshold == 15);
             }
 
             THEN("the function should return the input") {
-                REQUIRE(occupancy_detection_ins_threshold == 15);
+                REQUIRE(stateMachine.config().occupancy_detection_ins_threshold == 15);
             }
         }
 
@@ -415,7 +450,7 @@ SCENARIO("Set Occupancy Detection INS Threshold", "[occupancy detection threshol
             int returnFlag = occupancy_detection_ins_threshold_set("-15");
 
             THEN("the initial time value should not be updated") {
-                REQUIRE(occupancy_detection_ins_threshold == 10);
+                REQUIRE(stateMachine.config().occupancy_detection_ins_threshold == 10);
             }
 
             THEN("the function should return -1 to indicate an error") {
@@ -427,7 +462,7 @@ SCENARIO("Set Occupancy Detection INS Threshold", "[occupancy detection threshol
             int returnFlag = occupancy_detection_ins_threshold_set("nonint");
 
             THEN("the initial time value should not be updated") {
-                REQUIRE(occupancy_detection_ins_threshold == 10);
+                REQUIRE(stateMachine.config().occupancy_detection_ins_threshold == 10);
             }
 
             THEN("the function should return -1 to indicate an error") {
@@ -439,13 +474,13 @@ SCENARIO("Set Occupancy Detection INS Threshold", "[occupancy detection threshol
 
 SCENARIO("Set Stillness INS Threshold", "[stillness threshold]") {
     GIVEN("A starting initial threshold of 10") {
-        stillness_ins_threshold = 10;
+        stateMachine.config().stillness_ins_threshold = 10;
 
         WHEN("the function is called with 'e'") {
             int returnFlag = stillness_ins_threshold_set("e");
 
             THEN("the initial time value should remain the same") {
-                REQUIRE(stillness_ins_threshold == 10);
+                REQUIRE(stateMachine.config().stillness_ins_threshold == 10);
             }
 
             THEN("the function should return the stored value") {
@@ -457,7 +492,7 @@ SCENARIO("Set Stillness INS Threshold", "[stillness threshold]") {
             int returnFlag = stillness_ins_threshold_set("15");
 
             THEN("the initial time value should be updated to the input") {
-                REQUIRE(stillness_ins_threshold == 15);
+                REQUIRE(stateMachine.config().stillness_ins_threshold == 15);
             }
 
             THEN("the function should return the input") {
@@ -469,7 +504,7 @@ SCENARIO("Set Stillness INS Threshold", "[stillness threshold]") {
             int returnFlag = stillness_ins_threshold_set("-15");
 
             THEN("the initial time value should not be updated") {
-                REQUIRE(stillness_ins_threshold == 10);
+                REQUIRE(stateMachine.config().stillness_ins_threshold == 10);
             }
 
             THEN("the function should return -1 to indicate an error") {
@@ -481,7 +516,7 @@ SCENARIO("Set Stillness INS Threshold", "[stillness threshold]") {
             int returnFlag = stillness_ins_threshold_set("nonint");
 
             THEN("the initial time value should not be updated") {
-                REQUIRE(stillness_ins_threshold == 10);
+                REQUIRE(stateMachine.config().stillness_ins_threshold == 10);
             }
 
             THEN("the function should return -1 to indicate an error") {
@@ -493,13 +528,13 @@ SCENARIO("Set Stillness INS Threshold", "[stillness threshold]") {
 
 SCENARIO("Set State 0 Occupancy Detection Time", "[state 0 occupancy detection time]") {
     GIVEN("A starting occupancy detection time of 1 minute") {
-        state0_occupancy_detection_time = 60000;
+        stateMachine.config().state0_occupancy_detection_time = 60000;
 
         WHEN("the function is called with 'e'") {
             int returnFlag = occupancy_detection_time_set("e");
 
             THEN("the initial time value should remain the same") {
-                REQUIRE(state0_occupancy_detection_time == 60000);
+                REQUIRE(stateMachine.config().state0_occupancy_detection_time == 60000);
             }
 
             THEN("the function should return the stored value") {
@@ -511,7 +546,7 @@ SCENARIO("Set State 0 Occupancy Detection Time", "[state 0 occupancy detection t
             int returnFlag = occupancy_detection_time_set("30");
 
             THEN("the initial time value should be updated to the input * 1000") {
-                REQUIRE(state0_occupancy_detection_time == 30000);
+                REQUIRE(stateMachine.config().state0_occupancy_detection_time == 30000);
             }
 
             THEN("the function should return the input") {
@@ -523,7 +558,7 @@ SCENARIO("Set State 0 Occupancy Detection Time", "[state 0 occupancy detection t
             int returnFlag = occupancy_detection_time_set("-30");
 
             THEN("the initial time value should not be updated") {
-                REQUIRE(state0_occupancy_detection_time == 60000);
+                REQUIRE(stateMachine.config().state0_occupancy_detection_time == 60000);
             }
 
             THEN("the function should return -1 to indicate an error") {
@@ -535,7 +570,7 @@ SCENARIO("Set State 0 Occupancy Detection Time", "[state 0 occupancy detection t
             int returnFlag = occupancy_detection_time_set("nonInt");
 
             THEN("the initial time value should not be updated") {
-                REQUIRE(state0_occupancy_detection_time == 60000);
+                REQUIRE(stateMachine.config().state0_occupancy_detection_time == 60000);
             }
 
             THEN("the function should return -1 to indicate an error") {
@@ -547,13 +582,13 @@ SCENARIO("Set State 0 Occupancy Detection Time", "[state 0 occupancy detection t
 
 SCENARIO("Set State 1 Initial Time", "[state 1 initial time]") {
     GIVEN("A starting initial time of 10 milliseconds") {
-        state1_initial_time = 10000;
+        stateMachine.config().state1_initial_time = 10000;
 
         WHEN("the function is called with 'e'") {
             int returnFlag = initial_time_set("e");
 
             THEN("the initial time value should remain the same") {
-                REQUIRE(state1_initial_time == 10000);
+                REQUIRE(stateMachine.config().state1_initial_time == 10000);
             }
 
             THEN("the function should return the stored value") {
@@ -565,7 +600,7 @@ SCENARIO("Set State 1 Initial Time", "[state 1 initial time]") {
             int returnFlag = initial_time_set("15");
 
             THEN("the initial time value should be updated to the input * 1000") {
-                REQUIRE(state1_initial_time == 15000);
+                REQUIRE(stateMachine.config().state1_initial_time == 15000);
             }
 
             THEN("the function should return the input") {
@@ -577,7 +612,7 @@ SCENARIO("Set State 1 Initial Time", "[state 1 initial time]") {
             int returnFlag = initial_time_set("-15");
 
             THEN("the initial time value should not be updated") {
-                REQUIRE(state1_initial_time == 10000);
+                REQUIRE(stateMachine.config().state1_initial_time == 10000);
             }
 
             THEN("the function should return -1 to indicate an error") {
@@ -589,7 +624,7 @@ SCENARIO("Set State 1 Initial Time", "[state 1 initial time]") {
             int returnFlag = initial_time_set("nonInt");
 
             THEN("the initial time value should not be updated") {
-                REQUIRE(state1_initial_time == 10000);
+                REQUIRE(stateMachine.config().state1_initial_time == 10000);
             }
 
             THEN("the function should return -1 to indicate an error") {
@@ -601,13 +636,13 @@ SCENARIO("Set State 1 Initial Time", "[state 1 initial time]") {
 
 SCENARIO("Set Duration Alert Time", "[duration alert time]") {
     GIVEN("A starting duration time of 20 minutes") {
-        duration_alert_time = 1200000;
+        stateMachine.config().duration_alert_time = 1200000;
 
         WHEN("the function is called with 'e'") {
             int returnFlag = duration_alert_time_set("e");
 
             THEN("the duration alert time value should remain the same") {
-                REQUIRE(duration_alert_time == 1200000);
+                REQUIRE(stateMachine.config().duration_alert_time == 1200000);
             }
 
             THEN("the function should return the stored value in seconds") {
@@ -619,7 +654,7 @@ SCENARIO("Set Duration Alert Time", "[duration alert time]") {
             int returnFlag = duration_alert_time_set("15");
 
             THEN("the duration alert time value should be updated to the input * 1000") {
-                REQUIRE(duration_alert_time == 15000);
+                REQUIRE(stateMachine.config().duration_alert_time == 15000);
             }
 
             THEN("the function should return the input in seconds") {
@@ -631,7 +666,7 @@ SCENARIO("Set Duration Alert Time", "[duration alert time]") {
             int returnFlag = duration_alert_time_set("-15");
 
             THEN("the duration alert time value should not be updated") {
-                REQUIRE(duration_alert_time == 1200000);
+                REQUIRE(stateMachine.config().duration_alert_time == 1200000);
             }
 
             THEN("the function should return -1 to indicate an error") {
@@ -643,7 +678,7 @@ SCENARIO("Set Duration Alert Time", "[duration alert time]") {
             int returnFlag = duration_alert_time_set("nonInt");
 
             THEN("the duration alert time value should not be updated") {
-                REQUIRE(duration_alert_time == 1200000);
+                REQUIRE(stateMachine.config().duration_alert_time == 1200000);
             }
 
             THEN("the function should return -1 to indicate an error") {
@@ -655,13 +690,13 @@ SCENARIO("Set Duration Alert Time", "[duration alert time]") {
 
 SCENARIO("Set Stillness Alert Time", "[stillness alert time]") {
     GIVEN("A starting stillness alert time of 5 minutes") {
-        stillness_alert_time = 300000;
+        stateMachine.config().stillness_alert_time = 300000;
 
         WHEN("the function is called with 'e'") {
             int returnFlag = stillness_alert_time_set("e");
 
             THEN("the initial stillness alert time value should remain the same") {
-                REQUIRE(stillness_alert_time == 300000);
+                REQUIRE(stateMachine.config().stillness_alert_time == 300000);
             }
 
             THEN("the function should return the stored value in seconds") {
@@ -673,7 +708,7 @@ SCENARIO("Set Stillness Alert Time", "[stillness alert time]") {
             int returnFlag = stillness_alert_time_set("10");
 
             THEN("the initial stillness alert time value should be updated to the input * 1000") {
-                REQUIRE(stillness_alert_time == 10000);
+                REQUIRE(stateMachine.config().stillness_alert_time == 10000);
             }
 
             THEN("the function should return the input in seconds") {
@@ -685,7 +720,7 @@ SCENARIO("Set Stillness Alert Time", "[stillness alert time]") {
             int returnFlag = stillness_alert_time_set("-10");
 
             THEN("the initial stillness alert time value should not be updated") {
-                REQUIRE(stillness_alert_time == 300000);
+                REQUIRE(stateMachine.config().stillness_alert_time == 300000);
             }
 
             THEN("the function should return -1 to indicate an error") {
@@ -697,7 +732,7 @@ SCENARIO("Set Stillness Alert Time", "[stillness alert time]") {
             int returnFlag = stillness_alert_time_set("nonInt");
 
             THEN("the initial stillness alert time value should not be updated") {
-                REQUIRE(stillness_alert_time == 300000);
+                REQUIRE(stateMachine.config().stillness_alert_time == 300000);
             }
 
             THEN("the function should return -1 to indicate an error") {
@@ -745,3 +780,138 @@ SCENARIO("Change_IM21_Door_ID", "[change door id]") {
         }
     }
 }
+
+SCENARIO("Heartbeat_Format", "[heartbeat format]") {
+    GIVEN("JSON heartbeats") {
+        heartbeatFormat = HEARTBEAT_FORMAT_JSON;
+
+        WHEN("the function is called with 'e'") {
+            int returnFlag = heartbeat_format_set("e");
+
+            THEN("the function should return the current format") {
+                REQUIRE(returnFlag == HEARTBEAT_FORMAT_JSON);
+                REQUIRE(heartbeatFormat == HEARTBEAT_FORMAT_JSON);
+            }
+        }
+
+        WHEN("the function is called with '1'") {
+            int returnFlag = heartbeat_format_set("1");
+
+            THEN("heartbeats should be compact and the function should return 1") {
+                REQUIRE(heartbeatFormat == HEARTBEAT_FORMAT_COMPACT);
+                REQUIRE(returnFlag == HEARTBEAT_FORMAT_COMPACT);
+            }
+        }
+
+        WHEN("the function is called with something other than 'e', '0' or '1'") {
+            int returnFlag = heartbeat_format_set("2");
+            int longReturnFlag = heartbeat_format_set("10");
+
+            THEN("the format should not change and the function should return -1") {
+                REQUIRE(heartbeatFormat == HEARTBEAT_FORMAT_JSON);
+                REQUIRE(returnFlag == -1);
+                REQUIRE(longReturnFlag == -1);
+            }
+        }
+    }
+
+    GIVEN("Compact heartbeats") {
+        heartbeatFormat = HEARTBEAT_FORMAT_COMPACT;
+
+        WHEN("the function is called with '0'") {
+            int returnFlag = heartbeat_format_set("0");
+
+            THEN("heartbeats should be JSON and the function should return 0") {
+                REQUIRE(heartbeatFormat == HEARTBEAT_FORMAT_JSON);
+                REQUIRE(returnFlag == HEARTBEAT_FORMAT_JSON);
+            }
+        }
+    }
+}
+
+SCENARIO("Noise_Calibration", "[noise calibration]") {
+    GIVEN("The noise floor thresholds are not applied") {
+        noiseCalibration = NOISE_CALIBRATION_OFF;
+
+        WHEN("the function is called with 'e'") {
+            int returnFlag = noise_calibration_set("e");
+
+            THEN("the function should return 0") {
+                REQUIRE(returnFlag == NOISE_CALIBRATION_OFF);
+                REQUIRE(noiseCalibration == NOISE_CALIBRATION_OFF);
+            }
+        }
+
+        WHEN("the function is called with '1'") {
+            int returnFlag = noise_calibration_set("1");
+
+            THEN("the thresholds should be applied and the function should return 1") {
+                REQUIRE(noiseCalibration == NOISE_CALIBRATION_ON);
+                REQUIRE(returnFlag == NOISE_CALIBRATION_ON);
+            }
+        }
+
+        WHEN("the function is called with something other than 'e', '0' or '1'") {
+            int returnFlag = noise_calibration_set("a");
+            int longReturnFlag = noise_calibration_set("11");
+
+            THEN("nothing should change and the function should return -1") {
+                REQUIRE(noiseCalibration == NOISE_CALIBRATION_OFF);
+                REQUIRE(returnFlag == -1);
+                REQUIRE(longReturnFlag == -1);
+            }
+        }
+    }
+
+    GIVEN("The noise floor thresholds are applied") {
+        noiseCalibration = NOISE_CALIBRATION_ON;
+
+        WHEN("the function is called with '0'") {
+            int returnFlag = noise_calibration_set("0");
+
+            THEN("the thresholds should not be applied and the function should return 0") {
+                REQUIRE(noiseCalibration == NOISE_CALIBRATION_OFF);
+                REQUIRE(returnFlag == NOISE_CALIBRATION_OFF);
+            }
+        }
+    }
+}
+
+SCENARIO("Latency_Stats", "[latency stats]") {
+    GIVEN("A decision and a publish latency have been recorded") {
+        resetLatencyHistograms();
+        recordLatency(LATENCY_DECISION, 40);
+        recordLatency(LATENCY_PUBLISH, 700);
+        fullPublishString = "";
+
+        WHEN("the function is called with e") {
+            int returnVal = latency_stats("e");
+
+            THEN("the histograms are published and kept") {
+                REQUIRE(returnVal == 1);
+                REQUIRE(fullPublishString.startsWith("Latency Stats{\"queue\":{\"count\":0,\"max\":0,\"buckets\":[0,"));
+                REQUIRE(fullPublishString.indexOf("\"decision\":{\"count\":1,\"max\":40,") >= 0);
+                REQUIRE(fullPublishString.indexOf("\"publish\":{\"count\":1,\"max\":700,") >= 0);
+                REQUIRE(fullPublishString.endsWith("]}}"));
+                REQUIRE(getLatencyHistogram(LATENCY_DECISION).count == 1);
+            }
+        }
+
+        WHEN("the function is called with 0") {
+            int returnVal = latency_stats("0");
+
+            THEN("every histogram starts over") {
+                REQUIRE(returnVal == 0);
+                REQUIRE(getLatencyHistogram(LATENCY_DECISION).count == 0);
+                REQUIRE(getLatencyHistogram(LATENCY_PUBLISH).count == 0);
+            }
+        }
+
+        WHEN("the function is called with invalid input") {
+            THEN("the function should return -1") {
+                REQUIRE(latency_stats("e1") == -1);
+                REQUIRE(latency_stats("x") == -1);
+            }
+        }
+    }
+}
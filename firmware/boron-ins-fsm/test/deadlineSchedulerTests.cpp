@@ -0,0 +1,156 @@
+/* deadlineSchedulerTests.cpp - Unit tests for the deadline scheduler
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "base.h"
+#include "../src/deadlineScheduler.cpp"
+#include "../src/deadlineScheduler.h"
+
+static void resetSchedulerTest(uint64_t now) {
+    resetDeadlines();
+    VirtualClock::set(now);
+}
+
+SCENARIO("Deadlines fire once", "[deadlineScheduler]") {
+    GIVEN("A deadline armed 1 minute out") {
+        resetSchedulerTest(1000);
+        armDeadline(DEADLINE_DURATION_ALERT, 61000);
+
+        WHEN("The scheduler is serviced just before it") {
+            VirtualClock::set(60999);
+            serviceDeadlines();
+
+            THEN("It has not fired") {
+                REQUIRE(isDeadlineArmed(DEADLINE_DURATION_ALERT));
+                REQUIRE_FALSE(isDeadlineFired(DEADLINE_DURATION_ALERT));
+            }
+        }
+
+        WHEN("The scheduler is serviced at the due time") {
+            VirtualClock::set(61000);
+            serviceDeadlines();
+
+            THEN("It fires and is taken once") {
+                REQUIRE_FALSE(isDeadlineArmed(DEADLINE_DURATION_ALERT));
+                REQUIRE(takeDeadline(DEADLINE_DURATION_ALERT));
+                VirtualClock::advance(1000);
+                serviceDeadlines();
+                REQUIRE_FALSE(takeDeadline(DEADLINE_DURATION_ALERT));
+            }
+        }
+
+        WHEN("loop() stalls well past the due time") {
+            VirtualClock::set(61000 + 10 * 60000);
+            serviceDeadlines();
+
+            THEN("It still fires, once") {
+                REQUIRE(takeDeadline(DEADLINE_DURATION_ALERT));
+                REQUIRE_FALSE(takeDeadline(DEADLINE_DURATION_ALERT));
+            }
+        }
+    }
+
+    GIVEN("A deadline that fired and is armed again for the same time") {
+        resetSchedulerTest(1000);
+        armDeadline(DEADLINE_STILLNESS_ALERT, 2000);
+        VirtualClock::set(2000);
+        serviceDeadlines();
+        armDeadline(DEADLINE_STILLNESS_ALERT, 2000);
+
+        THEN("It stays fired and is not armed again") {
+            REQUIRE(isDeadlineFired(DEADLINE_STILLNESS_ALERT));
+            REQUIRE_FALSE(isDeadlineArmed(DEADLINE_STILLNESS_ALERT));
+        }
+
+        WHEN("It is armed for a later time") {
+            armDeadline(DEADLINE_STILLNESS_ALERT, 5000);
+
+            THEN("The firing is cleared until the new time") {
+                REQUIRE_FALSE(isDeadlineFired(DEADLINE_STILLNESS_ALERT));
+                VirtualClock::set(5000);
+                serviceDeadlines();
+                REQUIRE(isDeadlineFired(DEADLINE_STILLNESS_ALERT));
+            }
+        }
+    }
+}
+
+SCENARIO("Several deadlines", "[deadlineScheduler]") {
+    GIVEN("Three deadlines armed out of order") {
+        resetSchedulerTest(0);
+        armDeadline(DEADLINE_HEARTBEAT, 3000);
+        armDeadline(DEADLINE_DURATION_ALERT, 1000);
+        armDeadline(DEADLINE_STILLNESS_ALERT, 2000);
+
+        THEN("They fire in due order") {
+            VirtualClock::set(1000);
+            serviceDeadlines();
+            REQUIRE(isDeadlineFired(DEADLINE_DURATION_ALERT));
+            REQUIRE_FALSE(isDeadlineFired(DEADLINE_STILLNESS_ALERT));
+            REQUIRE_FALSE(isDeadlineFired(DEADLINE_HEARTBEAT));
+
+            VirtualClock::set(2500);
+            serviceDeadlines();
+            REQUIRE(isDeadlineFired(DEADLINE_STILLNESS_ALERT));
+            REQUIRE_FALSE(isDeadlineFired(DEADLINE_HEARTBEAT));
+        }
+
+        WHEN("One is cancelled and another moved earlier") {
+            cancelDeadline(DEADLINE_DURATION_ALERT);
+            armDeadline(DEADLINE_HEARTBEAT, 500);
+
+            THEN("The cancelled one never fires and the moved one fires first") {
+                VirtualClock::set(500);
+                serviceDeadlines();
+                REQUIRE(isDeadlineFired(DEADLINE_HEARTBEAT));
+                REQUIRE_FALSE(isDeadlineFired(DEADLINE_STILLNESS_ALERT));
+
+                VirtualClock::set(10000);
+                serviceDeadlines();
+                REQUIRE_FALSE(isDeadlineFired(DEADLINE_DURATION_ALERT));
+                REQUIRE(isDeadlineFired(DEADLINE_STILLNESS_ALERT));
+            }
+        }
+
+        WHEN("All of them are overdue at once") {
+            VirtualClock::set(60000);
+            serviceDeadlines();
+
+            THEN("All of them fire in one pass") {
+                REQUIRE(takeDeadline(DEADLINE_DURATION_ALERT));
+                REQUIRE(takeDeadline(DEADLINE_STILLNESS_ALERT));
+                REQUIRE(takeDeadline(DEADLINE_HEARTBEAT));
+            }
+        }
+    }
+}
+
+SCENARIO("Deadlines across the millis() rollover", "[deadlineScheduler]") {
+    GIVEN("A deadline past the rollover and one just before it") {
+        resetSchedulerTest(0xFFFFF000);
+        armDeadline(DEADLINE_DURATION_ALERT, 0x00001000);
+        armDeadline(DEADLINE_HEARTBEAT, 0xFFFFF800);
+
+        WHEN("millis() has not rolled over yet") {
+            VirtualClock::set(0xFFFFFFFF);
+            serviceDeadlines();
+
+            THEN("Only the one before the rollover has fired") {
+                REQUIRE(isDeadlineFired(DEADLINE_HEARTBEAT));
+                REQUIRE_FALSE(isDeadlineFired(DEADLINE_DURATION_ALERT));
+            }
+        }
+
+        WHEN("millis() has rolled over past the later one") {
+            VirtualClock::set(0x100001000ULL);
+            serviceDeadlines();
+
+            THEN("Both have fired") {
+                REQUIRE(isDeadlineFired(DEADLINE_HEARTBEAT));
+                REQUIRE(isDeadlineFired(DEADLINE_DURATION_ALERT));
+            }
+        }
+    }
+}
@@ -0,0 +1,250 @@
+/* heartbeatEncodingTests.cpp - Unit tests for the JSON and compact heartbeat encodings
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * The encodings have no Particle dependencies, so no mocks are needed here. The compact
+ * heartbeat is checked by decoding it with the host decoder from sim/.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <string.h>
+#include <string>
+#include <vector>
+#include "../src/jsonWriter.cpp"
+#include "../src/latencyStats.cpp"
+#include "../src/insHistogram.cpp"
+#include "../src/heartbeatEncoding.cpp"
+#include "../sim/heartbeatDecode.cpp"
+
+static HeartbeatRecord sampleRecord() {
+    HeartbeatRecord record = {};
+    record.doorHeard = true;
+    record.doorLastMessage = 60110;
+    record.doorLowBattery = false;
+    record.doorTampered = true;
+    record.isINSZero = false;
+    record.insReaderLoad = 12;
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        record.latency[stage] = {13200u + stage, 10u * stage, 20u * stage, 1160u + stage};
+    }
+    record.insQueue = {0, 1, 7};
+    record.bleQueue = {3, 32, 1000};
+    record.consecutiveOpenDoorHeartbeatCount = 2;
+    record.doorMissedCount = 5;
+    record.doorMissedFrequently = true;
+    record.resetReason = 140;
+    record.noiseFloor = {7200, 8.25f, 14.5f, 20, 60};
+    record.insMagnitude = 27.5f;
+    record.insFramesParsed = 13200;
+    record.insChecksumErrors = 1;
+    record.insFramingErrors = 2;
+    record.insBytesDiscarded = 0xFFFFFFFF;
+    record.insHistogram[INS_OCCUPANCY_MOVING] = {70, 3, {5, 0, 36}};
+    record.insHistogram[INS_OCCUPANCY_STILL] = {30, 1, {239}};
+    return record;
+}
+
+static std::string z85Group(const uint8_t* bytes) {
+    uint32_t value = ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+    std::string group(5, '0');
+    for (int digit = 4; digit >= 0; digit--) {
+        group[digit] = heartbeatZ85Digits[value % 85];
+        value /= 85;
+    }
+    return group;
+}
+
+static std::string z85Text(const std::vector<uint8_t>& bytes) {
+    std::string text(1, HEARTBEAT_COMPACT_PREFIX);
+    for (size_t i = 0; i < bytes.size(); i += 4) {
+        text += z85Group(&bytes[i]);
+    }
+    return text;
+}
+
+static std::string heartbeatJson(const HeartbeatRecord& record, bool withCompactFields = false) {
+    char buffer[PARTICLE_MAX_MESSAGE_LENGTH];
+    JsonWriter writer(buffer, sizeof(buffer));
+    writeHeartbeatJson(record, writer, withCompactFields);
+    REQUIRE_FALSE(writer.overflowed());
+    return buffer;
+}
+
+SCENARIO("Z85 text") {
+    GIVEN("The example from the Z85 specification") {
+        const uint8_t bytes[] = {0x86, 0x4F, 0xD2, 0x6F, 0xB5, 0x59, 0xF7, 0x5B};
+        uint8_t decoded[8];
+
+        THEN("It decodes to the example's bytes") {
+            REQUIRE(decodeZ85("HelloWorld", 10, decoded, sizeof(decoded)) == 8);
+            REQUIRE(memcmp(decoded, bytes, sizeof(bytes)) == 0);
+        }
+
+        THEN("Text that is not Z85 is refused") {
+            REQUIRE(decodeZ85("Hello~orld", 10, decoded, sizeof(decoded)) == 0);
+            REQUIRE(decodeZ85("%nSc1", 5, decoded, sizeof(decoded)) == 0);
+            REQUIRE(decodeZ85("Hello", 4, decoded, sizeof(decoded)) == 0);
+            REQUIRE(decodeZ85("HelloWorld", 10, decoded, 4) == 0);
+        }
+    }
+}
+
+SCENARIO("Compact heartbeats") {
+    GIVEN("A heartbeat with every field set") {
+        HeartbeatRecord record = sampleRecord();
+        char compact[HEARTBEAT_COMPACT_MAX_LENGTH + 1];
+        size_t length = encodeCompactHeartbeat(record, compact, sizeof(compact));
+
+        THEN("It is the prefix and Z85 text of the schema 3 layout, with only the buckets counted in") {
+            // 132 bytes, then 2 + 0, 2 + 3 and 2 + 1 for the histograms, padded to 144
+            REQUIRE(length == 1 + 144 / 4 * 5);
+            REQUIRE(strlen(compact) == length);
+            REQUIRE(compact[0] == HEARTBEAT_COMPACT_PREFIX);
+            REQUIRE(strspn(compact + 1, heartbeatZ85Digits) == length - 1);
+        }
+
+        WHEN("It is decoded") {
+            HeartbeatRecord decoded;
+            REQUIRE(decodeCompactHeartbeat(compact, decoded));
+
+            THEN("Its JSON is the JSON of the heartbeat it came from") {
+                REQUIRE(heartbeatJson(decoded, true) == heartbeatJson(record, true));
+                REQUIRE(decoded.insMagnitude == 27.5f);
+                REQUIRE(decoded.insBytesDiscarded == 0xFFFFFFFF);
+                REQUIRE(decoded.insHistogram[INS_OCCUPANCY_EMPTY].span == 0);
+                REQUIRE(decoded.insHistogram[INS_OCCUPANCY_STILL].counts[0] == 239);
+                REQUIRE(decoded.noiseFloor.p99 == 14.5f);
+                REQUIRE(decoded.noiseFloor.occupancyThreshold == 60);
+            }
+
+            THEN("The histograms are written as bucket lower bounds and counts") {
+                REQUIRE(heartbeatJson(decoded, true).find("\"insHistogram\":{\"empty\":[],\"moving\":[[416.000,5],[480.000,100]],"
+                                                          "\"still\":[[13.000,4160749568]]}") != std::string::npos);
+            }
+        }
+    }
+
+    GIVEN("Counts that do not fit in 16 bits") {
+        HeartbeatRecord record = sampleRecord();
+        record.consecutiveOpenDoorHeartbeatCount = 70000;
+        record.doorMissedCount = 0x10000;
+        char compact[HEARTBEAT_COMPACT_MAX_LENGTH + 1];
+        encodeCompactHeartbeat(record, compact, sizeof(compact));
+        HeartbeatRecord decoded;
+        REQUIRE(decodeCompactHeartbeat(compact, decoded));
+
+        THEN("They are sent as 65535") {
+            REQUIRE(decoded.consecutiveOpenDoorHeartbeatCount == 0xFFFF);
+            REQUIRE(decoded.doorMissedCount == 0xFFFF);
+        }
+    }
+
+    GIVEN("A buffer too small for the compact heartbeat") {
+        HeartbeatRecord record = sampleRecord();
+        char compact[HEARTBEAT_COMPACT_MAX_LENGTH];
+
+        THEN("Nothing is written") {
+            REQUIRE(encodeCompactHeartbeat(record, compact, sizeof(compact)) == 0);
+        }
+    }
+
+    GIVEN("Data that is not a compact heartbeat of a known schema") {
+        HeartbeatRecord record = sampleRecord();
+        char compact[HEARTBEAT_COMPACT_MAX_LENGTH + 1];
+        encodeCompactHeartbeat(record, compact, sizeof(compact));
+        HeartbeatRecord decoded;
+
+        THEN("It is refused") {
+            REQUIRE_FALSE(decodeCompactHeartbeat(heartbeatJson(record).c_str(), decoded));
+            REQUIRE_FALSE(decodeCompactHeartbeat(std::string(compact, strlen(compact) - 5).c_str(), decoded));
+
+            // Schema ID 4 in the first group, the rest of the layout unchanged
+            uint8_t firstGroup[4];
+            REQUIRE(decodeZ85(compact + 1, 5, firstGroup, sizeof(firstGroup)) == 4);
+            firstGroup[0] = HEARTBEAT_SCHEMA_ID + 1;
+            std::string otherSchema(compact);
+            otherSchema.replace(1, 5, z85Group(firstGroup));
+            REQUIRE_FALSE(decodeCompactHeartbeat(otherSchema.c_str(), decoded));
+        }
+    }
+
+    GIVEN("A schema 1 heartbeat, from firmware before the histograms") {
+        std::string schema1 = "~0rr91" + std::string(HEARTBEAT_COMPACT_SCHEMA1_BYTES / 4 * 5 - 5, '0');
+        HeartbeatRecord decoded = sampleRecord();
+
+        THEN("It decodes with empty histograms") {
+            REQUIRE(decodeCompactHeartbeat(schema1.c_str(), decoded));
+            REQUIRE_FALSE(decoded.doorHeard);
+            REQUIRE(decoded.latency[LATENCY_PUBLISH].max == 0);
+            REQUIRE(decoded.insHistogram[INS_OCCUPANCY_MOVING].span == 0);
+            REQUIRE(decoded.noiseFloor.sampleCount == 0);
+        }
+    }
+
+    GIVEN("A schema 2 heartbeat, from firmware before the noise floor") {
+        // The fixed fields of schema 1, then a still histogram of one bucket, padded to 124
+        std::vector<uint8_t> bytes(124, 0);
+        bytes[0] = 2;
+        bytes[HEARTBEAT_COMPACT_SCHEMA1_BYTES + 4] = 30;
+        bytes[HEARTBEAT_COMPACT_SCHEMA1_BYTES + 5] = 1;
+        bytes[HEARTBEAT_COMPACT_SCHEMA1_BYTES + 6] = 239;
+        HeartbeatRecord decoded = sampleRecord();
+
+        THEN("It decodes with its histograms and no noise floor") {
+            REQUIRE(decodeCompactHeartbeat(z85Text(bytes).c_str(), decoded));
+            REQUIRE(decoded.insHistogram[INS_OCCUPANCY_MOVING].span == 0);
+            REQUIRE(decoded.insHistogram[INS_OCCUPANCY_STILL].first == 30);
+            REQUIRE(decoded.insHistogram[INS_OCCUPANCY_STILL].counts[0] == 239);
+            REQUIRE(decoded.noiseFloor.sampleCount == 0);
+            REQUIRE(decoded.noiseFloor.stillnessThreshold == 0);
+        }
+    }
+}
+
+SCENARIO("JSON heartbeats") {
+    GIVEN("A heartbeat before the door sensor has been heard from") {
+        HeartbeatRecord record = {};
+        record.resetReason = 0;
+
+        THEN("The door fields are -1, as the server expects") {
+            REQUIRE(heartbeatJson(record) ==
+                    "{\"doorLastMessage\":-1,\"doorLowBattery\":-1,\"doorTampered\":-1,\"isINSZero\":false,\"insReaderLoad\":0,"
+                    "\"latency\":{\"queue\":[0,0,0,0],\"filter\":[0,0,0,0],\"decision\":[0,0,0,0],\"publish\":[0,0,0,0]},"
+                    "\"insQueue\":[0,0,0],\"bleQueue\":[0,0,0],\"consecutiveOpenDoorHeartbeatCount\":0,\"doorMissedCount\":0,"
+                    "\"doorMissedFrequently\":false,\"resetReason\":\"NONE\",\"noiseFloor\":[0,0.0,0.0,0,0]}");
+        }
+    }
+
+    GIVEN("A heartbeat with every field at its longest") {
+        HeartbeatRecord record = sampleRecord();
+        record.doorLastMessage = 0xFFFFFFFF;
+        record.isINSZero = true;
+        record.insReaderLoad = 0xFFFF;
+        for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+            record.latency[stage] = {0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF};
+        }
+        record.insQueue = {0xFFFFFFFF, 0xFFFF, 0xFFFF};
+        record.bleQueue = record.insQueue;
+        record.consecutiveOpenDoorHeartbeatCount = 0xFFFFFFFF;
+        record.doorMissedCount = 0xFFFFFFFF;
+        record.doorMissedFrequently = false;
+        record.resetReason = 40;
+        // The magnitudes are never negative, and the thresholds are at most NOISE_FLOOR_MAX plus a margin
+        uint32_t threshold = (uint32_t)NOISE_FLOOR_MAX + NOISE_FLOOR_OCCUPANCY_MARGIN;
+        record.noiseFloor = {0xFFFFFFFF, 4294967295.0f, 4294967295.0f, threshold, threshold};
+
+        THEN("It fits in a Particle event") {
+            REQUIRE(heartbeatJson(record).size() < PARTICLE_MAX_MESSAGE_LENGTH);
+        }
+    }
+
+    GIVEN("Reset reason codes") {
+        THEN("Known codes are named and unknown ones are NONE") {
+            REQUIRE(std::string(resetReasonName(60)) == "WATCHDOG");
+            REQUIRE(std::string(resetReasonName(140)) == "USER");
+            REQUIRE(std::string(resetReasonName(10)) == "UNKNOWN");
+            REQUIRE(std::string(resetReasonName(110)) == "NONE");
+        }
+    }
+}
@@ -5,7 +5,12 @@
 
 #define CATCH_CONFIG_MAIN
 #include "base.h"
+#include <algorithm>
+#include <vector>
 #include "../src/ins3331.cpp"
+#include "../src/insFrameParser.cpp"
+#include "../src/insMovingAverage.cpp"
+#include "../src/latencyStats.cpp"
 #include "../src/ins3331.h"
 #include "../src/flashAddresses.h"
 
@@ -46,4 +51,319 @@ SCENARIO("The correct checksum is returned by calculateChecksum()") {
             }
         }
     }
-}
\ No newline at end of file
+}
+SCENARIO("A block of samples is filtered by processINSBlock()") {
+    GIVEN("A block of constant valid samples longer than the filter warm-up") {
+        resetINSFilter();
+        const size_t blockSize = 100;
+        rawINSData block[blockSize];
+        for (size_t i = 0; i < blockSize; ++i) {
+            block[i] = {30, -40};
+        }
+
+        WHEN("The block is processed") {
+            filteredINSData result = processINSBlock(block, blockSize, 0);
+
+            THEN("The averages are the absolute sample values and the magnitude is their norm") {
+                REQUIRE(result.iAverage == Approx(30.0f));
+                REQUIRE(result.qAverage == Approx(40.0f));
+                REQUIRE(result.magnitude == Approx(50.0f));
+            }
+        }
+
+        WHEN("The block arrived 5 ms ago, just before the 16 bit arrival time wrapped") {
+            VirtualClock::set(0x10000 + 2);
+            filteredINSData result = processINSBlock(block, blockSize, (uint16_t)(0x10000 - 3));
+
+            THEN("The sample time is the full clockMillis() of the arrival") {
+                REQUIRE(result.sampleTime == 0x10000 - 3);
+            }
+        }
+
+        WHEN("A block containing a single spike is processed afterwards") {
+            processINSBlock(block, blockSize, 0);
+            block[blockSize / 2] = {1000, 1000};
+            filteredINSData result = processINSBlock(block, blockSize, 0);
+
+            THEN("The spike does not change the filtered value") {
+                REQUIRE(result.magnitude == Approx(50.0f));
+            }
+        }
+    }
+}
+
+// Pushes n copies of sample, returns how many of them updated the output
+template <typename Filter>
+static size_t pushConstant(Filter& filter, rawINSData sample, size_t n) {
+    size_t updates = 0;
+    for (size_t i = 0; i < n; ++i) {
+        updates += filter.push(sample, 0) ? 1 : 0;
+    }
+    return updates;
+}
+
+SCENARIO("InsFilter instances are independent and can be reset") {
+    GIVEN("A filter with short windows") {
+        InsFilter<3, 4, 8> filter;
+
+        THEN("The first value comes once the median and moving average windows have filled") {
+            REQUIRE(pushConstant(filter, {30, -40}, 3 + 4 - 2) == 0);
+            REQUIRE(filter.push({30, -40}, 0));
+            REQUIRE(filter.value().magnitude == Approx(50.0f));
+        }
+
+        WHEN("It is reset after some samples") {
+            pushConstant(filter, {30, -40}, 100);
+            filter.reset();
+
+            THEN("It has to warm up again and forgets the old samples") {
+                REQUIRE(filter.value().magnitude == 0.0f);
+                REQUIRE(pushConstant(filter, {6, 8}, 3 + 4 - 2) == 0);
+                REQUIRE(filter.push({6, 8}, 0));
+                REQUIRE(filter.value().magnitude == Approx(10.0f));
+            }
+        }
+
+        WHEN("A second filter with the firmware windows sees different samples") {
+            FirmwareInsFilter firmwareFilter;
+            pushConstant(filter, {30, -40}, 100);
+            pushConstant(firmwareFilter, {6, 8}, 100);
+
+            THEN("Each keeps its own output") {
+                REQUIRE(filter.value().magnitude == Approx(50.0f));
+                REQUIRE(firmwareFilter.value().magnitude == Approx(10.0f));
+            }
+        }
+    }
+
+    GIVEN("A filter fed a sample every 10 ms") {
+        InsFilter<5, 20, 8> filter;
+        for (uint16_t n = 0; n < 100; ++n) {
+            filter.push({30, -40}, (uint16_t)(65000 + n * 10));
+        }
+
+        THEN("The group delay is half of each window, across the 16 bit arrival time wrap") {
+            REQUIRE(filter.value().groupDelay == (5 / 2 + (20 - 1) / 2) * 10);
+        }
+    }
+
+    GIVEN("Random samples with spikes") {
+        std::vector<rawINSData> samples;
+        srand(99);
+        for (int n = 0; n < 5000; ++n) {
+            int16_t spike = (rand() % 50 == 0) ? 2000 : 0;
+            samples.push_back({(int16_t)(rand() % 60 - 30 + spike), (int16_t)(rand() % 60 - 30)});
+        }
+
+        WHEN("They go through processINSBlock() and a FirmwareInsFilter") {
+            resetINSFilter();
+            FirmwareInsFilter filter;
+            for (const rawINSData& sample : samples) {
+                filter.push(sample, 0);
+            }
+            filteredINSData result = processINSBlock(samples.data(), samples.size(), 0);
+
+            THEN("Both give the same value") {
+                REQUIRE(result.iAverage == filter.value().iAverage);
+                REQUIRE(result.qAverage == filter.value().qAverage);
+                REQUIRE(result.magnitude == filter.value().magnitude);
+            }
+        }
+    }
+}
+
+SCENARIO("SortedWindow tracks order statistics of the most recent samples") {
+    GIVEN("A window and a reference copy of the last samples pushed") {
+        SortedWindow<int16_t, QUARTILE_BUFFER_SIZE> window;
+        int16_t recent[QUARTILE_BUFFER_SIZE];
+        size_t pushed = 0;
+
+        // Small value range so the window holds plenty of duplicates
+        srand(1234);
+
+        WHEN("Many samples are pushed") {
+            bool allRanksMatch = true;
+            for (int n = 0; n < 2000; ++n) {
+                int16_t value = (int16_t)(rand() % 40) - 20;
+                window.push(value);
+                recent[pushed % QUARTILE_BUFFER_SIZE] = value;
+                pushed++;
+
+                size_t count = pushed < QUARTILE_BUFFER_SIZE ? pushed : QUARTILE_BUFFER_SIZE;
+                int16_t reference[QUARTILE_BUFFER_SIZE];
+                memcpy(reference, recent, count * sizeof(int16_t));
+                std::sort(reference, reference + count);
+
+                for (size_t rank = 0; rank < count; ++rank) {
+                    if (window.at(rank) != reference[rank]) {
+                        allRanksMatch = false;
+                    }
+                }
+            }
+
+            THEN("Every rank matches a full sort of the same samples") {
+                REQUIRE(window.isFull());
+                REQUIRE(allRanksMatch);
+            }
+        }
+    }
+}
+
+// Reference median from before the selection network: copy and bubble sort the window
+template <size_t N>
+static int16_t bubbleSortMedian(const int16_t window[N]) {
+    int16_t sorted[N];
+    memcpy(sorted, window, sizeof(sorted));
+    for (size_t i = 0; i < N - 1; i++) {
+        for (size_t j = 0; j < N - i - 1; j++) {
+            if (sorted[j] > sorted[j + 1]) {
+                int16_t temp = sorted[j];
+                sorted[j] = sorted[j + 1];
+                sorted[j + 1] = temp;
+            }
+        }
+    }
+    return sorted[N / 2];
+}
+
+// By the 0-1 principle, a comparator network selects the median of every input
+// if and only if it selects the median of every input made of zeros and ones
+template <size_t N>
+static bool selectsMedianForAllBinaryInputs() {
+    for (uint32_t bits = 0; bits < (1u << N); bits++) {
+        int16_t window[N];
+        for (size_t i = 0; i < N; i++) {
+            window[i] = (bits >> i) & 1;
+        }
+        int16_t expected = bubbleSortMedian<N>(window);
+        if (MedianNetwork<N>::median(window) != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SCENARIO("MedianNetwork selects the same median as sorting the window") {
+    GIVEN("Selection networks generated for several odd window sizes") {
+        THEN("Each network is correct for every 0-1 input") {
+            REQUIRE(selectsMedianForAllBinaryInputs<1>());
+            REQUIRE(selectsMedianForAllBinaryInputs<3>());
+            REQUIRE(selectsMedianForAllBinaryInputs<MEDIAN_FILTER_SIZE>());
+            REQUIRE(selectsMedianForAllBinaryInputs<7>());
+            REQUIRE(selectsMedianForAllBinaryInputs<9>());
+            REQUIRE(selectsMedianForAllBinaryInputs<15>());
+        }
+
+        THEN("The network for the filter window uses fewer compare-exchanges than a full sort") {
+            REQUIRE(MedianNetwork<MEDIAN_FILTER_SIZE>::comparators.size() < MedianNetworkDetail::sortingNetwork<MEDIAN_FILTER_SIZE>().size());
+        }
+    }
+
+    GIVEN("Random I and Q windows of the filter size") {
+        srand(4321);
+
+        WHEN("The medians are taken as a pair") {
+            bool allMatch = true;
+            for (int n = 0; n < 10000; ++n) {
+                int16_t iWindow[MEDIAN_FILTER_SIZE], qWindow[MEDIAN_FILTER_SIZE];
+                for (size_t i = 0; i < MEDIAN_FILTER_SIZE; ++i) {
+                    iWindow[i] = (int16_t)(rand() % 65536 - 32768);
+                    qWindow[i] = (int16_t)(rand() % 8);
+                }
+                int16_t iExpected = bubbleSortMedian<MEDIAN_FILTER_SIZE>(iWindow);
+                int16_t qExpected = bubbleSortMedian<MEDIAN_FILTER_SIZE>(qWindow);
+
+                int16_t iMedian, qMedian;
+                MedianNetwork<MEDIAN_FILTER_SIZE>::medianPair(iWindow, qWindow, iMedian, qMedian);
+                if (iMedian != iExpected || qMedian != qExpected) {
+                    allMatch = false;
+                }
+            }
+
+            THEN("They are bit-identical to the bubble sort medians") {
+                REQUIRE(allMatch);
+            }
+        }
+    }
+}
+
+// Synthetic radar trace of median-filtered magnitudes: empty room noise, a person moving,
+// a person lying still, then the room empty again. Deterministic so failures reproduce.
+static void generateMedianTrace(int16_t* iTrace, int16_t* qTrace, size_t length) {
+    uint32_t lcg = 12345;
+    for (size_t n = 0; n < length; ++n) {
+        int amplitude;
+        if (n < length / 4) {
+            amplitude = 8;
+        }
+        else if (n < length / 2) {
+            amplitude = 400;
+        }
+        else if (n < 3 * length / 4) {
+            amplitude = 25;
+        }
+        else {
+            amplitude = 8;
+        }
+        lcg = lcg * 1664525u + 1013904223u;
+        iTrace[n] = (int16_t)((lcg >> 16) % (amplitude + 1));
+        lcg = lcg * 1664525u + 1013904223u;
+        qTrace[n] = (int16_t)((lcg >> 16) % (amplitude + 1));
+    }
+}
+
+SCENARIO("The fixed point moving average stage matches the float stage") {
+    GIVEN("A synthetic trace of median filtered samples and both implementations") {
+        const size_t traceLength = 200000;
+        static int16_t iTrace[traceLength], qTrace[traceLength];
+        generateMedianTrace(iTrace, qTrace, traceLength);
+
+        FloatMovingAverage<MOVING_AVERAGE_SAMPLE_SIZE> floatStage;
+        FixedPointMovingAverage<MOVING_AVERAGE_SAMPLE_SIZE> fixedStage;
+
+        WHEN("The trace is run through both") {
+            filteredINSData floatOut = {};
+            filteredINSData fixedOut = {};
+            float worstError = 0;
+            size_t updates = 0;
+            size_t updateMismatches = 0;
+
+            for (size_t n = 0; n < traceLength; ++n) {
+                bool floatUpdated = floatStage.push(iTrace[n], qTrace[n], floatOut);
+                bool fixedUpdated = fixedStage.push(iTrace[n], qTrace[n], fixedOut);
+                if (floatUpdated != fixedUpdated) {
+                    updateMismatches++;
+                }
+
+                if (floatUpdated) {
+                    updates++;
+                    worstError = std::max(worstError, fabsf(floatOut.magnitude - fixedOut.magnitude));
+                    worstError = std::max(worstError, fabsf(floatOut.iAverage - fixedOut.iAverage));
+                    worstError = std::max(worstError, fabsf(floatOut.qAverage - fixedOut.qAverage));
+                }
+            }
+
+            THEN("Every output agrees to within the Q-format resolution") {
+                REQUIRE(updateMismatches == 0);
+                REQUIRE(updates == traceLength - MOVING_AVERAGE_SAMPLE_SIZE + 1);
+                REQUIRE(worstError <= 1.0f / (1 << INS_Q_FRACTION_BITS));
+            }
+
+            THEN("The Q-format magnitude is consistent with its float view") {
+                REQUIRE(fixedOut.magnitude == Approx((float)fixedOut.magnitudeQ / (1 << INS_Q_FRACTION_BITS)));
+            }
+        }
+    }
+
+    GIVEN("The integer square root") {
+        THEN("It rounds down for exact squares, their neighbours and the largest inputs") {
+            REQUIRE(isqrt64(0) == 0);
+            REQUIRE(isqrt64(1) == 1);
+            REQUIRE(isqrt64(15) == 3);
+            REQUIRE(isqrt64(16) == 4);
+            REQUIRE(isqrt64(17) == 4);
+            REQUIRE(isqrt64(4294836225ULL) == 65535);
+            REQUIRE(isqrt64(0xFFFFFFFFFFFFFFFFULL) == 0xFFFFFFFFu);
+        }
+    }
+}
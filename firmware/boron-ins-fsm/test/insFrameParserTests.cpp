@@ -0,0 +1,228 @@
+/* insFrameParserTests.cpp - Unit tests for the INS3331 frame parser
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * The parser has no Particle dependencies, so no mocks are needed here.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <vector>
+#include "../src/insFrameParser.cpp"
+
+struct Sample {
+    int16_t inPhase;
+    int16_t quadrature;
+};
+
+static void collectSample(int16_t inPhase, int16_t quadrature, void* context) {
+    static_cast<std::vector<Sample>*>(context)->push_back({inPhase, quadrature});
+}
+
+// Build a valid receive frame carrying the given sample. filler is used for the other data bytes.
+static std::vector<uint8_t> makeFrame(int16_t inPhase, int16_t quadrature, uint8_t filler = 0x00) {
+    std::vector<uint8_t> frame(INS_FRAME_LENGTH, filler);
+    frame[0] = INS_FRAME_START;
+    frame[INS_FRAME_I_HIGH_INDEX] = (uint8_t)((uint16_t)inPhase >> 8);
+    frame[INS_FRAME_I_HIGH_INDEX + 1] = (uint8_t)inPhase;
+    frame[INS_FRAME_Q_HIGH_INDEX] = (uint8_t)((uint16_t)quadrature >> 8);
+    frame[INS_FRAME_Q_HIGH_INDEX + 1] = (uint8_t)quadrature;
+
+    uint8_t checksum = 0;
+    for (int i = 1; i < INS_FRAME_CHECKSUM_INDEX; i++) {
+        checksum += frame[i];
+    }
+    frame[INS_FRAME_CHECKSUM_INDEX] = checksum;
+    frame[INS_FRAME_LENGTH - 1] = INS_FRAME_END;
+    return frame;
+}
+
+static void append(std::vector<uint8_t>& stream, const std::vector<uint8_t>& bytes) {
+    stream.insert(stream.end(), bytes.begin(), bytes.end());
+}
+
+SCENARIO("InsFrameParser decodes valid frames") {
+    GIVEN("A parser and a stream of three valid frames") {
+        std::vector<Sample> samples;
+        InsFrameParser parser(collectSample, &samples);
+
+        std::vector<uint8_t> stream;
+        append(stream, makeFrame(100, -100));
+        append(stream, makeFrame(-32768, 32767));
+        append(stream, makeFrame(0x0080, 0x7F80));
+
+        WHEN("The stream is fed in a single chunk") {
+            parser.feed(stream.data(), stream.size());
+
+            THEN("All three samples are emitted in order with their signs intact") {
+                REQUIRE(samples.size() == 3);
+                REQUIRE(samples[0].inPhase == 100);
+                REQUIRE(samples[0].quadrature == -100);
+                REQUIRE(samples[1].inPhase == -32768);
+                REQUIRE(samples[1].quadrature == 32767);
+                REQUIRE(samples[2].inPhase == 0x0080);
+                REQUIRE(samples[2].quadrature == 0x7F80);
+                REQUIRE(parser.stats().framesParsed == 3);
+                REQUIRE(parser.stats().resyncs == 0);
+            }
+        }
+
+        WHEN("The stream is fed one byte at a time") {
+            for (uint8_t byte : stream) {
+                parser.feed(&byte, 1);
+            }
+
+            THEN("The same samples are emitted") {
+                REQUIRE(samples.size() == 3);
+                REQUIRE(samples[1].inPhase == -32768);
+                REQUIRE(samples[2].quadrature == 0x7F80);
+            }
+        }
+
+        WHEN("The stream is fed in uneven chunks") {
+            size_t chunkSizes[] = {5, 13, 1, 9, 20};
+            size_t pos = 0;
+            for (size_t size : chunkSizes) {
+                size_t length = std::min(size, stream.size() - pos);
+                parser.feed(stream.data() + pos, length);
+                pos += length;
+            }
+
+            THEN("The same samples are emitted") {
+                REQUIRE(pos == stream.size());
+                REQUIRE(samples.size() == 3);
+                REQUIRE(samples[0].inPhase == 100);
+            }
+        }
+    }
+
+    GIVEN("A frame whose data bytes equal the END and START delimiters") {
+        std::vector<Sample> samples;
+        InsFrameParser parser(collectSample, &samples);
+        std::vector<uint8_t> frame = makeFrame(0x16A2, 0xA216, INS_FRAME_END);
+
+        WHEN("It is fed to the parser") {
+            parser.feed(frame.data(), frame.size());
+
+            THEN("The frame is not cut short at the delimiter bytes") {
+                REQUIRE(samples.size() == 1);
+                REQUIRE(samples[0].inPhase == 0x16A2);
+                REQUIRE(samples[0].quadrature == (int16_t)0xA216);
+                REQUIRE(parser.stats().framingErrors == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("InsFrameParser recovers from corrupt input") {
+    GIVEN("A parser") {
+        std::vector<Sample> samples;
+        InsFrameParser parser(collectSample, &samples);
+
+        WHEN("Garbage precedes a valid frame") {
+            std::vector<uint8_t> stream = {0x00, 0x16, 0x55, 0xFF};
+            append(stream, makeFrame(42, 43));
+            parser.feed(stream.data(), stream.size());
+
+            THEN("The garbage is discarded and the frame decoded") {
+                REQUIRE(samples.size() == 1);
+                REQUIRE(samples[0].inPhase == 42);
+                REQUIRE(parser.stats().bytesDiscarded == 4);
+            }
+        }
+
+        WHEN("A frame has a bad checksum") {
+            std::vector<uint8_t> stream = makeFrame(1, 1);
+            stream[INS_FRAME_CHECKSUM_INDEX] ^= 0xFF;
+            append(stream, makeFrame(2, 2));
+            parser.feed(stream.data(), stream.size());
+
+            THEN("It is dropped, counted, and the next frame still decodes") {
+                REQUIRE(samples.size() == 1);
+                REQUIRE(samples[0].inPhase == 2);
+                REQUIRE(parser.stats().checksumErrors == 1);
+                REQUIRE(parser.stats().resyncs >= 1);
+            }
+        }
+
+        WHEN("A frame is truncated and the next START arrives early") {
+            // Lost bytes in the middle of a frame used to overflow the old receive buffer
+            std::vector<uint8_t> truncated = makeFrame(7, 7);
+            truncated.resize(6);
+            std::vector<uint8_t> stream = truncated;
+            append(stream, makeFrame(8, 9));
+            append(stream, makeFrame(10, 11));
+
+            // Split so the resync happens inside the reassembly buffer as well
+            parser.feed(stream.data(), 10);
+            parser.feed(stream.data() + 10, stream.size() - 10);
+
+            THEN("The parser resyncs on the next START and decodes the following frames") {
+                REQUIRE(samples.size() == 2);
+                REQUIRE(samples[0].inPhase == 8);
+                REQUIRE(samples[0].quadrature == 9);
+                REQUIRE(samples[1].inPhase == 10);
+                REQUIRE(parser.stats().framingErrors >= 1);
+            }
+        }
+
+        WHEN("A long run of random bytes is fed before valid frames") {
+            std::vector<uint8_t> stream;
+            uint32_t lcg = 99;
+            for (int i = 0; i < 5000; i++) {
+                lcg = lcg * 1664525u + 1013904223u;
+                stream.push_back((uint8_t)(lcg >> 24));
+            }
+            size_t noiseSamples;
+            parser.feed(stream.data(), stream.size());
+            noiseSamples = samples.size();
+
+            std::vector<uint8_t> frames;
+            for (int i = 0; i < 10; i++) {
+                append(frames, makeFrame(i, -i));
+            }
+            parser.feed(frames.data(), frames.size());
+
+            THEN("All of the valid frames that follow are decoded") {
+                REQUIRE(samples.size() - noiseSamples >= 10);
+                REQUIRE(samples.back().inPhase == 9);
+                REQUIRE(samples.back().quadrature == -9);
+            }
+        }
+    }
+}
+
+SCENARIO("InsFrameParser counters are taken as snapshots") {
+    GIVEN("A parser that has decoded one frame") {
+        std::vector<Sample> samples;
+        InsFrameParser parser(collectSample, &samples);
+        std::vector<uint8_t> frame = makeFrame(1, 2);
+        parser.feed(frame.data(), frame.size());
+
+        WHEN("A snapshot is taken and more frames are fed") {
+            InsFrameParserStats snapshot = parser.stats();
+            parser.feed(frame.data(), frame.size());
+            parser.feed(frame.data(), frame.size());
+
+            THEN("The snapshot keeps the counts from when it was taken") {
+                REQUIRE(snapshot.framesParsed == 1);
+                REQUIRE(parser.stats().framesParsed == 3);
+            }
+        }
+
+        WHEN("The parser is reset") {
+            std::vector<uint8_t> garbage = {0x00, 0x01};
+            parser.feed(garbage.data(), garbage.size());
+            parser.reset();
+
+            THEN("Every counter starts again from zero") {
+                InsFrameParserStats stats = parser.stats();
+                REQUIRE(stats.framesParsed == 0);
+                REQUIRE(stats.framingErrors == 0);
+                REQUIRE(stats.checksumErrors == 0);
+                REQUIRE(stats.resyncs == 0);
+                REQUIRE(stats.bytesDiscarded == 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,125 @@
+/* insHistogramTests.cpp - Unit tests for the INS magnitude histograms
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * The histograms have no Particle dependencies, so no mocks are needed here.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <math.h>
+#include <random>
+#include "../src/insHistogram.cpp"
+
+SCENARIO("Magnitudes are counted in log-linear buckets") {
+    GIVEN("Magnitudes at the edges of the range") {
+        THEN("Below 1 is bucket 0 and 4096 and up is the last bucket") {
+            REQUIRE(insHistogramBucket(0.0f) == 0);
+            REQUIRE(insHistogramBucket(0.999f) == 0);
+            REQUIRE(insHistogramBucket(-5.0f) == 0);
+            REQUIRE(insHistogramBucket(NAN) == 0);
+            REQUIRE(insHistogramBucket(1.0f) == 1);
+            REQUIRE(insHistogramBucket(4095.9f) == INS_HISTOGRAM_BUCKETS - 2);
+            REQUIRE(insHistogramBucket(4096.0f) == INS_HISTOGRAM_BUCKETS - 1);
+            REQUIRE(insHistogramBucket(INFINITY) == INS_HISTOGRAM_BUCKETS - 1);
+        }
+    }
+
+    GIVEN("Magnitudes around the default thresholds") {
+        THEN("Each power of two is split into 8 buckets of equal width") {
+            REQUIRE(insHistogramBucketLower(insHistogramBucket(20.0f)) == 20.0f);
+            REQUIRE(insHistogramBucketLower(insHistogramBucket(21.9f)) == 20.0f);
+            REQUIRE(insHistogramBucketLower(insHistogramBucket(22.0f)) == 22.0f);
+            REQUIRE(insHistogramBucketLower(insHistogramBucket(59.9f)) == 56.0f);
+            REQUIRE(insHistogramBucketLower(insHistogramBucket(60.0f)) == 60.0f);
+            REQUIRE(insHistogramBucketLower(insHistogramBucket(64.0f)) == 64.0f);
+            REQUIRE(insHistogramBucketLower(insHistogramBucket(71.9f)) == 64.0f);
+        }
+    }
+
+    GIVEN("Random magnitudes") {
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> exponent(0, INS_HISTOGRAM_OCTAVES);
+
+        THEN("Each is at least its bucket's lower bound and below the next one's") {
+            int misplaced = 0;
+            for (int i = 0; i < 100000; i++) {
+                float magnitude = powf(2, exponent(generator));
+                size_t bucket = insHistogramBucket(magnitude);
+                if (magnitude < insHistogramBucketLower(bucket) || magnitude >= insHistogramBucketLower(bucket + 1)) {
+                    misplaced++;
+                }
+            }
+            REQUIRE(misplaced == 0);
+        }
+    }
+}
+
+SCENARIO("Counts are coded in 8 bits") {
+    GIVEN("Small counts") {
+        THEN("They are kept exactly") {
+            for (uint32_t count = 0; count < 16; count++) {
+                REQUIRE(insHistogramCodeCount(insHistogramCountCode(count)) == count);
+            }
+        }
+    }
+
+    GIVEN("Counts up to 2^32 - 1") {
+        THEN("Each decodes to within 1/16 of itself") {
+            for (uint64_t count = 16; count <= 0xFFFFFFFF; count = count * 9 / 8 + 1) {
+                double decoded = insHistogramCodeCount(insHistogramCountCode((uint32_t)count));
+                REQUIRE(fabs(decoded - (double)count) <= (double)count / 16);
+            }
+            REQUIRE(insHistogramCountCode(0xFFFFFFFF) == 239);
+        }
+    }
+}
+
+SCENARIO("Histograms are kept per occupancy and taken once per heartbeat") {
+    GIVEN("Magnitudes recorded while empty and while still") {
+        resetInsHistograms();
+        for (int i = 0; i < 100; i++) {
+            recordInsMagnitude(INS_OCCUPANCY_EMPTY, 3.0f);
+        }
+        recordInsMagnitude(INS_OCCUPANCY_STILL, 10.0f);
+        recordInsMagnitude(INS_OCCUPANCY_STILL, 17.0f);
+
+        WHEN("They are taken") {
+            InsHistogram empty = takeInsHistogram(INS_OCCUPANCY_EMPTY);
+            InsHistogram moving = takeInsHistogram(INS_OCCUPANCY_MOVING);
+            InsHistogram still = takeInsHistogram(INS_OCCUPANCY_STILL);
+
+            THEN("Each has only its own magnitudes and starts over") {
+                REQUIRE(empty.count == 100);
+                REQUIRE(empty.buckets[insHistogramBucket(3.0f)] == 100);
+                REQUIRE(moving.count == 0);
+                REQUIRE(still.count == 2);
+                REQUIRE(takeInsHistogram(INS_OCCUPANCY_EMPTY).count == 0);
+            }
+
+            THEN("Merging the next histogram into one gives the values of both") {
+                recordInsMagnitude(INS_OCCUPANCY_STILL, 10.0f);
+                mergeInsHistogram(still, takeInsHistogram(INS_OCCUPANCY_STILL));
+                REQUIRE(still.count == 3);
+                REQUIRE(still.buckets[insHistogramBucket(10.0f)] == 2);
+                REQUIRE(still.buckets[insHistogramBucket(17.0f)] == 1);
+            }
+
+            THEN("Snapshots span the buckets counted in") {
+                InsHistogramSnapshot emptySnapshot = snapshotInsHistogram(empty);
+                InsHistogramSnapshot movingSnapshot = snapshotInsHistogram(moving);
+                InsHistogramSnapshot stillSnapshot = snapshotInsHistogram(still);
+
+                REQUIRE(emptySnapshot.first == insHistogramBucket(3.0f));
+                REQUIRE(emptySnapshot.span == 1);
+                REQUIRE(insHistogramCodeCount(emptySnapshot.counts[0]) == 100);
+                REQUIRE(movingSnapshot.span == 0);
+                REQUIRE(stillSnapshot.first == insHistogramBucket(10.0f));
+                REQUIRE(stillSnapshot.span == insHistogramBucket(17.0f) - insHistogramBucket(10.0f) + 1);
+                REQUIRE(stillSnapshot.counts[0] == 1);
+                REQUIRE(stillSnapshot.counts[1] == 0);
+                REQUIRE(stillSnapshot.counts[stillSnapshot.span - 1] == 1);
+            }
+        }
+    }
+}
@@ -0,0 +1,177 @@
+/* jsonWriterTests.cpp - Unit tests for the fixed buffer JSON writer
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * The writer has no Particle dependencies, so no mocks are needed here.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <limits>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "../src/jsonWriter.cpp"
+
+static constexpr JsonField sampleFields[] = {
+    {"state", JSON_INT},
+    {"count", JSON_UINT, JSON_QUOTED},
+    {"open", JSON_BOOL},
+    {"ins", JSON_FIXED, JSON_BARE, 2},
+    {"status", JSON_HEX8_0X},
+    {"control", JSON_HEX8},
+    {"deviceid", JSON_HEX24},
+};
+
+// Argument types are checked against the field formats when they are compiled
+static_assert(jsonAccepts<int>(JSON_INT) && jsonAccepts<unsigned long>(JSON_UINT) && jsonAccepts<float>(JSON_FIXED), "");
+static_assert(!jsonAccepts<float>(JSON_INT) && !jsonAccepts<int>(JSON_UINT) && !jsonAccepts<int>(JSON_BOOL), "");
+static_assert(!jsonAccepts<int>(JSON_HEX8) && !jsonAccepts<uint16_t>(JSON_HEX24), "");
+static_assert(jsonMaxLength(sampleFields) == 129, "");
+
+static std::string fixedText(float value, uint8_t decimals) {
+    char buffer[64];
+    JsonWriter writer(buffer, sizeof(buffer));
+    writer.fixed(value, decimals);
+    return buffer;
+}
+
+static std::string printfText(float value, uint8_t decimals) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, (double)value);
+    return buffer;
+}
+
+SCENARIO("Numbers are written as printf writes them") {
+    GIVEN("Integers at the ends of their ranges") {
+        char buffer[64];
+        JsonWriter writer(buffer, sizeof(buffer));
+        writer.beginArray();
+        writer.integer(0).integer(-1).integer(std::numeric_limits<int32_t>::min()).integer(std::numeric_limits<int32_t>::max());
+        writer.unsignedInteger(7).unsignedInteger(std::numeric_limits<uint32_t>::max());
+        writer.endArray();
+
+        THEN("They are written in full") {
+            REQUIRE(std::string(buffer) == "[0,-1,-2147483648,2147483647,7,4294967295]");
+            REQUIRE(writer.length() == strlen(buffer));
+        }
+    }
+
+    GIVEN("Floats that are ties, signed zeros and not numbers") {
+        THEN("They round half to even and keep their sign") {
+            REQUIRE(fixedText(0.5f, 0) == "0");
+            REQUIRE(fixedText(1.5f, 0) == "2");
+            REQUIRE(fixedText(2.5f, 0) == "2");
+            REQUIRE(fixedText(0.125f, 2) == "0.12");
+            REQUIRE(fixedText(0.375f, 2) == "0.38");
+            REQUIRE(fixedText(9.9999999f, 6) == "10.000000");
+            REQUIRE(fixedText(-0.0f, 6) == "-0.000000");
+            REQUIRE(fixedText(-0.0000001f, 6) == "-0.000000");
+            REQUIRE(fixedText(123.5f, 6) == "123.500000");
+            REQUIRE(fixedText(NAN, 6) == printfText(NAN, 6));
+            REQUIRE(fixedText(-INFINITY, 3) == printfText(-INFINITY, 3));
+        }
+    }
+
+    GIVEN("Random floats up to 2^32") {
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> exponent(-30, 32);
+        std::uniform_int_distribution<int> decimals(0, JSON_MAX_DECIMALS);
+
+        THEN("Every one matches %.*f") {
+            int mismatches = 0;
+            for (int i = 0; i < 200000; i++) {
+                float value = powf(2, exponent(generator)) * ((i & 1) ? -1 : 1);
+                uint8_t places = (uint8_t)decimals(generator);
+                if (value < 4294967296.0f && value > -4294967296.0f && fixedText(value, places) != printfText(value, places)) {
+                    mismatches++;
+                }
+            }
+            REQUIRE(mismatches == 0);
+        }
+    }
+
+    GIVEN("A float of 2^32 or more") {
+        THEN("It is written as the largest integer part") {
+            REQUIRE(fixedText(1e20f, 1) == "4294967295.0");
+            REQUIRE(fixedText(-5e9f, 0) == "-4294967295");
+        }
+    }
+}
+
+SCENARIO("Schema payloads") {
+    GIVEN("A buffer sized for the schema") {
+        char buffer[jsonMaxLength(sampleFields) + 1];
+
+        WHEN("Typical values are written") {
+            size_t length = writeJson<sampleFields>(buffer, 2, 15ul, true, 123.456f, (uint8_t)0x0A, (uint8_t)0xF3, (uint32_t)0xAABBCC);
+
+            THEN("Each value is written in its field's format") {
+                REQUIRE(std::string(buffer) ==
+                        "{\"state\":2,\"count\":\"15\",\"open\":true,\"ins\":123.46,\"status\":\"0x0A\",\"control\":\"F3\",\"deviceid\":\"AA:BB:CC\"}");
+                REQUIRE(length == strlen(buffer));
+            }
+        }
+
+        WHEN("The longest values are written") {
+            size_t length = writeJson<sampleFields>(buffer, std::numeric_limits<int32_t>::min(), std::numeric_limits<uint32_t>::max(), false,
+                                                    -4294967295.0f, (uint8_t)0xFF, (uint8_t)0xFF, (uint32_t)0xFFFFFF);
+
+            THEN("They fill the buffer exactly") {
+                REQUIRE(length == jsonMaxLength(sampleFields));
+                REQUIRE(buffer[length] == '\0');
+            }
+        }
+    }
+
+    GIVEN("A writer with an object open") {
+        char buffer[128];
+        JsonWriter writer(buffer, sizeof(buffer));
+        writer.beginObject();
+
+        WHEN("Schema fields are followed by an optional field") {
+            writeJsonFields<sampleFields>(writer, -3, 0u, false, 0.0f, (uint8_t)0, (uint8_t)1, (uint32_t)0x010203);
+            writer.name("extra").value("a\"b\\c\n");
+            writer.endObject();
+
+            THEN("The fields are separated and the string is escaped") {
+                REQUIRE(std::string(buffer) == "{\"state\":-3,\"count\":\"0\",\"open\":false,\"ins\":0.00,\"status\":\"0x00\","
+                                               "\"control\":\"01\",\"deviceid\":\"01:02:03\",\"extra\":\"a\\\"b\\\\c\\u000A\"}");
+                REQUIRE_FALSE(writer.overflowed());
+            }
+        }
+    }
+}
+
+SCENARIO("A payload longer than its buffer") {
+    GIVEN("A writer with room for a few values") {
+        char buffer[16];
+        memset(buffer, 'x', sizeof(buffer));
+        JsonWriter writer(buffer, sizeof(buffer));
+
+        WHEN("More is written than fits") {
+            writer.beginArray();
+            for (int i = 0; i < 10; i++) {
+                writer.integer(1000 + i);
+            }
+            writer.endArray();
+
+            THEN("Writing stops at the first value that does not fit") {
+                REQUIRE(writer.overflowed());
+                REQUIRE(std::string(buffer) == "[1000,1001,1002");
+                REQUIRE(writer.length() == 15);
+            }
+        }
+
+        WHEN("A string does not fit") {
+            writer.beginArray().value("abc").value("a long string");
+
+            THEN("None of it is written") {
+                REQUIRE(writer.overflowed());
+                REQUIRE(std::string(buffer) == "[\"abc\",");
+            }
+        }
+    }
+}
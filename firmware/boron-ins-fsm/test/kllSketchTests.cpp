@@ -0,0 +1,202 @@
+/* kllSketchTests.cpp - Unit tests for the quantile sketch and the noise floor it keeps
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Neither has Particle dependencies, so no mocks are needed here. The streams are the
+ * integers 1 to N in a shuffled order, so the true rank of a value v is v / N.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "../src/kllSketch.cpp"
+#include "../src/noiseFloor.cpp"
+
+// Room per level from the top down, and in all 26 levels
+static_assert(kllLevelCapacity(0) == 200 && kllLevelCapacity(1) == 134 && kllLevelCapacity(7) == 12, "");
+static_assert(kllLevelCapacity(8) == KLL_SKETCH_MIN_WIDTH && kllLevelCapacity(25) == KLL_SKETCH_MIN_WIDTH, "");
+static_assert(KLL_SKETCH_MAX_ITEMS == 725, "");
+
+static std::vector<float> shuffled(uint32_t first, uint32_t last, uint32_t seed) {
+    std::vector<float> values;
+    for (uint32_t value = first; value <= last; value++) {
+        values.push_back((float)value);
+    }
+    std::shuffle(values.begin(), values.end(), std::mt19937(seed));
+    return values;
+}
+
+// Largest distance of a quantile from its true rank over the percentiles, as a fraction of N
+static double maxRankError(KllSketch& sketch, uint32_t n) {
+    double worst = 0;
+    for (int percentile = 1; percentile <= 99; percentile++) {
+        double rank = sketch.quantile(percentile / 100.0f) / n;
+        worst = std::max(worst, fabs(rank - percentile / 100.0));
+    }
+    return worst;
+}
+
+SCENARIO("Quantiles of a stream") {
+    GIVEN("An empty sketch") {
+        KllSketch sketch;
+
+        THEN("Every quantile is 0 and NaN is not recorded") {
+            sketch.update(NAN);
+            REQUIRE(sketch.count() == 0);
+            REQUIRE(sketch.retained() == 0);
+            REQUIRE(sketch.quantile(0.5f) == 0.0f);
+        }
+    }
+
+    GIVEN("Fewer values than the top level holds") {
+        KllSketch sketch;
+        for (float value : shuffled(1, 100, 1)) {
+            sketch.update(value);
+        }
+
+        THEN("They are all kept and the quantiles are exact") {
+            REQUIRE(sketch.count() == 100);
+            REQUIRE(sketch.retained() == 100);
+            REQUIRE(sketch.quantile(0.0f) == 1.0f);
+            REQUIRE(sketch.quantile(0.5f) == 50.0f);
+            REQUIRE(sketch.quantile(0.99f) == 99.0f);
+            REQUIRE(sketch.quantile(1.0f) == 100.0f);
+            REQUIRE(sketch.quantile(2.0f) == 100.0f);
+        }
+    }
+
+    GIVEN("A hundred thousand values") {
+        KllSketch sketch;
+        for (float value : shuffled(1, 100000, 2)) {
+            sketch.update(value);
+        }
+
+        THEN("Each percentile is within 2% of its true rank, in fixed memory") {
+            REQUIRE(sketch.count() == 100000);
+            REQUIRE(sketch.retained() <= KLL_SKETCH_MAX_ITEMS);
+            REQUIRE(maxRankError(sketch, 100000) < 0.02);
+        }
+
+        WHEN("It is cleared") {
+            sketch.clear();
+
+            THEN("It is empty") {
+                REQUIRE(sketch.count() == 0);
+                REQUIRE(sketch.retained() == 0);
+            }
+        }
+    }
+
+    GIVEN("Two million values in ascending order") {
+        KllSketch sketch;
+        for (uint32_t value = 1; value <= 2000000; value++) {
+            sketch.update((float)value);
+        }
+
+        THEN("The percentiles are still within 2%") {
+            REQUIRE(sketch.count() == 2000000);
+            REQUIRE(sketch.retained() <= KLL_SKETCH_MAX_ITEMS);
+            REQUIRE(maxRankError(sketch, 2000000) < 0.02);
+        }
+    }
+}
+
+SCENARIO("Merged sketches") {
+    GIVEN("Sketches of the lower and upper halves of a stream") {
+        KllSketch lower;
+        KllSketch upper;
+        for (float value : shuffled(1, 60000, 3)) {
+            lower.update(value);
+        }
+        for (float value : shuffled(60001, 100000, 4)) {
+            upper.update(value);
+        }
+
+        WHEN("One is merged into the other") {
+            upper.merge(lower);
+
+            THEN("It is a sketch of the whole stream") {
+                REQUIRE(upper.count() == 100000);
+                REQUIRE(upper.retained() <= KLL_SKETCH_MAX_ITEMS);
+                REQUIRE(maxRankError(upper, 100000) < 0.02);
+            }
+        }
+    }
+
+    GIVEN("A sketch merged into an empty one") {
+        KllSketch sketch;
+        KllSketch empty;
+        for (float value : shuffled(1, 50000, 5)) {
+            sketch.update(value);
+        }
+        float median = sketch.quantile(0.5f);
+        empty.merge(sketch);
+
+        THEN("It has the same quantiles") {
+            REQUIRE(empty.count() == 50000);
+            REQUIRE(empty.quantile(0.5f) == median);
+        }
+    }
+}
+
+SCENARIO("Noise floor thresholds") {
+    GIVEN("Fewer noise values than a suggestion needs") {
+        resetNoiseFloor();
+        for (int i = 0; i < NOISE_FLOOR_MIN_SAMPLES - 1; i++) {
+            recordNoiseFloor(1.0f + (float)(i % 100) / 10.0f);
+            recordNoiseFloor(0.0f);
+        }
+        NoiseFloorSuggestion suggestion = suggestNoiseFloorThresholds();
+
+        THEN("The percentiles are sent without thresholds, and silent readings are left out") {
+            REQUIRE(suggestion.sampleCount == NOISE_FLOOR_MIN_SAMPLES - 1);
+            REQUIRE(suggestion.p99 > 10.0f);
+            REQUIRE(suggestion.stillnessThreshold == 0);
+            REQUIRE(suggestion.occupancyThreshold == 0);
+        }
+
+        WHEN("There are enough") {
+            recordNoiseFloor(5.0f);
+            suggestion = suggestNoiseFloorThresholds();
+
+            THEN("The thresholds are margins above the 99th percentile") {
+                // The values are 1.0 to 10.9 evenly, so the 99th percentile is 10.8 or 10.9
+                REQUIRE(suggestion.p50 == Approx(5.95f).margin(0.3f));
+                REQUIRE(suggestion.p99 > 10.5f);
+                REQUIRE(suggestion.stillnessThreshold == 11 + NOISE_FLOOR_STILLNESS_MARGIN);
+                REQUIRE(suggestion.occupancyThreshold == 11 + NOISE_FLOOR_OCCUPANCY_MARGIN);
+            }
+        }
+    }
+
+    GIVEN("Noise that suggests the default thresholds") {
+        resetNoiseFloor();
+        for (float value : shuffled(1, 1500, 6)) {
+            for (int copy = 0; copy < 4; copy++) {
+                recordNoiseFloor(value / 100.0f);
+            }
+        }
+        NoiseFloorSuggestion suggestion = suggestNoiseFloorThresholds();
+
+        THEN("A 99th percentile of 15 or just under gives 20 and 60") {
+            REQUIRE(suggestion.sampleCount == 6000);
+            REQUIRE(suggestion.stillnessThreshold == 20);
+            REQUIRE(suggestion.occupancyThreshold == 60);
+        }
+    }
+
+    GIVEN("A radar reading far off the scale") {
+        resetNoiseFloor();
+        for (int i = 0; i < NOISE_FLOOR_MIN_SAMPLES; i++) {
+            recordNoiseFloor(1e12f);
+        }
+        NoiseFloorSuggestion suggestion = suggestNoiseFloorThresholds();
+
+        THEN("The floor is taken as NOISE_FLOOR_MAX") {
+            REQUIRE(suggestion.stillnessThreshold == (uint32_t)NOISE_FLOOR_MAX + NOISE_FLOOR_STILLNESS_MARGIN);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/* latencyStatsTests.cpp - Unit tests for the alert path latency histograms
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * The histograms have no Particle dependencies, so no mocks are needed here.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../src/latencyStats.cpp"
+
+SCENARIO("Latencies are counted in power of two buckets") {
+    GIVEN("Empty histograms") {
+        resetLatencyHistograms();
+
+        THEN("Every stage is empty and reports 0") {
+            for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+                LatencyHistogram histogram = getLatencyHistogram((LatencyStage)stage);
+                REQUIRE(histogram.count == 0);
+                REQUIRE(latencyPercentile(histogram, 50) == 0);
+            }
+        }
+
+        WHEN("Latencies on bucket boundaries are recorded") {
+            recordLatency(LATENCY_QUEUE, 0);
+            recordLatency(LATENCY_QUEUE, 1);
+            recordLatency(LATENCY_QUEUE, 3);
+            recordLatency(LATENCY_QUEUE, 4);
+            recordLatency(LATENCY_QUEUE, 100000);
+
+            THEN("Each lands in the bucket of its highest bit, and the longest in the last") {
+                LatencyHistogram histogram = getLatencyHistogram(LATENCY_QUEUE);
+                REQUIRE(histogram.count == 5);
+                REQUIRE(histogram.max == 100000);
+                REQUIRE(histogram.buckets[0] == 1);
+                REQUIRE(histogram.buckets[1] == 1);
+                REQUIRE(histogram.buckets[2] == 1);
+                REQUIRE(histogram.buckets[3] == 1);
+                REQUIRE(histogram.buckets[LATENCY_BUCKETS - 1] == 1);
+            }
+
+            THEN("Other stages are untouched") {
+                REQUIRE(getLatencyHistogram(LATENCY_PUBLISH).count == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Percentiles are read from the buckets") {
+    GIVEN("99 short latencies and one long one") {
+        resetLatencyHistograms();
+        for (int i = 0; i < 99; i++) {
+            recordLatency(LATENCY_DECISION, 20);
+        }
+        recordLatency(LATENCY_DECISION, 900);
+        LatencyHistogram histogram = getLatencyHistogram(LATENCY_DECISION);
+
+        THEN("Percentiles are the upper bound of their bucket, capped at the max") {
+            REQUIRE(latencyPercentile(histogram, 50) == 31);
+            REQUIRE(latencyPercentile(histogram, 99) == 31);
+            REQUIRE(latencyPercentile(histogram, 100) == 900);
+        }
+
+        WHEN("The histogram is taken") {
+            LatencyHistogram taken = takeLatencyHistogram(LATENCY_DECISION);
+
+            THEN("The caller gets the counts and the stage starts over") {
+                REQUIRE(taken.count == 100);
+                REQUIRE(taken.max == 900);
+                REQUIRE(getLatencyHistogram(LATENCY_DECISION).count == 0);
+                REQUIRE(getLatencyHistogram(LATENCY_DECISION).max == 0);
+            }
+
+            THEN("Merging the next histogram into it gives the counts of both") {
+                recordLatency(LATENCY_DECISION, 20);
+                recordLatency(LATENCY_DECISION, 1500);
+                mergeLatencyHistogram(taken, takeLatencyHistogram(LATENCY_DECISION));
+                REQUIRE(taken.count == 102);
+                REQUIRE(taken.max == 1500);
+                REQUIRE(latencyPercentile(taken, 50) == 31);
+                REQUIRE(latencyPercentile(taken, 100) == 1500);
+            }
+        }
+    }
+}
@@ -15,6 +15,7 @@
 #include <string.h>
 #include <time.h>
 #include <functional>
+#include <memory>
 
 #include "../../inc/spark_wiring_string.h"
 #include "helper.h"
@@ -22,6 +23,7 @@
 #include "mock_thread.h"
 
 uint32_t millis();
+uint32_t micros();
 void delay(unsigned long ms);
 
 String fullPublishString;
@@ -36,24 +38,69 @@ enum PublishFlag
 // Fake structs
 struct os_queue_t {};
 
+namespace particle {
+
+// Result of an asynchronous call. Copies share their state, so a test can resolve the
+// Future a publish returned after the code under test has stored it.
+template <typename T>
+class Future {
+public:
+    struct State {
+        bool done = false;
+        bool succeeded = false;
+        T value = T();
+    };
+
+    Future() : state(std::make_shared<State>()) {}
+
+    bool isDone() const { return state->done; }
+    bool isSucceeded() const { return state->done && state->succeeded; }
+    bool isFailed() const { return state->done && !state->succeeded; }
+    T result() const { return state->value; }
+    operator T() const { return state->value; }
+
+    void resolve(bool succeeded, T value) {
+        state->done = true;
+        state->succeeded = succeeded;
+        state->value = value;
+    }
+
+private:
+    std::shared_ptr<State> state;
+};
+
+}  // namespace particle
+
 class MockParticle {
 public:
     MockParticle() {}
 
 public:
     bool connected() const {
-        return true;
+        return isConnected;
     }
 
-    bool publish(char const* const szEventName, char const* const szData, int const flags) {
+    // Publishes succeed straight away unless resolvePublishes is false, then the test
+    // resolves lastPublish itself
+    particle::Future<bool> publish(char const* const szEventName, char const* const szData, int const flags) {
         printf("Particle.Publish: '%s' = '%s' (flags: 0x%02x)\n", szEventName, szData, flags);
         fullPublishString = String(szEventName) + String(szData);
-        return true;
+        publishCount++;
+        lastPublish = particle::Future<bool>();
+        if (resolvePublishes) {
+            lastPublish.resolve(true, true);
+        }
+        return lastPublish;
     }
 
     static void function(const char* funcKey, std::function<int(String)> func) {
         printf("Particle.function: '%s'", funcKey);
     }
+
+    bool isConnected = true;
+    bool resolvePublishes = true;
+    int publishCount = 0;
+    particle::Future<bool> lastPublish;
 };
 
 extern String fullPublishString;
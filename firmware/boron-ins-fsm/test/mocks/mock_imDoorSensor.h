@@ -23,13 +23,14 @@ os_queue_t bleHeartbeatQueue;
 IMDoorID globalDoorID = {DOORID_BYTE1, DOORID_BYTE2, DOORID_BYTE3};
 
 int missedDoorEventCount = 0;
+unsigned long missedDoorEventTotal = 0;
 bool doorLowBatteryFlag = false;
 bool doorTamperedFlag = false;
 bool doorMessageReceivedFlag = false;
 
 unsigned long doorHeartbeatReceived = 0;
 unsigned long doorLastMessage = 0;
-unsigned long timeWhenDoorClosed = 0;
+unsigned long doorClosedEventCount = 0;
 unsigned long consecutiveOpenDoorHeartbeatCount = 0;
 
 // Function implementations
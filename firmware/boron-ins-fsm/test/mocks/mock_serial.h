@@ -10,6 +10,15 @@
 
 #define SERIAL_8N1 0  // fake definition
 
+// Fake definition of the Device OS UART buffer configuration
+typedef struct hal_usart_buffer_config_t {
+    uint16_t size;
+    void* rx_buffer;
+    uint16_t rx_buffer_size;
+    void* tx_buffer;
+    uint16_t tx_buffer_size;
+} hal_usart_buffer_config_t;
+
 // Fake class for USARTSerial
 class MockUSARTSerial {
 public:
@@ -24,6 +33,10 @@ public:
         return -1;
     }
 
+    size_t readBytes(char* buffer, size_t length) {
+        return 0;
+    }
+
     size_t write(uint8_t c) {
         return 0;
     }
@@ -0,0 +1,67 @@
+/* mock_stateMachineIO.h - StateMachineIO callbacks for tests that tick a StateMachine
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * Everything an instance reads and sends is kept in its own TestSensor, so instances on
+ * different threads share nothing.
+ */
+
+#pragma once
+
+#include <string.h>
+#include <string>
+
+#include "../../src/clock.h"
+#include "../../src/stateMachineCore.h"
+
+// The time, inputs and session messages of one instance
+struct TestSensor {
+    uint32_t now;
+    StateMachineInputs inputs;
+    int durationAlerts;
+    int stillnessAlerts;
+    int sessionsEnded;
+    std::string lastSessionEnd;
+    std::string transitions;    // "from>to" per state change, with "r" if taken on the radar
+};
+
+static uint32_t testNow(void* context) {
+    return ((TestSensor*)context)->now;
+}
+
+// For tests where the code around the state machine reads clockMillis() as well
+static uint32_t testClockNow(void* context) {
+    return clockMillis();
+}
+
+// The door closed event is taken once
+static void readTestInputs(void* context, StateMachineInputs* inputs) {
+    TestSensor* sensor = (TestSensor*)context;
+    *inputs = sensor->inputs;
+    sensor->inputs.isDoorClosedEvent = false;
+}
+
+static void countSessionMessage(void* context, const char* eventName, const char* message, SessionMessageKind kind) {
+    TestSensor* sensor = (TestSensor*)context;
+    if (kind == SESSION_MESSAGE_END) {
+        sensor->sessionsEnded++;
+        sensor->lastSessionEnd = message;
+    }
+    else if (strcmp(eventName, "Duration Alert") == 0) {
+        sensor->durationAlerts++;
+    }
+    else {
+        sensor->stillnessAlerts++;
+    }
+}
+
+static void recordTransition(void* context, StateId from, StateId to, bool isRadarDecision, const StateMachineInputs& inputs) {
+    TestSensor* sensor = (TestSensor*)context;
+    sensor->transitions += std::to_string(from) + ">" + std::to_string(to) + (isRadarDecision ? "r " : " ");
+}
+
+// Ticks on the sensor's own time and counts its session messages. Set reportTransition to
+// recordTransition to keep the state changes as well.
+static StateMachineIO makeTestIO(TestSensor* sensor) {
+    return {testNow, readTestInputs, nullptr, nullptr, nullptr, nullptr, countSessionMessage, sensor};
+}
@@ -6,8 +6,14 @@
 #pragma once
 
 #include "helper.h"
+#include "../../src/clock.h"
 
+// Tests run on the virtual clock (see clock.h), step it with VirtualClock::advance()
 uint32_t millis() {
+    return VirtualClock::millis();
+}
+
+uint32_t micros() {
     struct timespec ts;
 
 #ifdef __linux__
@@ -17,7 +23,7 @@ uint32_t millis() {
 #else
 #endif
 
-    return (uint32_t)(uint64_t)(ts.tv_nsec / 1000000) + ((uint64_t)ts.tv_sec * 1000ull);
+    return (uint32_t)((uint64_t)(ts.tv_nsec / 1000) + ((uint64_t)ts.tv_sec * 1000000ull));
 }
 
 void delay(unsigned long ms) {
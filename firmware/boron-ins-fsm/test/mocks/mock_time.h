@@ -0,0 +1,25 @@
+/* mock_time.h - Mock implementation for the Time wall clock
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#pragma once
+
+class MockTime {
+public:
+    MockTime() {}
+
+public:
+    uint32_t now() {
+        return nowValue;
+    }
+
+    bool isValid() {
+        return valid;
+    }
+
+    uint32_t nowValue = 1735689600;
+    bool valid = true;
+};
+
+extern MockTime Time;
@@ -0,0 +1,145 @@
+/* profilerTests.cpp - Unit tests for the loop() call profiler
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * The profiler and state machine core have no Particle dependencies, so no Particle mocks
+ * are needed. Built with -DBRAVE_PROFILER, which the firmware leaves off.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <string.h>
+#include <string>
+#include "../src/deadlineScheduler.cpp"
+#include "../src/profiler.cpp"
+#include "../src/stateMachineCore.cpp"
+#include "../src/jsonWriter.cpp"
+#include "mocks/mock_stateMachineIO.h"
+
+SCENARIO("Call times are summarised per site") {
+    GIVEN("Profile stats that have been reset") {
+        resetProfileStats();
+
+        THEN("Every site is empty and reports 0") {
+            for (int site = 0; site < PROFILE_SITE_COUNT; site++) {
+                const ProfileStats& stats = getProfileStats((ProfileSite)site);
+                REQUIRE(stats.count == 0);
+                REQUIRE(stats.min == 0);
+                REQUIRE(profilePercentile(stats, 99) == 0);
+            }
+        }
+
+        WHEN("99 short calls and one long one are recorded") {
+            for (int i = 0; i < 99; i++) {
+                recordProfile(PROFILE_CHECK_IM, 100);
+            }
+            recordProfile(PROFILE_CHECK_IM, 50000);
+            const ProfileStats& stats = getProfileStats(PROFILE_CHECK_IM);
+
+            THEN("Count, min, max and the total are exact") {
+                REQUIRE(stats.count == 100);
+                REQUIRE(stats.min == 100);
+                REQUIRE(stats.max == 50000);
+                REQUIRE(stats.total == 99 * 100 + 50000);
+            }
+
+            THEN("p99 is the upper bound of its bucket and the long call shows only in the max") {
+                REQUIRE(profilePercentile(stats, 50) == 127);
+                REQUIRE(profilePercentile(stats, 99) == 127);
+                REQUIRE(profilePercentile(stats, 100) == 50000);
+            }
+
+            THEN("Other sites are untouched") {
+                REQUIRE(getProfileStats(PROFILE_HEARTBEAT).count == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Scoped timers record the block they are in") {
+    GIVEN("Profile stats that have been reset") {
+        resetProfileStats();
+
+        WHEN("A block with a scoped timer runs twice") {
+            for (int i = 0; i < 2; i++) {
+                PROFILE_SCOPE(PROFILE_READ_INS);
+                volatile uint32_t spin = 0;
+                while (spin < 10000) {
+                    spin = spin + 1;
+                }
+            }
+
+            THEN("Both runs are recorded and took some time") {
+                const ProfileStats& stats = getProfileStats(PROFILE_READ_INS);
+                REQUIRE(stats.count == 2);
+                REQUIRE(stats.min > 0);
+                REQUIRE(stats.max >= stats.min);
+            }
+        }
+
+        WHEN("A state machine ticks in the idle state") {
+            TestSensor sensor = {1000, {0, true, false, false, 0.0f}};
+            StateMachine machine(makeTestIO(&sensor), defaultStateMachineConfig);
+            for (int i = 0; i < 3; i++) {
+                machine.tick();
+                sensor.now += 1000;
+            }
+
+            THEN("Each tick is recorded against the idle handler only") {
+                REQUIRE(getProfileStats(PROFILE_STATE_IDLE).count == 3);
+                REQUIRE(getProfileStats(PROFILE_STATE_INITIAL_COUNTDOWN).count == 0);
+                REQUIRE(getProfileStats(PROFILE_STATE_MONITORING).count == 0);
+                REQUIRE(getProfileStats(PROFILE_STATE_STILLNESS).count == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Profile stats are formatted as JSON") {
+    GIVEN("One site with recorded calls") {
+        resetProfileStats();
+        recordProfile(PROFILE_HEARTBEAT, 10);
+        recordProfile(PROFILE_HEARTBEAT, 30);
+
+        WHEN("The stats are formatted") {
+            char buffer[622];
+            size_t length = formatProfileStats(buffer, sizeof(buffer));
+
+            THEN("Every site is listed as [count,min,mean,max,p99]") {
+                std::string json(buffer);
+                REQUIRE(length == json.size());
+                REQUIRE(json.rfind(std::string("{\"unit\":\"") + profileTickUnit() + "\"", 0) == 0);
+                REQUIRE(json.find("\"checkIM\":[0,0,0,0,0]") != std::string::npos);
+                REQUIRE(json.find("\"getHeartbeat\":[2,10,20,30,30]") != std::string::npos);
+                REQUIRE(json.back() == '}');
+            }
+        }
+
+        WHEN("Every site is at its largest") {
+            resetProfileStats();
+            for (int site = 0; site < PROFILE_SITE_COUNT; site++) {
+                for (int i = 0; i < 3; i++) {
+                    recordProfile((ProfileSite)site, UINT32_MAX - i);
+                }
+            }
+            char buffer[622];
+            size_t length = formatProfileStats(buffer, sizeof(buffer));
+
+            THEN("It still fits in one Particle event") {
+                REQUIRE(length < sizeof(buffer));
+                REQUIRE(buffer[length - 1] == '}');
+            }
+        }
+
+        WHEN("The buffer is too small") {
+            char buffer[16];
+            memset(buffer, 'x', sizeof(buffer));
+            size_t length = formatProfileStats(buffer, sizeof(buffer));
+
+            THEN("The output is truncated and the full length is returned") {
+                REQUIRE(strlen(buffer) == sizeof(buffer) - 1);
+                REQUIRE(length > sizeof(buffer));
+            }
+        }
+    }
+}
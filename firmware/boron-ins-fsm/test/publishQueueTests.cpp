@@ -0,0 +1,337 @@
+/* publishQueueTests.cpp - Unit tests for the asynchronous publish queue
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "base.h"
+#include "../src/publishQueue.cpp"
+#include "../src/latencyStats.cpp"
+#include "../src/publishQueue.h"
+
+static int callbackCalls = 0;
+static bool callbackSucceeded = false;
+
+static void recordCallback(bool succeeded, void* context) {
+    callbackCalls++;
+    callbackSucceeded = succeeded;
+}
+
+static void resetQueueTest() {
+    resetPublishQueue();
+    VirtualClock::set(1000);
+    Particle.isConnected = true;
+    Particle.resolvePublishes = true;
+    Particle.publishCount = 0;
+    fullPublishString = "";
+    callbackCalls = 0;
+    callbackSucceeded = false;
+}
+
+SCENARIO("Publish order", "[publishQueue]") {
+    GIVEN("A debug message, a heartbeat and an alert queued in that order") {
+        resetQueueTest();
+        Particle.resolvePublishes = false;
+        REQUIRE(queuePublish("Debug Message", "d", PUBLISH_PRIORITY_DEBUG));
+        REQUIRE(queuePublish("Heartbeat", "h", PUBLISH_PRIORITY_HEARTBEAT));
+        REQUIRE(queuePublish("Stillness Alert", "a", PUBLISH_PRIORITY_ALERT));
+
+        WHEN("The queue is serviced") {
+            servicePublishQueue();
+
+            THEN("Only the alert is in flight") {
+                REQUIRE(Particle.publishCount == 1);
+                REQUIRE(fullPublishString == "Stillness Alerta");
+            }
+
+            AND_WHEN("The queue is serviced again before the alert resolves") {
+                servicePublishQueue();
+
+                THEN("Nothing else is started") {
+                    REQUIRE(Particle.publishCount == 1);
+                }
+            }
+
+            AND_WHEN("Each publish succeeds") {
+                Particle.lastPublish.resolve(true, true);
+                servicePublishQueue();
+                REQUIRE(fullPublishString == "Heartbeath");
+                Particle.lastPublish.resolve(true, true);
+                servicePublishQueue();
+
+                THEN("The debug message goes last") {
+                    REQUIRE(fullPublishString == "Debug Messaged");
+                }
+            }
+        }
+    }
+
+    GIVEN("Several items of the same priority") {
+        resetQueueTest();
+        queuePublish("Door Opened", "1", PUBLISH_PRIORITY_SESSION_END);
+        queuePublish("Door Opened", "2", PUBLISH_PRIORITY_SESSION_END);
+
+        WHEN("The queue is serviced twice") {
+            servicePublishQueue();
+            String first = fullPublishString;
+            servicePublishQueue();
+
+            THEN("They go out oldest first") {
+                REQUIRE(first == "Door Opened1");
+                REQUIRE(fullPublishString == "Door Opened2");
+            }
+        }
+    }
+
+    GIVEN("The device is not connected") {
+        resetQueueTest();
+        Particle.isConnected = false;
+        queuePublish("Stillness Alert", "a", PUBLISH_PRIORITY_ALERT);
+
+        WHEN("The queue is serviced") {
+            servicePublishQueue();
+
+            THEN("Nothing is published until it connects") {
+                REQUIRE(Particle.publishCount == 0);
+                Particle.isConnected = true;
+                servicePublishQueue();
+                REQUIRE(Particle.publishCount == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Publish rate limit", "[publishQueue]") {
+    GIVEN("More alerts queued than the burst allows") {
+        resetQueueTest();
+        for (int i = 0; i < PUBLISH_RATE_BURST + 2; i++) {
+            queuePublish("Duration Alert", "a", PUBLISH_PRIORITY_ALERT);
+        }
+
+        WHEN("The queue is serviced repeatedly without time passing") {
+            for (int i = 0; i < 10; i++) {
+                servicePublishQueue();
+            }
+
+            THEN("Only the burst goes out") {
+                REQUIRE(Particle.publishCount == PUBLISH_RATE_BURST);
+                REQUIRE(getPublishQueueStats().rateLimited > 0);
+            }
+
+            AND_WHEN("One rate interval passes") {
+                VirtualClock::advance(PUBLISH_RATE_INTERVAL);
+                servicePublishQueue();
+                servicePublishQueue();
+
+                THEN("One more goes out") {
+                    REQUIRE(Particle.publishCount == PUBLISH_RATE_BURST + 1);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Publish retries", "[publishQueue]") {
+    GIVEN("An alert whose publish fails") {
+        resetQueueTest();
+        Particle.resolvePublishes = false;
+        queuePublish("Stillness Alert", "a", PUBLISH_PRIORITY_ALERT, recordCallback);
+        servicePublishQueue();
+        Particle.lastPublish.resolve(false, false);
+        servicePublishQueue();
+
+        THEN("It is not retried before the retry interval") {
+            VirtualClock::advance(PUBLISH_RETRY_INTERVAL - 1);
+            servicePublishQueue();
+            REQUIRE(Particle.publishCount == 1);
+            REQUIRE(callbackCalls == 0);
+        }
+
+        THEN("It is retried after the retry interval") {
+            VirtualClock::advance(PUBLISH_RETRY_INTERVAL);
+            servicePublishQueue();
+            REQUIRE(Particle.publishCount == 2);
+        }
+
+        WHEN("The retry fails too") {
+            VirtualClock::advance(PUBLISH_RETRY_INTERVAL);
+            servicePublishQueue();
+            Particle.lastPublish.resolve(false, false);
+            servicePublishQueue();
+
+            THEN("The wait doubles") {
+                VirtualClock::advance(2 * PUBLISH_RETRY_INTERVAL - 1);
+                servicePublishQueue();
+                REQUIRE(Particle.publishCount == 2);
+                VirtualClock::advance(1);
+                servicePublishQueue();
+                REQUIRE(Particle.publishCount == 3);
+            }
+
+            AND_WHEN("The next attempt succeeds") {
+                VirtualClock::advance(2 * PUBLISH_RETRY_INTERVAL);
+                servicePublishQueue();
+                Particle.lastPublish.resolve(true, true);
+                servicePublishQueue();
+
+                THEN("The callback reports success once") {
+                    REQUIRE(callbackCalls == 1);
+                    REQUIRE(callbackSucceeded);
+                    REQUIRE(getPublishQueueStats().published == 1);
+                    REQUIRE(getPublishQueueStats().failedAttempts == 2);
+                    REQUIRE(getPublishQueueStats().depth == 0);
+                }
+            }
+        }
+    }
+
+    GIVEN("A heartbeat whose publish never resolves") {
+        resetQueueTest();
+        Particle.resolvePublishes = false;
+        queuePublish("Heartbeat", "h", PUBLISH_PRIORITY_HEARTBEAT);
+        servicePublishQueue();
+
+        WHEN("The publish timeout passes") {
+            VirtualClock::advance(PUBLISH_TIMEOUT + 1);
+            servicePublishQueue();
+            VirtualClock::advance(PUBLISH_RETRY_INTERVAL);
+            servicePublishQueue();
+
+            THEN("It is abandoned and retried") {
+                REQUIRE(Particle.publishCount == 2);
+                REQUIRE(getPublishQueueStats().failedAttempts == 1);
+            }
+        }
+    }
+
+    GIVEN("A debug message whose publish fails") {
+        resetQueueTest();
+        Particle.resolvePublishes = false;
+        queuePublish("Debug Message", "d", PUBLISH_PRIORITY_DEBUG, recordCallback);
+        servicePublishQueue();
+        Particle.lastPublish.resolve(false, false);
+        servicePublishQueue();
+
+        THEN("It is dropped instead of retried") {
+            VirtualClock::advance(PUBLISH_RETRY_MAX_INTERVAL);
+            servicePublishQueue();
+            REQUIRE(Particle.publishCount == 1);
+            REQUIRE(callbackCalls == 1);
+            REQUIRE_FALSE(callbackSucceeded);
+            REQUIRE(getPublishQueueStats().dropped == 1);
+        }
+    }
+
+    GIVEN("A door sensor warning whose publishes fail") {
+        resetQueueTest();
+        Particle.resolvePublishes = false;
+        queuePublish("IM Door Sensor Warning", "w", PUBLISH_PRIORITY_WARNING, recordCallback);
+
+        WHEN("Every attempt fails") {
+            for (int i = 0; i < PUBLISH_WARNING_MAX_ATTEMPTS + 1; i++) {
+                servicePublishQueue();
+                Particle.lastPublish.resolve(false, false);
+                servicePublishQueue();
+                VirtualClock::advance(PUBLISH_RETRY_MAX_INTERVAL);
+            }
+
+            THEN("It is given up after PUBLISH_WARNING_MAX_ATTEMPTS") {
+                REQUIRE(Particle.publishCount == PUBLISH_WARNING_MAX_ATTEMPTS);
+                REQUIRE(callbackCalls == 1);
+                REQUIRE_FALSE(callbackSucceeded);
+                REQUIRE(getPublishQueueStats().depth == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Full publish queue", "[publishQueue]") {
+    GIVEN("A queue full of door sensor warnings") {
+        resetQueueTest();
+        Particle.isConnected = false;
+        for (int i = 0; i < PUBLISH_QUEUE_SLOTS; i++) {
+            REQUIRE(queuePublish("IM Door Sensor Warning", String(i).c_str(), PUBLISH_PRIORITY_WARNING));
+        }
+
+        THEN("A heartbeat still gets in, in place of the oldest warning") {
+            REQUIRE(queuePublish("Heartbeat", "h", PUBLISH_PRIORITY_HEARTBEAT));
+            Particle.isConnected = true;
+            servicePublishQueue();
+            REQUIRE(fullPublishString == "Heartbeath");
+            REQUIRE(getPublishQueueStats().dropped == 1);
+        }
+    }
+
+    GIVEN("A queue full of debug messages and a heartbeat") {
+        resetQueueTest();
+        Particle.isConnected = false;
+        REQUIRE(queuePublish("Heartbeat", "h", PUBLISH_PRIORITY_HEARTBEAT, recordCallback));
+        for (int i = 1; i < PUBLISH_QUEUE_SLOTS; i++) {
+            REQUIRE(queuePublish("Debug Message", String(i).c_str(), PUBLISH_PRIORITY_DEBUG));
+        }
+
+        WHEN("Another debug message is queued") {
+            THEN("It replaces the oldest debug message") {
+                REQUIRE(queuePublish("Debug Message", "new", PUBLISH_PRIORITY_DEBUG));
+                REQUIRE(getPublishQueueStats().dropped == 1);
+                REQUIRE(getPublishQueueStats().depth == PUBLISH_QUEUE_SLOTS);
+            }
+        }
+
+        WHEN("Alerts fill the queue") {
+            for (int i = 0; i < PUBLISH_QUEUE_SLOTS; i++) {
+                REQUIRE(queuePublish("Stillness Alert", "a", PUBLISH_PRIORITY_ALERT));
+            }
+
+            THEN("The heartbeat is evicted last and its callback runs on the next service") {
+                REQUIRE(callbackCalls == 0);
+                servicePublishQueue();
+                REQUIRE(callbackCalls == 1);
+                REQUIRE_FALSE(callbackSucceeded);
+            }
+
+            THEN("Further alerts are rejected rather than replacing alerts") {
+                REQUIRE_FALSE(queuePublish("Stillness Alert", "b", PUBLISH_PRIORITY_ALERT));
+                REQUIRE(getPublishQueueStats().highWaterMark == PUBLISH_QUEUE_SLOTS);
+            }
+        }
+    }
+
+    GIVEN("An event that does not fit in a slot") {
+        resetQueueTest();
+        char data[PUBLISH_DATA_LENGTH + 2];
+        memset(data, 'x', sizeof(data) - 1);
+        data[sizeof(data) - 1] = '\0';
+
+        THEN("It is rejected") {
+            REQUIRE_FALSE(queuePublish("Heartbeat", data, PUBLISH_PRIORITY_HEARTBEAT));
+            REQUIRE(getPublishQueueStats().queued == 0);
+        }
+    }
+}
+
+SCENARIO("Publish latency", "[publishQueue]") {
+    GIVEN("An alert and a debug message queued together") {
+        resetQueueTest();
+        resetLatencyHistograms();
+        Particle.resolvePublishes = false;
+        queuePublish("Stillness Alert", "a", PUBLISH_PRIORITY_ALERT);
+        queuePublish("Debug Message", "d", PUBLISH_PRIORITY_DEBUG);
+
+        WHEN("Both publishes resolve 300 ms after they were queued") {
+            servicePublishQueue();
+            VirtualClock::advance(300);
+            Particle.lastPublish.resolve(true, true);
+            servicePublishQueue();
+            Particle.lastPublish.resolve(true, true);
+            servicePublishQueue();
+
+            THEN("Only the alert is recorded, from queueing to its Future resolving") {
+                LatencyHistogram histogram = getLatencyHistogram(LATENCY_PUBLISH);
+                REQUIRE(fullPublishString == "Debug Messaged");
+                REQUIRE(histogram.count == 1);
+                REQUIRE(histogram.max == 300);
+            }
+        }
+    }
+}
@@ -0,0 +1,120 @@
+/* seqlockTests.cpp - Unit tests for the seqlock snapshot
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * The seqlock has no Particle dependencies, so no mocks are needed here. The threaded
+ * scenario is built with -fsanitize=thread so any data race fails the test run.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "../src/seqlock.h"
+
+// Every field holds the same value, so a torn read shows up as fields that disagree
+struct Snapshot {
+    uint32_t sequence;
+    float magnitude;
+    uint16_t copies[61];
+};
+
+static Snapshot makeSnapshot(uint32_t n) {
+    Snapshot snapshot;
+    snapshot.sequence = n;
+    snapshot.magnitude = (float)n;
+    for (uint16_t& copy : snapshot.copies) {
+        copy = (uint16_t)n;
+    }
+    return snapshot;
+}
+
+static bool isConsistent(const Snapshot& snapshot) {
+    if (snapshot.magnitude != (float)snapshot.sequence) {
+        return false;
+    }
+    for (uint16_t copy : snapshot.copies) {
+        if (copy != (uint16_t)snapshot.sequence) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SCENARIO("A seqlock returns the last value written") {
+    GIVEN("A seqlock that has not been written") {
+        Seqlock<Snapshot> seqlock;
+
+        THEN("Reads return a zeroed value") {
+            Snapshot snapshot = seqlock.read();
+            REQUIRE(seqlock.writeCount() == 0);
+            REQUIRE(snapshot.sequence == 0);
+            REQUIRE(isConsistent(snapshot));
+        }
+
+        WHEN("Values are written") {
+            seqlock.write(makeSnapshot(7));
+            seqlock.write(makeSnapshot(8));
+
+            THEN("Every read returns the last one and changes nothing") {
+                REQUIRE(seqlock.read().sequence == 8);
+                REQUIRE(seqlock.read().sequence == 8);
+                REQUIRE(isConsistent(seqlock.read()));
+                REQUIRE(seqlock.writeCount() == 2);
+                REQUIRE(seqlock.readRetries() == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Readers on other threads never see a torn value") {
+    GIVEN("A writer thread and several reader threads") {
+        Seqlock<Snapshot> seqlock;
+        const uint32_t numWrites = 100000;
+        const int numReaders = 3;
+        std::atomic<bool> writerDone(false);
+        std::vector<int> tornReads(numReaders, 0);
+        std::vector<int> backwardsReads(numReaders, 0);
+
+        WHEN("The writer publishes while the readers read") {
+            std::vector<std::thread> readers;
+            for (int r = 0; r < numReaders; r++) {
+                readers.emplace_back([&, r]() {
+                    uint32_t last = 0;
+                    while (!writerDone.load(std::memory_order_acquire)) {
+                        Snapshot snapshot = seqlock.read();
+                        if (!isConsistent(snapshot)) {
+                            tornReads[r]++;
+                        }
+                        if (snapshot.sequence < last) {
+                            backwardsReads[r]++;
+                        }
+                        last = snapshot.sequence;
+                    }
+                });
+            }
+
+            std::thread writer([&]() {
+                for (uint32_t n = 1; n <= numWrites; n++) {
+                    seqlock.write(makeSnapshot(n));
+                }
+                writerDone.store(true, std::memory_order_release);
+            });
+
+            writer.join();
+            for (std::thread& reader : readers) {
+                reader.join();
+            }
+
+            THEN("Every read is whole and never older than the one before") {
+                for (int r = 0; r < numReaders; r++) {
+                    REQUIRE(tornReads[r] == 0);
+                    REQUIRE(backwardsReads[r] == 0);
+                }
+                REQUIRE(seqlock.read().sequence == numWrites);
+                REQUIRE(seqlock.writeCount() == numWrites);
+            }
+        }
+    }
+}
@@ -0,0 +1,231 @@
+/* spscRingTests.cpp - Unit tests for the lock-free SPSC ring buffer
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * The ring has no Particle dependencies, so no mocks are needed here. The threaded
+ * scenarios are built with -fsanitize=thread so any data race fails the test run.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <thread>
+#include "../src/spscRing.h"
+
+struct Sample {
+    int16_t inPhase;
+    int16_t quadrature;
+};
+
+SCENARIO("Items pass through the ring in order") {
+    GIVEN("An empty ring") {
+        SpscRing<uint32_t, 8> ring;
+
+        THEN("Nothing can be popped") {
+            uint32_t item;
+            REQUIRE(ring.size() == 0);
+            REQUIRE_FALSE(ring.pop(item));
+        }
+
+        WHEN("Items are pushed one at a time and in bulk") {
+            uint32_t bulk[3] = {2, 3, 4};
+            REQUIRE(ring.push(1));
+            REQUIRE(ring.pushBulk(bulk, 3) == 3);
+
+            THEN("They are popped in the order they were pushed") {
+                uint32_t out[8];
+                REQUIRE(ring.size() == 4);
+                REQUIRE(ring.popBulk(out, 8) == 4);
+                for (uint32_t i = 0; i < 4; ++i) {
+                    REQUIRE(out[i] == i + 1);
+                }
+                REQUIRE(ring.size() == 0);
+            }
+        }
+
+        WHEN("Items are pushed and popped across the end of the buffer") {
+            uint32_t next = 0, expected = 0;
+            bool inOrder = true;
+            for (int round = 0; round < 100; ++round) {
+                uint32_t in[5], out[5];
+                for (int i = 0; i < 5; ++i) {
+                    in[i] = next++;
+                }
+                ring.pushBulk(in, 5);
+                size_t n = ring.popBulk(out, 5);
+                for (size_t i = 0; i < n; ++i) {
+                    inOrder = inOrder && (out[i] == expected++);
+                }
+            }
+
+            THEN("Order is preserved through every wrap") {
+                REQUIRE(inOrder);
+                REQUIRE(expected == next);
+            }
+        }
+    }
+
+    GIVEN("A full ring") {
+        SpscRing<Sample, 4> ring;
+        for (int16_t i = 0; i < 4; ++i) {
+            REQUIRE(ring.push({i, (int16_t)-i}));
+        }
+
+        WHEN("More items are pushed") {
+            Sample extra[3] = {{10, 10}, {11, 11}, {12, 12}};
+            bool single = ring.push({9, 9});
+            size_t bulk = ring.pushBulk(extra, 3);
+
+            THEN("They are rejected and counted, and the queued items are untouched") {
+                REQUIRE_FALSE(single);
+                REQUIRE(bulk == 0);
+                REQUIRE(ring.overflowCount() == 4);
+                REQUIRE(ring.highWaterMark() == 4);
+
+                Sample out;
+                REQUIRE(ring.pop(out));
+                REQUIRE(out.inPhase == 0);
+            }
+        }
+
+        WHEN("Some items are popped and a larger bulk push follows") {
+            Sample out[2];
+            Sample extra[3] = {{10, 10}, {11, 11}, {12, 12}};
+            ring.popBulk(out, 2);
+            size_t pushed = ring.pushBulk(extra, 3);
+
+            THEN("Only the free slots are filled and the rest are counted as overflow") {
+                SpscRingStats stats = ring.stats();
+                REQUIRE(pushed == 2);
+                REQUIRE(stats.overflows == 1);
+                REQUIRE(stats.depth == 4);
+                REQUIRE(stats.capacity == 4);
+                REQUIRE(stats.highWaterMark == 4);
+            }
+        }
+    }
+}
+
+SCENARIO("Telemetry windows restart on every take") {
+    GIVEN("A ring that has been filled and drained") {
+        SpscRing<uint32_t, 8> ring;
+        uint32_t items[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+        uint32_t out[8];
+        ring.push(items[0]);                // 1 waiting
+        ring.pushBulk(items, 3);            // 4 waiting
+        ring.pushBulk(items, 10);           // 8 waiting, 6 rejected
+        ring.popBulk(out, 8);
+
+        WHEN("The window is taken") {
+            SpscRingWindow window = ring.takeWindow();
+
+            THEN("It holds every push call since the ring was made") {
+                REQUIRE(window.pushes == 3);
+                REQUIRE(window.occupancySum == 1 + 4 + 8);
+                REQUIRE(window.overflows == 6);
+                REQUIRE(window.highWaterMark == 8);
+            }
+
+            THEN("The next window holds only what was pushed after the take") {
+                ring.pushBulk(items, 2);
+                SpscRingWindow next = ring.takeWindow();
+                REQUIRE(next.pushes == 1);
+                REQUIRE(next.occupancySum == 2);
+                REQUIRE(next.overflows == 0);
+                REQUIRE(next.highWaterMark == 2);
+            }
+
+            THEN("The lifetime counters are kept") {
+                REQUIRE(ring.overflowCount() == 6);
+                REQUIRE(ring.highWaterMark() == 8);
+            }
+
+            THEN("Merging the next window gives the counts of both") {
+                ring.pushBulk(items, 2);
+                mergeSpscRingWindow(window, ring.takeWindow());
+                REQUIRE(window.pushes == 4);
+                REQUIRE(window.occupancySum == 1 + 4 + 8 + 2);
+                REQUIRE(window.overflows == 6);
+                REQUIRE(window.highWaterMark == 8);
+            }
+        }
+    }
+}
+
+SCENARIO("One producer and one consumer thread share the ring") {
+    GIVEN("A small ring and a producer pushing a long numbered sequence") {
+        static SpscRing<Sample, 64> ring;
+        const uint32_t total = 1000000;
+
+        WHEN("A consumer thread drains the ring while the producer fills it") {
+            // The ring is static, so start from the counts of any earlier run
+            uint32_t overflowsBefore = ring.overflowCount();
+            ring.takeWindow();
+            uint32_t pushCalls = 0;
+            std::thread producer([&]() {
+                uint32_t sent = 0;
+                Sample chunk[7];
+                while (sent < total) {
+                    // Mix single and bulk pushes, retrying whatever did not fit
+                    size_t n = (sent % 3 == 0) ? 1 : 7;
+                    if (n > total - sent) {
+                        n = total - sent;
+                    }
+                    for (size_t i = 0; i < n; ++i) {
+                        uint32_t value = sent + (uint32_t)i;
+                        chunk[i] = {(int16_t)(value & 0x7FFF), (int16_t)(value >> 15)};
+                    }
+                    size_t pushed = (n == 1) ? (ring.push(chunk[0]) ? 1 : 0) : ring.pushBulk(chunk, n);
+                    pushCalls++;
+                    sent += (uint32_t)pushed;
+                    if (pushed < n) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+
+            // The consumer also takes the telemetry windows, as the heartbeat would
+            uint32_t received = 0;
+            uint32_t outOfOrder = 0;
+            uint64_t windowPushes = 0;
+            uint64_t windowOverflows = 0;
+            uint32_t windowHighWater = 0;
+            Sample out[16];
+            while (received < total) {
+                if (received % 4096 == 0) {
+                    SpscRingWindow window = ring.takeWindow();
+                    windowPushes += window.pushes;
+                    windowOverflows += window.overflows;
+                    windowHighWater = (window.highWaterMark > windowHighWater) ? window.highWaterMark : windowHighWater;
+                }
+                size_t n = ring.popBulk(out, (received % 2 == 0) ? 16 : 5);
+                for (size_t i = 0; i < n; ++i) {
+                    uint32_t value = (uint32_t)out[i].inPhase | ((uint32_t)out[i].quadrature << 15);
+                    if (value != received) {
+                        outOfOrder++;
+                    }
+                    received++;
+                }
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+            }
+            producer.join();
+            SpscRingWindow last = ring.takeWindow();
+            windowPushes += last.pushes;
+            windowOverflows += last.overflows;
+
+            THEN("Every item arrives exactly once and in order") {
+                REQUIRE(outOfOrder == 0);
+                REQUIRE(received == total);
+                REQUIRE(ring.size() == 0);
+                REQUIRE(ring.highWaterMark() <= ring.capacity());
+            }
+
+            THEN("The windows add up to every push call and overflow") {
+                REQUIRE(windowPushes == pushCalls);
+                REQUIRE(windowOverflows == ring.overflowCount() - overflowsBefore);
+                REQUIRE(windowHighWater <= ring.highWaterMark());
+            }
+        }
+    }
+}
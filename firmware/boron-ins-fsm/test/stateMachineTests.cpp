@@ -0,0 +1,228 @@
+/* stateMachineTests.cpp - Unit tests for StateMachine instances
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * The state machine core has no Particle dependencies, so no Particle mocks are needed. The
+ * threaded scenario is built with -fsanitize=thread so any state shared between instances
+ * fails the test run.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <limits>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/deadlineScheduler.cpp"
+#include "../src/stateMachineCore.cpp"
+#include "../src/jsonWriter.cpp"
+#include "mocks/mock_stateMachineIO.h"
+
+#define MOVING_MAGNITUDE    100.0f
+#define STILL_MAGNITUDE     10.0f
+
+// Ticks once a second for ms with the door closed
+static void runSession(StateMachine& machine, TestSensor& sensor, unsigned long ms, float magnitude) {
+    sensor.inputs.insMagnitude = magnitude;
+    for (unsigned long elapsed = 0; elapsed < ms; elapsed += 1000) {
+        machine.tick();
+        sensor.now += 1000;
+    }
+}
+
+// The door closes, someone moves about for 5 s and then stays still for stillMs
+static void runStillSession(StateMachine& machine, TestSensor& sensor, unsigned long stillMs) {
+    sensor.inputs = {0, false, false, true, MOVING_MAGNITUDE};
+    runSession(machine, sensor, 5000, MOVING_MAGNITUDE);
+    runSession(machine, sensor, stillMs, STILL_MAGNITUDE);
+}
+
+SCENARIO("Instances keep their own config and session") {
+    GIVEN("Two instances with different stillness alert times") {
+        TestSensor shortSensor = {1000, {}, 0, 0, 0};
+        TestSensor longSensor = {1000, {}, 0, 0, 0};
+        StateMachineConfig shortConfig = defaultStateMachineConfig;
+        StateMachineConfig longConfig = defaultStateMachineConfig;
+        shortConfig.stillness_alert_time = 20000;
+        longConfig.stillness_alert_time = 60000;
+        StateMachine shortMachine(makeTestIO(&shortSensor), shortConfig);
+        StateMachine longMachine(makeTestIO(&longSensor), longConfig);
+
+        WHEN("Both see the same 40 s of stillness") {
+            runStillSession(shortMachine, shortSensor, 40000);
+            runStillSession(longMachine, longSensor, 40000);
+
+            THEN("Only the instance with the shorter time sends a stillness alert") {
+                REQUIRE(shortMachine.currentState() == STATE_STILLNESS);
+                REQUIRE(longMachine.currentState() == STATE_STILLNESS);
+                REQUIRE(shortSensor.stillnessAlerts == 1);
+                REQUIRE(longSensor.stillnessAlerts == 0);
+                REQUIRE(shortMachine.status().numStillnessAlertSent == 1);
+                REQUIRE(longMachine.status().numStillnessAlertSent == 0);
+            }
+
+            THEN("Resetting one instance leaves the other in its session") {
+                shortMachine.resetToIdle();
+                REQUIRE(shortMachine.currentState() == STATE_IDLE);
+                REQUIRE(longMachine.currentState() == STATE_STILLNESS);
+
+                runSession(longMachine, longSensor, 30000, STILL_MAGNITUDE);
+                REQUIRE(longSensor.stillnessAlerts == 1);
+                REQUIRE(shortSensor.stillnessAlerts == 1);
+            }
+        }
+
+        WHEN("The door opens after the stillness alert") {
+            runStillSession(shortMachine, shortSensor, 40000);
+            shortSensor.inputs.isDoorOpen = true;
+            shortMachine.tick();
+
+            THEN("The session ends and the transition is counted on that instance only") {
+                REQUIRE(shortMachine.currentState() == STATE_IDLE);
+                REQUIRE(shortSensor.sessionsEnded == 1);
+                REQUIRE(longSensor.sessionsEnded == 0);
+
+                StateTransitionCount shortCounts[STATE_MACHINE_TRANSITION_COUNT];
+                StateTransitionCount longCounts[STATE_MACHINE_TRANSITION_COUNT];
+                REQUIRE(shortMachine.getTransitionCounts(shortCounts, STATE_MACHINE_TRANSITION_COUNT) == STATE_MACHINE_TRANSITION_COUNT);
+                REQUIRE(longMachine.getTransitionCounts(longCounts, STATE_MACHINE_TRANSITION_COUNT) == STATE_MACHINE_TRANSITION_COUNT);
+
+                uint32_t shortTotal = 0;
+                uint32_t longTotal = 0;
+                for (int row = 0; row < STATE_MACHINE_TRANSITION_COUNT; row++) {
+                    shortTotal += shortCounts[row].count;
+                    longTotal += longCounts[row].count;
+                }
+                REQUIRE(shortTotal > 0);
+                REQUIRE(longTotal == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Each session is summarized in Door Opened") {
+    GIVEN("An instance with a 20 s stillness alert time") {
+        TestSensor sensor = {1000, {}, 0, 0, 0};
+        StateMachineConfig config = defaultStateMachineConfig;
+        config.stillness_alert_time = 20000;
+        StateMachine machine(makeTestIO(&sensor), config);
+
+        WHEN("The door opens after 40 s of stillness") {
+            runStillSession(machine, sensor, 40000);
+            sensor.inputs.isDoorOpen = true;
+            machine.tick();
+
+            THEN("The summary has the time, transitions and INS magnitudes of each state and the alert time") {
+                REQUIRE(sensor.sessionsEnded == 1);
+                REQUIRE(sensor.lastSessionEnd ==
+                        "{\"alertSentFromState\":3,\"numDurationAlertsSent\":0,\"numStillnessAlertsSent\":1,\"occupancyDuration\":0,"
+                        "\"session\":{\"stateTime\":[0,3,2,40],\"transitions\":4,"
+                        "\"ins\":[[100.0,100.0,100.0],[100.0,100.0,100.0],[10.0,55.0,100.0],[10.0,10.0,10.0]],"
+                        "\"durationAlerts\":[],\"stillnessAlerts\":[25],\"missedDoorEvents\":0}}");
+                REQUIRE_FALSE(machine.sessionSummary().isActive);
+            }
+        }
+
+        WHEN("The door closes again in state 3 without being seen to open, after missed door events") {
+            runStillSession(machine, sensor, 10000);
+            sensor.inputs.missedDoorEvents = 2;
+            machine.tick();
+            sensor.inputs.missedDoorEvents = 0;
+            sensor.now += 1000;
+            sensor.inputs.isDoorClosedEvent = true;
+            machine.tick();
+
+            THEN("The session is sent with its missed door events and the next one starts at the door close") {
+                REQUIRE(sensor.sessionsEnded == 1);
+                REQUIRE(sensor.lastSessionEnd.find("\"missedDoorReset\":true,") != std::string::npos);
+                REQUIRE(sensor.lastSessionEnd.find("\"missedDoorEvents\":2}") != std::string::npos);
+                REQUIRE(machine.sessionSummary().isActive);
+                REQUIRE(machine.sessionSummary().startTime == sensor.now);
+                REQUIRE(machine.sessionSummary().transitionCount == 0);
+            }
+        }
+    }
+
+    GIVEN("A summary with every field at its longest") {
+        SessionSummary session = {};
+        for (int state = 0; state < STATE_COUNT; state++) {
+            session.timeInState[state] = std::numeric_limits<uint32_t>::max();
+            session.ins[state] = {1, SESSION_SUMMARY_INS_MAX, SESSION_SUMMARY_INS_MAX, SESSION_SUMMARY_INS_MAX};
+        }
+        session.transitionCount = std::numeric_limits<uint32_t>::max();
+        session.durationAlertCount = SESSION_SUMMARY_ALERT_TIMES + 1;
+        session.stillnessAlertCount = SESSION_SUMMARY_ALERT_TIMES + 1;
+        for (int i = 0; i < SESSION_SUMMARY_ALERT_TIMES; i++) {
+            session.durationAlertTimes[i] = std::numeric_limits<uint32_t>::max();
+            session.stillnessAlertTimes[i] = std::numeric_limits<uint32_t>::max();
+        }
+        session.missedDoorEvents = std::numeric_limits<uint32_t>::max();
+
+        WHEN("Door Opened is written with it") {
+            char message[PARTICLE_MAX_MESSAGE_LENGTH + 1];
+            JsonWriter writer(message, sizeof(message));
+            writer.beginObject();
+            writeJsonFields<sessionMessageFields>(writer, std::numeric_limits<int>::min(), std::numeric_limits<unsigned long>::max(),
+                                                  std::numeric_limits<unsigned long>::max(), std::numeric_limits<unsigned long>::max());
+            writer.name("missedDoorReset").value(true);
+            writeSessionSummary(writer, session);
+            writer.endObject();
+
+            THEN("It leaves room for the alert journal's header in one event") {
+                REQUIRE_FALSE(writer.overflowed());
+                REQUIRE(writer.length() == 487);
+            }
+        }
+    }
+}
+
+SCENARIO("Instances on different threads share nothing") {
+    GIVEN("One instance per thread replaying the same session") {
+        const int numThreads = 4;
+        std::vector<TestSensor> sensors(numThreads, TestSensor{1000, {}, 0, 0, 0});
+        StateMachineConfig config = defaultStateMachineConfig;
+        config.duration_alert_time = 10000;
+        config.stillness_alert_time = 20000;
+
+        WHEN("Every thread runs its instance through the session") {
+            std::vector<std::thread> threads;
+            for (int t = 0; t < numThreads; t++) {
+                threads.emplace_back([&sensors, &config, t]() {
+                    StateMachine machine(makeTestIO(&sensors[t]), config);
+                    runStillSession(machine, sensors[t], 30000);
+                });
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+
+            THEN("Every instance sends the same alerts") {
+                for (int t = 0; t < numThreads; t++) {
+                    REQUIRE(sensors[t].durationAlerts == 2);
+                    REQUIRE(sensors[t].stillnessAlerts == 1);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Transitions report whether they were taken on a radar reading") {
+    GIVEN("An instance that reports its transitions") {
+        TestSensor sensor = {1000, {}, 0, 0, 0};
+        StateMachineIO io = makeTestIO(&sensor);
+        io.reportTransition = recordTransition;
+        StateMachine machine(io, defaultStateMachineConfig);
+
+        WHEN("Someone moves, stays still, moves again and leaves") {
+            runStillSession(machine, sensor, 10000);
+            runSession(machine, sensor, 2000, MOVING_MAGNITUDE);
+            sensor.inputs.isDoorOpen = true;
+            machine.tick();
+
+            THEN("Only the movement and stillness changes are radar decisions, not the countdown or the door") {
+                REQUIRE(sensor.transitions == "0>1r 1>2 2>3r 3>2r 2>0 ");
+            }
+        }
+    }
+}
@@ -0,0 +1,202 @@
+/* traceLogTests.cpp - Unit tests for the binary trace log and its host decoder
+ *
+ * Copyright (C) 2025 Brave Technology Coop. All rights reserved.
+ *
+ * The trace log and decoder have no Particle dependencies, so no mocks are needed here.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include <string>
+#include <vector>
+#include "../src/traceLog.cpp"
+#include "../sim/traceDecode.cpp"
+
+// Drains everything in the ring through a buffer of the given size
+static std::vector<uint8_t> drainAll(size_t bufferSize) {
+    std::vector<uint8_t> capture;
+    std::vector<uint8_t> buffer(bufferSize);
+    size_t length;
+    while ((length = drainTrace(buffer.data(), buffer.size())) > 0) {
+        capture.insert(capture.end(), buffer.begin(), buffer.begin() + length);
+    }
+    return capture;
+}
+
+static std::string decodeAll(const std::vector<uint8_t>& capture) {
+    return decodeTraceStream(capture.data(), capture.size());
+}
+
+// Formats are checked when they are compiled, not when they run
+static_assert(traceArgCount("State %d: Door Status = 0x%02X, INS Magnitude = %f") == 3, "");
+static_assert(traceArgCount("100%% done") == 0, "");
+static_assert(traceConversion("%-8.3lf and %lu", 0) == 'f', "");
+static_assert(traceConversion("%-8.3lf and %lu", 1) == 'u', "");
+static_assert(TraceArgs<int, unsigned char, float>::match("%d %02X %f", std::index_sequence<0, 1, 2>()), "");
+static_assert(!TraceArgs<float>::match("%d", std::index_sequence<0>()), "");
+static_assert(!TraceArgs<int>::match("%f", std::index_sequence<0>()), "");
+
+SCENARIO("Trace records decode to the lines they replace") {
+    GIVEN("An empty trace log") {
+        resetTraceLog();
+        setTraceLevel(TRACE_LEVEL_INFO);
+        VirtualClock::set(12345);
+
+        THEN("Nothing is drained") {
+            uint8_t buffer[64];
+            REQUIRE(drainTrace(buffer, sizeof(buffer)) == 0);
+        }
+
+        WHEN("Records with and without arguments are written and drained") {
+            TRACE(TRACE_STATE, 2, (uint8_t)0x0A, 123.5f);
+            VirtualClock::advance(10);
+            TRACE(TRACE_DOOR_CLOSED);
+            TRACE(TRACE_DOOR_DATA_PUBLISHED, (uint8_t)0x00);
+            std::vector<uint8_t> capture = drainAll(256);
+
+            THEN("Each frame is delimited by zeros and holds none itself") {
+                REQUIRE(capture.front() == 0x00);
+                REQUIRE(capture.back() == 0x00);
+                size_t zeros = 0;
+                for (uint8_t byte : capture) {
+                    zeros += (byte == 0x00);
+                }
+                REQUIRE(zeros == 6);
+            }
+
+            THEN("The decoder expands them with their time and level") {
+                REQUIRE(decodeAll(capture) ==
+                        "0000012345 [INFO] State 2: Door Status = 0x0A, INS Magnitude = 123.500000\n"
+                        "0000012355 [WARN] Door closed - State transitions enabled\n"
+                        "0000012355 [WARN] published, 0x00\n");
+            }
+
+            THEN("The ring is empty and the records are counted") {
+                TraceStats stats = getTraceStats();
+                REQUIRE(stats.records == 3);
+                REQUIRE(stats.dropped == 0);
+                REQUIRE(stats.pending == 0);
+            }
+        }
+
+        WHEN("Negative and large arguments are written") {
+            TRACE(TRACE_STATE, -1, (uint8_t)0xFF, -0.25f);
+
+            THEN("They keep their sign and bits") {
+                REQUIRE(decodeAll(drainAll(64)) == "0000012345 [INFO] State -1: Door Status = 0xFF, INS Magnitude = -0.250000\n");
+            }
+        }
+
+        WHEN("The drain buffer holds one record at a time") {
+            for (int i = 0; i < 10; i++) {
+                TRACE(TRACE_DOOR_NO_NEW_DATA, (uint8_t)i);
+            }
+            // A record of 3 words is at most 15 bytes framed
+            uint8_t buffer[20];
+            size_t length = drainTrace(buffer, sizeof(buffer));
+
+            THEN("Only whole records are drained and the rest wait") {
+                REQUIRE(length > 0);
+                REQUIRE(buffer[length - 1] == 0x00);
+                REQUIRE(getTraceStats().pending == 9 * 3);
+                REQUIRE(decodeAll(drainAll(sizeof(buffer))).size() > 0);
+                REQUIRE(getTraceStats().pending == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("A full trace log drops records and says so") {
+    GIVEN("A trace log filled with records that are not drained") {
+        resetTraceLog();
+        setTraceLevel(TRACE_LEVEL_INFO);
+        VirtualClock::set(1000);
+        const int written = TRACE_RING_WORDS / 3 + 10;
+        for (int i = 0; i < written; i++) {
+            TRACE(TRACE_DOOR_NO_NEW_DATA, (uint8_t)i);
+        }
+
+        THEN("The records that did not fit are counted") {
+            TraceStats stats = getTraceStats();
+            REQUIRE(stats.records == TRACE_RING_WORDS / 3);
+            REQUIRE(stats.dropped == written - TRACE_RING_WORDS / 3);
+        }
+
+        WHEN("The log is drained and written to again") {
+            drainAll(256);
+            TRACE(TRACE_DOOR_CLOSED);
+            std::string decoded = decodeAll(drainAll(256));
+
+            THEN("The next record is preceded by the number dropped") {
+                REQUIRE(decoded == "0000001000 [WARN] 10 trace records dropped\n"
+                                   "0000001000 [WARN] Door closed - State transitions enabled\n");
+            }
+        }
+    }
+}
+
+SCENARIO("Records below the trace level are not written") {
+    GIVEN("A trace log at the warning level") {
+        resetTraceLog();
+        setTraceLevel(TRACE_LEVEL_WARN);
+        VirtualClock::set(20);
+
+        WHEN("State and door records are written") {
+            TRACE(TRACE_STATE, 0, (uint8_t)0x02, 4.5f);
+            TRACE(TRACE_DOOR_NO_NEW_DATA, (uint8_t)0x02);
+            TRACE(TRACE_DOOR_CLOSED);
+
+            THEN("Only the warning is kept, and the others are not counted as dropped") {
+                REQUIRE(decodeAll(drainAll(64)) == "0000000020 [WARN] Door closed - State transitions enabled\n");
+                REQUIRE(getTraceStats().records == 1);
+                REQUIRE(getTraceStats().dropped == 0);
+            }
+        }
+    }
+
+    GIVEN("A trace log that is off") {
+        resetTraceLog();
+        setTraceLevel(TRACE_LEVEL_OFF);
+        TRACE(TRACE_DOOR_CLOSED);
+
+        THEN("Nothing is written") {
+            REQUIRE(getTraceStats().records == 0);
+            REQUIRE(getTraceStats().pending == 0);
+        }
+    }
+}
+
+SCENARIO("The decoder passes text logs through") {
+    GIVEN("A capture with text logs around and between trace frames") {
+        resetTraceLog();
+        setTraceLevel(TRACE_LEVEL_INFO);
+        VirtualClock::set(5);
+        TRACE(TRACE_DOOR_CLOSED);
+        std::vector<uint8_t> frame = drainAll(64);
+
+        std::string text1 = "0000000004 [WARN] service watchdog\r\n";
+        std::string text2 = "0000000006 [WARN] Heartbeat\r\n";
+        std::vector<uint8_t> capture(text1.begin(), text1.end());
+        capture.insert(capture.end(), frame.begin(), frame.end());
+        capture.insert(capture.end(), text2.begin(), text2.end());
+
+        THEN("The text is kept in order around the decoded record") {
+            REQUIRE(decodeAll(capture) == text1 + "0000000005 [WARN] Door closed - State transitions enabled\n" + text2);
+        }
+
+        THEN("A capture that starts inside a frame finds the next one") {
+            std::vector<uint8_t> cut(frame.begin() + 3, frame.end());
+            cut.insert(cut.end(), frame.begin(), frame.end());
+            std::string decoded = decodeAll(cut);
+            REQUIRE(decoded.find("<bad trace record>") == std::string::npos);
+            REQUIRE(decoded.substr(decoded.size() - 58) == "0000000005 [WARN] Door closed - State transitions enabled\n");
+        }
+
+        THEN("A damaged frame is reported and the next one still decodes") {
+            std::vector<uint8_t> damaged = frame;
+            damaged[2] ^= 0x40;
+            damaged.insert(damaged.end(), frame.begin(), frame.end());
+            REQUIRE(decodeAll(damaged) == "<bad trace record>\n0000000005 [WARN] Door closed - State transitions enabled\n");
+        }
+    }
+}